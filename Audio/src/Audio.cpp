@@ -4,6 +4,7 @@
 #include "Audio_Impl.hpp"
 #include "AudioOutput.hpp"
 #include "DSP.hpp"
+#include <Shared/Profiling.hpp>
 
 Audio *g_audio = nullptr;
 static Audio_Impl g_impl;
@@ -17,6 +18,7 @@ Audio_Impl::Audio_Impl()
 
 void Audio_Impl::Mix(void *data, uint32 &numSamples)
 {
+	PROFILE_SCOPE("Audio Mix");
 	double adv = GetSecondsPerSample();
 
 	uint32 outputChannels = this->output->GetNumChannels();
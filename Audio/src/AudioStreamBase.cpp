@@ -13,18 +13,19 @@ bool AudioStreamBase::Init(Audio *audio, const String &path, bool preload)
 {
 	m_audio = audio;
 
-	if (!m_file.OpenRead(path))
-		return false;
-
 	if (preload)
 	{
-		m_data.resize(m_file.GetSize());
-		m_file.Read(m_data.data(), m_data.size());
-		m_memoryReader = MemoryReader(m_data);
+		// Read in one go so the audio thread doesn't wait on the disk
+		//	not mapped, the stream lives as long as the song plays and the file could be replaced meanwhile
+		if (!File::ReadAll(path, m_data))
+			return false;
+		m_memoryReader = MappedReader(m_data);
 		m_preloaded = preload;
 	}
 	else
 	{
+		if (!m_file.OpenRead(path))
+			return false;
 		m_fileReader = FileReader(m_file);
 		m_preloaded = false;
 	}
@@ -220,7 +221,7 @@ void AudioStreamBase::Process(float *out, uint32 numSamples)
 		double avgDelta = m_deltaSum / (double)m_deltaSamples;
 		if (abs(timingDelta - avgDelta) > 0.2)
 		{
-			Logf("Timing restart, delta = %f", Logger::Severity::Info, avgDelta);
+			LogfRateLimited(1000, "Timing restart, delta = %f", Logger::Severity::Info, avgDelta);
 			m_restartTiming();
 		}
 		else
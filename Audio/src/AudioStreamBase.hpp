@@ -12,7 +12,7 @@ protected:
 	Audio *m_audio;
 	File m_file;
 	Buffer m_data;
-	MemoryReader m_memoryReader;
+	MappedReader m_memoryReader;
 	FileReader m_fileReader;
 	bool m_preloaded = false;
 	BinaryStream &m_reader();
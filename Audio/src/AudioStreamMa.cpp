@@ -46,7 +46,7 @@ bool AudioStreamMa::Init(Audio *audio, const String &path, bool preload)
 
 	if (m_preloaded)
 	{
-		result = ma_decode_memory((void *)m_data.data(), m_file.GetSize(), &config, &m_samplesTotal, (void **)&m_pcm);
+		result = ma_decode_memory(m_data.data(), m_data.size(), &config, &m_samplesTotal, (void **)&m_pcm);
 	}
 	else
 	{
@@ -52,7 +52,7 @@ bool AudioStreamMp3::Init(Audio *audio, const String &path, bool preload)
 	}
 	while (tag == "ID3")
 	{
-		tagSize += m_unsynchsafe(m_toLittleEndian(*(int32 *)(m_dataSource + 6 + tagSize))) + 10;
+		tagSize += m_unsynchsafe(m_toLittleEndian(*(const int32 *)(m_dataSource + 6 + tagSize))) + 10;
 		for (size_t i = 0; i < 3; i++)
 		{
 			tag[i] = m_dataSource[i + tagSize];
@@ -51,10 +51,14 @@ public:
 	}
 	bool Init(const String &path)
 	{
+		// Decoded in one go, the mapping is only needed until then
+		MappedFile file;
+		if (!file.Open(path, MappedFileAccess::Sequential))
+			return false;
 
 		ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, g_audio->GetSampleRate());
 		ma_result result;
-		result = ma_decode_file(*path, &config, &m_length, (void **)&m_pcm);
+		result = ma_decode_memory(file.GetData(), file.GetSize(), &config, &m_length, (void **)&m_pcm);
 
 		if (result != MA_SUCCESS)
 			return false;
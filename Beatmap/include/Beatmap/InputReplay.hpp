@@ -0,0 +1,79 @@
+#pragma once
+#include "BeatmapObjects.hpp"
+#include "PlaybackOptions.hpp"
+#include <Shared/BinaryStream.hpp>
+#include <Shared/Buffer.hpp>
+
+// Button press or release, button is the index of an input button
+struct InputReplayEvent
+{
+	uint8 button;
+	bool pressed;
+};
+
+// A single gameplay update
+struct InputReplayFrame
+{
+	// Playback position the update was done with
+	MapTime time;
+	float deltaTime;
+	// Laser input of this update
+	float laserInput[2];
+	// Button events that happened before this update, indices into InputReplay::events
+	uint32 firstEvent;
+	uint32 numEvents;
+	// Updates without input that follow this one, each 1 ms after the previous with the same delta time
+	uint32 numRepeats;
+};
+
+/*
+	Replay that stores the input of a play instead of the judgements
+	replaying the frames through the scoring system gives back exactly the same result
+
+	Frames are delta and varint encoded, the encoded data is optionally deflate compressed
+	the gameplay thread updates every ms, runs of updates without input are stored as repeats of a single frame
+*/
+class InputReplay
+{
+public:
+	static const uint32 Version = 2;
+
+	void Clear();
+	// Adds a button event that will be part of the next frame
+	void AddEvent(uint8 button, bool pressed);
+	// Adds a repeat to the last frame when there is no input and the update follows it by 1 ms with the same delta time
+	void AddFrame(MapTime time, float deltaTime, float laser0, float laser1);
+
+	bool Save(BinaryStream& stream, bool compress = true) const;
+	bool Load(BinaryStream& stream);
+
+	// Encodes everything but the file header
+	void Encode(Buffer& out) const;
+	bool Decode(const Buffer& in, uint32 version = Version);
+
+	// Settings the play was recorded with
+	PlaybackOptions options;
+	int32 hitWindowPerfect = 0;
+	int32 hitWindowGood = 0;
+	int32 hitWindowHold = 0;
+	int32 hitWindowMiss = 0;
+	int32 hitWindowSlam = 0;
+	int32 inputOffset = 0;
+	int32 laserOffset = 0;
+	int32 bounceGuard = 0;
+	// Arguments of the BeatmapPlayback reset at the start of the play
+	MapTime playbackInitTime = 0;
+	MapTime playbackStartTime = 0;
+
+	// Result of the recorded play, used to verify a re-simulation
+	uint32 score = 0;
+	uint32 perfects = 0;
+	uint32 goods = 0;
+	uint32 misses = 0;
+
+	Vector<InputReplayFrame> frames;
+	Vector<InputReplayEvent> events;
+
+private:
+	uint32 m_frameEventStart = 0;
+};
@@ -227,6 +227,8 @@ public:
 	
 	void RemoveSearchPath(const String& path);
 	void UpdateChartOffset(const ChartIndex* chart);
+	// Charts whose offset was never set and that have no scores
+	Vector<ChartIndex*> FindChartsWithoutOffset();
 
 	void SetChartUpdateBehavior(bool transferScores);
 
@@ -0,0 +1,333 @@
+#include "stdafx.h"
+#include "InputReplay.hpp"
+#include <Shared/VarInt.hpp>
+#include <Shared/Compression.hpp>
+
+static const char inputReplayMagic[4] = { 'U', 'S', 'C', 'I' };
+
+enum class InputReplayCompression : uint8
+{
+	None = 0,
+	Deflate,
+};
+
+// Frame flags, the upper bits contain the number of events
+enum InputReplayFrameFlags : uint8
+{
+	FrameDeltaTimeChanged = 0x1,
+	FrameLaser0 = 0x2,
+	FrameLaser1 = 0x4,
+	// The number of repeats follows as a varint, since version 2
+	FrameRepeated = 0x8,
+};
+static const uint32 frameEventShift = 4;
+// Event count that indicates that the actual count follows as a varint
+static const uint32 frameEventEscape = 0xff >> frameEventShift;
+// Version 1 had no repeats, the event count started one bit lower
+static const uint32 frameEventShiftV1 = 3;
+
+// Floats are stored as their bits xor'ed with the previous value, similar values only differ in the lower bits
+static uint32 FloatBits(float v)
+{
+	uint32 bits;
+	memcpy(&bits, &v, sizeof(bits));
+	return bits;
+}
+static float BitsFloat(uint32 bits)
+{
+	float v;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+void InputReplay::Clear()
+{
+	frames.clear();
+	events.clear();
+	m_frameEventStart = 0;
+}
+
+void InputReplay::AddEvent(uint8 button, bool pressed)
+{
+	events.push_back({ button, pressed });
+}
+
+void InputReplay::AddFrame(MapTime time, float deltaTime, float laser0, float laser1)
+{
+	if (!frames.empty() && events.size() == m_frameEventStart && laser0 == 0.0f && laser1 == 0.0f)
+	{
+		InputReplayFrame& last = frames.back();
+		if (FloatBits(last.deltaTime) == FloatBits(deltaTime) && time == last.time + (MapTime)last.numRepeats + 1)
+		{
+			last.numRepeats++;
+			return;
+		}
+	}
+
+	InputReplayFrame frame;
+	frame.time = time;
+	frame.deltaTime = deltaTime;
+	frame.laserInput[0] = laser0;
+	frame.laserInput[1] = laser1;
+	frame.firstEvent = m_frameEventStart;
+	frame.numEvents = (uint32)events.size() - m_frameEventStart;
+	frame.numRepeats = 0;
+	m_frameEventStart = (uint32)events.size();
+	frames.push_back(frame);
+}
+
+void InputReplay::Encode(Buffer& out) const
+{
+	out.clear();
+	// Frames without laser input take a few bytes
+	out.reserve(64 + frames.size() * 6 + events.size());
+
+	VarInt::WriteSigned(out, hitWindowPerfect);
+	VarInt::WriteSigned(out, hitWindowGood);
+	VarInt::WriteSigned(out, hitWindowHold);
+	VarInt::WriteSigned(out, hitWindowMiss);
+	VarInt::WriteSigned(out, hitWindowSlam);
+	VarInt::WriteSigned(out, inputOffset);
+	VarInt::WriteSigned(out, laserOffset);
+	VarInt::WriteSigned(out, bounceGuard);
+	VarInt::WriteSigned(out, playbackInitTime);
+	VarInt::WriteSigned(out, playbackStartTime);
+
+	VarInt::Write(out, (uint64)options.gaugeType);
+	VarInt::Write(out, options.gaugeOption);
+	VarInt::Write(out, (options.mirror ? 1 : 0) | (options.random ? 2 : 0) | (options.backupGauge ? 4 : 0));
+	VarInt::Write(out, (uint64)options.autoFlags);
+
+	VarInt::Write(out, score);
+	VarInt::Write(out, perfects);
+	VarInt::Write(out, goods);
+	VarInt::Write(out, misses);
+
+	VarInt::Write(out, frames.size());
+	VarInt::Write(out, events.size());
+
+	MapTime lastTime = 0;
+	uint32 lastDeltaTime = 0;
+	uint32 lastLaser[2] = { 0 };
+	for (const InputReplayFrame& frame : frames)
+	{
+		const uint32 deltaTime = FloatBits(frame.deltaTime);
+		uint8 flags = 0;
+		if (deltaTime != lastDeltaTime)
+			flags |= FrameDeltaTimeChanged;
+		if (frame.laserInput[0] != 0.0f)
+			flags |= FrameLaser0;
+		if (frame.laserInput[1] != 0.0f)
+			flags |= FrameLaser1;
+		if (frame.numRepeats > 0)
+			flags |= FrameRepeated;
+		flags |= Math::Min(frame.numEvents, frameEventEscape) << frameEventShift;
+		out.push_back(flags);
+		if (frame.numEvents >= frameEventEscape)
+			VarInt::Write(out, frame.numEvents - frameEventEscape);
+		if (frame.numRepeats > 0)
+			VarInt::Write(out, frame.numRepeats);
+
+		VarInt::WriteSigned(out, (int64)frame.time - lastTime);
+		lastTime = frame.time;
+
+		if (flags & FrameDeltaTimeChanged)
+		{
+			VarInt::Write(out, deltaTime ^ lastDeltaTime);
+			lastDeltaTime = deltaTime;
+		}
+		for (uint32 i = 0; i < 2; i++)
+		{
+			if (frame.laserInput[i] == 0.0f)
+				continue;
+			const uint32 laser = FloatBits(frame.laserInput[i]);
+			VarInt::Write(out, laser ^ lastLaser[i]);
+			lastLaser[i] = laser;
+		}
+
+		for (uint32 i = 0; i < frame.numEvents; i++)
+		{
+			const InputReplayEvent& e = events[frame.firstEvent + i];
+			out.push_back((e.button & 0x7f) | (e.pressed ? 0x80 : 0));
+		}
+	}
+}
+
+bool InputReplay::Decode(const Buffer& in, uint32 version)
+{
+	Clear();
+	const uint8* data = in.data();
+	const uint8* end = data + in.size();
+
+	int64 signedValues[10];
+	for (int64& v : signedValues)
+	{
+		if (!VarInt::ReadSigned(data, end, v))
+			return false;
+	}
+	hitWindowPerfect = (int32)signedValues[0];
+	hitWindowGood = (int32)signedValues[1];
+	hitWindowHold = (int32)signedValues[2];
+	hitWindowMiss = (int32)signedValues[3];
+	hitWindowSlam = (int32)signedValues[4];
+	inputOffset = (int32)signedValues[5];
+	laserOffset = (int32)signedValues[6];
+	bounceGuard = (int32)signedValues[7];
+	playbackInitTime = (MapTime)signedValues[8];
+	playbackStartTime = (MapTime)signedValues[9];
+
+	uint64 values[10];
+	for (uint64& v : values)
+	{
+		if (!VarInt::Read(data, end, v))
+			return false;
+	}
+	options.gaugeType = (GaugeType)values[0];
+	options.gaugeOption = (uint32)values[1];
+	options.mirror = (values[2] & 1) != 0;
+	options.random = (values[2] & 2) != 0;
+	options.backupGauge = (values[2] & 4) != 0;
+	options.autoFlags = (AutoFlags)values[3];
+	score = (uint32)values[4];
+	perfects = (uint32)values[5];
+	goods = (uint32)values[6];
+	misses = (uint32)values[7];
+
+	// Every frame and event takes at least a byte
+	const uint64 numFrames = values[8];
+	const uint64 numEvents = values[9];
+	if (numFrames > (uint64)(end - data) || numEvents > (uint64)(end - data))
+		return false;
+	frames.resize(numFrames);
+	events.resize(numEvents);
+
+	const uint32 eventShift = version < 2 ? frameEventShiftV1 : frameEventShift;
+	const uint32 eventEscape = 0xff >> eventShift;
+	MapTime lastTime = 0;
+	uint32 lastDeltaTime = 0;
+	uint32 lastLaser[2] = { 0 };
+	uint32 eventIndex = 0;
+	for (InputReplayFrame& frame : frames)
+	{
+		if (data >= end)
+			return false;
+		const uint8 flags = *data++;
+		uint64 value;
+		int64 signedValue;
+
+		frame.numEvents = flags >> eventShift;
+		if (frame.numEvents == eventEscape)
+		{
+			if (!VarInt::Read(data, end, value))
+				return false;
+			frame.numEvents += (uint32)value;
+		}
+		frame.numRepeats = 0;
+		if (version >= 2 && (flags & FrameRepeated))
+		{
+			if (!VarInt::Read(data, end, value))
+				return false;
+			frame.numRepeats = (uint32)value;
+		}
+
+		if (!VarInt::ReadSigned(data, end, signedValue))
+			return false;
+		lastTime += (MapTime)signedValue;
+		frame.time = lastTime;
+
+		if (flags & FrameDeltaTimeChanged)
+		{
+			if (!VarInt::Read(data, end, value))
+				return false;
+			lastDeltaTime ^= (uint32)value;
+		}
+		frame.deltaTime = BitsFloat(lastDeltaTime);
+
+		for (uint32 i = 0; i < 2; i++)
+		{
+			frame.laserInput[i] = 0.0f;
+			if ((flags & (FrameLaser0 << i)) == 0)
+				continue;
+			if (!VarInt::Read(data, end, value))
+				return false;
+			lastLaser[i] ^= (uint32)value;
+			frame.laserInput[i] = BitsFloat(lastLaser[i]);
+		}
+
+		if (frame.numEvents > numEvents - eventIndex || frame.numEvents > (uint64)(end - data))
+			return false;
+		frame.firstEvent = eventIndex;
+		for (uint32 i = 0; i < frame.numEvents; i++)
+		{
+			const uint8 e = *data++;
+			events[eventIndex++] = { (uint8)(e & 0x7f), (e & 0x80) != 0 };
+		}
+	}
+	m_frameEventStart = eventIndex;
+	return eventIndex == numEvents && data == end;
+}
+
+bool InputReplay::Save(BinaryStream& stream, bool compress) const
+{
+	Buffer raw;
+	Encode(raw);
+
+	Buffer compressed;
+	InputReplayCompression compression = InputReplayCompression::None;
+	if (compress && Compression::Deflate(raw, compressed))
+		compression = InputReplayCompression::Deflate;
+	const Buffer& data = compression == InputReplayCompression::None ? raw : compressed;
+
+	uint32 version = Version;
+	uint32 rawSize = (uint32)raw.size();
+	uint32 dataSize = (uint32)data.size();
+	stream.Serialize((void*)inputReplayMagic, sizeof(inputReplayMagic));
+	stream << version;
+	stream << compression;
+	stream << rawSize;
+	stream << dataSize;
+	return stream.Serialize((void*)data.data(), data.size()) == data.size();
+}
+
+bool InputReplay::Load(BinaryStream& stream)
+{
+	char magic[4];
+	if (stream.Serialize(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, inputReplayMagic, sizeof(magic)) != 0)
+		return false;
+
+	uint32 version = 0;
+	InputReplayCompression compression = InputReplayCompression::None;
+	uint32 rawSize = 0;
+	uint32 dataSize = 0;
+	stream << version;
+	stream << compression;
+	stream << rawSize;
+	stream << dataSize;
+	if (version > Version)
+	{
+		Logf("Input replay version %d is newer than the supported version %d", Logger::Severity::Warning, version, Version);
+		return false;
+	}
+	if (dataSize > stream.GetSize() - stream.Tell())
+		return false;
+
+	Buffer data;
+	data.resize(dataSize);
+	if (stream.Serialize(data.data(), dataSize) != dataSize)
+		return false;
+
+	switch (compression)
+	{
+	case InputReplayCompression::None:
+		return Decode(data, version);
+	case InputReplayCompression::Deflate:
+	{
+		Buffer raw;
+		if (!Compression::Inflate(data, raw, rawSize))
+			return false;
+		return Decode(raw, version);
+	}
+	default:
+		return false;
+	}
+}
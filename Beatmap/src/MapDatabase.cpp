@@ -6,6 +6,7 @@
 #include "Shared/Profiling.hpp"
 #include "Shared/Files.hpp"
 #include "Shared/Time.hpp"
+#include "Shared/ObjectArena.hpp"
 #include "KShootMap.hpp"
 #include <thread>
 #include <mutex>
@@ -32,6 +33,7 @@ public:
 	bool m_interruptSearch = false;
 	Set<String> m_searchPaths;
 	Database m_database;
+	String m_databasePath;
 
 	Map<int32, FolderIndex*> m_folders;
 	Map<int32, ChartIndex*> m_charts;
@@ -42,6 +44,11 @@ public:
 	Map<String, FolderIndex*> m_foldersByPath;
 	Multimap<int32, PracticeSetupIndex*> m_practiceSetupsByChartId;
 
+	// Storage for everything loaded by m_LoadInitialData, records added later on are allocated individually
+	ObjectArena<FolderIndex> m_folderArena;
+	ObjectArena<ChartIndex> m_chartArena;
+	ObjectArena<ScoreIndex> m_scoreArena;
+
 	int32 m_nextFolderId = 1;
 	int32 m_nextChartId = 1;
 	int32 m_nextChalId = 1;
@@ -90,16 +97,16 @@ public:
 	List<Event> m_pendingChanges;
 	mutex m_pendingChangesLock;
 
-	static const int32 m_version = 19;
+	static const int32 m_version = 20;
 
 public:
 	MapDatabase_Impl(MapDatabase& outer, bool transferScores) : m_outer(outer)
 	{
 		m_transferScores = transferScores;
-		String databasePath = Path::Absolute("maps.db");
-		if(!m_database.Open(databasePath))
+		m_databasePath = Path::Absolute("maps.db");
+		if(!m_database.Open(m_databasePath))
 		{
-			Logf("Failed to open database [%s]", Logger::Severity::Warning, databasePath);
+			Logf("Failed to open database [%s]", Logger::Severity::Warning, m_databasePath);
 			assert(false);
 		}
 		m_paused.store(false);
@@ -208,21 +215,12 @@ public:
 					}
 
 					String hash;
-					File diffFile;
-					if (diffFile.OpenRead(diffpath))
+					Buffer diffData;
+					if (File::ReadAll(diffpath, diffData))
 					{
-						char data_buffer[0x80];
 						uint32_t digest[5];
 						sha1::SHA1 s;
-
-						size_t amount_read = 0;
-						size_t read_size;
-						do
-						{
-							read_size = diffFile.Read(data_buffer, sizeof(data_buffer));
-							amount_read += read_size;
-							s.processBytes(data_buffer, read_size);
-						} while (read_size != 0);
+						s.processBytes(diffData.data(), diffData.size());
 
 						s.getDigest(digest);
 						hash = Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
@@ -416,6 +414,13 @@ public:
 				m_database.Exec("UPDATE Scores SET window_slam=84");
 				gotVersion = 19;
 			}
+			if (gotVersion == 19)
+			{
+				// Charts that were never played have no offset, like charts added since version 14
+				// a played chart keeps its offset of 0 since the player may have chosen it
+				m_database.Exec("UPDATE Charts SET custom_offset=NULL WHERE custom_offset=0 AND NOT EXISTS(SELECT 1 FROM Scores WHERE Scores.chart_hash=Charts.hash)");
+				gotVersion = 20;
+			}
 			m_database.Exec(Utility::Sprintf("UPDATE Database SET `version`=%d WHERE `rowid`=1", m_version));
 
 			m_outer.OnDatabaseUpdateDone.Call();
@@ -1148,12 +1153,7 @@ public:
 
 				itFolder->second->charts.Remove(itChart->second);
 
-				for (auto s : itChart->second->scores)
-				{
-					delete s;
-				}
-				itChart->second->scores.clear();
-				delete itChart->second;
+				m_DeleteChart(itChart->second);
 				m_charts.erase(e.id);
 
 				// Remove diff in db
@@ -1197,7 +1197,7 @@ public:
 			m_outer.OnFoldersRemoved.Call(eventsArray);
 			for(auto e : eventsArray)
 			{
-				delete e;
+				m_DeleteFolder(e);
 			}
 		}
 		if(!addedChartEvents.empty())
@@ -1398,6 +1398,20 @@ public:
 		m_database.Exec(Utility::Sprintf("UPDATE Charts SET custom_offset=%d WHERE hash LIKE '%s'", chart->custom_offset, *chart->hash));
 	}
 
+	Vector<ChartIndex*> FindChartsWithoutOffset()
+	{
+		Vector<ChartIndex*> charts;
+		// Like the offset computed before the first play, charts that have scores are left alone
+		DBStatement search = m_database.Query("SELECT rowid FROM Charts WHERE custom_offset IS NULL AND NOT EXISTS(SELECT 1 FROM Scores WHERE Scores.chart_hash=Charts.hash)");
+		while (search.StepRow())
+		{
+			ChartIndex** chart = m_charts.Find(search.IntColumn(0));
+			if (chart)
+				charts.Add(*chart);
+		}
+		return charts;
+	}
+
 	void AddOrRemoveToCollection(const String& name, int32 mapid)
 	{
 		DBStatement addColl = m_database.Query("INSERT INTO Collections(folderid,collection) VALUES(?,?)");
@@ -1455,16 +1469,11 @@ private:
 	{
 		for(auto m : m_folders)
 		{
-			delete m.second;
+			m_DeleteFolder(m.second);
 		}
 		for(auto m : m_charts)
 		{
-			for (auto s : m.second->scores)
-			{
-				delete s;
-			}
-			m.second->scores.clear();
-			delete m.second;
+			m_DeleteChart(m.second);
 		}
 		for (auto m : m_practiceSetups)
 		{
@@ -1474,6 +1483,27 @@ private:
 		m_charts.clear();
 		m_practiceSetups.clear();
 		m_practiceSetupsByChartId.clear();
+
+		m_folderArena.Clear();
+		m_chartArena.Clear();
+		m_scoreArena.Clear();
+	}
+	// Arena records stay alive until the next cleanup
+	void m_DeleteFolder(FolderIndex* folder)
+	{
+		if (!m_folderArena.Contains(folder))
+			delete folder;
+	}
+	void m_DeleteChart(ChartIndex* chart)
+	{
+		for (auto s : chart->scores)
+		{
+			if (!m_scoreArena.Contains(s))
+				delete s;
+		}
+		chart->scores.clear();
+		if (!m_chartArena.Contains(chart))
+			delete chart;
 	}
 	void m_CreateTables()
 	{
@@ -1581,11 +1611,15 @@ private:
 		// Scan original maps
 		m_CleanupMapIndex();
 
+		// Scores don't depend on anything else until they are linked to their charts, so they are read on a separate connection while the charts are loaded
+		Vector<ScoreIndex*> scores;
+		thread scoreThread(&MapDatabase_Impl::m_ReadScores, this, std::ref(scores));
+
 		// Select Maps
 		DBStatement mapScan = m_database.Query("SELECT rowid, path FROM Folders");
 		while(mapScan.StepRow())
 		{
-			FolderIndex* folder = new FolderIndex();
+			FolderIndex* folder = m_folderArena.New();
 			folder->id = mapScan.IntColumn(0);
 			folder->path = mapScan.StringColumn(1);
 			folder->selectId = (int32) m_folders.size();
@@ -1619,7 +1653,7 @@ private:
 			"FROM Charts");
 		while(chartScan.StepRow())
 		{
-			ChartIndex* chart = new ChartIndex();
+			ChartIndex* chart = m_chartArena.New();
 			chart->id = chartScan.IntColumn(0);
 			chart->folderId = chartScan.IntColumn(1);
 			chart->path = chartScan.StringColumn(2);
@@ -1646,11 +1680,10 @@ private:
 			m_charts.Add(chart->id, chart);
 			m_chartsByHash.Add(chart->hash, chart);
 
-			// Add difficulty to map and resort difficulties
+			// Add difficulty to map, they are sorted once all charts are loaded
 			auto folderIt = m_folders.find(chart->folderId);
 			assert(folderIt != m_folders.end());
 			folderIt->second->charts.Add(chart);
-			m_SortCharts(folderIt->second);
 
 			// Add to search state
 			SearchState::ExistingFileEntry ed;
@@ -1665,51 +1698,25 @@ private:
 			}
 			m_searchState.difficulties.Add(chart->path, ed);
 		}
-
-		// Select Scores
-		DBStatement scoreScan = m_database.Query("SELECT "
-			"rowid,score,crit,near,miss,gauge,auto_flags,replay,timestamp,chart_hash,user_name,user_id,local_score,window_perfect,window_good,window_hold,window_miss,window_slam,gauge_type,gauge_opt,mirror,random "
-			"FROM Scores");
-		
-		while (scoreScan.StepRow())
+		for (auto& folder : m_folders)
 		{
-			ScoreIndex* score = new ScoreIndex();
-			score->id = scoreScan.IntColumn(0);
-			score->score = scoreScan.IntColumn(1);
-			score->crit = scoreScan.IntColumn(2);
-			score->almost = scoreScan.IntColumn(3);
-			score->miss = scoreScan.IntColumn(4);
-			score->gauge = (float) scoreScan.DoubleColumn(5);
-			score->autoFlags = (AutoFlags)scoreScan.IntColumn(6);
-			score->replayPath = scoreScan.StringColumn(7);
-
-			score->timestamp = scoreScan.Int64Column(8);
-			score->chartHash = scoreScan.StringColumn(9);
-			score->userName = scoreScan.StringColumn(10);
-			score->userId = scoreScan.StringColumn(11);
-			score->localScore = scoreScan.IntColumn(12);
-
-			score->hitWindowPerfect = scoreScan.IntColumn(13);
-			score->hitWindowGood = scoreScan.IntColumn(14);
-			score->hitWindowHold = scoreScan.IntColumn(15);
-			score->hitWindowMiss = scoreScan.IntColumn(16);
-			score->hitWindowSlam = scoreScan.IntColumn(17);
-
-			score->gaugeType = (GaugeType)scoreScan.IntColumn(18);
-			score->gaugeOption = scoreScan.IntColumn(19);
-			score->mirror = scoreScan.IntColumn(20) == 1;
-			score->random = scoreScan.IntColumn(21) == 1;
+			m_SortCharts(folder.second);
+		}
 
-			// Add difficulty to map and resort difficulties
+		// Link the scores read meanwhile
+		scoreThread.join();
+		for (ScoreIndex* score : scores)
+		{
+			// If for whatever reason the diff that the score is attatched to is not in the db, ignore the score.
+			// It stays in the arena until the next cleanup
 			auto diffIt = m_chartsByHash.find(score->chartHash);
-			if (diffIt == m_chartsByHash.end()) // If for whatever reason the diff that the score is attatched to is not in the db, ignore the score.
-			{
-				delete score;
+			if (diffIt == m_chartsByHash.end())
 				continue;
-			}
-
 			diffIt->second->scores.Add(score);
-			m_SortScores(diffIt->second);
+		}
+		for (auto& chart : m_charts)
+		{
+			m_SortScores(chart.second);
 		}
 
 		// Select Practice setups
@@ -1811,6 +1818,50 @@ private:
 
 		m_outer.OnChallengesCleared.Call(m_challenges);
 	}
+	// Reads all scores into the score arena
+	void m_ReadScores(Vector<ScoreIndex*>& scores)
+	{
+		Database database;
+		if (!database.Open(m_databasePath))
+		{
+			Logf("Failed to open database [%s] to read scores", Logger::Severity::Warning, m_databasePath);
+			return;
+		}
+
+		DBStatement scoreScan = database.Query("SELECT "
+			"rowid,score,crit,near,miss,gauge,auto_flags,replay,timestamp,chart_hash,user_name,user_id,local_score,window_perfect,window_good,window_hold,window_miss,window_slam,gauge_type,gauge_opt,mirror,random "
+			"FROM Scores");
+		while (scoreScan.StepRow())
+		{
+			ScoreIndex* score = m_scoreArena.New();
+			score->id = scoreScan.IntColumn(0);
+			score->score = scoreScan.IntColumn(1);
+			score->crit = scoreScan.IntColumn(2);
+			score->almost = scoreScan.IntColumn(3);
+			score->miss = scoreScan.IntColumn(4);
+			score->gauge = (float) scoreScan.DoubleColumn(5);
+			score->autoFlags = (AutoFlags)scoreScan.IntColumn(6);
+			score->replayPath = scoreScan.StringColumn(7);
+
+			score->timestamp = scoreScan.Int64Column(8);
+			score->chartHash = scoreScan.StringColumn(9);
+			score->userName = scoreScan.StringColumn(10);
+			score->userId = scoreScan.StringColumn(11);
+			score->localScore = scoreScan.IntColumn(12);
+
+			score->hitWindowPerfect = scoreScan.IntColumn(13);
+			score->hitWindowGood = scoreScan.IntColumn(14);
+			score->hitWindowHold = scoreScan.IntColumn(15);
+			score->hitWindowMiss = scoreScan.IntColumn(16);
+			score->hitWindowSlam = scoreScan.IntColumn(17);
+
+			score->gaugeType = (GaugeType)scoreScan.IntColumn(18);
+			score->gaugeOption = scoreScan.IntColumn(19);
+			score->mirror = scoreScan.IntColumn(20) == 1;
+			score->random = scoreScan.IntColumn(21) == 1;
+			scores.Add(score);
+		}
+	}
 	void m_SortCharts(FolderIndex* folderIndex)
 	{
 		folderIndex->charts.Sort([](ChartIndex* a, ChartIndex* b)
@@ -1927,11 +1978,13 @@ private:
 				m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Discovered Chart [%s]", f.first));
 				// Try to read map metadata
 				bool mapValid = false;
-				File fileStream;
+				// The chart is parsed and hashed from the same buffer, so it is only read from the disk once
+				//	it isn't mapped because the scanner runs while charts are being edited
+				Buffer chartData;
 				Beatmap map;
-				if(fileStream.OpenRead(f.first))
+				if(File::ReadAll(f.first, chartData))
 				{
-					FileReader reader(fileStream);
+					MappedReader reader(chartData);
 
 					if(map.Load(reader, true))
 					{
@@ -1941,24 +1994,13 @@ private:
 
 				if(mapValid)
 				{
-					fileStream.Seek(0);
 					evt.mapData = new BeatmapSettings(map.GetMapSettings());
 
 					ProfilerScope $("Chart Database - Hash Chart");
-					char data_buffer[0x80];
 					uint32_t digest[5];
 					sha1::SHA1 s;
+					s.processBytes(chartData.data(), chartData.size());
 
-					size_t amount_read = 0;
-					size_t read_size;
-					do
-					{
-						read_size = fileStream.Read(data_buffer, sizeof(data_buffer));
-						amount_read += read_size;
-						s.processBytes(data_buffer, read_size);
-					}
-					while (read_size != 0);
-						
 					s.getDigest(digest);
 
 					evt.hash = Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
@@ -2300,6 +2342,10 @@ void MapDatabase::UpdateChartOffset(const ChartIndex* chart)
 {
 	m_impl->UpdateChartOffset(chart);
 }
+Vector<ChartIndex*> MapDatabase::FindChartsWithoutOffset()
+{
+	return m_impl->FindChartsWithoutOffset();
+}
 void MapDatabase::AddScore(ScoreIndex* score)
 {
 	m_impl->AddScore(score);
@@ -8,6 +8,8 @@
 #include "Shared/Transform.hpp"
 #include "Shared/Files.hpp"
 #include "Shared/Thread.hpp"
+#include "Shared/Jobs.hpp"
+#include "json.hpp"
 #include <atomic>
 #include <mutex>
 
@@ -36,14 +38,29 @@ struct ImageAnimation
 	std::atomic<bool> LoadComplete;
 	std::atomic<bool> Cancelled;
 	std::mutex LoadMutex;
-	Vector<Graphics::Image> Frames;
-	Vector<Buffer> FrameData; //for storing the file contents of the compressed frames
-	Image CurrentImage; //the current uncompressed frame in use
-	Image NextImage;
-	Thread* JobThread;
+	Vector<Graphics::Image> Frames; //decoded frames, only the frames in the prefetch window are kept when streaming
+	Vector<Buffer> FrameData; //for storing the file contents of the frames
+	Map<int, Job> DecodeJobs; //frames that are being decoded
+	size_t DecodedBytes = 0;
+	// Only the prefetch window is decoded, set once the memory budget is exceeded, only used on the main thread
+	bool Streaming = false;
+	Job LoadJob;
+	//sprite sheet animations keep the whole sheet decoded and copy the current frame out of it
+	Image Sheet;
+	int SheetColumns = 0;
+	Image CurrentImage;
+	bool SheetUploaded = false;
 	lua_State* State;
 };
 
+// Number of frames ahead of the current frame that are decoded when streaming an animation
+static const int AnimationPrefetchFrames = 8;
+// Decoded frames of all animations combined, uncompressed animations start streaming once this is exceeded
+static const size_t AnimationMemoryBudget = 256 * 1024 * 1024;
+// Streaming animations only decode all their frames again when that keeps the memory use below this
+static const size_t AnimationMemoryLowWatermark = AnimationMemoryBudget / 4 * 3;
+static std::atomic<size_t> g_animationMemory(0);
+
 struct GUIState
 {
 	NVGcontext* vg;
@@ -70,6 +87,8 @@ struct GUIState
 	int scissorOffset;
 	Vector<Transform> transformStack;
 	Vector<int> nvgFonts;
+	// Maps images given to lua to the current nanovg image, jackets get a new image when they are loaded again after being evicted
+	int (*resolveImage)(int image) = nullptr;
 };
 
 
@@ -77,6 +96,11 @@ struct GUIState
 
 GUIState g_guiState;
 
+static int ResolveImage(int image)
+{
+	return g_guiState.resolveImage ? g_guiState.resolveImage(image) : image;
+}
+
 static int LoadFont(const char* name, const char* filename, lua_State* L)
 {
 	{
@@ -128,65 +152,158 @@ static int lBeginPath(lua_State* L)
 }
 
 
-static void AnimationLoader(Vector<FileInfo> files, Ref<ImageAnimation> ia)
+// Reads the frame files or the sprite sheet of an animation
+class AnimationLoadJob : public JobBase
 {
-	ia->FrameCount = files.size();
-	files.Sort([](FileInfo& a, FileInfo& b) {
-		String af, bf;
-		Path::RemoveLast(a.fullPath, &af);
-		Path::RemoveLast(b.fullPath, &bf);
-		return af.compare(bf) < 0;
-	});
-	ia->Timer = 0;
-
-	if (ia->Compressed.load())
+public:
+	bool Run() override
 	{
-		for (int i = 0; i < ia->FrameCount; i++)
+		if (!sheetPath.empty())
 		{
-			if (ia->Cancelled.load())
-				break;
-			File newImage;
-			if (newImage.OpenRead(files[i].fullPath)) {
+			ia->Sheet = ImageRes::Create(sheetPath);
+			if (!ia->Sheet)
+				return false;
+			ia->SheetColumns = Math::Max(1, ia->Sheet->GetSize().x / ia->w);
+			ia->FrameCount = Math::Min(ia->FrameCount, ia->SheetColumns * (ia->Sheet->GetSize().y / ia->h));
+			if (ia->FrameCount <= 0)
+				return false;
+			ia->DecodedBytes = ia->Sheet->GetSize().x * ia->Sheet->GetSize().y * sizeof(Colori);
+			g_animationMemory += ia->DecodedBytes;
+			ia->CurrentImage = ImageRes::Create(Vector2i(ia->w, ia->h));
+		}
+		else
+		{
+			for (const FileInfo& file : files)
+			{
+				if (ia->Cancelled.load())
+					return false;
+				File newImage;
 				Buffer newData;
-				newData.resize(newImage.GetSize());
-				newImage.Read(newData.data(), newImage.GetSize());
+				if (newImage.OpenRead(file.fullPath))
+				{
+					newData.resize(newImage.GetSize());
+					newImage.Read(newData.data(), newImage.GetSize());
+				}
 				ia->FrameData.push_back(std::move(newData));
 			}
+			ia->Frames.resize(ia->FrameCount);
 		}
-		ia->NextImage = ImageRes::Create(ia->FrameData[0]);
+		ia->LoadComplete.store(true);
+		return true;
 	}
-	else {
-		for (int i = 0; i < ia->FrameCount; i++)
-		{
-			if (ia->Cancelled.load())
-				break;
-			ia->Frames.Add(Graphics::ImageRes::Create(files[i].fullPath));
-		}
+
+	Ref<ImageAnimation> ia;
+	Vector<FileInfo> files;
+	String sheetPath;
+};
+
+// Decodes a single frame of an animation on the job sheduler
+class AnimationDecodeJob : public JobBase
+{
+public:
+	bool Run() override
+	{
+		if (ia->Cancelled.load())
+			return false;
+		Image image = ImageRes::Create(ia->FrameData[frame]);
+		if (!image || image->GetSize().x != ia->w || image->GetSize().y != ia->h)
+			return false;
+
+		ia->LoadMutex.lock();
+		ia->Frames[frame] = image;
+		ia->DecodedBytes += ia->w * ia->h * sizeof(Colori);
+		ia->LoadMutex.unlock();
+		g_animationMemory += ia->w * ia->h * sizeof(Colori);
+		return true;
 	}
-	ia->LoadComplete.store(true);
 
+	Ref<ImageAnimation> ia;
+	int frame;
+};
 
-	if (ia->Compressed.load())
+// Queues decoding of the frames after the current one and frees the frames that are no longer needed
+//	uncompressed animations keep all their frames as long as the memory budget allows it
+static void UpdateAnimationFrames(Ref<ImageAnimation> ia)
+{
+	if (ia->Sheet)
+		return;
+
+	for (auto it = ia->DecodeJobs.begin(); it != ia->DecodeJobs.end();)
+	{
+		if (it->second->IsFinished())
+			it = ia->DecodeJobs.erase(it);
+		else
+			++it;
+	}
+
+	const size_t frameBytes = ia->w * ia->h * sizeof(Colori);
+	const int current = ia->CurrentFrame;
+
+	ia->LoadMutex.lock();
+	// Switching back needs room for all frames below the low watermark,
+	//	otherwise an animation around the budget would keep freeing and decoding all its frames
+	if (!ia->Streaming)
+		ia->Streaming = ia->Compressed.load() || g_animationMemory.load() > AnimationMemoryBudget;
+	else if (!ia->Compressed.load() && g_animationMemory.load() + ia->FrameCount * frameBytes - ia->DecodedBytes < AnimationMemoryLowWatermark)
+		ia->Streaming = false;
+	const int window = Math::Min(ia->Streaming ? AnimationPrefetchFrames : ia->FrameCount - 1, ia->FrameCount - 1);
+
+	if (ia->Streaming)
 	{
-		std::chrono::microseconds sleepDuration((uint32)(250000.f * ia->SecondsPerFrame));
-		int currentFrame = -1;
-		while (!ia->Cancelled.load())
+		for (int i = 0; i < ia->FrameCount; i++)
 		{
-			if (ia->CurrentFrame != currentFrame)
-			{
-				currentFrame = ia->CurrentFrame;
-				int nextFrame = (currentFrame + 1) % ia->FrameCount;
-				Image nextImage = ImageRes::Create(ia->FrameData[nextFrame]);
-				ia->LoadMutex.lock();
-				ia->NextImage = nextImage;
-				ia->LoadMutex.unlock();
-			}
-			else 
+			int distance = (i - current + ia->FrameCount) % ia->FrameCount;
+			if (distance > window && ia->Frames[i])
 			{
-				std::this_thread::sleep_for(sleepDuration);
+				ia->Frames[i].reset();
+				ia->DecodedBytes -= frameBytes;
+				g_animationMemory -= frameBytes;
 			}
 		}
 	}
+	for (int i = 1; i <= window; i++)
+	{
+		int frame = (current + i) % ia->FrameCount;
+		if (ia->Frames[frame] || ia->DecodeJobs.Contains(frame) || ia->FrameData[frame].empty())
+			continue;
+		// Always keep the next frame coming when over budget
+		if (i > 1 && g_animationMemory.load() + frameBytes > AnimationMemoryBudget)
+			break;
+
+		AnimationDecodeJob* job = new AnimationDecodeJob();
+		job->ia = ia;
+		job->frame = frame;
+		Job decodeJob = Job(job);
+		ia->DecodeJobs.Add(frame, decodeJob);
+		g_jobSheduler->Queue(decodeJob);
+	}
+	ia->LoadMutex.unlock();
+}
+
+// Copies a frame out of the sprite sheet into the image that is uploaded
+static void CopySheetFrame(Ref<ImageAnimation> ia, int frame)
+{
+	const int sheetWidth = ia->Sheet->GetSize().x;
+	const Colori* src = ia->Sheet->GetBits() + (frame / ia->SheetColumns) * ia->h * sheetWidth + (frame % ia->SheetColumns) * ia->w;
+	Colori* dst = ia->CurrentImage->GetBits();
+	for (int y = 0; y < ia->h; y++)
+		memcpy(dst + y * ia->w, src + y * sheetWidth, ia->w * sizeof(Colori));
+}
+
+static void FreeAnimation(Ref<ImageAnimation> ia)
+{
+	ia->Cancelled.store(true);
+	if (ia->LoadJob)
+		ia->LoadJob->Terminate();
+	for (auto& job : ia->DecodeJobs)
+		job.second->Terminate();
+	ia->DecodeJobs.clear();
+
+	g_animationMemory -= ia->DecodedBytes;
+	ia->DecodedBytes = 0;
+	ia->Frames.clear();
+	ia->FrameData.clear();
+	ia->Sheet.reset();
 }
 
 static int lTickAnimation(lua_State* L)
@@ -206,11 +323,38 @@ static int lTickAnimation(lua_State* L)
 	if (ia->Cancelled.load())
 		return 0;
 
+	// The texture of a sprite sheet is created before the sheet is loaded
+	if (ia->Sheet && !ia->SheetUploaded)
+	{
+		CopySheetFrame(ia, ia->CurrentFrame);
+		nvgUpdateImage(g_guiState.vg, key, (unsigned char*)ia->CurrentImage->GetBits());
+		ia->SheetUploaded = true;
+	}
+
+	UpdateAnimationFrames(ia);
+
 	ia->Timer += deltatime;
 	if (ia->Timer >= ia->SecondsPerFrame)
 	{
 		if (ia->LoopCounter < ia->TimesToLoop || ia->TimesToLoop == 0)
 		{
+			int nextFrame = (ia->CurrentFrame + 1) % ia->FrameCount;
+			Image nextImage;
+			if (ia->Sheet)
+			{
+				CopySheetFrame(ia, nextFrame);
+				nextImage = ia->CurrentImage;
+			}
+			else
+			{
+				ia->LoadMutex.lock();
+				nextImage = ia->Frames[nextFrame];
+				ia->LoadMutex.unlock();
+			}
+			// Hold the current frame until the next one is decoded
+			if (!nextImage)
+				return 0;
+
 			ia->Timer = fmodf(ia->Timer, ia->SecondsPerFrame);
 
 			if (ia->CurrentFrame == ia->FrameCount - 1)
@@ -219,39 +363,92 @@ static int lTickAnimation(lua_State* L)
 			if (ia->LoopCounter == ia->TimesToLoop && ia->LoopCounter != 0)
 				return 0;
 
-			ia->CurrentFrame = (ia->CurrentFrame + 1) % ia->FrameCount;
-			if (ia->Compressed.load())
-			{
-				ia->LoadMutex.lock();
-				ia->CurrentImage = ia->NextImage;
-				ia->LoadMutex.unlock();
-				nvgUpdateImage(g_guiState.vg, key, (unsigned char*)ia->CurrentImage->GetBits());
-			}
-			else 
-			{
-				nvgUpdateImage(g_guiState.vg, key, (unsigned char*)ia->Frames[ia->CurrentFrame]->GetBits());
-			}
+			ia->CurrentFrame = nextFrame;
+			nvgUpdateImage(g_guiState.vg, key, (unsigned char*)nextImage->GetBits());
 		}
 	}
 	return 0;
 }
 
-static int LoadAnimation(lua_State* L, const char* path, float frametime, int loopcount, bool compressed)
+// Loads a sprite sheet animation, the layout is read from a json file next to the image:
+//	{ "frameWidth": 256, "frameHeight": 256, "frameCount": 30 }
+//	frames are stored left to right, top to bottom, frameCount defaults to all the frames that fit in the sheet
+static int LoadSheetAnimation(lua_State* L, const char* path, Ref<ImageAnimation> ia)
 {
-	Vector<FileInfo> files = Files::ScanFiles(path);
-	if (files.empty())
+	String layoutPath = Path::ReplaceExtension(path, "json");
+	File layoutFile;
+	if (!layoutFile.OpenRead(layoutPath))
+		return -1;
+	String layoutText;
+	layoutText.resize(layoutFile.GetSize());
+	layoutFile.Read(&layoutText.front(), layoutText.size());
+
+	nlohmann::json layout = nlohmann::json::parse(layoutText, nullptr, false);
+	if (layout.is_discarded() || !layout.is_object())
 		return -1;
+	ia->w = layout.value("frameWidth", 0);
+	ia->h = layout.value("frameHeight", 0);
+	ia->FrameCount = layout.value("frameCount", INT32_MAX);
+	if (ia->w <= 0 || ia->h <= 0)
+		return -1;
+
+	AnimationLoadJob* job = new AnimationLoadJob();
+	job->ia = ia;
+	job->sheetPath = path;
+	job->jobFlags = JobFlags::IO;
+	ia->LoadJob = Job(job);
 
-	int key = nvgCreateImage(g_guiState.vg, *files[0].fullPath, 0);
+	// Transparent until the first frame is uploaded once the sheet is loaded
+	Vector<uint8> blank(ia->w * ia->h * 4, 0);
+	return nvgCreateImageRGBA(g_guiState.vg, ia->w, ia->h, 0, blank.data());
+}
+
+static int LoadAnimation(lua_State* L, const char* path, float frametime, int loopcount, bool compressed)
+{
 	Ref<ImageAnimation> ia = std::make_shared<ImageAnimation>();
 	ia->Compressed = compressed;
 	ia->TimesToLoop = loopcount;
 	ia->LoopCounter = 0;
+	ia->CurrentFrame = 0;
 	ia->SecondsPerFrame = frametime;
+	ia->Timer = 0;
 	ia->LoadComplete.store(false);
 	ia->Cancelled.store(false);
 	ia->State = L;
-	ia->JobThread = new Thread(AnimationLoader, files, ia);
+
+	int key;
+	if (Path::IsDirectory(path))
+	{
+		Vector<FileInfo> files = Files::ScanFiles(path);
+		if (files.empty())
+			return -1;
+		files.Sort([](FileInfo& a, FileInfo& b) {
+			String af, bf;
+			Path::RemoveLast(a.fullPath, &af);
+			Path::RemoveLast(b.fullPath, &bf);
+			return af.compare(bf) < 0;
+		});
+
+		key = nvgCreateImage(g_guiState.vg, *files[0].fullPath, 0);
+		if (key == 0)
+			return -1;
+		nvgImageSize(g_guiState.vg, key, &ia->w, &ia->h);
+		ia->FrameCount = files.size();
+
+		AnimationLoadJob* job = new AnimationLoadJob();
+		job->ia = ia;
+		job->files = files;
+		job->jobFlags = JobFlags::IO;
+		ia->LoadJob = Job(job);
+	}
+	else
+	{
+		key = LoadSheetAnimation(L, path, ia);
+		if (key <= 0)
+			return -1;
+	}
+
+	g_jobSheduler->Queue(ia->LoadJob);
 	g_guiState.animations.insert(std::make_pair(key, ia));
 
 	return key;
@@ -405,7 +602,7 @@ static int lCreateImage(lua_State* L /*const char* filename, int imageflags */)
 }
 static int lImagePatternFill(lua_State* L /*int image, float alpha*/)
 {
-	int image = luaL_checkinteger(L, 1);
+	int image = ResolveImage(luaL_checkinteger(L, 1));
 	float alpha = luaL_checknumber(L, 2);
 	int w, h;
 	nvgImageSize(g_guiState.vg, image, &w, &h);
@@ -436,7 +633,7 @@ static int lImageRect(lua_State* L /*float x, float y, float w, float h, int ima
 	y = luaL_checknumber(L, 2);
 	w = luaL_checknumber(L, 3);
 	h = luaL_checknumber(L, 4);
-	image = luaL_checkinteger(L, 5);
+	image = ResolveImage(luaL_checkinteger(L, 5));
 	alpha = luaL_checknumber(L, 6);
 	angle = luaL_checknumber(L, 7);
 
@@ -856,7 +1053,7 @@ static int lImagePattern(lua_State* L /* float ox, float oy, float ex, float ey,
 	float ex = luaL_checknumber(L, 3);
 	float ey = luaL_checknumber(L, 4);
 	float angle = luaL_checknumber(L, 5);
-	int image = luaL_checkinteger(L, 6);
+	int image = ResolveImage(luaL_checkinteger(L, 6));
 	float alpha = luaL_checknumber(L, 7);
 	NVGpaint paint = nvgImagePattern(g_guiState.vg, ox, oy, ex, ey, angle, image, alpha);
 	g_guiState.paintCache[L].Add(g_guiState.nextPaintId[L], paint);
@@ -1023,7 +1220,7 @@ static int lFastTextSize(lua_State* L /* char* text */)
 }
 static int lImageSize(lua_State* L /*int image*/)
 {
-		int image = luaL_checkinteger(L, 1);
+		int image = ResolveImage(luaL_checkinteger(L, 1));
 		int w,h;
 		nvgImageSize(g_guiState.vg, image, &w, &h);
 		lua_pushnumber(L,w);
@@ -1050,14 +1247,8 @@ static int DisposeGUI(lua_State* state)
 		if (anim.second->State != state)
 			continue;
 
-		anim.second->Cancelled.store(true);
-
-		if(anim.second->JobThread && anim.second->JobThread->joinable())
-			anim.second->JobThread->join();
-		anim.second->Frames.clear();
-		anim.second->FrameData.clear();
+		FreeAnimation(anim.second);
 		keysToDelete.Add(anim.first);
-		delete anim.second->JobThread;
 		nvgDeleteImage(g_guiState.vg, anim.first);
 	}
 	for (int k : keysToDelete)
@@ -1,5 +1,6 @@
 #pragma once
 #include <Graphics/ResourceTypes.hpp>
+#include <Graphics/VertexFormat.hpp>
 
 #ifdef None
 #undef None
@@ -9,18 +10,43 @@ namespace Graphics
 {
 	/*
 		A prerendered text object, contains all the vertices and texture sheets to draw itself
+		the vertices are rebuilt transparently when glyphs it uses got evicted from the font's atlas
 	*/
 	class TextRes
 	{
 		friend class Font_Impl;
-		struct FontSize* fontSize;
-		Ref<class MeshRes> mesh;
+		friend class TextCache;
+		friend class TextBatch;
 	public:
+		struct Vertex : public VertexFormat<Vector2, Vector2>
+		{
+			Vertex(Vector2 point, Vector2 uv) : pos(point), tex(uv) {}
+			Vector2 pos;
+			Vector2 tex;
+		};
+
 		~TextRes();
 		Ref<class TextureRes> GetTexture();
-		Ref<class MeshRes> GetMesh() { return mesh; }
+		// The mesh is only uploaded when requested, texts that are only drawn through a TextBatch never create one
+		Ref<class MeshRes> GetMesh();
+		const Vector<Vertex>& GetVertices();
 		void Draw();
 		Vector2 size;
+
+	private:
+		void m_Refresh();
+
+		class Font_Impl* m_font = nullptr;
+		WString m_str;
+		uint32 m_fontSize = 0;
+		uint32 m_options = 0;
+		// Atlas shelves the glyphs are on and the version of each shelf the vertices were laid out for
+		Vector<std::pair<uint32, uint32>> m_shelves;
+		// Frame in which some glyphs didn't fit into the atlas, the text is laid out again in a later frame
+		uint64 m_missingFrame = 0;
+		bool m_meshDirty = true;
+		Vector<Vertex> m_vertices;
+		Ref<class MeshRes> m_mesh;
 	};
 
 	/*
@@ -33,6 +59,9 @@ namespace Graphics
 		static Ref<FontRes> Create(class OpenGL* gl, const String& assetPath);
 		static bool InitLibrary();
 		static void FreeLibrary();
+		// Starts the next frame, call once per frame after rendering
+		//	glyphs used in the current frame are never evicted from the font atlases
+		static void EndFrame();
 	public:
 		// Text rendering options
 		enum TextOptions
@@ -51,5 +80,32 @@ namespace Graphics
 	typedef Ref<FontRes> Font;
 	typedef Ref<TextRes> Text;
 
+	/*
+		Combines text objects created by the same font into a single mesh so they are drawn with one draw call
+		all the texts in a batch share the material parameters they are drawn with (e.g. color)
+	*/
+	class TextBatch : public Unique
+	{
+	public:
+		TextBatch(class OpenGL* gl);
+		void Add(Text text, const Transform& transform);
+		void Clear();
+		size_t GetTextCount() const { return m_texts.size(); }
+
+		// Builds the combined mesh, vertices are already in world space
+		Ref<class MeshRes> GetMesh();
+		Ref<class TextureRes> GetTexture();
+
+	private:
+		void m_Build();
+
+		class OpenGL* m_gl;
+		Vector<std::pair<Text, Transform>> m_texts;
+		Vector<TextRes::Vertex> m_vertices;
+		Ref<class MeshRes> m_mesh;
+		Ref<class TextureRes> m_texture;
+		bool m_dirty = false;
+	};
+
 	DEFINE_RESOURCE_TYPE(Font, FontRes)
 }
@@ -14,9 +14,14 @@ namespace Graphics
 		static Ref<ImageRes> Create(const String& assetPath);
 		static Ref<ImageRes> Create(Vector2i size = Vector2i());
 		static Ref<ImageRes> Create(Buffer& b);
+		// Loads an image that is going to be shrunk to fit in the given size,
+		//	the decoder may skip detail (e.g. JPEG DCT scaling) as long as the image stays at least this large
+		static Ref<ImageRes> Create(const String& assetPath, Vector2i sizeHint);
+		static Ref<ImageRes> Create(Buffer& b, Vector2i sizeHint);
 		static Ref<ImageRes> Screenshot(class OpenGL* gl, Vector2i size = Vector2i(), Vector2i pos = Vector2i());
 	public:
 		virtual void SetSize(Vector2i size) = 0;
+		// Scales the image, shrinking averages the covered area of the source
 		virtual void ReSize(Vector2i size) = 0;
 		virtual Vector2i GetSize() const = 0;
 		virtual Colori* GetBits() = 0;
@@ -12,7 +12,10 @@ namespace Graphics
 	class ImageLoader
 	{
 	public:
-		static bool Load(ImageRes* outPtr, const String& fullPath);
-		static bool Load(ImageRes* outPtr, Buffer& b);
+		// A non-zero size hint allows decoding at a reduced size that still covers the hint
+		static bool Load(ImageRes* outPtr, const String& fullPath, Vector2i sizeHint = Vector2i());
+		static bool Load(ImageRes* outPtr, Buffer& b, Vector2i sizeHint = Vector2i());
+		// Decodes an image from memory that isn't owned by a buffer, e.g. a mapped file
+		static bool Load(ImageRes* outPtr, const uint8* data, size_t size, Vector2i sizeHint = Vector2i());
 	};
 }
\ No newline at end of file
@@ -41,6 +41,11 @@ namespace Graphics
 		virtual void Draw() = 0;
 		// Draws the mesh after if has already been drawn once, reuse of bound objects
 		virtual void Redraw() = 0;
+		// Same as Draw/Redraw but only draws vertexCount vertices starting at firstVertex
+		virtual void DrawRange(size_t firstVertex, size_t vertexCount) = 0;
+		virtual void RedrawRange(size_t firstVertex, size_t vertexCount) = 0;
+		// Static meshes are uploaded once and never changed afterwards
+		virtual void SetStatic(bool isStatic) = 0;
 
 	private:
 		virtual void SetData(const void* pData, size_t vertexCount, const VertexFormatList& desc) = 0;
@@ -31,6 +31,9 @@ namespace Graphics
 		Transform worldTransform; 
 		// Scissor rectangle
 		Rect scissorRect;
+		// Range of vertices to draw, the whole mesh if vertexCount is 0
+		size_t firstVertex = 0;
+		size_t vertexCount = 0;
 	};
 
 	// Command for points/lines with size/width parameter
@@ -63,7 +66,11 @@ namespace Graphics
 		// Clears all the render commands in the queue
 		void Clear();
 		void Draw(Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
+		// Draws a range of vertices from a mesh, used to draw parts of large static meshes
+		void DrawRange(Transform worldTransform, Mesh m, size_t firstVertex, size_t vertexCount, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 		void Draw(Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
+		// Draws all the texts in a batch with a single draw call
+		void Draw(Transform worldTransform, TextBatch& batch, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 		void DrawScissored(Rect scissor, Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 		void DrawScissored(Rect scissor, Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params = MaterialParameterSet());
 
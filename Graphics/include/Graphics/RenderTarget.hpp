@@ -0,0 +1,60 @@
+#pragma once
+#include <Graphics/ResourceTypes.hpp>
+#include <Graphics/Texture.hpp>
+
+namespace Graphics
+{
+	/*
+		Offscreen framebuffer with a colour texture that shaders can sample directly, instead of copying the default framebuffer
+		targets have a stencil buffer like the default framebuffer so nanovg can render into them
+		multisampled targets render into renderbuffers which are resolved into the colour texture when it is used
+	*/
+	class RenderTargetRes
+	{
+	public:
+		virtual ~RenderTargetRes() = default;
+		// The sample count is limited to what the driver supports, 0 for no multisampling
+		static Ref<RenderTargetRes> Create(class OpenGL* gl, Vector2i size, uint32 samples = 0);
+		// Renders into the default framebuffer again
+		static void Unbind(class OpenGL* gl);
+	public:
+		// Renders into this target and sets the viewport to its size
+		virtual void Bind() = 0;
+		// Clears colour and stencil of the bound target
+		virtual void Clear(const Color& color = Color(0.0f, 0.0f, 0.0f, 0.0f)) = 0;
+		// Resolves multisampled rendering into the colour texture, only does work if the target was rendered into since the last resolve
+		virtual void Resolve() = 0;
+		// Colour texture with everything rendered into the target so far
+		virtual Ref<class TextureRes> GetTexture() = 0;
+		// Draws the colour texture over a viewport of the bound framebuffer, scaled with linear filtering and without blending
+		virtual void Draw(const Shared::Recti& viewport) = 0;
+
+		virtual const Vector2i& GetSize() const = 0;
+		virtual uint32 GetSamples() const = 0;
+		virtual uint32 Handle() = 0;
+	};
+
+	typedef Ref<RenderTargetRes> RenderTarget;
+
+	DEFINE_RESOURCE_TYPE(RenderTarget, RenderTargetRes)
+
+	/*
+		Two render targets of the same size for chains of full screen passes
+		each pass samples the target the previous one rendered into and renders into the other one
+	*/
+	class RenderTargetPair
+	{
+	public:
+		bool Create(class OpenGL* gl, Vector2i size, uint32 samples = 0);
+
+		// Target the next pass renders into
+		const RenderTarget& GetWrite() const { return m_targets[m_write]; }
+		// Target the previous pass rendered into
+		const RenderTarget& GetRead() const { return m_targets[m_write ^ 1]; }
+		void Swap() { m_write ^= 1; }
+
+	private:
+		RenderTarget m_targets[2];
+		uint32 m_write = 0;
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <Graphics/RenderTarget.hpp>
+
+namespace Graphics
+{
+	/*
+		Plans the offscreen render targets of a frame from a list of passes, each pass renders into one target and samples others
+
+		Compile works out the size of every target and which targets can share memory:
+		targets whose contents are no longer needed are reused by later targets of the same size,
+		and a pass that samples the target it renders into gets a second target to ping-pong with.
+		Compiling doesn't need a GPU, the render targets are only created by CreateTargets
+	*/
+	class RenderTargetGraph
+	{
+	public:
+		// The default framebuffer, passes can render into it but not sample it
+		static const uint32 Screen = 0;
+
+		struct Target
+		{
+			String name;
+			// Size relative to the screen
+			float scale;
+			uint32 samples;
+		};
+		struct Pass
+		{
+			String name;
+			uint32 output;
+			Vector<uint32> inputs;
+		};
+
+		// Render target shared by targets that are not used at the same time
+		struct PhysicalTarget
+		{
+			Vector2i size;
+			uint32 samples;
+		};
+		struct CompiledPass
+		{
+			// Indices of physical targets, -1 for the screen
+			int32 output;
+			Vector<int32> inputs;
+			// Set for the first pass that renders into a target, the target is cleared before it
+			bool clear;
+		};
+
+		RenderTargetGraph();
+
+		// Removes all targets and passes
+		void Reset();
+		uint32 AddTarget(const String& name, float scale = 1.0f, uint32 samples = 0);
+		// Passes run in the order they were added in
+		uint32 AddPass(const String& name, uint32 output, const Vector<uint32>& inputs = Vector<uint32>());
+
+		// Returns false when a pass samples the screen or a target nothing rendered into before it
+		bool Compile(Vector2i screenSize);
+		bool IsCompiled() const { return m_compiled; }
+
+		const Vector<Target>& GetTargets() const { return m_targets; }
+		const Vector<Pass>& GetPasses() const { return m_passes; }
+		const Vector<PhysicalTarget>& GetPhysicalTargets() const { return m_physicalTargets; }
+		const Vector<CompiledPass>& GetCompiledPasses() const { return m_compiledPasses; }
+		const Vector2i& GetScreenSize() const { return m_screenSize; }
+
+		// Creates the render targets of the compiled graph
+		bool CreateTargets(class OpenGL* gl);
+		// Renders into the output of a pass, clearing it for the first pass that renders into it
+		//	passes that render into the screen use the given viewport
+		void BeginPass(class OpenGL* gl, uint32 pass, const Shared::Recti& screenViewport);
+		// Target sampled by the current pass, in the order the inputs were given to AddPass
+		const RenderTarget& GetInput(uint32 index) const;
+		// Renders into the screen again
+		void EndFrame(class OpenGL* gl, const Shared::Recti& screenViewport);
+
+	private:
+		Vector<Target> m_targets;
+		Vector<Pass> m_passes;
+
+		bool m_compiled = false;
+		Vector2i m_screenSize;
+		Vector<PhysicalTarget> m_physicalTargets;
+		Vector<CompiledPass> m_compiledPasses;
+
+		Vector<RenderTarget> m_renderTargets;
+		uint32 m_currentPass = 0;
+	};
+}
@@ -20,6 +20,7 @@ template<> struct ResourceManagerTypes<ResourceType::_EnumMember>\
 		Shader,
 		Material,
 		ParticleSystem,
+		RenderTarget,
 		_Length
 	};
 
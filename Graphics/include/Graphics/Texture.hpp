@@ -31,6 +31,8 @@ namespace Graphics
 	public:
 		virtual void Init(Vector2i size, TextureFormat format = TextureFormat::RGBA8) = 0;
 		virtual void SetData(Vector2i size, void* pData) = 0;
+		// Updates a region of an already initialized RGBA8 texture
+		virtual void SetSubData(Vector2i pos, Vector2i size, void* pData) = 0;
 		virtual void SetFromFrameBuffer(Vector2i pos = { 0, 0 }) = 0;
 		virtual void SetMipmaps(bool enabled) = 0;
 		virtual void SetFilter(bool enabled, bool mipFiltering = true, float anisotropic = 1.0f) = 0;
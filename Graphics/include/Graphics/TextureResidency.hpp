@@ -0,0 +1,92 @@
+#pragma once
+#include <Shared/Shared.hpp>
+#include <functional>
+#include <list>
+
+namespace Graphics
+{
+	struct TextureResidencyStats
+	{
+		size_t budget = 0;
+		// Bytes of the resident reloadable textures
+		size_t residentBytes = 0;
+		// Bytes of textures that can't be evicted, these count against the budget too
+		size_t pinnedBytes = 0;
+		size_t peakBytes = 0;
+		uint32 numTextures = 0;
+		uint32 numResident = 0;
+		// Totals since the manager was created
+		uint64 numEvicted = 0;
+		uint64 evictedBytes = 0;
+		uint64 numReloaded = 0;
+		// Textures evicted during the last frame
+		uint32 frameEvicted = 0;
+	};
+
+	/*
+		Tracks the memory used by textures and evicts the least recently used ones once the total goes over a budget
+		Only textures that can be loaded again are evicted. Their owner is told through the callback given when the texture was added,
+		it frees the texture and loads it again the next time Touch reports that it isn't resident.
+		Textures used during the current frame are never evicted, so a single frame that uses more than the budget can go over it
+
+		Doesn't create or delete any textures itself, only used from the main thread
+	*/
+	class TextureResidency : public Unique
+	{
+	public:
+		typedef std::function<void()> EvictFunction;
+
+		// Adds a texture that is not resident yet, returns a non-zero id
+		//	textures without an evict function are never evicted, the function must not add or remove textures
+		uint32 Add(EvictFunction evict = EvictFunction());
+		// Removes a texture, its evict function is not called
+		void Remove(uint32 id);
+		// Called by the owner once the texture is created or loaded again after it was evicted
+		//	other textures are evicted right away if this goes over the budget
+		void SetResident(uint32 id, size_t bytes);
+
+		// Marks a texture as used in this frame, returns false when it isn't resident
+		bool Touch(uint32 id);
+		bool IsResident(uint32 id) const;
+
+		// Evicts textures until the total is within the budget and starts the next frame, call once per frame after rendering
+		void EndFrame();
+
+		void SetBudget(size_t bytes);
+		size_t GetBudget() const { return m_stats.budget; }
+		// Memory of textures that are managed elsewhere, e.g. skin textures held by the resource managers
+		void SetExternalBytes(size_t bytes);
+		const TextureResidencyStats& GetStats() const { return m_stats; }
+
+		// Memory used by a texture of the given size, mipmaps add a third
+		static size_t GetTextureBytes(Vector2i size, bool mipmaps = false, uint32 bytesPerPixel = 4);
+
+	private:
+		struct Entry
+		{
+			EvictFunction evict;
+			size_t bytes = 0;
+			uint64 lastFrame = 0;
+			bool resident = false;
+			bool evicted = false;
+			// Position in the usage order, only valid for resident reloadable textures
+			std::list<uint32>::iterator usage;
+		};
+
+		// Removes the memory of a resident texture from the totals
+		void m_Release(Entry& entry);
+		void m_Evict(Entry& entry);
+		// Evicts the least recently used textures that weren't used in this frame until the total is within the budget
+		void m_EvictOverBudget();
+
+		Map<uint32, Entry> m_entries;
+		// Resident reloadable textures, the most recently used one is in front
+		std::list<uint32> m_usage;
+		size_t m_externalBytes = 0;
+		size_t m_residentPinnedBytes = 0;
+		uint64 m_frame = 1;
+		uint32 m_numFrameEvicted = 0;
+		uint32 m_nextId = 1;
+		TextureResidencyStats m_stats;
+	};
+}
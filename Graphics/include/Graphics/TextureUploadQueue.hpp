@@ -0,0 +1,70 @@
+#pragma once
+#include <Graphics/ResourceTypes.hpp>
+
+namespace Graphics
+{
+	/*
+		A single image that is being uploaded by a TextureUploadQueue
+	*/
+	class TextureUpload : public Unique
+	{
+		friend class TextureUploadQueue;
+	public:
+		TextureUpload(Ref<class ImageRes> image);
+
+		bool IsFinished() const { return m_finished; }
+		const Vector2i& GetSize() const { return m_size; }
+
+		// Takes ownership of the uploaded OpenGL texture, only valid after the upload finished
+		//	the texture is RGBA8 with linear filtering and clamped edges
+		uint32 Release();
+
+	private:
+		Ref<class ImageRes> m_image;
+		Vector2i m_size;
+		uint32 m_texture = 0;
+		int32 m_rowsUploaded = 0;
+		bool m_finished = false;
+	};
+
+	/*
+		Uploads images to textures spread out over multiple frames
+		pixels are staged in pixel buffer objects so the transfers to the textures don't block the main thread
+		and the amount of bytes uploaded per frame is limited so many images finishing at once don't cause a hitch
+	*/
+	class TextureUploadQueue : public Unique
+	{
+	public:
+		TextureUploadQueue(class OpenGL* gl);
+		~TextureUploadQueue();
+
+		// Queues an image for uploading, the image data should not be modified until the upload is finished
+		Ref<TextureUpload> Queue(Ref<class ImageRes> image);
+
+		// Uploads the next part of the queue, call once per frame from the OpenGL thread
+		//	uploads that are no longer referenced outside the queue are cancelled
+		void Update();
+
+		size_t GetPendingBytes() const;
+		size_t GetPendingCount() const { return m_uploads.size(); }
+
+		// Maximum amount of pixel data uploaded in a single Update, at least one row is always uploaded
+		size_t maxBytesPerFrame = 2 * 1024 * 1024;
+
+	private:
+		struct Chunk
+		{
+			TextureUpload* upload;
+			int32 row;
+			int32 numRows;
+			size_t offset;
+		};
+
+		class OpenGL* m_gl;
+		Vector<Ref<TextureUpload>> m_uploads;
+		Vector<Chunk> m_chunks;
+		// Buffers are cycled so writing a new frame's data doesn't wait on transfers that are still in flight
+		uint32 m_pixelBuffers[3] = { 0 };
+		uint32 m_currentBuffer = 0;
+	};
+}
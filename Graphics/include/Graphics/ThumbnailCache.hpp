@@ -0,0 +1,73 @@
+#pragma once
+#include <Graphics/Image.hpp>
+#include <Shared/File.hpp>
+#include <Shared/Thread.hpp>
+
+namespace Graphics
+{
+	/*
+		Persistent cache of downscaled images (e.g. song jackets)
+		Thumbnails are stored as RGBA8 pixels in a single pack file, records are read with explicit reads instead of a mapping since the pack is truncated and replaced while it is in use,
+		entries are keyed by the source path and the requested size and are invalidated when the source's last write time changes
+
+		Can be used from multiple threads
+	*/
+	class ThumbnailCache : public Unique
+	{
+	public:
+		~ThumbnailCache();
+
+		// Opens or creates the pack file, returns false if the cache can't be used
+		bool Open(const String& packPath);
+		void Close();
+		bool IsOpen() const;
+
+		// Returns the thumbnail of an image that fits within the given size
+		//	on a cache miss the image is loaded, scaled down and stored
+		Image Load(const String& imagePath, Vector2i size);
+
+		// Returns the cached thumbnail if it exists and is up to date
+		Image Find(const String& imagePath, uint64 lastWriteTime, Vector2i size);
+		void Store(const String& imagePath, uint64 lastWriteTime, Vector2i size, Image thumbnail);
+
+		size_t GetNumEntries() const;
+		size_t GetPackSize() const;
+
+		// When a thumbnail doesn't fit in the pack anymore, the records of thumbnails that were stored again are dropped
+		//	the pack is cleared instead if the remaining records would still fill most of it
+		void SetMaxPackSize(size_t bytes);
+		static const size_t defaultMaxPackSize = 512 * 1024 * 1024;
+
+	private:
+		struct Entry
+		{
+			String path;
+			Vector2i requestedSize;
+			size_t pixelOffset;
+			uint64 lastWriteTime;
+			Vector2i size;
+		};
+
+		bool m_ScanPack();
+		bool m_CreatePack();
+		// Makes room for a record of the given size by compacting or clearing the pack
+		void m_MakeRoom(size_t recordSize);
+		bool m_Compact();
+		// Reopens the writer and the reader after the pack file was replaced
+		void m_OpenWriter();
+		bool m_ReadPixels(const Entry& entry, uint8* out);
+		static bool m_WriteRecord(File& file, const Entry& entry, const uint8* pixels);
+		static String m_Key(const String& imagePath, Vector2i size);
+
+		String m_packPath;
+		File m_reader;
+		File m_writer;
+		size_t m_packSize = 0;
+		size_t m_maxPackSize = defaultMaxPackSize;
+		// False after a failed write couldn't be undone, thumbnails are still read but no longer stored
+		bool m_writable = false;
+		Map<String, Entry> m_entries;
+		mutable Mutex m_lock;
+		bool m_open = false;
+	};
+}
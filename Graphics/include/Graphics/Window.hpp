@@ -110,6 +110,10 @@ namespace Graphics
 
 		ModifierKeys GetModifierKeys() const;
 
+		// Time of the event that is being handled, or of the last one outside of the event handlers
+		//	in milliseconds since SDL_GetTicks started counting
+		uint32 GetEventTime() const;
+
 		// Start allowing text input
 		void StartTextInput();
 		// Stop allowing text input
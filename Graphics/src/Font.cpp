@@ -7,6 +7,7 @@
 #include "OpenGL.hpp"
 #include <Shared/Timer.hpp>
 #include <Shared/Profiling.hpp>
+#include <unordered_map>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -16,53 +17,325 @@ namespace Graphics
 	using Shared::Margin;
 	using Shared::Recti;
 
+	// The atlas starts at the initial size and doubles until it reaches the maximum size,
+	//	after that the least recently used shelves get evicted
+	static const int32 atlasInitialSize = 256;
+	static const int32 atlasMaxSize = 2048;
+	// Shelf heights are rounded up to this, so glyphs of similar heights (and sizes) share shelves
+	static const int32 shelfGranularity = 4;
+	// Empty space between glyphs to prevent bleeding
+	static const int32 glyphPadding = 1;
+	// Duration after which unused text runs are dropped from the cache
+	static const float textCacheDuration = 1.0f;
+
+	// Incremented by FontRes::EndFrame, atlas shelves used in the current frame are never evicted
+	static uint64 fontFrame = 1;
+
+	/*
+		Glyph atlas shared by all the sizes of a font
+		glyphs are packed into full-width shelves, only the changed rows are uploaded to the texture
+	*/
+	class GlyphAtlas
+	{
+		struct Shelf
+		{
+			int32 y;
+			int32 height;
+			int32 usedX = 0;
+			uint64 lastUsage = 0;
+			// Incremented every time the shelf is cleared, texts laid out for an older version are laid out again
+			uint32 version = 0;
+			// Keys of the glyphs stored on this shelf
+			Vector<uint64> glyphs;
+		};
+
+		OpenGL* m_gl;
+		Image m_image;
+		Texture m_texture;
+		Vector<Shelf> m_shelves;
+		int32 m_usedY = 0;
+		// Row range that needs to be uploaded
+		int32 m_dirtyBegin = 0;
+		int32 m_dirtyEnd = 0;
+		bool m_resized = true;
+
+	public:
+		static const uint32 invalidShelf = -1;
+
+		GlyphAtlas(OpenGL* gl) : m_gl(gl)
+		{
+			m_image = ImageRes::Create(Vector2i(atlasInitialSize));
+			memset(m_image->GetBits(), 0, atlasInitialSize * atlasInitialSize * sizeof(Colori));
+		}
+
+		// Reserves space for a glyph, keys of glyphs that were evicted to make space are added to evicted
+		//	shelves that were used in the given frame are never evicted
+		bool Allocate(Vector2i size, uint64 key, uint64 frame, Recti& outCoords, uint32& outShelf, Vector<uint64>& evicted)
+		{
+			int32 shelfHeight = ((size.y + glyphPadding + shelfGranularity - 1) / shelfGranularity) * shelfGranularity;
+			int32 width = size.x + glyphPadding;
+			if(width > atlasMaxSize || shelfHeight > atlasMaxSize)
+				return false;
+
+			uint32 shelfIndex = m_FindShelf(width, shelfHeight);
+			while(shelfIndex == invalidShelf)
+			{
+				// Open a new shelf
+				if(m_usedY + shelfHeight <= m_image->GetSize().y)
+				{
+					shelfIndex = (uint32)m_shelves.size();
+					Shelf& shelf = m_shelves.Add();
+					shelf.y = m_usedY;
+					shelf.height = shelfHeight;
+					m_usedY += shelfHeight;
+				}
+				else if(m_image->GetSize().y < atlasMaxSize)
+				{
+					m_Grow();
+				}
+				else
+				{
+					shelfIndex = m_Evict(shelfHeight, frame, evicted);
+					if(shelfIndex == invalidShelf)
+						return false;
+				}
+			}
+
+			Shelf& shelf = m_shelves[shelfIndex];
+			outCoords = Recti(Vector2i(shelf.usedX, shelf.y), size);
+			outShelf = shelfIndex;
+			shelf.usedX += width;
+			shelf.lastUsage = frame;
+			shelf.glyphs.Add(key);
+			return true;
+		}
+
+		void Touch(uint32 shelf, uint64 frame)
+		{
+			if(shelf != invalidShelf)
+				m_shelves[shelf].lastUsage = frame;
+		}
+
+		// Marks the shelves a text was laid out with as used, returns false if one of them was cleared since
+		bool Touch(const Vector<std::pair<uint32, uint32>>& shelves, uint64 frame)
+		{
+			for(const auto& shelf : shelves)
+			{
+				if(m_shelves[shelf.first].version != shelf.second)
+					return false;
+			}
+			for(const auto& shelf : shelves)
+				m_shelves[shelf.first].lastUsage = frame;
+			return true;
+		}
+
+		uint32 GetVersion(uint32 shelf) const
+		{
+			return m_shelves[shelf].version;
+		}
+
+		// Copies an 8-bit coverage bitmap into the atlas
+		void Blit(const Recti& coords, const uint8* src, int32 pitch)
+		{
+			const int32 atlasWidth = m_image->GetSize().x;
+			for(int32 y = 0; y < coords.size.y; y++)
+			{
+				Colori* pDst = m_image->GetBits() + coords.pos.x + (coords.pos.y + y) * atlasWidth;
+				const uint8* pSrc = src + y * pitch;
+				for(int32 x = 0; x < coords.size.x; x++)
+				{
+					pDst[x] = Colori(255, 255, 255, pSrc[x]);
+				}
+			}
+			m_MarkDirty(coords.pos.y, coords.pos.y + coords.size.y);
+		}
+
+		Texture GetTexture()
+		{
+			if(m_resized)
+			{
+				m_texture = TextureRes::Create(m_gl, m_image);
+				m_texture->SetWrap(TextureWrap::Clamp, TextureWrap::Clamp);
+				m_resized = false;
+			}
+			else if(m_dirtyEnd > m_dirtyBegin)
+			{
+				const int32 atlasWidth = m_image->GetSize().x;
+				m_texture->SetSubData(Vector2i(0, m_dirtyBegin), Vector2i(atlasWidth, m_dirtyEnd - m_dirtyBegin),
+					m_image->GetBits() + m_dirtyBegin * atlasWidth);
+			}
+			m_dirtyBegin = m_dirtyEnd = 0;
+			return m_texture;
+		}
+
+	private:
+		// Finds the shelf with the least wasted height that has room for the given size
+		uint32 m_FindShelf(int32 width, int32 shelfHeight)
+		{
+			uint32 best = invalidShelf;
+			const int32 atlasWidth = m_image->GetSize().x;
+			for(uint32 i = 0; i < m_shelves.size(); i++)
+			{
+				const Shelf& shelf = m_shelves[i];
+				if(shelf.height < shelfHeight || shelf.height > shelfHeight + shelfHeight / 4 + shelfGranularity)
+					continue;
+				if(atlasWidth - shelf.usedX < width)
+					continue;
+				if(best == invalidShelf || shelf.height < m_shelves[best].height)
+					best = i;
+			}
+			return best;
+		}
+
+		// Doubles the size of the atlas, existing shelves keep their position and gain horizontal space
+		void m_Grow()
+		{
+			Vector2i oldSize = m_image->GetSize();
+			Vector2i newSize = oldSize * 2;
+			Image newImage = ImageRes::Create(newSize);
+			memset(newImage->GetBits(), 0, newSize.x * newSize.y * sizeof(Colori));
+			for(int32 y = 0; y < oldSize.y; y++)
+			{
+				memcpy(newImage->GetBits() + y * newSize.x, m_image->GetBits() + y * oldSize.x, oldSize.x * sizeof(Colori));
+			}
+			m_image = newImage;
+			m_resized = true;
+		}
+
+		// Clears the least recently used shelf that can hold glyphs of the given height and wasn't used in the given frame
+		uint32 m_Evict(int32 shelfHeight, uint64 frame, Vector<uint64>& evicted)
+		{
+			uint32 lru = invalidShelf;
+			for(uint32 i = 0; i < m_shelves.size(); i++)
+			{
+				const Shelf& shelf = m_shelves[i];
+				if(shelf.height < shelfHeight || shelf.lastUsage == frame)
+					continue;
+				if(lru == invalidShelf || shelf.lastUsage < m_shelves[lru].lastUsage)
+					lru = i;
+			}
+			if(lru == invalidShelf)
+				return invalidShelf;
+
+			Shelf& shelf = m_shelves[lru];
+			for(uint64 key : shelf.glyphs)
+				evicted.Add(key);
+			shelf.glyphs.clear();
+			shelf.usedX = 0;
+			shelf.version++;
+			return lru;
+		}
+
+		void m_MarkDirty(int32 begin, int32 end)
+		{
+			if(m_dirtyEnd <= m_dirtyBegin)
+			{
+				m_dirtyBegin = begin;
+				m_dirtyEnd = end;
+				return;
+			}
+			m_dirtyBegin = Math::Min(m_dirtyBegin, begin);
+			m_dirtyEnd = Math::Max(m_dirtyEnd, end);
+		}
+	};
+
 	struct CachedText
 	{
+		WString str;
+		uint32 fontSize;
+		uint32 options;
 		Text text;
 		float lastUsage;
 	};
 	// Prevents continuous recreation of text that doesn't change
-	class TextCache : public Map<WString, CachedText>
+	//	runs are looked up by a hash of their contents, expired runs are swept at most once per cache duration
+	class TextCache
 	{
+		std::unordered_map<uint64, CachedText> m_entries;
+		// Meshes of expired texts that nothing else referenced, reused for new texts
+		Vector<Mesh> m_freeMeshes;
 		Timer timer;
+		float m_lastSweep = 0.0f;
+
 	public:
+		static uint64 Hash(const WString& str, uint32 fontSize, uint32 options)
+		{
+			// FNV-1a
+			uint64 hash = 14695981039346656037ULL;
+			auto feed = [&](uint32 v)
+			{
+				hash ^= v;
+				hash *= 1099511628211ULL;
+			};
+			feed(fontSize);
+			feed(options);
+			for(wchar_t c : str)
+				feed((uint32)c);
+			return hash;
+		}
+
 		void Update()
 		{
 			float currentTime = timer.SecondsAsFloat();
-			for(auto it = begin(); it != end();)
+			if(currentTime - m_lastSweep < textCacheDuration)
+				return;
+			m_lastSweep = currentTime;
+
+			for(auto it = m_entries.begin(); it != m_entries.end();)
 			{
 				float durationSinceUsed = currentTime - it->second.lastUsage;
-				if(durationSinceUsed > 1.0f)
+				if(durationSinceUsed > textCacheDuration)
 				{
-					it = erase(it);
+					m_Recycle(it->second.text);
+					it = m_entries.erase(it);
 					continue;
 				}
 				it++;
 			}
 		}
-		Text GetText(const WString& key)
+		Text GetText(uint64 hash, const WString& str, uint32 fontSize, uint32 options)
 		{
-			auto it = find(key);
-			if(it != end())
+			auto it = m_entries.find(hash);
+			if(it != m_entries.end() && it->second.fontSize == fontSize && it->second.options == options && it->second.str == str)
 			{
 				it->second.lastUsage = timer.SecondsAsFloat();
 				return it->second.text;
 			}
 			return Text();
 		}
-		void AddText(const WString& key, Text obj)
+		void AddText(uint64 hash, const WString& str, uint32 fontSize, uint32 options, Text obj)
 		{
 			Update();
-			Add(key, { obj, timer.SecondsAsFloat() });
+			CachedText& entry = m_entries[hash];
+			if(entry.text)
+				m_Recycle(entry.text);
+			entry = { str, fontSize, options, obj, timer.SecondsAsFloat() };
+		}
+		Mesh AcquireMesh()
+		{
+			if(m_freeMeshes.empty())
+				return Mesh();
+			Mesh mesh = m_freeMeshes.back();
+			m_freeMeshes.pop_back();
+			return mesh;
+		}
+		void Clear()
+		{
+			m_entries.clear();
+			m_freeMeshes.clear();
+		}
+
+	private:
+		void m_Recycle(Text& text)
+		{
+			if(text.use_count() == 1 && text->m_mesh && m_freeMeshes.size() < 64)
+				m_freeMeshes.Add(text->m_mesh);
 		}
 	};
 
 	FT_Library library;
 	class Font_Impl;
 
-	using Utility::Reinterpret;
-	using VectorMath::VectorBase;
-
 	FT_Face fallbackFont;
 	uint32 fallbackFontSize = 0;
 	Buffer loadedFallbackFont;
@@ -74,105 +347,24 @@ namespace Graphics
 		int32 leftOffset;
 		int32 topOffset;
 		Recti coords;
+		uint32 shelf = GlyphAtlas::invalidShelf;
+		// Frame in which the glyph didn't fit into the atlas, it is added again in a later frame
+		uint64 missingFrame = 0;
 	};
 	struct FontSize
 	{
-		SpriteMap spriteMap;
-		Texture textureMap;
-		FT_Face face;
-		Vector<CharInfo> infos;
-		Map<wchar_t, uint32> infoByChar;
-		bool bUpdated = false;
+		Map<wchar_t, CharInfo> infos;
 		float lineHeight;
-		TextCache cache;
 
-		FontSize(OpenGL* gl, FT_Face& face)
-			: face(face), m_gl(gl)
+		FontSize(FT_Face& face)
 		{
-			spriteMap = SpriteMapRes::Create();
-			textureMap = TextureRes::Create(m_gl);
 			lineHeight = (float)face->size->metrics.height / 64.0f;
 		}
-		~FontSize()
-		{
-		}
-
-		const CharInfo& GetCharInfo(wchar_t t)
-		{
-			auto it = infoByChar.find(t);
-			if(it == infoByChar.end())
-				return AddCharInfo(t);
-			return infos[it->second];
-		}
-		Texture GetTextureMap()
-		{
-			if(bUpdated)
-			{
-				textureMap = spriteMap->GenerateTexture(m_gl);
-				bUpdated = false;
-			}
-			return textureMap;
-		}
-	private:
-		const CharInfo& AddCharInfo(wchar_t t)
-		{
-			bUpdated = true;
-			infoByChar.Add(t, (uint32)infos.size());
-			infos.emplace_back();
-			CharInfo& ci = infos.back();
-
-			FT_Face* pFace = &face;
-
-			ci.glyphID = FT_Get_Char_Index(*pFace, t);
-			if(ci.glyphID == 0)
-			{
-				pFace = &fallbackFont;
-				ci.glyphID = FT_Get_Char_Index(*pFace, t);
-			}
-			FT_Load_Glyph(*pFace, ci.glyphID, FT_LOAD_DEFAULT);
-
-			if((*pFace)->glyph->format != FT_GLYPH_FORMAT_BITMAP)
-			{
-				FT_Render_Glyph((*pFace)->glyph, FT_RENDER_MODE_NORMAL);
-			}
-
-			ci.topOffset = (*pFace)->glyph->bitmap_top;
-			ci.leftOffset = (*pFace)->glyph->bitmap_left;
-			ci.advance = (float)(*pFace)->glyph->advance.x / 64.0f;
-
-			Image img = ImageRes::Create(Vector2i((*pFace)->glyph->bitmap.width, (*pFace)->glyph->bitmap.rows));
-			Colori* pDst = img->GetBits();
-			uint8* pSrc = (*pFace)->glyph->bitmap.buffer;
-			uint32 nLen = (*pFace)->glyph->bitmap.width * (*pFace)->glyph->bitmap.rows;
-			for(uint32 i = 0; i < nLen; i++)
-			{
-				pDst[0].w = pSrc[0];
-				Reinterpret<VectorBase<uint8, 3>>(pDst[0]) = VectorBase<uint8, 3>(255, 255, 255);
-				pSrc++;
-				pDst++;
-			}
-			uint32 nIndex = spriteMap->AddSegment(img);
-			ci.coords = spriteMap->GetCoords(nIndex);
-
-			return ci;
-		}
-
-		OpenGL* m_gl;
 	};
 
-
-	TextRes::~TextRes()
-	{
-	}
-
-	Ref<class TextureRes> TextRes::GetTexture()
-	{
-		return fontSize->GetTextureMap();
-	}
-	void TextRes::Draw()
+	static uint64 GlyphKey(uint32 fontSize, wchar_t c)
 	{
-		GetTexture()->Bind();
-		mesh->Draw();
+		return ((uint64)fontSize << 32) | (uint32)c;
 	}
 
 	class Font_Impl : public FontRes
@@ -184,15 +376,20 @@ namespace Graphics
 		Map<uint32, FontSize*> m_sizes;
 		uint32 m_currentSize = 0;
 
+		GlyphAtlas m_atlas;
+		TextCache m_cache;
+		Vector<uint64> m_evicted;
 
 		friend class TextRes;
+		friend class TextBatch;
 	public:
-		Font_Impl(class OpenGL* gl) : m_gl(gl) , m_face(nullptr)
+		Font_Impl(class OpenGL* gl) : m_gl(gl) , m_face(nullptr), m_atlas(gl)
 		{
 
 		}
 		~Font_Impl()
 		{
+			m_cache.Clear();
 			for(auto s : m_sizes)
 			{
 				delete s.second;
@@ -242,35 +439,80 @@ namespace Graphics
 			if(it != m_sizes.end())
 				return it->second;
 
-			FontSize* pMap = new FontSize(m_gl, m_face);
+			FontSize* pMap = new FontSize(m_face);
 			m_sizes.Add(nSize, pMap);
 			return pMap;
 		}
-		Ref<TextRes> CreateText(const WString& str, uint32 nFontSize, TextOptions options)
+
+		const CharInfo& GetCharInfo(FontSize* size, uint32 nSize, wchar_t t)
 		{
-			FontSize* size = GetSize(nFontSize);
+			auto it = size->infos.find(t);
+			if(it == size->infos.end() || (it->second.missingFrame != 0 && it->second.missingFrame != fontFrame))
+				return AddCharInfo(size, nSize, t);
+			m_atlas.Touch(it->second.shelf, fontFrame);
+			return it->second;
+		}
 
-			Text cachedText = size->cache.GetText(str);
-			if(cachedText)
-				return cachedText;
+		Texture GetTexture()
+		{
+			return m_atlas.GetTexture();
+		}
 
-			struct TextVertex : public VertexFormat<Vector2, Vector2>
+		Ref<TextRes> CreateText(const WString& str, uint32 nFontSize, TextOptions options) override
+		{
+			uint64 hash = TextCache::Hash(str, nFontSize, options);
+			Text cachedText = m_cache.GetText(hash, str, nFontSize, options);
+			if(cachedText)
 			{
-				TextVertex(Vector2 point, Vector2 uv) : pos(point), tex(uv) {}
-				Vector2 pos;
-				Vector2 tex;
-			};
+				// Keeps the glyphs of the text in the atlas until it is drawn
+				Refresh(*cachedText);
+				return cachedText;
+			}
 
 			TextRes* ret = new TextRes();
-			ret->mesh = MeshRes::Create(m_gl);
+			ret->m_font = this;
+			ret->m_str = str;
+			ret->m_fontSize = nFontSize;
+			ret->m_options = options;
+			ret->m_mesh = m_cache.AcquireMesh();
+			Layout(*ret);
 
-			float monospaceWidth = size->GetCharInfo(L'_').advance;
+			Text textObj = Utility::MakeRef(ret);
+			// Insert into cache
+			m_cache.AddText(hash, str, nFontSize, options, textObj);
+			return textObj;
+		}
+
+		// Lays a text out again if one of its glyphs was evicted or didn't fit in an earlier frame
+		//	otherwise marks its glyphs as used in this frame
+		void Refresh(TextRes& text)
+		{
+			const bool missingGlyphs = text.m_missingFrame != 0 && text.m_missingFrame != fontFrame;
+			if(missingGlyphs || !m_atlas.Touch(text.m_shelves, fontFrame))
+				Layout(text);
+		}
+
+		// Generates the vertices of a text object
+		void Layout(TextRes& text)
+		{
+			FontSize* size = GetSize(text.m_fontSize);
+			const float nFontSize = (float)text.m_fontSize;
+			const bool monospace = (text.m_options & TextOptions::Monospace) != 0;
+
+			Vector<TextRes::Vertex>& vertices = text.m_vertices;
+			vertices.clear();
+			vertices.reserve(text.m_str.size() * 6);
+			text.size = Vector2();
+			text.m_shelves.clear();
+			text.m_missingFrame = 0;
+
+			float monospaceWidth = GetCharInfo(size, text.m_fontSize, L'_').advance;
 
-			Vector<TextVertex> vertices;
 			Vector2 pen;
-			for(wchar_t c : str)
+			for(wchar_t c : text.m_str)
 			{
-				const CharInfo& info = size->GetCharInfo(c);
+				const CharInfo& info = GetCharInfo(size, text.m_fontSize, c);
+				m_AddShelf(text, info);
 
 				if(c != L'\n' && c != L'\t' && info.coords.size.x != 0 && info.coords.size.y != 0)
 				{
@@ -283,7 +525,7 @@ namespace Graphics
 					Vector2 offset = Vector2(pen.x, pen.y);
 					offset.x += info.leftOffset;
 					offset.y += nFontSize - info.topOffset;
-					if((options & TextOptions::Monospace) != 0)
+					if(monospace)
 					{
 						offset.x += (monospaceWidth - info.coords.size.x) * 0.5f;
 					}
@@ -309,38 +551,198 @@ namespace Graphics
 				{
 					pen.x = 0.0f;
 					pen.y += size->lineHeight;
-					ret->size.y = pen.y;
+					text.size.y = pen.y;
 				}
 				else if(c == L'\t')
 				{
-					const CharInfo& space = size->GetCharInfo(L' ');
+					const CharInfo& space = GetCharInfo(size, text.m_fontSize, L' ');
+					m_AddShelf(text, space);
 					pen.x += space.advance * 3.0f;
 				}
 				else
 				{
-					if((options & TextOptions::Monospace) != 0)
+					if(monospace)
 					{
 						pen.x += monospaceWidth;
 					}
 					else
 						pen.x += info.advance;
 				}
-				ret->size.x = std::max(ret->size.x, pen.x);
+				text.size.x = std::max(text.size.x, pen.x);
 			}
 
-			ret->size.y += size->lineHeight;
+			text.size.y += size->lineHeight;
+			text.m_meshDirty = true;
+		}
 
-			ret->fontSize = size;
-			ret->mesh->SetData(vertices);
-			ret->mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+	private:
+		// Remembers the atlas shelf a glyph of a text is on, so the text notices when the shelf gets cleared
+		void m_AddShelf(TextRes& text, const CharInfo& info)
+		{
+			if(info.missingFrame != 0)
+				text.m_missingFrame = info.missingFrame;
+			if(info.shelf == GlyphAtlas::invalidShelf)
+				return;
+			for(const auto& shelf : text.m_shelves)
+			{
+				if(shelf.first == info.shelf)
+					return;
+			}
+			text.m_shelves.Add(std::make_pair(info.shelf, m_atlas.GetVersion(info.shelf)));
+		}
 
-			Text textObj = Utility::MakeRef(ret);
-			// Insert into cache
-			size->cache.AddText(str, textObj);
-			return textObj;
+		const CharInfo& AddCharInfo(FontSize* size, uint32 nSize, wchar_t t)
+		{
+			CharInfo& ci = size->infos[t];
+
+			FT_Face* pFace = &m_face;
+
+			ci.glyphID = FT_Get_Char_Index(*pFace, t);
+			if(ci.glyphID == 0)
+			{
+				pFace = &fallbackFont;
+				ci.glyphID = FT_Get_Char_Index(*pFace, t);
+			}
+			FT_Load_Glyph(*pFace, ci.glyphID, FT_LOAD_DEFAULT);
+
+			if((*pFace)->glyph->format != FT_GLYPH_FORMAT_BITMAP)
+			{
+				FT_Render_Glyph((*pFace)->glyph, FT_RENDER_MODE_NORMAL);
+			}
+
+			const FT_Bitmap& bitmap = (*pFace)->glyph->bitmap;
+			ci.topOffset = (*pFace)->glyph->bitmap_top;
+			ci.leftOffset = (*pFace)->glyph->bitmap_left;
+			ci.advance = (float)(*pFace)->glyph->advance.x / 64.0f;
+			ci.coords = Recti();
+			ci.shelf = GlyphAtlas::invalidShelf;
+			ci.missingFrame = 0;
+
+			Vector2i glyphSize = Vector2i(bitmap.width, bitmap.rows);
+			if(glyphSize.x == 0 || glyphSize.y == 0)
+				return ci;
+
+			m_evicted.clear();
+			if(!m_atlas.Allocate(glyphSize, GlyphKey(nSize, t), fontFrame, ci.coords, ci.shelf, m_evicted))
+			{
+				Logf("Glyph atlas is full, can't add character %d", Logger::Severity::Warning, (int32)t);
+				ci.coords = Recti();
+				ci.missingFrame = fontFrame;
+				return ci;
+			}
+			m_atlas.Blit(ci.coords, bitmap.buffer, bitmap.pitch);
+
+			// Forget about glyphs that were evicted to make space, they get rendered again on next use
+			for(uint64 key : m_evicted)
+			{
+				FontSize** evictedSize = m_sizes.Find((uint32)(key >> 32));
+				if(evictedSize)
+					(*evictedSize)->infos.erase((wchar_t)(key & 0xFFFFFFFF));
+			}
+
+			return ci;
 		}
 	};
 
+	TextRes::~TextRes()
+	{
+	}
+
+	void TextRes::m_Refresh()
+	{
+		if(m_font)
+			m_font->Refresh(*this);
+	}
+	Ref<class TextureRes> TextRes::GetTexture()
+	{
+		m_Refresh();
+		return m_font->GetTexture();
+	}
+	Ref<class MeshRes> TextRes::GetMesh()
+	{
+		m_Refresh();
+		if(!m_mesh)
+		{
+			m_mesh = MeshRes::Create(m_font->m_gl);
+			m_mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+			m_meshDirty = true;
+		}
+		if(m_meshDirty)
+		{
+			m_mesh->SetData(m_vertices);
+			m_mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+			m_meshDirty = false;
+		}
+		return m_mesh;
+	}
+	const Vector<TextRes::Vertex>& TextRes::GetVertices()
+	{
+		m_Refresh();
+		return m_vertices;
+	}
+	void TextRes::Draw()
+	{
+		Mesh mesh = GetMesh();
+		GetTexture()->Bind();
+		mesh->Draw();
+	}
+
+	TextBatch::TextBatch(OpenGL* gl) : m_gl(gl)
+	{
+	}
+	void TextBatch::Add(Text text, const Transform& transform)
+	{
+		assert(m_texts.empty() || m_texts.front().first->m_font == text->m_font);
+		m_texts.Add(std::make_pair(text, transform));
+		m_dirty = true;
+	}
+	void TextBatch::Clear()
+	{
+		m_texts.clear();
+		m_vertices.clear();
+		m_dirty = true;
+	}
+	void TextBatch::m_Build()
+	{
+		m_vertices.clear();
+		if(m_texts.empty())
+			return;
+
+		// Texts added before are marked as used in this frame, laying out later texts can't evict their glyphs
+		Font_Impl* font = m_texts.front().first->m_font;
+		for(auto& entry : m_texts)
+		{
+			const Vector<TextRes::Vertex>& vertices = entry.first->GetVertices();
+			for(const TextRes::Vertex& v : vertices)
+			{
+				Vector3 pos = entry.second.TransformPoint(Vector3(v.pos.x, v.pos.y, 0.0f));
+				m_vertices.emplace_back(Vector2(pos.x, pos.y), v.tex);
+			}
+		}
+
+		m_texture = font->GetTexture();
+	}
+	Ref<class MeshRes> TextBatch::GetMesh()
+	{
+		if(m_dirty)
+		{
+			m_Build();
+			if(!m_mesh)
+			{
+				m_mesh = MeshRes::Create(m_gl);
+				m_mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+			}
+			m_mesh->SetData(m_vertices);
+			m_dirty = false;
+		}
+		return m_mesh;
+	}
+	Ref<class TextureRes> TextBatch::GetTexture()
+	{
+		GetMesh();
+		return m_texture;
+	}
+
 	Font FontRes::Create(OpenGL* gl, const String& assetPath)
 	{
 		Font_Impl* pImpl = new Font_Impl(gl);
@@ -355,6 +757,11 @@ namespace Graphics
 		}
 	}
 
+	void FontRes::EndFrame()
+	{
+		fontFrame++;
+	}
+
 	bool FontRes::InitLibrary()
 	{
 		ProfilerScope $("Font library initialization");
@@ -386,4 +793,4 @@ namespace Graphics
 		return FT_New_Memory_Face(library, loadedFallbackFont.data(), (uint32)loadedFallbackFont.size(), 0, &fallbackFont) == 0
 				&& FT_Select_Charmap(fallbackFont, FT_ENCODING_UNICODE) == 0;
 	}
-}
\ No newline at end of file
+}
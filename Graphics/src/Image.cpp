@@ -10,8 +10,169 @@
 #include "png.h"
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USC_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Graphics
 {
+	/*
+		Separable area averaging (box) filter for downscaling RGBA8 images
+		source rows are read once in order, each one is scaled horizontally and accumulated into the output rows it covers
+	*/
+	class ImageScaler
+	{
+		// Source pixels (and their weights) that contribute to each output pixel along one axis
+		struct Contributions
+		{
+			Vector<int32> first;
+			Vector<int32> count;
+			Vector<float> weights;
+			int32 stride = 0;
+
+			void Build(int32 srcSize, int32 dstSize)
+			{
+				const double scale = (double)srcSize / (double)dstSize;
+				stride = (int32)ceil(scale) + 1;
+				first.resize(dstSize);
+				count.resize(dstSize);
+				weights.resize((size_t)dstSize * stride);
+				for(int32 i = 0; i < dstSize; i++)
+				{
+					const double begin = i * scale;
+					const double end = Math::Min((i + 1) * scale, (double)srcSize);
+					int32 j = (int32)begin;
+					first[i] = j;
+					int32 n = 0;
+					for(; j < end && n < stride; j++, n++)
+					{
+						double overlap = Math::Min(end, (double)(j + 1)) - Math::Max(begin, (double)j);
+						weights[i * stride + n] = (float)(overlap / scale);
+					}
+					count[i] = n;
+				}
+			}
+		};
+
+		// Scratch memory, reused between calls on the same thread
+		struct Scratch
+		{
+			Contributions horizontal;
+			Contributions vertical;
+			Vector<float> row;
+			Vector<float> accum;
+		};
+
+	public:
+		// src and dst may point to the same memory
+		static void DownScale(const Colori* src, Vector2i srcSize, Colori* dst, Vector2i dstSize)
+		{
+			thread_local Scratch scratch;
+			scratch.horizontal.Build(srcSize.x, dstSize.x);
+			scratch.vertical.Build(srcSize.y, dstSize.y);
+			scratch.row.resize((size_t)dstSize.x * 4);
+			scratch.accum.assign((size_t)dstSize.x * dstSize.y * 4, 0.0f);
+
+			const Contributions& vertical = scratch.vertical;
+			int32 dstY = 0;
+			for(int32 sy = 0; sy < srcSize.y; sy++)
+			{
+				ScaleRow(src + (size_t)sy * srcSize.x, scratch.horizontal, scratch.row.data(), dstSize.x);
+
+				// A source row covers at most two output rows when shrinking
+				while(dstY < dstSize.y && vertical.first[dstY] + vertical.count[dstY] <= sy)
+					dstY++;
+				for(int32 y = dstY; y < dstSize.y && vertical.first[y] <= sy; y++)
+				{
+					const int32 k = sy - vertical.first[y];
+					if(k >= vertical.count[y])
+						continue;
+					AccumulateRow(scratch.row.data(), vertical.weights[y * vertical.stride + k],
+						scratch.accum.data() + (size_t)y * dstSize.x * 4, dstSize.x);
+				}
+			}
+
+			StoreRows(scratch.accum.data(), dst, (size_t)dstSize.x * dstSize.y);
+		}
+
+	private:
+#ifdef USC_IMAGE_SSE2
+		static void ScaleRow(const Colori* src, const Contributions& c, float* out, int32 dstWidth)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			for(int32 x = 0; x < dstWidth; x++)
+			{
+				const Colori* p = src + c.first[x];
+				const float* w = c.weights.data() + x * c.stride;
+				__m128 acc = _mm_setzero_ps();
+				for(int32 k = 0; k < c.count[x]; k++)
+				{
+					int32 packed;
+					memcpy(&packed, p + k, sizeof(packed));
+					__m128i px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+					acc = _mm_add_ps(acc, _mm_mul_ps(_mm_cvtepi32_ps(px), _mm_set1_ps(w[k])));
+				}
+				_mm_storeu_ps(out + x * 4, acc);
+			}
+		}
+		static void AccumulateRow(const float* row, float weight, float* accum, int32 dstWidth)
+		{
+			const __m128 w = _mm_set1_ps(weight);
+			for(int32 i = 0; i < dstWidth * 4; i += 4)
+			{
+				_mm_storeu_ps(accum + i, _mm_add_ps(_mm_loadu_ps(accum + i), _mm_mul_ps(_mm_loadu_ps(row + i), w)));
+			}
+		}
+		static void StoreRows(const float* accum, Colori* dst, size_t numPixels)
+		{
+			for(size_t i = 0; i < numPixels; i++)
+			{
+				__m128i v = _mm_cvtps_epi32(_mm_loadu_ps(accum + i * 4));
+				v = _mm_packs_epi32(v, v);
+				v = _mm_packus_epi16(v, v);
+				int32 packed = _mm_cvtsi128_si32(v);
+				memcpy(dst + i, &packed, sizeof(packed));
+			}
+		}
+#else
+		static void ScaleRow(const Colori* src, const Contributions& c, float* out, int32 dstWidth)
+		{
+			for(int32 x = 0; x < dstWidth; x++)
+			{
+				const Colori* p = src + c.first[x];
+				const float* w = c.weights.data() + x * c.stride;
+				float acc[4] = { 0.0f };
+				for(int32 k = 0; k < c.count[x]; k++)
+				{
+					acc[0] += p[k].x * w[k];
+					acc[1] += p[k].y * w[k];
+					acc[2] += p[k].z * w[k];
+					acc[3] += p[k].w * w[k];
+				}
+				memcpy(out + x * 4, acc, sizeof(acc));
+			}
+		}
+		static void AccumulateRow(const float* row, float weight, float* accum, int32 dstWidth)
+		{
+			for(int32 i = 0; i < dstWidth * 4; i++)
+				accum[i] += row[i] * weight;
+		}
+		static void StoreRows(const float* accum, Colori* dst, size_t numPixels)
+		{
+			for(size_t i = 0; i < numPixels; i++)
+			{
+				const float* p = accum + i * 4;
+				dst[i] = Colori(
+					(uint8)Math::Clamp(p[0] + 0.5f, 0.0f, 255.0f),
+					(uint8)Math::Clamp(p[1] + 0.5f, 0.0f, 255.0f),
+					(uint8)Math::Clamp(p[2] + 0.5f, 0.0f, 255.0f),
+					(uint8)Math::Clamp(p[3] + 0.5f, 0.0f, 255.0f));
+			}
+		}
+#endif
+	};
+
 	class Image_Impl : public ImageRes
 	{
 		Vector2i m_size;
@@ -52,13 +213,22 @@ namespace Graphics
 			if (new_DataLength == 0){
 				return;
 			}
+
+			// Shrinking is done in place with an area averaging filter
+			if(size.x <= m_size.x && size.y <= m_size.y)
+			{
+				ImageScaler::DownScale(m_pData, m_size, m_pData, size);
+				m_size = size;
+				return;
+			}
+
 			Colori* new_pData = new Colori[new_DataLength];
 
-			for (int32 ix = 0; ix < size.x; ++ix){
-				for (int32 iy = 0; iy < size.y; ++iy){
-					int32 sampledX = ix * ((double)m_size.x / (double)size.x);
-					int32 sampledY = iy * ((double)m_size.y / (double)size.y);
-					new_pData[size.x * iy + ix] = m_pData[m_size.x * sampledY + sampledX];
+			for (int32 iy = 0; iy < size.y; ++iy){
+				const Colori* srcRow = m_pData + m_size.x * (int32)(((int64)iy * m_size.y) / size.y);
+				Colori* dstRow = new_pData + size.x * iy;
+				for (int32 ix = 0; ix < size.x; ++ix){
+					dstRow[ix] = srcRow[((int64)ix * m_size.x) / size.x];
 				}
 			}
 
@@ -184,9 +354,13 @@ namespace Graphics
 		return GetResourceManager<ResourceType::Image>().Register(pImpl);
 	}
 	Ref<ImageRes> ImageRes::Create(Buffer & b)
+	{
+		return Create(b, Vector2i());
+	}
+	Ref<ImageRes> ImageRes::Create(Buffer& b, Vector2i sizeHint)
 	{
 		Image_Impl* pImpl = new Image_Impl();
-		if (ImageLoader::Load(pImpl, b))
+		if (ImageLoader::Load(pImpl, b, sizeHint))
 		{
 			return GetResourceManager<ResourceType::Image>().Register(pImpl);
 		}
@@ -198,9 +372,13 @@ namespace Graphics
 		return Image();
 	}
 	Image ImageRes::Create(const String& assetPath)
+	{
+		return Create(assetPath, Vector2i());
+	}
+	Image ImageRes::Create(const String& assetPath, Vector2i sizeHint)
 	{
 		Image_Impl* pImpl = new Image_Impl();
-		if(ImageLoader::Load(pImpl, assetPath))
+		if(ImageLoader::Load(pImpl, assetPath, sizeHint))
 		{
 			return GetResourceManager<ResourceType::Image>().Register(pImpl);
 		}
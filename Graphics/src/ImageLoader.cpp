@@ -46,7 +46,7 @@ namespace Graphics
 		{
 		}
 
-		bool LoadJPEG(ImageRes* pImage, Buffer& in)
+		bool LoadJPEG(ImageRes* pImage, const uint8* data, size_t size, Vector2i sizeHint)
 		{
 
 			/* This struct contains the JPEG decompression parameters and pointers to
@@ -65,9 +65,24 @@ namespace Graphics
 			if(setjmp(jerr.jmpBuf) == 0)
 			{
 				jpeg_create_decompress(&cinfo);
-				jpeg_mem_src(&cinfo, in.data(), (uint32)in.size());
+				jpeg_mem_src(&cinfo, (unsigned char*)data, (uint32)size);
 				int res = jpeg_read_header(&cinfo, TRUE);
 
+				// Let the IDCT produce a 1/2, 1/4 or 1/8 scale image when that is still large enough
+				if(sizeHint.x > 0 && sizeHint.y > 0)
+				{
+					cinfo.scale_num = 1;
+					cinfo.scale_denom = 1;
+					for(uint32 denom = 8; denom > 1; denom /= 2)
+					{
+						if(cinfo.image_width / denom >= (uint32)sizeHint.x && cinfo.image_height / denom >= (uint32)sizeHint.y)
+						{
+							cinfo.scale_denom = denom;
+							break;
+						}
+					}
+				}
+
 				jpeg_start_decompress(&cinfo);
 				int row_stride = cinfo.output_width * cinfo.output_components;
 				JSAMPARRAY sample = (*cinfo.mem->alloc_sarray)
@@ -100,13 +115,13 @@ namespace Graphics
 			// If we get here, the loading of the jpeg failed
 			return false;
 		}
-		bool LoadPNG(ImageRes* pImage, Buffer& in)
+		bool LoadPNG(ImageRes* pImage, const uint8* data, size_t size)
 		{
 			png_image image;
 			memset(&image, 0, (sizeof image));
 			image.version = PNG_IMAGE_VERSION;
 
-			if(png_image_begin_read_from_memory(&image, in.data(), in.size()) == 0)
+			if(png_image_begin_read_from_memory(&image, data, size) == 0)
 				return false;
 
 			image.format = PNG_FORMAT_RGBA;
@@ -125,27 +140,26 @@ namespace Graphics
 			png_image_free(&image);
 			return true;
 		}
-		bool Load(ImageRes* pImage, const String& fullPath)
+		bool Load(ImageRes* pImage, const String& fullPath, Vector2i sizeHint)
 		{
-			File f;
-			if(!f.OpenRead(fullPath))
-				return false;
-
-			Buffer b(f.GetSize());
-			f.Read(b.data(), b.size());
-			if(b.size() < 4)
+			// Read into memory instead of mapped, skins and jackets can be replaced on disk while they are loaded
+			Buffer data;
+			if(!File::ReadAll(fullPath, data))
 				return false;
 
-			return Load(pImage, b);
+			return Load(pImage, data.data(), data.size(), sizeHint);
 		}
 
-		bool Load(ImageRes* pImage, Buffer& b)
+		bool Load(ImageRes* pImage, const uint8* data, size_t size, Vector2i sizeHint)
 		{
+			if(size < 4)
+				return false;
+
 			// Check for PNG based on first 4 bytes
-			if (std::memcmp(b.data(), "\x89PNG", 4) == 0)
-				return LoadPNG(pImage, b);
+			if (std::memcmp(data, "\x89PNG", 4) == 0)
+				return LoadPNG(pImage, data, size);
 			else // jay-PEG ?
-				return LoadJPEG(pImage, b);
+				return LoadJPEG(pImage, data, size, sizeHint);
 		}
 
 		static ImageLoader_Impl& Main()
@@ -156,13 +170,18 @@ namespace Graphics
 	};
 
 
-	bool ImageLoader::Load(ImageRes* pImage, const String& fullPath)
+	bool ImageLoader::Load(ImageRes* pImage, const String& fullPath, Vector2i sizeHint)
+	{
+		return ImageLoader_Impl::Main().Load(pImage, fullPath, sizeHint);
+	}
+
+	bool ImageLoader::Load(ImageRes* pImage, Buffer& b, Vector2i sizeHint)
 	{
-		return ImageLoader_Impl::Main().Load(pImage, fullPath);
+		return ImageLoader_Impl::Main().Load(pImage, b.data(), b.size(), sizeHint);
 	}
 
-	bool ImageLoader::Load(ImageRes* pImage, Buffer& b)
+	bool ImageLoader::Load(ImageRes* pImage, const uint8* data, size_t size, Vector2i sizeHint)
 	{
-		return ImageLoader_Impl::Main().Load(pImage, b);
+		return ImageLoader_Impl::Main().Load(pImage, data, size, sizeHint);
 	}
 }
\ No newline at end of file
@@ -85,31 +85,42 @@ namespace Graphics
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
 		
-		#ifdef EMBEDDED
 		void Draw() override
 		{
-			glBindVertexArray(m_vao);
-			glDrawArrays(m_glType, 0, (int)m_vertexCount);
-			glBindVertexArray(0);
+			DrawRange(0, m_vertexCount);
 		}
 		void Redraw() override
+		{
+			RedrawRange(0, m_vertexCount);
+		}
+		#ifdef EMBEDDED
+		void DrawRange(size_t firstVertex, size_t vertexCount) override
 		{
 			glBindVertexArray(m_vao);
-			glDrawArrays(m_glType, 0, (int)m_vertexCount);
+			glDrawArrays(m_glType, (int)firstVertex, (int)vertexCount);
 			glBindVertexArray(0);
 		}
+		void RedrawRange(size_t firstVertex, size_t vertexCount) override
+		{
+			DrawRange(firstVertex, vertexCount);
+		}
 		#else
-		void Draw() override
+		void DrawRange(size_t firstVertex, size_t vertexCount) override
 		{
 			glBindVertexArray(m_vao);
-			glDrawArrays(m_glType, 0, (int)m_vertexCount);
+			glDrawArrays(m_glType, (int)firstVertex, (int)vertexCount);
 		}
-		void Redraw() override
+		void RedrawRange(size_t firstVertex, size_t vertexCount) override
 		{
-			glDrawArrays(m_glType, 0, (int)m_vertexCount);
+			glDrawArrays(m_glType, (int)firstVertex, (int)vertexCount);
 		}
 		#endif
 
+		void SetStatic(bool isStatic) override
+		{
+			m_bDynamic = !isStatic;
+		}
+
 		void SetPrimitiveType(PrimitiveType pt) override
 		{
 			m_type = pt;
@@ -32,6 +32,8 @@ namespace Graphics
 		if(m_impl->context)
 		{
 			// Cleanup resource managers
+			// Render targets hold textures and meshes
+			ResourceManagers::DestroyResourceManager<ResourceType::RenderTarget>();
 			ResourceManagers::DestroyResourceManager<ResourceType::Mesh>();
 			ResourceManagers::DestroyResourceManager<ResourceType::Texture>();
 			ResourceManagers::DestroyResourceManager<ResourceType::Shader>();
@@ -59,6 +61,7 @@ namespace Graphics
 		ResourceManagers::CreateResourceManager<ResourceType::Font>();
 		ResourceManagers::CreateResourceManager<ResourceType::Material>();
 		ResourceManagers::CreateResourceManager<ResourceType::ParticleSystem>();
+		ResourceManagers::CreateResourceManager<ResourceType::RenderTarget>();
 	}
 	bool OpenGL::Init(Window& window, uint32 antialiasing)
 	{
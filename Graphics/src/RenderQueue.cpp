@@ -112,6 +112,16 @@ namespace Graphics
 					currentMesh = mesh;
 				}
 			};
+			auto DrawOrRedrawMeshRange = [&](Mesh& mesh, size_t firstVertex, size_t vertexCount)
+			{
+				if(currentMesh == mesh)
+					mesh->RedrawRange(firstVertex, vertexCount);
+				else
+				{
+					mesh->DrawRange(firstVertex, vertexCount);
+					currentMesh = mesh;
+				}
+			};
 
 			if(Cast<SimpleDrawCall>(item))
 			{
@@ -142,7 +152,10 @@ namespace Graphics
 					}
 				}
 
-				DrawOrRedrawMesh(sdc->mesh);
+				if(sdc->vertexCount > 0)
+					DrawOrRedrawMeshRange(sdc->mesh, sdc->firstVertex, sdc->vertexCount);
+				else
+					DrawOrRedrawMesh(sdc->mesh);
 				#ifdef EMBEDDED
 				glUseProgram(0);
 				#endif
@@ -207,6 +220,17 @@ namespace Graphics
 		sdc->worldTransform = worldTransform;
 		m_orderedCommands.push_back(sdc);
 	}
+	void RenderQueue::DrawRange(Transform worldTransform, Mesh m, size_t firstVertex, size_t vertexCount, Material mat, const MaterialParameterSet& params)
+	{
+		SimpleDrawCall* sdc = new SimpleDrawCall();
+		sdc->mat = mat;
+		sdc->mesh = m;
+		sdc->params = params;
+		sdc->worldTransform = worldTransform;
+		sdc->firstVertex = firstVertex;
+		sdc->vertexCount = vertexCount;
+		m_orderedCommands.push_back(sdc);
+	}
 	void RenderQueue::Draw(Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params)
 	{
 		SimpleDrawCall* sdc = new SimpleDrawCall();
@@ -218,6 +242,21 @@ namespace Graphics
 		sdc->worldTransform = worldTransform;
 		m_orderedCommands.push_back(sdc);
 	}
+	void RenderQueue::Draw(Transform worldTransform, TextBatch& batch, Material mat, const MaterialParameterSet& params)
+	{
+		if(batch.GetTextCount() == 0)
+			return;
+
+		SimpleDrawCall* sdc = new SimpleDrawCall();
+		sdc->mat = mat;
+		sdc->mesh = batch.GetMesh();
+		sdc->params = params;
+		// Set Font texture map
+		sdc->params.SetParameter("mainTex", batch.GetTexture());
+		sdc->params.SetParameter("mapSize", batch.GetTexture()->GetSize());
+		sdc->worldTransform = worldTransform;
+		m_orderedCommands.push_back(sdc);
+	}
 
 	void RenderQueue::DrawScissored(Rect scissor, Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params /*= MaterialParameterSet()*/)
 	{
@@ -0,0 +1,297 @@
+#include "stdafx.h"
+#include "RenderTarget.hpp"
+#include "OpenGL.hpp"
+#include "Texture.hpp"
+#include "Mesh.hpp"
+#include "MeshGenerators.hpp"
+#include <Graphics/ResourceManagers.hpp>
+
+namespace Graphics
+{
+#ifdef EMBEDDED
+	static const char* copyVertexSource =
+		"#version 100\n"
+		"attribute vec3 inPos;\n"
+		"attribute vec2 inTex;\n"
+		"varying vec2 fsTex;\n"
+		"void main()\n"
+		"{\n"
+		"	fsTex = vec2(inTex.x, 1.0 - inTex.y);\n"
+		"	gl_Position = vec4(inPos.xy, 0.0, 1.0);\n"
+		"}\n";
+	static const char* copyFragmentSource =
+		"#version 100\n"
+		"precision mediump float;\n"
+		"varying vec2 fsTex;\n"
+		"uniform sampler2D mainTex;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_FragColor = texture2D(mainTex, fsTex);\n"
+		"}\n";
+#else
+	static const char* copyVertexSource =
+		"#version 330\n"
+		"layout(location=0) in vec3 inPos;\n"
+		"layout(location=1) in vec2 inTex;\n"
+		"out vec2 fsTex;\n"
+		"void main()\n"
+		"{\n"
+		"	fsTex = vec2(inTex.x, 1.0 - inTex.y);\n"
+		"	gl_Position = vec4(inPos.xy, 0.0, 1.0);\n"
+		"}\n";
+	static const char* copyFragmentSource =
+		"#version 330\n"
+		"in vec2 fsTex;\n"
+		"layout(location=0) out vec4 target;\n"
+		"uniform sampler2D mainTex;\n"
+		"void main()\n"
+		"{\n"
+		"	target = texture(mainTex, fsTex);\n"
+		"}\n";
+#endif
+
+	class RenderTarget_Impl : public RenderTargetRes
+	{
+		OpenGL* m_gl = nullptr;
+		Vector2i m_size;
+		uint32 m_samples = 0;
+
+		// Framebuffer that is rendered into, the texture is attached directly when there is no multisampling
+		uint32 m_fb = 0;
+		uint32 m_colorBuffer = 0;
+		uint32 m_stencilBuffer = 0;
+		// Framebuffer with the texture that multisampled rendering is resolved into
+		uint32 m_resolveFb = 0;
+		Texture m_texture;
+		bool m_dirty = false;
+
+		// Program and quad for Draw
+		uint32 m_copyProgram = 0;
+		bool m_copyProgramFailed = false;
+		Mesh m_quad;
+
+	public:
+		RenderTarget_Impl(OpenGL* gl) : m_gl(gl)
+		{
+		}
+		~RenderTarget_Impl()
+		{
+			if(m_copyProgram)
+				glDeleteProgram(m_copyProgram);
+			if(m_resolveFb)
+				glDeleteFramebuffers(1, &m_resolveFb);
+			if(m_fb)
+				glDeleteFramebuffers(1, &m_fb);
+			if(m_colorBuffer)
+				glDeleteRenderbuffers(1, &m_colorBuffer);
+			if(m_stencilBuffer)
+				glDeleteRenderbuffers(1, &m_stencilBuffer);
+		}
+		bool Init(Vector2i size, uint32 samples)
+		{
+			int32 maxSamples = 0;
+			glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+			m_size = size;
+			m_samples = Math::Min(samples, (uint32)Math::Max(maxSamples, 0));
+			if(m_samples == 1)
+				m_samples = 0;
+
+			m_texture = TextureRes::Create(m_gl);
+			if(!m_texture)
+				return false;
+			m_texture->Init(size, TextureFormat::RGBA8);
+			m_texture->SetWrap(TextureWrap::Clamp, TextureWrap::Clamp);
+
+			glGenFramebuffers(1, &m_fb);
+			glBindFramebuffer(GL_FRAMEBUFFER, m_fb);
+			glGenRenderbuffers(1, &m_stencilBuffer);
+			glBindRenderbuffer(GL_RENDERBUFFER, m_stencilBuffer);
+			if(m_samples > 0)
+			{
+				glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_samples, GL_DEPTH24_STENCIL8, size.x, size.y);
+
+				glGenRenderbuffers(1, &m_colorBuffer);
+				glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+				glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_samples, GL_RGBA8, size.x, size.y);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+			}
+			else
+			{
+				glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture->Handle(), 0);
+			}
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_stencilBuffer);
+			bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+			if(complete && m_samples > 0)
+			{
+				glGenFramebuffers(1, &m_resolveFb);
+				glBindFramebuffer(GL_FRAMEBUFFER, m_resolveFb);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture->Handle(), 0);
+				complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+			}
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			if(!complete)
+			{
+				Logf("Render target of %dx%d with %d samples is not supported", Logger::Severity::Error, size.x, size.y, m_samples);
+				return false;
+			}
+			return true;
+		}
+
+		void Bind() override
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, m_fb);
+			glViewport(0, 0, m_size.x, m_size.y);
+			m_dirty = true;
+		}
+		void Clear(const Color& color) override
+		{
+			glClearColor(color.x, color.y, color.z, color.w);
+			glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		}
+		void Resolve() override
+		{
+			if(!m_dirty)
+				return;
+			m_dirty = false;
+			if(m_samples == 0)
+				return;
+
+			GLint drawFb = 0;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFb);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fb);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolveFb);
+			glBlitFramebuffer(0, 0, m_size.x, m_size.y, 0, 0, m_size.x, m_size.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFb);
+		}
+		Texture GetTexture() override
+		{
+			Resolve();
+			return m_texture;
+		}
+		void Draw(const Recti& viewport) override
+		{
+			if(!m_copyProgram && (m_copyProgramFailed || !InitCopyProgram()))
+				return;
+			Resolve();
+
+			glViewport(viewport.pos.x, viewport.pos.y, viewport.size.x, viewport.size.y);
+			const bool blend = glIsEnabled(GL_BLEND);
+			glDisable(GL_BLEND);
+			glUseProgram(m_copyProgram);
+			m_texture->Bind(0);
+			m_quad->Draw();
+			glBindTexture(GL_TEXTURE_2D, 0);
+			// Materials bind program pipelines, which are only used when no program is
+			glUseProgram(0);
+			if(blend)
+				glEnable(GL_BLEND);
+		}
+
+		const Vector2i& GetSize() const override
+		{
+			return m_size;
+		}
+		uint32 GetSamples() const override
+		{
+			return m_samples;
+		}
+		uint32 Handle() override
+		{
+			return m_fb;
+		}
+
+	private:
+		static uint32 CompileShader(GLenum type, const char* source)
+		{
+			uint32 shader = glCreateShader(type);
+			glShaderSource(shader, 1, &source, nullptr);
+			glCompileShader(shader);
+
+			int status = 0;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+			if(status == GL_FALSE)
+			{
+				char infoLog[1024];
+				glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+				Logf("Render target copy shader compile log: %s", Logger::Severity::Error, infoLog);
+				glDeleteShader(shader);
+				return 0;
+			}
+			return shader;
+		}
+		bool InitCopyProgram()
+		{
+			m_copyProgramFailed = true;
+			uint32 vs = CompileShader(GL_VERTEX_SHADER, copyVertexSource);
+			uint32 fs = CompileShader(GL_FRAGMENT_SHADER, copyFragmentSource);
+			if(!vs || !fs)
+			{
+				glDeleteShader(vs);
+				glDeleteShader(fs);
+				return false;
+			}
+
+			uint32 program = glCreateProgram();
+			glAttachShader(program, vs);
+			glAttachShader(program, fs);
+			glBindAttribLocation(program, 0, "inPos");
+			glBindAttribLocation(program, 1, "inTex");
+			glLinkProgram(program);
+			glDeleteShader(vs);
+			glDeleteShader(fs);
+
+			int status = 0;
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+			if(status == GL_FALSE)
+			{
+				Log("Failed to link the render target copy program", Logger::Severity::Error);
+				glDeleteProgram(program);
+				return false;
+			}
+
+			glUseProgram(program);
+			glUniform1i(glGetUniformLocation(program, "mainTex"), 0);
+			glUseProgram(0);
+
+			m_copyProgram = program;
+			m_copyProgramFailed = false;
+			m_quad = MeshGenerators::Quad(m_gl, Vector2(-1.0f), Vector2(2.0f));
+			return true;
+		}
+	};
+
+	RenderTarget RenderTargetRes::Create(OpenGL* gl, Vector2i size, uint32 samples)
+	{
+		RenderTarget_Impl* pImpl = new RenderTarget_Impl(gl);
+		if(pImpl->Init(size, samples))
+		{
+			return GetResourceManager<ResourceType::RenderTarget>().Register(pImpl);
+		}
+		else
+		{
+			delete pImpl;
+			return RenderTarget();
+		}
+	}
+	void RenderTargetRes::Unbind(OpenGL* gl)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	bool RenderTargetPair::Create(OpenGL* gl, Vector2i size, uint32 samples)
+	{
+		for(uint32 i = 0; i < 2; i++)
+		{
+			m_targets[i] = RenderTargetRes::Create(gl, size, samples);
+			if(!m_targets[i])
+				return false;
+		}
+		m_write = 0;
+		return true;
+	}
+}
@@ -0,0 +1,181 @@
+#include "stdafx.h"
+#include "RenderTargetGraph.hpp"
+#include "OpenGL.hpp"
+
+namespace Graphics
+{
+	RenderTargetGraph::RenderTargetGraph()
+	{
+		Reset();
+	}
+
+	void RenderTargetGraph::Reset()
+	{
+		m_targets.clear();
+		m_passes.clear();
+		m_targets.Add({ "Screen", 1.0f, 0 });
+
+		m_compiled = false;
+		m_physicalTargets.clear();
+		m_compiledPasses.clear();
+		m_renderTargets.clear();
+	}
+
+	uint32 RenderTargetGraph::AddTarget(const String& name, float scale, uint32 samples)
+	{
+		m_compiled = false;
+		m_targets.Add({ name, scale, samples });
+		return (uint32)m_targets.size() - 1;
+	}
+
+	uint32 RenderTargetGraph::AddPass(const String& name, uint32 output, const Vector<uint32>& inputs)
+	{
+		assert(output < m_targets.size());
+		m_compiled = false;
+		m_passes.Add({ name, output, inputs });
+		return (uint32)m_passes.size() - 1;
+	}
+
+	bool RenderTargetGraph::Compile(Vector2i screenSize)
+	{
+		m_compiled = false;
+		m_screenSize = screenSize;
+		m_physicalTargets.clear();
+		m_compiledPasses.clear();
+		m_renderTargets.clear();
+
+		// Contents of a target from the pass that starts rendering into it to the last pass that uses them
+		struct Version
+		{
+			uint32 target;
+			uint32 first;
+			uint32 last;
+			int32 physical;
+		};
+		Vector<Version> versions;
+		Vector<int32> currentVersion(m_targets.size(), -1);
+		Vector<int32> outputVersions;
+		Vector<Vector<int32>> inputVersions;
+
+		for(uint32 i = 0; i < m_passes.size(); i++)
+		{
+			const Pass& pass = m_passes[i];
+			Vector<int32>& inputs = inputVersions.Add();
+			bool samplesOutput = false;
+			for(uint32 input : pass.inputs)
+			{
+				assert(input < m_targets.size());
+				if(input == Screen || currentVersion[input] < 0)
+				{
+					Logf("Render pass %s samples %s before anything rendered into it", Logger::Severity::Error, pass.name, m_targets[input].name);
+					return false;
+				}
+				versions[currentVersion[input]].last = i;
+				inputs.Add(currentVersion[input]);
+				samplesOutput |= input == pass.output;
+			}
+
+			if(pass.output == Screen)
+			{
+				outputVersions.Add(-1);
+			}
+			else if(currentVersion[pass.output] < 0 || samplesOutput)
+			{
+				currentVersion[pass.output] = (int32)versions.size();
+				versions.Add({ pass.output, i, i, -1 });
+				outputVersions.Add(currentVersion[pass.output]);
+			}
+			else
+			{
+				versions[currentVersion[pass.output]].last = i;
+				outputVersions.Add(currentVersion[pass.output]);
+			}
+		}
+
+		// Versions are created in the order of their first pass, a physical target is free once the last pass of its current version is done
+		Vector<uint32> physicalLastUse;
+		for(Version& version : versions)
+		{
+			const Target& target = m_targets[version.target];
+			const Vector2i size = Vector2i(
+				Math::Max((int32)(screenSize.x * target.scale + 0.5f), 1),
+				Math::Max((int32)(screenSize.y * target.scale + 0.5f), 1));
+
+			for(uint32 i = 0; i < m_physicalTargets.size(); i++)
+			{
+				const PhysicalTarget& physical = m_physicalTargets[i];
+				if(physical.size.x == size.x && physical.size.y == size.y && physical.samples == target.samples && physicalLastUse[i] < version.first)
+				{
+					version.physical = (int32)i;
+					break;
+				}
+			}
+			if(version.physical < 0)
+			{
+				version.physical = (int32)m_physicalTargets.size();
+				m_physicalTargets.Add({ size, target.samples });
+				physicalLastUse.Add(0);
+			}
+			physicalLastUse[version.physical] = version.last;
+		}
+
+		for(uint32 i = 0; i < m_passes.size(); i++)
+		{
+			CompiledPass& compiled = m_compiledPasses.Add();
+			const int32 output = outputVersions[i];
+			compiled.output = output < 0 ? -1 : versions[output].physical;
+			compiled.clear = output >= 0 && versions[output].first == i;
+			for(int32 input : inputVersions[i])
+				compiled.inputs.Add(versions[input].physical);
+		}
+
+		m_compiled = true;
+		return true;
+	}
+
+	bool RenderTargetGraph::CreateTargets(OpenGL* gl)
+	{
+		assert(m_compiled);
+		m_renderTargets.clear();
+		for(const PhysicalTarget& physical : m_physicalTargets)
+		{
+			RenderTarget target = RenderTargetRes::Create(gl, physical.size, physical.samples);
+			if(!target)
+			{
+				m_renderTargets.clear();
+				return false;
+			}
+			m_renderTargets.Add(target);
+		}
+		return true;
+	}
+
+	void RenderTargetGraph::BeginPass(OpenGL* gl, uint32 pass, const Recti& screenViewport)
+	{
+		assert(m_renderTargets.size() == m_physicalTargets.size());
+		m_currentPass = pass;
+		const CompiledPass& compiled = m_compiledPasses[pass];
+		if(compiled.output < 0)
+		{
+			RenderTargetRes::Unbind(gl);
+			gl->SetViewport(screenViewport);
+			return;
+		}
+
+		RenderTarget& target = m_renderTargets[compiled.output];
+		target->Bind();
+		if(compiled.clear)
+			target->Clear();
+	}
+
+	const RenderTarget& RenderTargetGraph::GetInput(uint32 index) const
+	{
+		return m_renderTargets[m_compiledPasses[m_currentPass].inputs[index]];
+	}
+
+	void RenderTargetGraph::EndFrame(OpenGL* gl, const Recti& screenViewport)
+	{
+		RenderTargetRes::Unbind(gl);
+		gl->SetViewport(screenViewport);
+	}
+}
@@ -0,0 +1,151 @@
+#include "stdafx.h"
+#include "TextureResidency.hpp"
+
+namespace Graphics
+{
+	uint32 TextureResidency::Add(EvictFunction evict)
+	{
+		const uint32 id = m_nextId++;
+		Entry& entry = m_entries[id];
+		entry.evict = std::move(evict);
+		entry.usage = m_usage.end();
+		m_stats.numTextures++;
+		return id;
+	}
+
+	void TextureResidency::Remove(uint32 id)
+	{
+		auto it = m_entries.find(id);
+		if(it == m_entries.end())
+			return;
+		if(it->second.resident)
+		{
+			m_Release(it->second);
+			m_stats.numResident--;
+		}
+		m_stats.numTextures--;
+		m_entries.erase(it);
+	}
+
+	void TextureResidency::SetResident(uint32 id, size_t bytes)
+	{
+		auto it = m_entries.find(id);
+		if(it == m_entries.end())
+			return;
+		Entry& entry = it->second;
+		if(entry.resident)
+			m_Release(entry);
+		else
+			m_stats.numResident++;
+		if(entry.evicted)
+		{
+			entry.evicted = false;
+			m_stats.numReloaded++;
+		}
+
+		entry.bytes = bytes;
+		entry.resident = true;
+		entry.lastFrame = m_frame;
+		if(entry.evict)
+		{
+			m_usage.push_front(id);
+			entry.usage = m_usage.begin();
+			m_stats.residentBytes += bytes;
+		}
+		else
+		{
+			m_residentPinnedBytes += bytes;
+			m_stats.pinnedBytes = m_residentPinnedBytes + m_externalBytes;
+		}
+		m_EvictOverBudget();
+	}
+
+	bool TextureResidency::Touch(uint32 id)
+	{
+		auto it = m_entries.find(id);
+		if(it == m_entries.end())
+			return false;
+		Entry& entry = it->second;
+		if(!entry.resident)
+			return false;
+		entry.lastFrame = m_frame;
+		if(entry.evict && entry.usage != m_usage.begin())
+			m_usage.splice(m_usage.begin(), m_usage, entry.usage);
+		return true;
+	}
+
+	bool TextureResidency::IsResident(uint32 id) const
+	{
+		auto it = m_entries.find(id);
+		return it != m_entries.end() && it->second.resident;
+	}
+
+	void TextureResidency::EndFrame()
+	{
+		m_EvictOverBudget();
+		m_stats.frameEvicted = m_numFrameEvicted;
+		m_numFrameEvicted = 0;
+		m_frame++;
+	}
+
+	void TextureResidency::SetBudget(size_t bytes)
+	{
+		m_stats.budget = bytes;
+	}
+
+	void TextureResidency::SetExternalBytes(size_t bytes)
+	{
+		m_externalBytes = bytes;
+		m_stats.pinnedBytes = m_residentPinnedBytes + m_externalBytes;
+		m_EvictOverBudget();
+	}
+
+	size_t TextureResidency::GetTextureBytes(Vector2i size, bool mipmaps, uint32 bytesPerPixel)
+	{
+		size_t bytes = (size_t)Math::Max(size.x, 0) * (size_t)Math::Max(size.y, 0) * bytesPerPixel;
+		if(mipmaps)
+			bytes += bytes / 3;
+		return bytes;
+	}
+
+	void TextureResidency::m_Release(Entry& entry)
+	{
+		if(entry.evict)
+		{
+			m_usage.erase(entry.usage);
+			entry.usage = m_usage.end();
+			m_stats.residentBytes -= entry.bytes;
+		}
+		else
+		{
+			m_residentPinnedBytes -= entry.bytes;
+			m_stats.pinnedBytes = m_residentPinnedBytes + m_externalBytes;
+		}
+		entry.bytes = 0;
+	}
+
+	void TextureResidency::m_Evict(Entry& entry)
+	{
+		m_stats.numEvicted++;
+		m_stats.evictedBytes += entry.bytes;
+		m_numFrameEvicted++;
+		m_Release(entry);
+		m_stats.numResident--;
+		entry.resident = false;
+		entry.evicted = true;
+		entry.evict();
+	}
+
+	void TextureResidency::m_EvictOverBudget()
+	{
+		while(!m_usage.empty() && m_stats.residentBytes + m_stats.pinnedBytes > m_stats.budget)
+		{
+			Entry& entry = m_entries[m_usage.back()];
+			// Everything before this was used in this frame too
+			if(entry.lastFrame == m_frame)
+				break;
+			m_Evict(entry);
+		}
+		m_stats.peakBytes = Math::Max(m_stats.peakBytes, m_stats.residentBytes + m_stats.pinnedBytes);
+	}
+}
@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "TextureUploadQueue.hpp"
+#include "OpenGL.hpp"
+#include "Image.hpp"
+
+namespace Graphics
+{
+	TextureUpload::TextureUpload(Ref<ImageRes> image) : m_image(image)
+	{
+		m_size = image->GetSize();
+	}
+	uint32 TextureUpload::Release()
+	{
+		assert(m_finished);
+		uint32 texture = m_texture;
+		m_texture = 0;
+		return texture;
+	}
+
+	TextureUploadQueue::TextureUploadQueue(OpenGL* gl) : m_gl(gl)
+	{
+		glGenBuffers(3, m_pixelBuffers);
+	}
+	TextureUploadQueue::~TextureUploadQueue()
+	{
+		// Cancel unfinished uploads
+		for(auto& upload : m_uploads)
+		{
+			if(upload->m_texture)
+				glDeleteTextures(1, &upload->m_texture);
+			upload->m_texture = 0;
+		}
+		glDeleteBuffers(3, m_pixelBuffers);
+	}
+
+	Ref<TextureUpload> TextureUploadQueue::Queue(Ref<ImageRes> image)
+	{
+		Ref<TextureUpload> upload = Ref<TextureUpload>(new TextureUpload(image));
+		// Nothing to upload for empty images
+		if(upload->m_size.x <= 0 || upload->m_size.y <= 0)
+		{
+			upload->m_finished = true;
+			upload->m_image.reset();
+		}
+		else
+		{
+			m_uploads.Add(upload);
+		}
+		return upload;
+	}
+
+	size_t TextureUploadQueue::GetPendingBytes() const
+	{
+		size_t ret = 0;
+		for(auto& upload : m_uploads)
+			ret += (size_t)(upload->m_size.y - upload->m_rowsUploaded) * upload->m_size.x * sizeof(Colori);
+		return ret;
+	}
+
+	void TextureUploadQueue::Update()
+	{
+		assert(m_gl->IsOpenGLThread());
+
+		// Drop uploads nobody is waiting for anymore
+		for(auto it = m_uploads.begin(); it != m_uploads.end();)
+		{
+			if((*it).use_count() == 1)
+			{
+				if((*it)->m_texture)
+					glDeleteTextures(1, &(*it)->m_texture);
+				(*it)->m_texture = 0;
+				it = m_uploads.erase(it);
+			}
+			else
+				++it;
+		}
+		if(m_uploads.empty())
+			return;
+
+		// Divide the budget over the queue in order, rows of the same image are uploaded in a single chunk
+		m_chunks.clear();
+		size_t totalBytes = 0;
+		for(auto& upload : m_uploads)
+		{
+			const size_t rowBytes = (size_t)upload->m_size.x * sizeof(Colori);
+			int32 numRows = (int32)((maxBytesPerFrame - Math::Min(totalBytes, maxBytesPerFrame)) / rowBytes);
+			if(numRows == 0 && m_chunks.empty())
+				numRows = 1;
+			numRows = Math::Min(numRows, upload->m_size.y - upload->m_rowsUploaded);
+			if(numRows <= 0)
+				break;
+
+			m_chunks.Add({ upload.get(), upload->m_rowsUploaded, numRows, totalBytes });
+			totalBytes += rowBytes * numRows;
+		}
+
+		// Orphan the previous storage and copy all chunks into the staging buffer
+		const uint32 pixelBuffer = m_pixelBuffers[m_currentBuffer];
+		m_currentBuffer = (m_currentBuffer + 1) % 3;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+		uint8* staging = (uint8*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if(!staging)
+		{
+			Log("Failed to map texture upload buffer", Logger::Severity::Error);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			return;
+		}
+		for(const Chunk& chunk : m_chunks)
+		{
+			const size_t rowBytes = (size_t)chunk.upload->m_size.x * sizeof(Colori);
+			memcpy(staging + chunk.offset, (uint8*)chunk.upload->m_image->GetBits() + rowBytes * chunk.row, rowBytes * chunk.numRows);
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		for(const Chunk& chunk : m_chunks)
+		{
+			TextureUpload* upload = chunk.upload;
+			if(!upload->m_texture)
+			{
+				glGenTextures(1, &upload->m_texture);
+				glBindTexture(GL_TEXTURE_2D, upload->m_texture);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, upload->m_size.x, upload->m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			}
+			else
+			{
+				glBindTexture(GL_TEXTURE_2D, upload->m_texture);
+			}
+			// Pointer is an offset into the bound pixel buffer
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, chunk.row, upload->m_size.x, chunk.numRows, GL_RGBA, GL_UNSIGNED_BYTE, (void*)chunk.offset);
+
+			upload->m_rowsUploaded += chunk.numRows;
+			if(upload->m_rowsUploaded == upload->m_size.y)
+			{
+				upload->m_finished = true;
+				upload->m_image.reset();
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		m_uploads.erase(std::remove_if(m_uploads.begin(), m_uploads.end(),
+			[](const Ref<TextureUpload>& upload) { return upload->m_finished; }), m_uploads.end());
+	}
+}
@@ -0,0 +1,348 @@
+#include "stdafx.h"
+#include "ThumbnailCache.hpp"
+
+namespace Graphics
+{
+	/*
+		Pack file layout:
+			PackHeader
+			Repeated records of: RecordHeader, path (pathLength bytes), pixels (width * height * 4 bytes)
+		Records for a key that is stored again are left in place, the last one wins. They are dropped when the pack is compacted
+	*/
+	struct PackHeader
+	{
+		char magic[4];
+		uint32 version;
+	};
+	struct RecordHeader
+	{
+		uint32 magic;
+		uint32 pathLength;
+		uint64 lastWriteTime;
+		int32 requestedWidth;
+		int32 requestedHeight;
+		int32 width;
+		int32 height;
+	};
+
+	static const char packMagic[4] = { 'U', 'S', 'C', 'T' };
+	static const uint32 packVersion = 1;
+	static const uint32 recordMagic = 0x52434854;
+
+	ThumbnailCache::~ThumbnailCache()
+	{
+		Close();
+	}
+
+	bool ThumbnailCache::Open(const String& packPath)
+	{
+		Close();
+
+		m_lock.lock();
+		m_packPath = packPath;
+		m_open = Path::FileExists(packPath) && m_ScanPack();
+		if(!m_open)
+		{
+			if(Path::FileExists(packPath))
+				Log("Thumbnail cache is invalid or too large, clearing it", Logger::Severity::Info);
+			m_open = m_CreatePack();
+		}
+		if(m_open)
+			m_open = m_writer.OpenWrite(packPath, true) && m_reader.OpenRead(packPath);
+		m_writable = m_open;
+		m_lock.unlock();
+
+		return m_open;
+	}
+
+	void ThumbnailCache::Close()
+	{
+		m_lock.lock();
+		m_writer.Close();
+		m_reader.Close();
+		m_entries.clear();
+		m_packSize = 0;
+		m_open = false;
+		m_writable = false;
+		m_lock.unlock();
+	}
+
+	bool ThumbnailCache::IsOpen() const
+	{
+		return m_open;
+	}
+
+	size_t ThumbnailCache::GetNumEntries() const
+	{
+		m_lock.lock();
+		size_t ret = m_entries.size();
+		m_lock.unlock();
+		return ret;
+	}
+
+	size_t ThumbnailCache::GetPackSize() const
+	{
+		m_lock.lock();
+		size_t ret = m_packSize;
+		m_lock.unlock();
+		return ret;
+	}
+
+	void ThumbnailCache::SetMaxPackSize(size_t bytes)
+	{
+		m_lock.lock();
+		m_maxPackSize = bytes;
+		m_lock.unlock();
+	}
+
+	Image ThumbnailCache::Load(const String& imagePath, Vector2i size)
+	{
+		uint64 lastWriteTime = File::GetLastWriteTime(imagePath);
+		Image image = Find(imagePath, lastWriteTime, size);
+		if(image)
+			return image;
+
+		image = ImageRes::Create(imagePath, size);
+		if(!image)
+			return Image();
+		if(image->GetSize().x > size.x || image->GetSize().y > size.y)
+			image->ReSize(size);
+
+		Store(imagePath, lastWriteTime, size, image);
+		return image;
+	}
+
+	Image ThumbnailCache::Find(const String& imagePath, uint64 lastWriteTime, Vector2i size)
+	{
+		Image ret;
+		m_lock.lock();
+		Entry* entry = m_entries.Find(m_Key(imagePath, size));
+		if(m_open && entry && entry->lastWriteTime == lastWriteTime)
+		{
+			ret = ImageRes::Create(entry->size);
+			if(!m_ReadPixels(*entry, (uint8*)ret->GetBits()))
+				ret = Image();
+		}
+		m_lock.unlock();
+		return ret;
+	}
+
+	void ThumbnailCache::Store(const String& imagePath, uint64 lastWriteTime, Vector2i size, Image thumbnail)
+	{
+		Entry entry;
+		entry.path = imagePath;
+		entry.requestedSize = size;
+		entry.lastWriteTime = lastWriteTime;
+		entry.size = thumbnail->GetSize();
+		const size_t pixelSize = (size_t)entry.size.x * entry.size.y * sizeof(Colori);
+		const size_t recordSize = sizeof(RecordHeader) + imagePath.size() + pixelSize;
+
+		// Thumbnails that would never fit don't clear the pack
+		if(sizeof(PackHeader) + recordSize > m_maxPackSize)
+			return;
+
+		m_lock.lock();
+		if(m_writable && m_packSize + recordSize > m_maxPackSize)
+			m_MakeRoom(recordSize);
+		if(m_writable && m_packSize + recordSize <= m_maxPackSize)
+		{
+			if(m_WriteRecord(m_writer, entry, (const uint8*)thumbnail->GetBits()))
+			{
+				entry.pixelOffset = m_packSize + sizeof(RecordHeader) + imagePath.size();
+				m_entries[m_Key(imagePath, size)] = entry;
+				m_packSize += recordSize;
+			}
+			// A partial record would shift the offsets of every record written after it
+			else if(!m_writer.Truncate(m_packSize))
+			{
+				Logf("Failed to undo a partial write to the thumbnail cache %s, new thumbnails are no longer stored", Logger::Severity::Warning, m_packPath);
+				m_writer.Close();
+				m_writable = false;
+			}
+			else
+			{
+				Logf("Failed to write to the thumbnail cache %s", Logger::Severity::Warning, m_packPath);
+			}
+		}
+		m_lock.unlock();
+	}
+
+	void ThumbnailCache::m_MakeRoom(size_t recordSize)
+	{
+		size_t liveSize = sizeof(PackHeader);
+		for(auto& it : m_entries)
+			liveSize += sizeof(RecordHeader) + it.second.path.size() + (size_t)it.second.size.x * it.second.size.y * sizeof(Colori);
+
+		// Compacting a pack that is mostly live records would have to be repeated after a few more thumbnails
+		if(liveSize + recordSize <= m_maxPackSize / 4 * 3 && m_Compact())
+		{
+			Logf("Compacted the thumbnail cache from %.1f MB to %.1f MB", Logger::Severity::Info,
+				m_packSize / (1024.0 * 1024.0), liveSize / (1024.0 * 1024.0));
+			return;
+		}
+
+		Log("Thumbnail cache is full, clearing it", Logger::Severity::Info);
+		m_writer.Close();
+		m_writable = m_CreatePack();
+		if(m_writable)
+			m_OpenWriter();
+	}
+
+	// Writes the current records to a new pack and replaces the old one with it
+	bool ThumbnailCache::m_Compact()
+	{
+		const String compactPath = m_packPath + ".tmp";
+		Map<String, Entry> entries;
+		size_t packSize = sizeof(PackHeader);
+		{
+			File file;
+			if(!file.OpenWrite(compactPath))
+				return false;
+			PackHeader header;
+			memcpy(header.magic, packMagic, sizeof(packMagic));
+			header.version = packVersion;
+			bool written = file.Write(&header, sizeof(header)) == sizeof(header);
+			Buffer pixels;
+			for(auto& it : m_entries)
+			{
+				if(!written)
+					break;
+				Entry entry = it.second;
+				pixels.resize((size_t)entry.size.x * entry.size.y * sizeof(Colori));
+				written = m_ReadPixels(entry, pixels.data()) && m_WriteRecord(file, entry, pixels.data());
+				entry.pixelOffset = packSize + sizeof(RecordHeader) + entry.path.size();
+				packSize = entry.pixelOffset + (size_t)entry.size.x * entry.size.y * sizeof(Colori);
+				entries.Add(it.first, entry);
+			}
+			if(!written)
+			{
+				file.Close();
+				Path::Delete(compactPath);
+				return false;
+			}
+		}
+
+		m_writer.Close();
+		m_reader.Close();
+		if(!Path::Delete(m_packPath) || !Path::Rename(compactPath, m_packPath))
+		{
+			Path::Delete(compactPath);
+			return false;
+		}
+		m_entries = std::move(entries);
+		m_packSize = packSize;
+		m_OpenWriter();
+		return true;
+	}
+
+	void ThumbnailCache::m_OpenWriter()
+	{
+		m_writable = m_writer.OpenWrite(m_packPath, true);
+		if(!m_writable)
+			Logf("Failed to reopen the thumbnail cache %s, new thumbnails are no longer stored", Logger::Severity::Warning, m_packPath);
+		m_open = m_reader.OpenRead(m_packPath);
+	}
+
+	// Records are read with explicit reads instead of through a mapping, reading a mapping of a pack that was truncated would raise SIGBUS
+	bool ThumbnailCache::m_ReadPixels(const Entry& entry, uint8* out)
+	{
+		const size_t pixelSize = (size_t)entry.size.x * entry.size.y * sizeof(Colori);
+		m_reader.Seek(entry.pixelOffset);
+		return m_reader.Read(out, pixelSize) == pixelSize;
+	}
+
+	bool ThumbnailCache::m_WriteRecord(File& file, const Entry& entry, const uint8* pixels)
+	{
+		RecordHeader header;
+		header.magic = recordMagic;
+		header.pathLength = (uint32)entry.path.size();
+		header.lastWriteTime = entry.lastWriteTime;
+		header.requestedWidth = entry.requestedSize.x;
+		header.requestedHeight = entry.requestedSize.y;
+		header.width = entry.size.x;
+		header.height = entry.size.y;
+
+		const size_t pixelSize = (size_t)entry.size.x * entry.size.y * sizeof(Colori);
+		return file.Write(&header, sizeof(header)) == sizeof(header)
+			&& file.Write(entry.path.data(), entry.path.size()) == entry.path.size()
+			&& file.Write(pixels, pixelSize) == pixelSize;
+	}
+
+	// Builds the index from the record headers, the pixel data is not read
+	bool ThumbnailCache::m_ScanPack()
+	{
+		File file;
+		if(!file.OpenRead(m_packPath))
+			return false;
+
+		const size_t size = file.GetSize();
+		if(size < sizeof(PackHeader) || size > m_maxPackSize)
+			return false;
+
+		PackHeader packHeader;
+		if(file.Read(&packHeader, sizeof(packHeader)) != sizeof(packHeader))
+			return false;
+		if(memcmp(packHeader.magic, packMagic, sizeof(packMagic)) != 0 || packHeader.version != packVersion)
+			return false;
+
+		size_t offset = sizeof(PackHeader);
+		while(offset < size)
+		{
+			if(offset + sizeof(RecordHeader) > size)
+				return false;
+			RecordHeader header;
+			file.Seek(offset);
+			if(file.Read(&header, sizeof(header)) != sizeof(header))
+				return false;
+			if(header.magic != recordMagic || header.width <= 0 || header.height <= 0)
+				return false;
+			if(offset + sizeof(header) + header.pathLength > size)
+				return false;
+
+			const size_t pixelOffset = offset + sizeof(header) + header.pathLength;
+			const size_t pixelSize = (size_t)header.width * header.height * sizeof(Colori);
+			// Incomplete record (e.g. the game was closed while writing)
+			if(pixelOffset + pixelSize > size)
+				return false;
+
+			Entry entry;
+			entry.path.resize(header.pathLength);
+			if(file.Read(&entry.path.front(), header.pathLength) != header.pathLength)
+				return false;
+			entry.requestedSize = Vector2i(header.requestedWidth, header.requestedHeight);
+			entry.pixelOffset = pixelOffset;
+			entry.lastWriteTime = header.lastWriteTime;
+			entry.size = Vector2i(header.width, header.height);
+			m_entries[m_Key(entry.path, entry.requestedSize)] = entry;
+
+			offset = pixelOffset + pixelSize;
+		}
+
+		m_packSize = size;
+		return true;
+	}
+
+	bool ThumbnailCache::m_CreatePack()
+	{
+		m_reader.Close();
+		m_entries.clear();
+		Path::Delete(m_packPath);
+
+		File file;
+		if(!file.OpenWrite(m_packPath))
+			return false;
+
+		PackHeader header;
+		memcpy(header.magic, packMagic, sizeof(packMagic));
+		header.version = packVersion;
+		if(file.Write(&header, sizeof(header)) != sizeof(header))
+			return false;
+		m_packSize = sizeof(header);
+		return true;
+	}
+
+	String ThumbnailCache::m_Key(const String& imagePath, Vector2i size)
+	{
+		return Utility::Sprintf("%dx%d:%s", size.x, size.y, imagePath);
+	}
+}
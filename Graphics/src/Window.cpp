@@ -278,6 +278,7 @@ namespace Graphics
 			SDL_Event evt;
 			while (SDL_PollEvent(&evt))
 			{
+				m_eventTime = evt.common.timestamp;
 				if (evt.type == SDL_EventType::SDL_KEYDOWN)
 				{
 					HandleKeyEvent(evt.key.keysym, 1, evt.key.repeat);
@@ -589,6 +590,8 @@ namespace Graphics
 		Map<SDL_Scancode, uint8> m_keyStates;
 		KeyMap m_keyMapping;
 		ModifierKeys m_modKeys = ModifierKeys::None;
+		// SDL timestamp of the event that is being handled
+		uint32 m_eventTime = 0;
 
 		// Gamepad input
 		Map<int32, Ref<Gamepad_Impl>> m_gamepads;
@@ -702,6 +705,11 @@ namespace Graphics
 		return m_impl->m_modKeys;
 	}
 
+	uint32 Window::GetEventTime() const
+	{
+		return m_impl->m_eventTime;
+	}
+
 	bool Window::IsActive() const
 	{
 		return SDL_GetWindowFlags(m_impl->m_window) & SDL_WindowFlags::SDL_WINDOW_INPUT_FOCUS;
@@ -2,6 +2,11 @@
 #include "SkinHttp.hpp"
 #include "SkinIR.hpp"
 #include "Scoring.hpp"
+#include <Graphics/ThumbnailCache.hpp>
+#include <Graphics/TextureUploadQueue.hpp>
+#include <Graphics/TextureResidency.hpp>
+#include <Shared/LuaGCScheduler.hpp>
+#include <Shared/FramePacer.hpp>
 
 #define DISCORD_APPLICATION_ID "514489760568573952"
 
@@ -28,6 +33,20 @@ public:
 		int texture;
 		bool loaded = false;
 		Job loadingJob;
+		// Set once the image is loaded, the texture is created when the upload finished
+		Ref<Graphics::TextureUpload> upload;
+		// Size of the loaded texture
+		Vector2i size;
+		// Path and requested size, kept to load the image again after it was evicted
+		String path;
+		Vector2i maxSize;
+		bool web = false;
+		// Id in the texture residency manager, the texture is deleted when it's evicted
+		uint32 residency = 0;
+		bool evicted = false;
+		// Image given to lua, stays the same when the texture is loaded again so it's resolved when drawing
+		int handle = 0;
+		int placeholder = 0;
 	};
 	void ApplySettings();
 	// Runs the application
@@ -67,8 +86,12 @@ public:
 	Sample LoadSample(const String& name, const bool& external = false);
 	Graphics::Font LoadFont(const String& name, const bool& external = false);
 	int LoadImageJob(const String& path, Vector2i size, int placeholder, const bool& web = false);
+	// Gives the current nanovg image of an image handed to lua, loads evicted jackets again
+	int ResolveImage(int image);
 	void SetScriptPath(lua_State* L);
 	lua_State* LoadScript(const String& name, bool noError = false);
+	// Creates an empty lua state whose garbage collection is scheduled by the application, close it with DisposeLua
+	lua_State* NewLuaState(const String& name);
 	void ReloadScript(const String& name, lua_State* L);
 	void ShowLuaError(const String& error);
 
@@ -113,8 +136,17 @@ private:
 	void m_SaveConfig();
 	void m_InitDiscord();
 	bool m_Init();
+	// Runs the headless chart simulator or scoring benchmark, nothing but the config is initialized
+	int32 m_RunSimulation();
 	void m_MainLoop();
 	void m_Tick();
+	void m_RenderLuaStats();
+	void m_RenderTextureStats();
+	void m_QueueJacketJob(CachedJacketImage* image);
+	// Marks a jacket as used and returns its current texture, 0 while it's loading
+	int m_UseJacket(CachedJacketImage* image);
+	// Updates the memory of textures outside the residency manager and evicts jackets that are over the budget
+	void m_UpdateTextureResidency();
 	void m_Cleanup();
 	void m_OnKeyPressed(SDL_Scancode code);
 	void m_OnKeyReleased(SDL_Scancode code);
@@ -134,18 +166,27 @@ private:
 	Material m_fillMaterial;
 	Material m_guiTex;
 	Map<String, CachedJacketImage*> m_jacketImages;
+	Map<int, CachedJacketImage*> m_jacketHandles;
+	Graphics::ThumbnailCache m_jacketCache;
+	Graphics::TextureUploadQueue* m_textureUploads = nullptr;
+	Graphics::TextureResidency m_textureResidency;
 	String m_lastMapPath;
 	Thread m_updateThread;
 	class Beatmap* m_currentMap = nullptr;
 	SkinHttp m_skinHttp;
 	SkinIR m_skinIR;
+	LuaGCScheduler m_luaGC;
 
 	float m_deltaTime;
-	float m_fpsTargetSleepMult = 1.0f;
+	FramePacer m_framePacer;
 	float m_appTime;
 	bool m_allowMapConversion;
 	bool m_hasUpdate = false;
 	bool m_showFps = false;
+	bool m_showLuaStats = false;
+	bool m_showTextureStats = false;
+	// Profiling capture started with -profile, written when the game is closed
+	String m_profilePath;
 	String m_updateUrl;
 	String m_updateDownload;
 	String m_updateVersion;
@@ -173,6 +214,9 @@ public:
 	String imagePath;
 	int w = 0, h = 0;
 	bool web = false;
+	// Downscaled jackets of local images are read from and stored in this cache
+	Graphics::ThumbnailCache* cache = nullptr;
+	Graphics::TextureUploadQueue* uploadQueue = nullptr;
 	Application::CachedJacketImage* target;
 };
 
@@ -0,0 +1,77 @@
+#pragma once
+#include <Audio/AudioStream.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct ChartIndex;
+class MapDatabase;
+
+/*
+	Computes the offsets of charts with the OffsetComputer on a background thread that only runs when the CPU is idle
+
+	Charts are analysed in the order of their paths so the music shared by the charts of a song is only decoded once.
+	Results are stored in the charts and the map database by Update on the main thread,
+	charts that were removed or got an offset from somewhere else in the meantime are left alone
+*/
+class OffsetAnalyzer : public Unique
+{
+public:
+	~OffsetAnalyzer();
+
+	// Stops a previous analysis
+	void Start(const Vector<ChartIndex*>& charts);
+	void Stop();
+	// Waits before the next chart until resumed
+	void Pause();
+	void Resume();
+
+	bool IsRunning() const { return m_thread.joinable() && !m_finished; }
+
+	// Stores finished results, call from the main thread
+	void Update(MapDatabase& database);
+
+private:
+	struct Request
+	{
+		String hash;
+		String path;
+		int32 offset;
+	};
+	struct Result
+	{
+		const Request* request;
+		bool success = false;
+		double offset = 0.0;
+		// Times in ms
+		double loadTime = 0.0;
+		double onsetTime = 0.0;
+		double correlationTime = 0.0;
+	};
+
+	void m_Run();
+	void m_Analyse(const Request& request, Result& result);
+
+	std::thread m_thread;
+	std::atomic<bool> m_stop{ false };
+	std::atomic<bool> m_finished{ false };
+	// Only written before the thread is started
+	Vector<Request> m_requests;
+
+	std::mutex m_lock;
+	std::condition_variable m_resume;
+	bool m_paused = false;
+	Vector<Result> m_results;
+
+	// Music of the previous chart, only used by the analysis thread
+	String m_audioPath;
+	Ref<AudioStream> m_music;
+
+	// Totals for the summary when all charts are done
+	uint32 m_numResults = 0;
+	uint32 m_numFailed = 0;
+	double m_totalLoadTime = 0.0;
+	double m_totalOnsetTime = 0.0;
+	double m_totalCorrelationTime = 0.0;
+};
@@ -0,0 +1,5 @@
+#pragma once
+
+// Computes the offset of a chart, or of every chart in a folder, with the cross correlation and with the brute force search
+//	logs the time each step takes and how often both agree within 1 ms
+bool RunOffsetBenchmark(const String& path);
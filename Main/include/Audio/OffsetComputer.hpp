@@ -17,8 +17,19 @@ public:
 	OffsetComputer& operator= (const OffsetComputer&) = delete;
 	OffsetComputer& operator= (OffsetComputer&&) = delete;
 
+	// Finds the offset that lines the beats of the chart up with the onsets in the music,
+	// outOffset is also the center of the offsets that are considered
 	bool Compute(int& outOffset);
+	// Same as Compute with sub millisecond precision, the fitness of all offsets is computed at once with a cross correlation
+	bool ComputePrecise(double& outOffset);
+	// Evaluates the fitness of every offset separately, the offset benchmark checks the cross correlation against it
+	bool ComputeBruteForce(int& outOffset);
+	// Reads the beats and computes the onsets around center, the Compute functions do this when needed
+	bool ComputeOnsets(MapTime center);
+
 	static bool Compute(const ChartIndex* chart, int& outOffset);
+	// Loads a chart and the path of its music without effects, doesn't need an AudioPlayback so it can be used on any thread
+	static bool LoadChart(const String& chartPath, Beatmap& outBeatmap, String& outAudioPath);
 
 private:
 	struct Beat {
@@ -45,6 +56,7 @@ private:
 	const Beatmap& m_beatmap;
 
 	MapTime m_offsetCenter = 0;
+	bool m_hasOnsets = false;
 
 	// Reads the beats from the chart
 	void ReadBeats();
@@ -9,8 +9,14 @@ public:
 	virtual ~Background() = default;
 	virtual bool Init(bool foreground) = 0;
 	virtual void Render(float deltaTime) = 0;
+	// True when the shader samples what was rendered before it as texFrameBuffer
+	virtual bool SamplesFrame() const { return false; }
 
 	class Game* game;
+	// Size of the target the background renders into, the window size when not set
+	Vector2i resolution;
+	// Rendered frame sampled by the shader, the framebuffer is copied when not set
+	Texture frameTexture;
 };
 
 // Creates the default game background
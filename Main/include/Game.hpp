@@ -2,6 +2,7 @@
 #include "ApplicationTickable.hpp"
 #include "AsyncLoadable.hpp"
 #include <Beatmap/MapDatabase.hpp>
+#include <Beatmap/InputReplay.hpp>
 #include "json.hpp"
 #include "GameFailCondition.hpp"
 #include "HitStat.hpp"
@@ -41,6 +42,11 @@ GameFlags operator|(const GameFlags& a, const GameFlags& b);
 GameFlags operator&(const GameFlags& a, const GameFlags& b);
 GameFlags operator~(const GameFlags& a);
 
+// Loads a chart file, returns null if the chart couldn't be read
+Ref<class Beatmap> TryLoadMap(const String& path);
+// Mirrors the lanes of all objects in a chart
+void ApplyMirror(class Beatmap& beatmap);
+
 /*
 	Main game scene / logic manager
 */
@@ -98,6 +104,10 @@ public:
 	virtual class Camera& GetCamera() = 0;
 	virtual class BeatmapPlayback& GetPlayback() = 0;
 	virtual class Scoring& GetScoring() = 0;
+	// Latest gameplay state, unlike the scoring this can be read while the gameplay thread runs
+	virtual const struct GameplaySnapshot& GetGameplaySnapshot() const = 0;
+	// Input recorded during gameplay
+	virtual const InputReplay& GetInputReplay() const = 0;
 	// Samples of the gauge for the performance graph
 	virtual const std::array<float, 256>& GetGaugeSamples() = 0;
 	virtual PlaybackOptions GetPlaybackOptions() = 0;
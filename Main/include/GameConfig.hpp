@@ -51,6 +51,8 @@ DefineEnum(GameConfigKeys,
 		   Laser0Color,
 		   Laser1Color,
 		   FPSTarget,
+		   JustInTimeRender,
+		   TextureMemoryBudget,
 		   GaugeDrainNormal,
 		   GaugeDrainHalf,
 
@@ -64,6 +66,7 @@ DefineEnum(GameConfigKeys,
 		   DistantButtonScale,
 		   BTOverFXScale,
 		   DisableBackgrounds,
+		   HalfResolutionBackground,
 		   ScoreDisplayMode,
 		   AutoComputeSongOffset,
 		   UpdateSongOffsetAfterFirstPlay,
@@ -150,6 +153,7 @@ DefineEnum(GameConfigKeys,
 		   AutoResetToSpeed,		//Mod-Speed to reset to after each song (when AutoResetSettings is true)
 		   SlamThicknessMultiplier, //TODO: Remove after better values have been found(?)
 		   DelayedHitEffects,		// TODO: Think of a better name
+		   BakeLaserMeshes,			// Generate all laser meshes when a chart is loaded
 
 		   EditorPath,
 		   EditorParamsFormat,
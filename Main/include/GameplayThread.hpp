@@ -0,0 +1,158 @@
+#pragma once
+#include <Shared/FixedRateThread.hpp>
+#include <Shared/TripleBuffer.hpp>
+#include <Beatmap/BeatmapPlayback.hpp>
+#include <Beatmap/InputReplay.hpp>
+#include "Scoring.hpp"
+#include "Input.hpp"
+#include <mutex>
+
+// Gameplay state published by the gameplay thread after every step
+struct GameplaySnapshot
+{
+	uint64 step = 0;
+	MapTime time = 0;
+	uint32 score = 0;
+	uint32 combo = 0;
+	uint32 maxCombo = 0;
+	uint8 comboState = 2;
+	// Miss, good and perfect counts
+	uint32 categorizedHits[3] = { 0 };
+	// Value, type, options and name of the top gauge, the name is null without a gauge
+	float gauge = 0.0f;
+	GaugeType gaugeType = GaugeType::Normal;
+	uint32 gaugeOptions = 0;
+	const char* gaugeName = nullptr;
+	float laserPositions[2] = { 0.0f };
+	float laserTargetPositions[2] = { 0.0f };
+	bool lasersAreExtend[2] = { false };
+	float timeSinceLaserUsed[2] = { 0.0f };
+	bool laserHeld[2] = { false };
+	float laserRollOutput[2] = { 0.0f };
+	// Input of the music filter, applied while a laser other than a slam is held
+	float laserOutput = 0.0f;
+	bool laserFilterHeld = false;
+	// Objects held by the buttons [0,5] and lasers [6,7]
+	ObjectState* heldObjects[8] = { nullptr };
+	bool failed = false;
+
+	bool IsObjectHeld(uint32 index) const { return heldObjects[index] != nullptr; }
+	// Same as Scoring::IsObjectHeld, a hold is held when any of its segments is
+	bool IsObjectHeld(ObjectState* object) const;
+};
+
+/*
+	Runs the BeatmapPlayback and Scoring of a play at a fixed rate on its own thread
+
+	Button and laser input is queued with the playback time it happened at and applied in order at that time,
+	so judgement doesn't depend on how long frames on the render thread take.
+	The render thread reads the latest state through a triple buffer without waiting for the gameplay thread,
+	anything else that touches the playback, scoring or input has to hold the state lock while the thread runs.
+	The renderer can't use the playback of the thread without the lock, so it keeps a second playback of the same chart.
+	Handlers registered with Defer are called on the thread that calls DispatchCalls instead of the gameplay thread
+*/
+class GameplayThread : public Unique
+{
+public:
+	// Current playback time, usually the audio position
+	typedef std::function<MapTime()> Clock;
+	typedef std::unique_lock<std::recursive_timed_mutex> StateLock;
+
+	GameplayThread(BeatmapPlayback& playback, Scoring& scoring, Input& input);
+	~GameplayThread();
+
+	void Start(Clock&& clock, uint32 rate = 1000);
+	// Can be called while holding the state lock
+	void Stop();
+	bool IsRunning() const { return m_thread.IsRunning(); }
+
+	// Blocks the gameplay thread between steps until the lock is released
+	StateLock LockState() { return StateLock(m_stateLock); }
+
+	// Thread safe, time is the playback time at which the input happened
+	void QueueButton(Input::Button button, bool pressed, MapTime time);
+	// Forwards the gameplay buttons of the source to the scoring input, queued with the time from eventClock while the thread runs
+	//	and applied right away otherwise, the source has to outlive this object
+	void ForwardButtons(Input& source, Clock&& eventClock);
+	// Playback time of an input event that happened age ms before now
+	//	events wait in the window's event queue until the next frame handles them
+	static MapTime GetEventTime(MapTime now, int32 age, float playbackSpeed);
+	// Laser movement is summed up until the next step
+	void QueueLaserInput(uint32 index, float dir);
+
+	// Switches to the latest published state, only one thread may read snapshots
+	//	while the thread is stopped the current state is published first
+	const GameplaySnapshot& GetSnapshot();
+
+	// Registers a handler that is called right away when the source is called on another thread,
+	//	calls from the gameplay thread are queued until the next DispatchCalls
+	//	the source has to outlive this object
+	template<typename Class, typename... A>
+	void Defer(Delegate<A...>& source, Class* object, void (Class::*func)(A...))
+	{
+		DelegateHandle handle = source.AddLambda([=](A... args)
+		{
+			if(!m_thread.IsCurrentThread())
+			{
+				(object->*func)(args...);
+				return;
+			}
+			std::lock_guard<std::mutex> lock(m_callLock);
+			m_calls.push_back([=]() { (object->*func)(args...); });
+		});
+		m_deferred.push_back([&source, handle]() { source.Remove(handle); });
+	}
+	// Calls the handlers queued by the gameplay thread
+	void DispatchCalls();
+
+	// Every step is recorded in this replay while the thread runs, steps without input only add a repeat to the last frame
+	void SetReplay(InputReplay* replay) { m_replay = replay; }
+
+	// Replaces the clock the steps are scheduled with, see FixedRateThread::SetClock
+	void SetThreadClock(FixedRateThread::NowFunction now, FixedRateThread::SleepFunction sleepUntil);
+	uint64 GetNumSteps() const { return m_thread.GetNumSteps(); }
+	uint64 GetNumDroppedSteps() const { return m_thread.GetNumDroppedSteps(); }
+
+private:
+	struct QueuedInput
+	{
+		MapTime time;
+		Input::Button button;
+		bool pressed;
+	};
+
+	void m_Step(uint64 step, double time);
+	void m_ForwardButton(Input::Button button, bool pressed);
+	void m_ApplyButton(const QueuedInput& input);
+	void m_Tick(float deltaTime);
+	void m_PublishSnapshot(uint64 step);
+
+	BeatmapPlayback& m_playback;
+	Scoring& m_scoring;
+	Input& m_input;
+	InputReplay* m_replay = nullptr;
+
+	Clock m_clock;
+	Clock m_eventClock;
+	FixedRateThread m_thread;
+	uint64 m_lastStep = 0;
+	double m_lastStepTime = 0.0;
+
+	std::recursive_timed_mutex m_stateLock;
+	std::atomic<bool> m_stopping{ false };
+
+	std::mutex m_inputLock;
+	Vector<QueuedInput> m_queuedInput;
+	float m_queuedLaserInput[2] = { 0.0f };
+	// Input taken from the queue that is not due yet, only used by the gameplay thread
+	Vector<QueuedInput> m_pendingInput;
+	float m_laserInput[2] = { 0.0f };
+
+	std::mutex m_callLock;
+	Vector<std::function<void()>> m_calls;
+	Vector<std::function<void()>> m_dispatching;
+	// Removes the handlers added by Defer and ForwardButtons
+	Vector<std::function<void()>> m_deferred;
+
+	TripleBuffer<GameplaySnapshot> m_snapshots;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include "Shared/RequestPool.hpp"
+#include <atomic>
+#include <future>
+
+struct HttpRequest
+{
+	enum class Method
+	{
+		Get,
+		Post,
+	};
+	Method method = Method::Get;
+	String url;
+	cpr::Header header;
+	cpr::Parameters parameters;
+	String body;
+	// Posted as a multipart form instead of the body when set
+	Ref<cpr::Multipart> multipart;
+};
+
+/*
+	Http client shared by skin scripts, IR and web jackets
+	requests are done by a small RequestPool, every worker keeps a cpr::Session per host so connections stay alive between requests
+*/
+class HttpClient : public Unique
+{
+public:
+	typedef std::function<void(cpr::Response&&)> Callback;
+
+	HttpClient(uint32 numWorkers = 4);
+
+	// The callback is called on a worker thread as soon as the response arrives, it is not called for cancelled requests
+	RequestId Send(HttpRequest&& request, RequestPriority priority, const void* owner, Callback&& callback);
+	// Returns the response through a future instead
+	std::future<cpr::Response> Send(HttpRequest&& request, RequestPriority priority = RequestPriority::Normal);
+	bool Cancel(RequestId id);
+	void CancelOwner(const void* owner);
+
+	// Number of sessions that were created, each one keeps its own connection
+	uint32 GetNumSessions() const { return m_numSessions; }
+
+	// Scheme, host and port of an url, used to pick a session
+	static String GetHost(const String& url);
+
+private:
+	cpr::Response m_Perform(uint32 worker, HttpRequest& request);
+
+	// Sessions of every worker by host, only used by the worker itself
+	Vector<Map<String, Ref<cpr::Session>>> m_sessions;
+	std::atomic<uint32> m_numSessions{ 0 };
+	// Destroyed first so no worker uses the sessions anymore
+	RequestPool m_pool;
+};
+
+extern HttpClient* g_httpClient;
@@ -1,6 +1,7 @@
 #pragma once
 #include <Beatmap/MapDatabase.hpp>
 #include <Beatmap/BeatmapObjects.hpp>
+#include "HttpClient.hpp"
 
 #ifdef Success
 #undef Success
@@ -43,12 +44,13 @@ namespace IR
         ~ResponseState() = delete;
     };
 
-    cpr::AsyncResponse PostScore(const ScoreIndex& score, const BeatmapSettings& map);
-    cpr::AsyncResponse Heartbeat();
-    cpr::AsyncResponse ChartTracked(String chartHash);
-    cpr::AsyncResponse Record(String chartHash);
-    cpr::AsyncResponse Leaderboard(String chartHash, String mode, int n);
-    cpr::AsyncResponse PostReplay(String identifier, String replayPath);
+    // Requests are sent through g_httpClient
+    HttpRequest PostScore(const ScoreIndex& score, const BeatmapSettings& map);
+    HttpRequest Heartbeat();
+    HttpRequest ChartTracked(String chartHash);
+    HttpRequest Record(String chartHash);
+    HttpRequest Leaderboard(String chartHash, String mode, int n);
+    HttpRequest PostReplay(String identifier, String replayPath);
 
     bool ValidateReturn(const nlohmann::json& json);
     bool ValidatePostScoreReturn(const nlohmann::json& json);
@@ -31,6 +31,8 @@ public:
 
 	~Input();
 	void Init(Graphics::Window& wnd);
+	// Initializes input without a window, state is only changed through the Simulate functions
+	void InitHeadless();
 	void Cleanup();
 
 	// Poll/Update input
@@ -58,6 +60,11 @@ public:
 	// Request laser input state without sensitivity applied
 	float GetAbsoluteInputLaserDir(uint32 laserIdx);
 
+	// Sets the state of a button as if it was pressed or released on a device
+	void SimulateButton(Button button, bool pressed);
+	// Sets the laser movement returned by GetInputLaserDir
+	void SimulateLaserDir(uint32 laserIdx, float dir);
+
 	// Button delegates
 	Delegate<Button> OnButtonPressed;
 	Delegate<Button> OnButtonReleased;
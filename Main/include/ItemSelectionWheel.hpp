@@ -459,22 +459,7 @@ public:
 				isFiltered = true;
 		}
 		m_filterSet = isFiltered;
-
-		// Add the filtered maps into the sort vec then sort
-		m_sortVec.clear();
-		for (auto &it : m_itemFilter)
-		{
-			m_sortVec.push_back(it.first);
-		}
-		m_doSort();
-
-		// Clear the current queue of random charts
-		m_randomVec.clear();
-		
-		// Try to go back to selected song in new sort
-		SelectLastItemIndex(isFiltered);
-
-		m_SetCurrentItems();
+		m_OnFilterChanged();
 	}
 
 	void ClearFilter()
@@ -519,7 +504,27 @@ protected:
 	virtual DBIndex* m_getDBEntryFromItemIndex(const ItemSelectIndex*) const = 0;
 	virtual DBIndex* m_getDBEntryFromItemIndex(const ItemSelectIndex) const = 0;
 
-	void m_doSort()
+	// Sorts the items of the current filter and reselects the last item
+	void m_OnFilterChanged()
+	{
+		// Add the filtered maps into the sort vec then sort
+		m_sortVec.clear();
+		for (auto &it : m_SourceCollection())
+		{
+			m_sortVec.push_back(it.first);
+		}
+		m_doSort();
+
+		// Clear the current queue of random charts
+		m_randomVec.clear();
+
+		// Try to go back to selected song in new sort
+		SelectLastItemIndex(m_filterSet);
+
+		m_SetCurrentItems();
+	}
+
+	virtual void m_doSort()
 	{
 		if (m_currentSort == nullptr)
 		{
@@ -1,13 +1,61 @@
 #pragma once
 #include <Beatmap/BeatmapObjects.hpp>
+#include <unordered_map>
+
+/*
+	View distance of a chart as a piecewise linear function of time, precomputed at every timing point and stop
+	the distance between two points in time is the difference of their values, this does not depend on the hi-speed
+*/
+class ViewDistanceCurve
+{
+public:
+	void Build(class BeatmapPlayback& playback);
+	void Clear();
+	bool IsValid() const { return !m_times.empty(); }
+	double Evaluate(MapTime time) const;
+
+private:
+	Vector<MapTime> m_times;
+	Vector<double> m_distances;
+};
 
 class LaserTrackBuilder
 {
 public:
+	// Range of a baked chunk mesh that contains part of a laser
+	struct BakedMesh
+	{
+		Mesh mesh;
+		uint32 firstVertex = 0;
+		uint32 vertexCount = 0;
+		// Position of the geometry on the ViewDistanceCurve
+		double viewDistance = 0.0;
+	};
+	// Baked geometry of a laser segment, the body is stored without laserLengthScale applied
+	struct BakedLaser
+	{
+		BakedMesh body;
+		BakedMesh entry;
+		BakedMesh exit;
+	};
+
 	LaserTrackBuilder(class OpenGL* gl, class Track* track, uint32 laserIndex);
 	void Reset();
 	void Update(MapTime newTime);
 
+	// Generates the geometry of all lasers of the chart into a few static meshes split by time
+	//	laserLengthScale is only used for the texture coordinates, so the baked geometry stays valid when it changes
+	void Bake(class BeatmapPlayback& playback, const ViewDistanceCurve& viewDistance);
+	void ClearBaked();
+	bool IsBaked() const { return !m_bakedChunks.empty(); }
+	// Baked geometry of a laser or null if it isn't baked
+	const BakedLaser* GetBaked(const LaserObjectState* laser) const;
+	size_t GetNumBakedChunks() const { return m_bakedChunks.size(); }
+	size_t GetNumBakedLasers() const { return m_bakedLasers.size(); }
+
+	// Time range of the lasers in a single baked mesh
+	static const MapTime bakedChunkDuration = 10000;
+
 	// Generates a normal segment
 	Mesh GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser);
 
@@ -54,6 +102,14 @@ private:
 private:
 	void m_RecalculateConstants();
 	void m_Cleanup(MapTime newTime, Map<LaserObjectState*, Mesh>& arr);
+	// Geometry of a segment, lengths are multiplied by lengthScale
+	void m_GenerateTrackVertices(class BeatmapPlayback& playback, LaserObjectState* laser, float lengthScale, Vector<MeshGenerators::SimpleVertex>& verts);
+	void m_GenerateEntryVertices(LaserObjectState* laser, Vector<MeshGenerators::SimpleVertex>& verts);
+	// The exit starts at the given distance from the start of the segment
+	void m_GenerateExitVertices(LaserObjectState* laser, float offset, Vector<MeshGenerators::SimpleVertex>& verts);
+	// Length of a segment without laserLengthScale, slams use slamDuration
+	float m_GetSegmentLength(class BeatmapPlayback& playback, LaserObjectState* laser);
+
 	class OpenGL* m_gl;
 	class Track* m_track;
 
@@ -63,4 +119,7 @@ private:
 	Map<LaserObjectState*, Mesh> m_objectCache;
 	Map<LaserObjectState*, Mesh> m_cachedEntries;
 	Map<LaserObjectState*, Mesh> m_cachedExits;
+
+	Vector<Mesh> m_bakedChunks;
+	std::unordered_map<const LaserObjectState*, BakedLaser> m_bakedLasers;
 };
\ No newline at end of file
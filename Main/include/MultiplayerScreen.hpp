@@ -80,6 +80,12 @@ public:
 		return &m_finalStats;
 	}
 
+	// Last scoreboard received during a game
+	const MultiplayerProtocol::Scoreboard& GetScoreboard() const
+	{
+		return m_scoreboard;
+	}
+
 	TCPSocket& GetTCP()
 	{
 		return m_tcp;
@@ -138,6 +144,8 @@ private:
 	bool m_handleError(nlohmann::json& packet);
 	void m_handleSocketClose();
 	bool m_handleFinalStats(nlohmann::json& packet);
+	bool m_handleScoreboard(nlohmann::json& packet);
+	bool m_handleBinaryScoreboard(const String& packet);
 	void m_SetCurrentChartOffset(int newValue);
 
 	void m_onDatabaseUpdateStart(int max);
@@ -214,6 +222,11 @@ private:
 	// Socket to talk to the server
 	TCPSocket m_tcp;
 
+	// Score updates and scoreboards are sent as binary packets when the server supports it
+	bool m_binaryProtocol = false;
+	Buffer m_binaryPacket;
+	MultiplayerProtocol::Scoreboard m_scoreboard;
+
 	// Database ids of the selected map
 	int32 m_selectedMapId = 0;
 	String m_selectedMapShortPath;
@@ -255,6 +268,8 @@ private:
 	float m_speedBPM;
 
 	Vector<nlohmann::json> m_finalStats;
+	// Sort keys of m_finalStats
+	Vector<int> m_finalStatKeys;
 
 	DBUpdateScreen* m_dbUpdateScreen = nullptr;
 
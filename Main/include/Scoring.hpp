@@ -3,6 +3,8 @@
 #include "HitStat.hpp"
 #include "Input.hpp"
 #include "Game.hpp"
+#include <Shared/RingBuffer.hpp>
+#include <Shared/ObjectArena.hpp>
 
 #define AUTOPLAY_BUTTON_HIT_DURATION (4 / 60.f)
 
@@ -98,6 +100,9 @@ public:
 	// Called after SetPlayback
 	void Reset(const MapTimeRange& range = {});
 
+	// Overrides the input offsets and bounce guard read from the config by Reset
+	void SetInputOffsets(int32 inputOffset, int32 laserOffset, int32 bounceGuard);
+
 	void FinishGame();
 
 	// Updates the list of objects that are possible to hit
@@ -119,6 +124,8 @@ public:
 	// Check if an object is currently held, by object index
 	//	Buttons[0,5], Lasers[6,7]
 	bool IsObjectHeld(uint32 index) const;
+	// The object held by a button or laser, null when nothing is held
+	ObjectState* GetHeldObject(uint32 index) const;
 	// Check if a laser is currently held
 	bool IsLaserHeld(uint32 laserIndex, bool includeSlams = true) const;
 
@@ -288,7 +295,11 @@ private:
 
 	// Creates or retrieves an existing hit stat and returns it
 	HitStat* m_AddOrUpdateHitStat(ObjectState* object);
+	// Adds the hit stat of a single hold or laser tick
+	void m_AddTickHitStat(const ScoreTick* tick, ScoreHitRating rating);
 	void m_CleanupHitStats();
+	// Calculates the tick counts of all hold objects and laser chains and reserves the tick queues for them
+	void m_CalculateLongObjectTicks();
 
 	LaserObjectState* m_GetLaserObjectWithinTwoBeats(uint8 index);
 
@@ -324,8 +335,20 @@ private:
 	float m_drainMultiplier = 1.0f;
 	MapTime m_endTime = 180000;
 
-	// used the update the amount of hit ticks for hold/laser notes
-	Map<ObjectState*, HitStat*> m_holdHitStats;
+	// Hold objects and laser chain roots with their precalculated number of ticks
+	//	and the hit stat that is used to update the amount of hit ticks
+	struct LongObjectInfo
+	{
+		uint32 numTicks = 0;
+		HitStat* stat = nullptr;
+	};
+	Map<ObjectState*, LongObjectInfo> m_longObjects;
+
+	// Storage for all hit stats of the current game
+	ObjectArena<HitStat> m_hitStatArena;
+	// Reused when calculating the ticks of an object that entered
+	Vector<MapTime> m_holdTickBuffer;
+	Vector<ScoreTick> m_laserTickBuffer;
 
 	// Laser objects currently in range
 	//	used to sample target laser positions
@@ -334,7 +357,7 @@ private:
 	Vector<LaserObjectState*> m_laserSegmentQueue;
 
 	// Ticks for each BT[4] / FX[2] / Laser[2]
-	Vector<ScoreTick*> m_ticks[8];
+	RingBuffer<ScoreTick> m_ticks[8];
 
 	// Hold objects
 	ObjectState* m_holdObjects[8];
@@ -0,0 +1,5 @@
+#pragma once
+
+// Plays a chart with autoplay as fast as possible and reports the time spent in Scoring
+//	and, in builds with the COUNT_ALLOCATIONS option, the number of heap allocations made while playing
+bool RunScoringBenchmark(const String& mapPath);
@@ -0,0 +1,102 @@
+#pragma once
+#include <Beatmap/Beatmap.hpp>
+#include <Beatmap/BeatmapPlayback.hpp>
+#include <Beatmap/InputReplay.hpp>
+#include "Scoring.hpp"
+#include "Input.hpp"
+
+/*
+	Source of input events for a simulated play
+	Called once per simulation step before the scoring system is updated
+*/
+class SimulationInput
+{
+public:
+	virtual ~SimulationInput() = default;
+	// Apply all input events up to the given time
+	virtual void Update(MapTime time, Input& input) = 0;
+};
+
+// Button press or release of a simulated player
+struct SimulatedPress
+{
+	MapTime time;
+	Input::Button button;
+	bool pressed;
+};
+
+// Result of a single simulated play
+struct SimulationResult
+{
+	String path;
+	bool success = false;
+
+	uint32 score = 0;
+	uint32 perfects = 0;
+	uint32 goods = 0;
+	uint32 misses = 0;
+	uint32 maxCombo = 0;
+	float gauge = 0.0f;
+	ClearMark clearMark = ClearMark::NotPlayed;
+
+	// Copies of the hit stats recorded by the scoring system, object pointers are not valid after the simulation
+	Vector<HitStat> hitStats;
+
+	// Length of the simulated chart and the wall clock time it took to simulate
+	MapTime chartTime = 0;
+	double seconds = 0.0;
+};
+
+/*
+	Plays a chart without a window, audio or rendering as fast as possible
+	Each simulator owns its own input and scoring state so multiple simulators can run on different threads
+*/
+class GameplaySimulator : public Unique
+{
+public:
+	GameplaySimulator();
+	~GameplaySimulator();
+
+	bool Load(const String& mapPath);
+
+	// Plays the loaded chart from start to end in steps of the given length (ms)
+	//	uses autoplay when no input source is given
+	SimulationResult Run(SimulationInput* input = nullptr, MapTime step = 1);
+	// Plays the recorded frames of an input replay with the settings it was recorded with
+	//	the result should match the score stored in the replay
+	SimulationResult Replay(const InputReplay& replay);
+
+	// Presses every button object of the loaded chart a few ms off its time, lasers are not played
+	Vector<SimulatedPress> CreatePresses() const;
+	// Plays the loaded chart on a GameplayThread that is driven by a simulated clock, the presses are forwarded from an input like the ones of g_input
+	//	they are handled at the start of the first frame after they happen, frames are 1 ms long
+	//	every stallInterval ms the render side holds the state lock for stallLength ms, the gameplay thread catches up once it is released
+	SimulationResult RunThreaded(const Vector<SimulatedPress>& presses, MapTime stallInterval = 0, MapTime stallLength = 0);
+
+	PlaybackOptions options;
+	HitWindow hitWindow = HitWindow::NORMAL;
+
+	// Offsets used for judgement, the defaults are read from the config
+	int32 inputOffset = 0;
+	int32 laserOffset = 0;
+	int32 bounceGuard = 0;
+
+private:
+	void m_InitPlay(BeatmapPlayback& playback, Scoring& scoring, bool autoplay, MapTime initTime = 0, MapTime start = 0);
+	void m_FinishPlay(Scoring& scoring, SimulationResult& result);
+
+	String m_mapPath;
+	Ref<Beatmap> m_beatmap;
+	Input m_input;
+};
+
+// Re-simulates an input replay and checks if the result matches the recorded one
+bool RunReplayVerification(const String& mapPath, const String& replayPath);
+
+// Plays a chart on the gameplay thread with and without stalls on the render side
+//	checks that the same buttons are hit and that presses are judged no later than the step after the frame that handled them
+bool RunGameplayThreadVerification(const String& mapPath);
+
+// Simulates all charts found in the given path, using the given amount of threads (0 = number of cores)
+//	results are logged and optionally written to a csv file
+bool RunSimulation(const String& path, uint32 numThreads, const String& csvPath);
@@ -1,5 +1,6 @@
 #pragma once
 #include "LuaRequests.hpp"
+#include "HttpClient.hpp"
 
 //structs have been moved into shared LuaRequests header to stop IR from including Http or vice versa
 
@@ -18,13 +19,12 @@ public:
 	void ClearState(struct lua_State* L);
 
 private:
-	Thread m_requestThread;
 	Mutex m_mutex;
-	std::queue<AsyncRequest*> m_requests;
-	std::queue<CompleteRequest> m_callbackQueue;
-	bool m_running;
+	// Filled by the http workers as requests complete
+	Vector<CompleteRequest> m_callbackQueue;
+	Vector<CompleteRequest> m_processing;
 	Map<struct lua_State*, class LuaBindable*> m_boundStates;
 
-	void m_requestLoop();
+	void m_SendAsync(struct lua_State* L, HttpRequest&& request);
 	void m_PushResponse(struct lua_State* L, const cpr::Response& r);
 };
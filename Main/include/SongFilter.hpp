@@ -1,5 +1,6 @@
 #pragma once
 #include "SongSelect.hpp"
+#include "SongTable.hpp"
 #include "ChallengeSelect.hpp"
 #include <Beatmap/MapDatabase.hpp>
 
@@ -25,7 +26,12 @@ private:
 	String m_name = "All";
 };
 
-using SongFilter = Filter<SongSelectIndex>;
+class SongFilter : public Filter<SongSelectIndex>
+{
+public:
+	// Removes charts that don't pass this filter from the selected rows of the song wheel's table
+	virtual void FilterCharts(const SongTable& table, BitSet& charts) {}
+};
 
 class LevelFilter : public SongFilter
 {
@@ -33,6 +39,7 @@ public:
 	~LevelFilter() = default;
 	LevelFilter(uint16 level) : m_level(level) {}
 	Map<int32, SongSelectIndex> GetFiltered(const Map<int32, SongSelectIndex>& source) override;
+	void FilterCharts(const SongTable& table, BitSet& charts) override;
 	String GetName() const override;
 	bool IsAll() const override;
 	FilterType GetType() const override { return FilterType::Level; }
@@ -48,6 +55,7 @@ public:
 	FolderFilter(String folder, MapDatabase* database) : m_folder(folder), m_mapDatabase(database) {}
 	~FolderFilter() = default;
 	Map<int32, SongSelectIndex> GetFiltered(const Map<int32, SongSelectIndex>& source) override;
+	void FilterCharts(const SongTable& table, BitSet& charts) override;
 	String GetName() const override;
 	bool IsAll() const override;
 	FilterType GetType() const override { return FilterType::Folder; }
@@ -66,6 +74,7 @@ public:
 	~CollectionFilter() = default;
 
 	Map<int32, SongSelectIndex> GetFiltered(const Map<int32, SongSelectIndex>& source) override;
+	void FilterCharts(const SongTable& table, BitSet& charts) override;
 	String GetName() const override;
 	bool IsAll() const override;
 	FilterType GetType() const override { return FilterType::Collection; }
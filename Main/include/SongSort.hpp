@@ -1,5 +1,6 @@
 #pragma once
 #include "SongSelect.hpp"
+#include "SongTable.hpp"
 #include "ChallengeSelect.hpp"
 #include <Beatmap/MapDatabase.hpp>
 
@@ -35,88 +36,91 @@ class ItemSort
 		bool m_dir;
 };
 
-using SongSort = ItemSort<SongSelectIndex>;
+/*
+	Sorts songs by a precomputed key of a SongTable, items with the same key are ordered by title
+*/
+class SongSort : public ItemSort<SongSelectIndex>
+{
+	public:
+		SongSort(String name, bool dir) : ItemSort(name, dir) {};
+		// Builds a temporary table, the song wheel keeps its own one and uses the other overload
+		void SortInplace(Vector<uint32>& vec, const Map<int32,
+				SongSelectIndex>& collection) override;
+		void SortInplace(Vector<uint32>& vec, const SongTable& table);
+	protected:
+		virtual SongTable::Key m_GetKey() const = 0;
+};
 
 class TitleSort : public SongSort
 {
 	public:
 		TitleSort(String name, bool dir) : SongSort(name, dir) {};
-		void SortInplace(Vector<uint32>& vec, const Map<int32,
-				SongSelectIndex>& collection) override;
-		virtual bool CompareSongs(const SongSelectIndex& song_a,
-				const SongSelectIndex& song_b);
 		SortType GetType() const override
 		{ 
 			return m_dir? SortType::TITLE_DESC : SortType::TITLE_ASC;
 		};
+	protected:
+		SongTable::Key m_GetKey() const override { return SongTable::Key::Title; }
 };
 
-class ScoreSort : public TitleSort
+class ScoreSort : public SongSort
 {
 	public:
-		ScoreSort(String name, bool dir) : TitleSort(name, dir) {};
-		void SortInplace(Vector<uint32>& vec, const Map<int32,
-				SongSelectIndex>& collection) override;
+		ScoreSort(String name, bool dir) : SongSort(name, dir) {};
 		SortType GetType() const override
 		{ 
 			return m_dir? SortType::SCORE_DESC : SortType::SCORE_ASC;
 		};
-	private:
-		Map<uint32, uint32> m_scoreMap;
+	protected:
+		SongTable::Key m_GetKey() const override { return SongTable::Key::Score; }
 };
 
-class DateSort : public TitleSort
+class DateSort : public SongSort
 {
 	public:
-		DateSort(String name, bool dir) : TitleSort(name, dir) {};
-		void SortInplace(Vector<uint32>& vec, const Map<int32,
-				SongSelectIndex>& collection) override;
+		DateSort(String name, bool dir) : SongSort(name, dir) {};
 		SortType GetType() const override
 		{ 
 			return m_dir? SortType::DATE_DESC : SortType::DATE_ASC;
 		};
-	private:
-		Map<uint32, uint64> m_dateMap;
+	protected:
+		SongTable::Key m_GetKey() const override { return SongTable::Key::Date; }
 };
 
-class ArtistSort : public TitleSort
+class ArtistSort : public SongSort
 {
 	public:
-		ArtistSort(String name, bool dir) : TitleSort(name, dir) {};
-		void SortInplace(Vector<uint32>& vec, const Map<int32,
-				SongSelectIndex>& collection) override;
+		ArtistSort(String name, bool dir) : SongSort(name, dir) {};
 		SortType GetType() const override
 		{ 
 			return m_dir? SortType::ARTIST_DESC : SortType::ARTIST_ASC;
 		};
-	private:
-		Map<uint32, uint64> m_dateMap;
+	protected:
+		SongTable::Key m_GetKey() const override { return SongTable::Key::Artist; }
 };
 
-class EffectorSort : public TitleSort
+class EffectorSort : public SongSort
 {
 	public:
-		EffectorSort(String name, bool dir) : TitleSort(name, dir) {};
-		void SortInplace(Vector<uint32>& vec, const Map<int32,
-				SongSelectIndex>& collection) override;
+		EffectorSort(String name, bool dir) : SongSort(name, dir) {};
 		SortType GetType() const override
 		{ 
 			return m_dir? SortType::EFFECTOR_DESC : SortType::EFFECTOR_ASC;
 		};
+	protected:
+		SongTable::Key m_GetKey() const override { return SongTable::Key::Effector; }
 };
 
-class ClearMarkSort : public TitleSort
+class ClearMarkSort : public SongSort
 {
 	public:
-		ClearMarkSort(String name, bool dir) : TitleSort(name, dir) {};
-		void SortInplace(Vector<uint32>& vec, const Map<int32,
-				SongSelectIndex>& collection) override;
+		ClearMarkSort(String name, bool dir) : SongSort(name, dir) {};
 		SortType GetType() const override
 		{ 
 			return m_dir? SortType::EFFECTOR_DESC : SortType::EFFECTOR_ASC;
 		};
-	private:
-		Map<uint32, uint64> m_clearMap;
+	protected:
+		SongTable::Key m_GetKey() const override { return SongTable::Key::ClearMark; }
 };
 
 using ChallengeSort = ItemSort<ChallengeSelectIndex>;
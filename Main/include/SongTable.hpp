@@ -0,0 +1,73 @@
+#pragma once
+#include "SongSelect.hpp"
+#include <Shared/BitSet.hpp>
+#include <unordered_map>
+
+/*
+	Columnar copy of the songs in the song wheel
+
+	Every sort key is computed once when the songs change so sorting only compares integers,
+	strings are replaced by their rank among all uppercased strings of the same column.
+	Charts are stored per row with the charts of a folder next to each other, filters select charts with bitsets
+*/
+class SongTable
+{
+public:
+	enum class Key
+	{
+		Title,
+		Artist,
+		Effector,
+		Score,
+		ClearMark,
+		Date,
+	};
+
+	// Rebuilds all columns from folder items
+	void Build(const Map<int32, SongSelectIndex>& items);
+	void Invalidate() { m_valid = false; }
+	bool IsValid() const { return m_valid; }
+
+	// Key of a folder or single chart item, folders use the best score, clear mark and date of their charts
+	uint64 GetKey(Key key, int32 itemId) const;
+
+	size_t GetNumCharts() const { return m_charts.size(); }
+	size_t GetNumFolders() const { return m_folders.size(); }
+
+	// All charts with the given level
+	const BitSet& GetLevelCharts(int32 level) const;
+	// Removes charts of folders that are not in the given map of database folders
+	void SelectFolders(const Map<int32, FolderIndex*>& folders, BitSet& charts) const;
+	// Adds an item for every selected chart if splitCharts is set, otherwise for every folder with any selected chart
+	void GetItems(const BitSet& charts, bool splitCharts, Map<int32, SongSelectIndex>& items) const;
+
+private:
+	// Chart row of the first chart of an item or -1
+	int64 m_GetChartRow(int32 itemId, uint32& folderRow) const;
+
+	// Chart columns
+	Vector<ChartIndex*> m_charts;
+	Vector<uint32> m_chartFolder;
+	Vector<uint32> m_chartTitle;
+	Vector<uint32> m_chartArtist;
+	Vector<uint32> m_chartEffector;
+	Vector<int32> m_chartScore;
+	Vector<uint8> m_chartClearMark;
+	Vector<uint64> m_chartDate;
+	// Charts by level
+	Vector<BitSet> m_levelCharts;
+	BitSet m_noCharts;
+
+	// Folder columns
+	Vector<FolderIndex*> m_folders;
+	Vector<uint32> m_folderFirstChart;
+	Vector<uint32> m_folderNumCharts;
+	Vector<int32> m_folderScore;
+	Vector<uint8> m_folderClearMark;
+	Vector<uint64> m_folderDate;
+	// Folder rows by select id and by database id
+	std::unordered_map<int32, uint32> m_selectIdRows;
+	std::unordered_map<int32, uint32> m_folderIdRows;
+
+	bool m_valid = false;
+};
@@ -1,36 +1,7 @@
 #pragma once
 
-#ifdef _WIN32
-/* See http://stackoverflow.com/questions/12765743/getaddrinfo-on-win32 */
-#ifndef _WIN32_WINNT
-#define _WIN32_WINNT 0x0501  /* Windows XP. */
-#endif
-#include <winsock2.h>
-#include <Ws2tcpip.h>
-// XXX should be tracked elsewhere (not in source)?
-#pragma comment( lib, "ws2_32.lib")
-
-#define invalid_socket(s) (s == INVALID_SOCKET)
-#else
-/* Assume that any non-Windows platform uses POSIX-style sockets instead. */
-#include <sys/socket.h>
-#include <arpa/inet.h>
-#include <netdb.h>  /* Needed for getaddrinfo() and freeaddrinfo() */
-#include <unistd.h> /* Needed for close() */
-
-#define INVALID_SOCKET -1
-
-#define invalid_socket(s) (s < 0)
-
-typedef int SOCKET;
-#endif
-
-enum TCPPacketMode
-{
-	NOT_READING = 0,
-	JSON_LINE,
-	UNKNOWN
-};
+#include "Shared/TCPConnection.hpp"
+#include "Shared/MultiplayerProtocol.hpp"
 
 struct LuaTCPHandler
 {
@@ -51,6 +22,8 @@ public:
 
 	void SendLine(String);
 	void SendJSON(nlohmann::json packet);
+	// Only use after the server agreed on the binary protocol
+	void SendBinary(const Buffer& packet);
 
 	void PushFunctions(struct lua_State* L);
 	void ClearState(struct lua_State* L);
@@ -68,6 +41,17 @@ public:
 		m_topicHandlers.Add(topic, binding);
 	}
 
+	// Add a new bound member function for a binary topic
+	template<typename Class>
+	void SetBinaryHandler(MultiplayerProtocol::BinaryTopic topic, Class* object, bool (Class::* func)(const String&))
+	{
+		auto binding = new ObjectBinding<Class, bool, const String&>(object, func);
+		m_binaryHandlers.Add(topic, binding);
+	}
+
+	// Calls the lua handlers of a topic, push should push the packet table onto the given state
+	void CallLuaTopicHandler(const String& topic, std::function<void(struct lua_State*)> push);
+
 	// Add a bound member function to call on socket close
 	template<typename Class>
 	void SetCloseHandler(Class* object, void (Class::* func)(void))
@@ -83,7 +67,7 @@ public:
 
 	bool IsOpen()
 	{
-		return m_open;
+		return m_connection.IsOpen();
 	}
 
 	// TODO(itszn) move this somewhere else
@@ -91,29 +75,20 @@ public:
 	static void PushJsonObject(lua_State* L, const nlohmann::json& packet);
 
 private:
-	void m_processPacket(char* data, size_t length, TCPPacketMode mode);
-	void m_eraseBuffer(size_t end);
-
-
-	bool m_readyToRead();
+	void m_processPacket(const TCPPacket& packet);
 
 	// Bound lua states
 	Map<struct lua_State*, class LuaBindable*> m_boundStates;
 
 	// TODO(itszn) maybe support a stack of handlers per topic
 	Map<String, IFunctionBinding<bool, nlohmann::json&>*> m_topicHandlers;
+	Map<MultiplayerProtocol::BinaryTopic, IFunctionBinding<bool, const String&>*> m_binaryHandlers;
 	Map<String, LuaTCPHandler*> m_luaTopicHandlers;
 	IFunctionBinding<void>* m_closeCallback = nullptr;
 
-	// Underlying socket for the class
-	SOCKET m_socket;
-
-	// Tell if the socket is currently open and connected
-	bool m_open;
+	// Does the socket I/O on a separate thread
+	TCPConnection m_connection;
 
-	// Internal variables for data buffering and packet reading
-	uint32 m_dataLength = 0;
-	uint32 m_amountRead = 0;
-	char* m_dataBuff = nullptr;
-	TCPPacketMode m_readingMode = TCPPacketMode::NOT_READING;
+	// Packets taken from the connection, reused between updates
+	Vector<TCPPacket> m_packets;
 };
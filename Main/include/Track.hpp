@@ -94,6 +94,8 @@ public:
 	virtual bool AsyncLoad() override;
 	virtual bool AsyncFinalize() override;
 	void Tick(class BeatmapPlayback& playback, float deltaTime);
+	// Generates the meshes of all lasers of the chart up front so none are created while playing
+	void BakeLasers(class BeatmapPlayback& playback);
 
 	// Draw black laser underlays for wide lasers or all lasers if lane is hidden
 	void DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, const Vector<ObjectState*>& objects);
@@ -209,6 +211,8 @@ public:
 private:
 	// Laser track generators
 	class LaserTrackBuilder* m_laserTrackBuilder[2] = { 0 };
+	// View distance used to place baked lasers
+	class ViewDistanceCurve* m_laserViewDistance = nullptr;
 
 	const TimingPoint* m_lastTimingPoint = nullptr;
 
@@ -8,12 +8,17 @@
 #include <Audio/Audio.hpp>
 #include <Graphics/ResourceManagers.hpp>
 #include <Shared/Profiling.hpp>
+#include <Shared/Time.hpp>
 #include "GameConfig.hpp"
 #include "Input.hpp"
 #include "TransitionScreen.hpp"
 #include "SkinConfig.hpp"
 #include "ShadedMesh.hpp"
 #include "IR.hpp"
+#include "HttpClient.hpp"
+#include "ScoringBenchmark.hpp"
+#include "Audio/OffsetBenchmark.hpp"
+#include "Simulator.hpp"
 
 #ifdef EMBEDDED
 #define NANOVG_GLES2_IMPLEMENTATION
@@ -37,6 +42,7 @@ OpenGL *g_gl = nullptr;
 Graphics::Window *g_gameWindow = nullptr;
 Application *g_application = nullptr;
 JobSheduler *g_jobSheduler = nullptr;
+HttpClient *g_httpClient = nullptr;
 TransitionScreen *g_transition = nullptr;
 Input g_input;
 
@@ -107,6 +113,7 @@ void Application::ApplySettings()
 	Logger::Get().SetLogLevel(g_gameConfig.GetEnum<Logger::Enum_Severity>(GameConfigKeys::LogLevel));
 	g_gameWindow->SetVSync(g_gameConfig.GetBool(GameConfigKeys::VSync) ? 1 : 0);
 	m_showFps = g_gameConfig.GetBool(GameConfigKeys::ShowFps);
+	m_textureResidency.SetBudget((size_t)g_gameConfig.GetInt(GameConfigKeys::TextureMemoryBudget) * 1024 * 1024);
 
 	m_UpdateWindowPosAndShape();
 	m_OnWindowResized(g_gameWindow->GetWindowSize());
@@ -114,6 +121,11 @@ void Application::ApplySettings()
 }
 int32 Application::Run()
 {
+	// The simulator does not need a window, so it runs before anything else is initialized
+	if (m_commandLine.Contains("-simulate") || m_commandLine.Contains("-verifyreplay") || m_commandLine.Contains("-benchscoring")
+		|| m_commandLine.Contains("-verifygameplaythread") || m_commandLine.Contains("-benchoffsets"))
+		return m_RunSimulation();
+
 	if (!m_Init())
 		return 1;
 
@@ -163,6 +175,86 @@ int32 Application::Run()
 	return 0;
 }
 
+int32 Application::m_RunSimulation()
+{
+	uint32 numThreads = 0;
+	String csvPath;
+	for (auto &cl : m_commandLine)
+	{
+		String k, v;
+		if (cl.Split("=", &k, &v))
+		{
+			if (k == "-gamedir")
+				Path::gameDir = v;
+			else if (k == "-simulate-threads")
+				numThreads = atol(*v);
+			else if (k == "-simulate-out")
+				csvPath = v;
+		}
+	}
+
+	setlocale(LC_CTYPE, ".UTF-8");
+	if (!m_LoadConfig())
+		Log("Failed to load config file", Logger::Severity::Warning);
+
+	if (m_commandLine.Contains("-verifyreplay"))
+	{
+		// Chart and replay paths are the arguments after the flag
+		auto it = std::find(m_commandLine.begin(), m_commandLine.end(), "-verifyreplay");
+		if (m_commandLine.end() - it < 3)
+		{
+			Log("Usage: -verifyreplay <chart> <input replay>", Logger::Severity::Error);
+			return 1;
+		}
+		return RunReplayVerification(*(it + 1), *(it + 2)) ? 0 : 1;
+	}
+
+	if (m_commandLine.Contains("-verifygameplaythread"))
+	{
+		// Chart path is the argument after the flag
+		auto it = std::find(m_commandLine.begin(), m_commandLine.end(), "-verifygameplaythread");
+		if (it + 1 == m_commandLine.end())
+		{
+			Log("Usage: -verifygameplaythread <chart>", Logger::Severity::Error);
+			return 1;
+		}
+		return RunGameplayThreadVerification(*(it + 1)) ? 0 : 1;
+	}
+
+	if (m_commandLine.Contains("-benchscoring"))
+	{
+		// Map path is the argument after the flag
+		auto it = std::find(m_commandLine.begin(), m_commandLine.end(), "-benchscoring");
+		if (it + 1 == m_commandLine.end())
+		{
+			Log("Usage: -benchscoring <map path>", Logger::Severity::Error);
+			return 1;
+		}
+		return RunScoringBenchmark(*(it + 1)) ? 0 : 1;
+	}
+
+	if (m_commandLine.Contains("-benchoffsets"))
+	{
+		// Chart or folder path is the argument after the flag
+		auto it = std::find(m_commandLine.begin(), m_commandLine.end(), "-benchoffsets");
+		if (it + 1 == m_commandLine.end())
+		{
+			Log("Usage: -benchoffsets <chart or folder>", Logger::Severity::Error);
+			return 1;
+		}
+		return RunOffsetBenchmark(*(it + 1)) ? 0 : 1;
+	}
+
+	// Chart or folder path is the argument after the flag
+	auto it = std::find(m_commandLine.begin(), m_commandLine.end(), "-simulate");
+	if (it + 1 == m_commandLine.end())
+	{
+		Log("Usage: -simulate <chart or folder> [-simulate-threads=N] [-simulate-out=results.csv]", Logger::Severity::Error);
+		return 1;
+	}
+	return RunSimulation(*(it + 1), numThreads, csvPath) ? 0 : 1;
+}
+
 void Application::SetUpdateAvailable(const String &version, const String &url, const String &download)
 {
 	m_updateVersion = version;
@@ -812,6 +904,13 @@ bool Application::m_Init()
 			{
 				Path::gameDir = v;
 			}
+			else if (k == "-profile")
+			{
+				// Captures everything from startup until the game is closed
+				m_profilePath = v;
+				PROFILE_THREAD("Main thread");
+				Profiling::StartCapture();
+			}
 		}
 	}
 
@@ -829,6 +928,7 @@ bool Application::m_Init()
 
 	// Job sheduler
 	g_jobSheduler = new JobSheduler();
+	g_httpClient = new HttpClient();
 
 	m_allowMapConversion = false;
 	bool debugMute = false;
@@ -984,7 +1084,10 @@ bool Application::m_Init()
 		g_guiState.vg = nvgCreateGL3(0);
 #endif
 #endif
+		g_guiState.resolveImage = [](int image) { return g_application->ResolveImage(image); };
 		nvgCreateFont(g_guiState.vg, "fallback", *Path::Absolute("fonts/NotoSansCJKjp-Regular.otf"));
+
+		m_textureUploads = new TextureUploadQueue(g_gl);
 	}
 
 	CheckForUpdate();
@@ -1005,6 +1108,9 @@ bool Application::m_Init()
 	m_OnWindowResized(g_resolution);
 
 	m_showFps = g_gameConfig.GetBool(GameConfigKeys::ShowFps);
+	m_showLuaStats = m_commandLine.Contains("-luastats");
+	m_showTextureStats = m_commandLine.Contains("-texturestats");
+	m_textureResidency.SetBudget((size_t)g_gameConfig.GetInt(GameConfigKeys::TextureMemoryBudget) * 1024 * 1024);
 	g_gameWindow->SetVSync(g_gameConfig.GetBool(GameConfigKeys::VSync) ? 1 : 0);
 
 	{
@@ -1017,6 +1123,8 @@ bool Application::m_Init()
 	Path::CreateDir(Path::Absolute("songs"));
 	Path::CreateDir(Path::Absolute("replays"));
 	Path::CreateDir(Path::Absolute("crash_dumps"));
+	if (!m_jacketCache.Open(Path::Absolute("jackets.cache")))
+		Log("Failed to open jacket cache", Logger::Severity::Warning);
 	Logger::Get().SetLogLevel(g_gameConfig.GetEnum<Logger::Enum_Severity>(GameConfigKeys::LogLevel));
 	return true;
 }
@@ -1029,6 +1137,7 @@ void Application::m_MainLoop()
 	{
 		m_appTime = appTimer.SecondsAsFloat();
 		frameTimer.Restart();
+		PROFILE_FRAME();
 		//run discord callbacks
 		Discord_RunCallbacks();
 
@@ -1089,7 +1198,6 @@ void Application::m_MainLoop()
 
 		// Determine target tick rates for update and render
 		int32 targetFPS = 120; // Default to 120 FPS
-		uint32 targetRenderTime = 0;
 		for (auto tickable : g_tickables)
 		{
 			int32 tempTarget = 0;
@@ -1098,8 +1206,13 @@ void Application::m_MainLoop()
 				targetFPS = tempTarget;
 			}
 		}
-		if (targetFPS > 0)
-			targetRenderTime = 1000000 / targetFPS;
+		m_framePacer.SetTarget(targetFPS, g_gameConfig.GetBool(GameConfigKeys::JustInTimeRender) ? FramePacer::Mode::JustInTime : FramePacer::Mode::Normal);
+
+		// Waits here in just in time mode so input is sampled as late as possible
+		{
+			PROFILE_SCOPE("Frame Pacer");
+			m_framePacer.BeginFrame();
+		}
 
 		// Main loop
 		float currentTime = appTimer.SecondsAsFloat();
@@ -1115,43 +1228,63 @@ void Application::m_MainLoop()
 
 		m_Tick();
 
-		// Garbage collect resources
-		ResourceManagers::TickAll();
+		{
+			PROFILE_SCOPE("Resources and Jobs");
 
-		// Tick job sheduler
-		// processed callbacks for finished tasks
-		g_jobSheduler->Update();
+			// Garbage collect resources
+			ResourceManagers::TickAll();
 
-		//This FPS limiter seems unstable over 500fps
-		uint32 frameTime = frameTimer.Microseconds();
-		if (frameTime < targetRenderTime)
-		{
-			uint32 timeLeft = (targetRenderTime - frameTime);
-			uint32 sleepMicroSecs = (uint32)(timeLeft * m_fpsTargetSleepMult * 0.75);
-			if (sleepMicroSecs > 1000)
-			{
-				uint32 sleepStart = frameTimer.Microseconds();
-				std::this_thread::sleep_for(std::chrono::microseconds(sleepMicroSecs));
-				float actualSleep = frameTimer.Microseconds() - sleepStart;
+			// Glyphs drawn in this frame can be evicted from the font atlases again
+			FontRes::EndFrame();
 
-				m_fpsTargetSleepMult += ((float)timeLeft - (float)actualSleep / 0.75) / 500000.f;
-				m_fpsTargetSleepMult = Math::Clamp(m_fpsTargetSleepMult, 0.0f, 1.0f);
-			}
+			// Tick job sheduler
+			// processed callbacks for finished tasks
+			g_jobSheduler->Update();
 
-			do
-			{
-				std::this_thread::yield();
-			} while (frameTimer.Microseconds() < targetRenderTime);
+			// Upload part of the textures of finished jacket loading jobs
+			m_textureUploads->Update();
+
+			m_UpdateTextureResidency();
+		}
+
+		// Run lua garbage collection in part of the time the FPS limiter would sleep,
+		// a small step is still done when there is no time left so collection cycles don't stall
+		double timeLeft = m_framePacer.GetTimeLeft();
+		double gcBudget = timeLeft > 0.0 ? timeLeft / 2 : 0.0001;
+		{
+			PROFILE_SCOPE("Lua GC");
+			m_luaGC.Step(gcBudget);
+			m_luaGC.EndFrame();
+		}
+#ifdef PROFILING
+		if (Profiling::IsCapturing())
+		{
+			size_t luaMemory = 0;
+			for (const LuaStateStats& stats : m_luaGC.GetStats())
+				luaMemory += stats.bytesInUse;
+			Profiling::Counter("Lua memory (KB)", luaMemory / 1024.0);
+		}
+#endif
+
+		{
+			PROFILE_SCOPE("Frame Pacer");
+			m_framePacer.EndFrame();
 		}
 		// Swap buffers
-		g_gl->SwapBuffers();
+		{
+			PROFILE_SCOPE("Swap Buffers");
+			g_gl->SwapBuffers();
+		}
 
 		m_deltaTime = frameTimer.SecondsAsFloat();
+		PROFILE_COUNTER("Frame time (ms)", m_deltaTime * 1000.0);
 	}
 }
 
 void Application::m_Tick()
 {
+	PROFILE_SCOPE("Tick");
+
 	// Handle input first
 	g_input.Update(m_deltaTime);
 
@@ -1164,6 +1297,7 @@ void Application::m_Tick()
 	// Tick all items
 	for (auto &tickable : g_tickables)
 	{
+		PROFILE_SCOPE("Tickable Tick");
 		tickable->Tick(m_deltaTime);
 	}
 
@@ -1199,6 +1333,7 @@ void Application::m_Tick()
 		assert(!g_tickables.empty());
 		for (auto &tickable : g_tickables)
 		{
+			PROFILE_SCOPE("Tickable Render");
 			tickable->Render(m_deltaTime);
 		}
 		m_renderStateBase.projectionTransform = GetGUIProjection();
@@ -1212,14 +1347,21 @@ void Application::m_Tick()
 			nvgFillColor(g_guiState.vg, nvgRGB(0, 200, 255));
 			String fpsText = Utility::Sprintf("%.1fFPS", GetRenderFPS());
 			nvgText(g_guiState.vg, g_resolution.x - 5, g_resolution.y - 5, fpsText.c_str(), 0);
-			// Visualize m_fpsTargetSleepMult for debugging
+			// Visualize the frame pacer sleep slack for debugging
 			//nvgBeginPath(g_guiState.vg);
-			//float h = m_fpsTargetSleepMult * g_resolution.y;
+			//float h = (float)(m_framePacer.GetStats().sleepSlack * 1000.0 / 4.0) * g_resolution.y;
 			//nvgRect(g_guiState.vg, g_resolution.x - 10, g_resolution.y - h, 10, h);
 			//nvgFill(g_guiState.vg);
 		}
-		nvgEndFrame(g_guiState.vg);
-		m_renderQueueBase.Process();
+		if (m_showLuaStats)
+			m_RenderLuaStats();
+		if (m_showTextureStats)
+			m_RenderTextureStats();
+		{
+			PROFILE_SCOPE("Flush Render Queue");
+			nvgEndFrame(g_guiState.vg);
+			m_renderQueueBase.Process();
+		}
 		glCullFace(GL_FRONT);
 	}
 
@@ -1230,6 +1372,64 @@ void Application::m_Tick()
 	}
 }
 
+void Application::m_RenderLuaStats()
+{
+	NVGcontext* vg = g_guiState.vg;
+	nvgReset(vg);
+	nvgFontFace(vg, "fallback");
+	nvgFontSize(vg, 16);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+
+	const Vector<LuaStateStats>& stats = m_luaGC.GetStats();
+	nvgBeginPath(vg);
+	nvgRect(vg, 0, 0, 460, 20 + stats.size() * 18);
+	nvgFillColor(vg, nvgRGBA(0, 0, 0, 180));
+	nvgFill(vg);
+
+	nvgFillColor(vg, nvgRGB(0, 200, 255));
+	nvgText(vg, 5, 2, "Lua state         memory   allocs   gc ms   max gc ms  cycles", 0);
+	float y = 20;
+	for (const LuaStateStats& s : stats)
+	{
+		String line = Utility::Sprintf("%-16.16s %6.0fKB %7llu %7.3f %11.3f %7u", *s.name,
+			s.bytesInUse / 1024.0, (unsigned long long)s.frameAllocations, s.frameGCTime * 1000.0, s.maxFrameGCTime * 1000.0, s.completedCycles);
+		nvgText(vg, 5, y, line.c_str(), 0);
+		y += 18;
+	}
+}
+
+void Application::m_RenderTextureStats()
+{
+	NVGcontext* vg = g_guiState.vg;
+	nvgReset(vg);
+	nvgFontFace(vg, "fallback");
+	nvgFontSize(vg, 16);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+
+	const TextureResidencyStats& stats = m_textureResidency.GetStats();
+	const float x = g_resolution.x - 300;
+	nvgBeginPath(vg);
+	nvgRect(vg, x, 0, 300, 5 * 18 + 4);
+	nvgFillColor(vg, nvgRGBA(0, 0, 0, 180));
+	nvgFill(vg);
+
+	const double mb = 1.0 / (1024.0 * 1024.0);
+	const String lines[] = {
+		Utility::Sprintf("Textures %.1f / %.0f MB (peak %.1f)", (stats.residentBytes + stats.pinnedBytes) * mb, stats.budget * mb, stats.peakBytes * mb),
+		Utility::Sprintf("Jackets  %.1f MB, %u of %u resident", stats.residentBytes * mb, stats.numResident, stats.numTextures),
+		Utility::Sprintf("Skin     %.1f MB", stats.pinnedBytes * mb),
+		Utility::Sprintf("Evicted  %llu (%.1f MB), %u this frame", (unsigned long long)stats.numEvicted, stats.evictedBytes * mb, stats.frameEvicted),
+		Utility::Sprintf("Reloaded %llu, %u uploading", (unsigned long long)stats.numReloaded, (uint32)m_textureUploads->GetPendingCount()),
+	};
+	nvgFillColor(vg, nvgRGB(0, 200, 255));
+	float y = 2;
+	for (const String& line : lines)
+	{
+		nvgText(vg, x + 5, y, line.c_str(), 0);
+		y += 18;
+	}
+}
+
 void Application::m_Cleanup()
 {
 	ProfilerScope $("Application Cleanup");
@@ -1246,6 +1446,12 @@ void Application::m_Cleanup()
 		g_audio = nullptr;
 	}
 
+	if (m_textureUploads)
+	{
+		delete m_textureUploads;
+		m_textureUploads = nullptr;
+	}
+
 	if (g_gl)
 	{
 		delete g_gl;
@@ -1267,6 +1473,13 @@ void Application::m_Cleanup()
 		delete g_jobSheduler;
 		g_jobSheduler = nullptr;
 	}
+	// After the jobs since web jackets wait for their response
+	if (g_httpClient)
+	{
+		delete g_httpClient;
+		g_httpClient = nullptr;
+	}
+	m_jacketCache.Close();
 
 	if (g_skinConfig)
 	{
@@ -1303,11 +1516,15 @@ void Application::m_Cleanup()
 
 	Discord_Shutdown();
 
+	if (g_guiState.vg)
+	{
 #ifdef EMBEDDED
-	nvgDeleteGLES2(g_guiState.vg);
+		nvgDeleteGLES2(g_guiState.vg);
 #else
-	nvgDeleteGL3(g_guiState.vg);
+		nvgDeleteGL3(g_guiState.vg);
 #endif
+		g_guiState.vg = nullptr;
+	}
 
 	Graphics::FontRes::FreeLibrary();
 	if (m_updateThread.joinable())
@@ -1315,6 +1532,11 @@ void Application::m_Cleanup()
 
 	// Finally, save config
 	m_SaveConfig();
+
+#ifdef PROFILING
+	if (!m_profilePath.empty() && Profiling::IsCapturing())
+		Profiling::ExportChromeTrace(m_profilePath);
+#endif
 }
 
 class Game *Application::LaunchMap(const String &mapPath)
@@ -1472,30 +1694,106 @@ int Application::LoadImageJob(const String &path, Vector2i size, int placeholder
 	if (it == m_jacketImages.end() || !it->second)
 	{
 		CachedJacketImage *newImage = new CachedJacketImage();
-		JacketLoadingJob *job = new JacketLoadingJob();
-		job->imagePath = path;
-		job->target = newImage;
-		job->w = size.x;
-		job->h = size.y;
-		job->web = web;
-		newImage->loadingJob = Ref<JobBase>(job);
-		newImage->lastUsage = m_jobTimer.SecondsAsFloat();
-		g_jobSheduler->Queue(newImage->loadingJob);
+		newImage->path = path;
+		newImage->maxSize = size;
+		newImage->web = web;
+		newImage->placeholder = placeholder;
+		newImage->residency = m_textureResidency.Add([newImage]() {
+			nvgDeleteImage(g_guiState.vg, newImage->texture);
+			newImage->texture = 0;
+			newImage->loaded = false;
+			newImage->evicted = true;
+		});
+		m_QueueJacketJob(newImage);
 
 		m_jacketImages.Add(path, newImage);
 	}
 	else
 	{
-		it->second->lastUsage = m_jobTimer.SecondsAsFloat();
+		it->second->placeholder = placeholder;
 		// If loaded set texture
-		if (it->second->loaded)
+		if (m_UseJacket(it->second))
 		{
-			ret = it->second->texture;
+			ret = it->second->handle;
 		}
 	}
 	return ret;
 }
 
+int Application::ResolveImage(int image)
+{
+	auto it = m_jacketHandles.find(image);
+	if (it == m_jacketHandles.end())
+		return image;
+	int texture = m_UseJacket(it->second);
+	return texture ? texture : it->second->placeholder;
+}
+
+int Application::m_UseJacket(CachedJacketImage *image)
+{
+	image->lastUsage = m_jobTimer.SecondsAsFloat();
+	// Load evicted images again, the placeholder is shown until they are
+	if (!m_textureResidency.Touch(image->residency) && image->evicted)
+	{
+		image->evicted = false;
+		m_QueueJacketJob(image);
+		return 0;
+	}
+
+	// Wrap the texture in a nanovg image once it's uploaded
+	Ref<TextureUpload> &upload = image->upload;
+	if (!image->loaded && upload && upload->IsFinished())
+	{
+		image->size = upload->GetSize();
+#ifdef EMBEDDED
+		image->texture = nvglCreateImageFromHandleGLES2(g_guiState.vg, upload->Release(), image->size.x, image->size.y, 0);
+#else
+		image->texture = nvglCreateImageFromHandleGL3(g_guiState.vg, upload->Release(), image->size.x, image->size.y, 0);
+#endif
+		image->loaded = true;
+		upload.reset();
+	}
+	if (!image->loaded)
+		return 0;
+
+	if (!m_textureResidency.IsResident(image->residency))
+	{
+		m_textureResidency.SetResident(image->residency, TextureResidency::GetTextureBytes(image->size));
+		if (image->handle == 0)
+		{
+			image->handle = image->texture;
+			m_jacketHandles.Add(image->handle, image);
+		}
+	}
+	return image->texture;
+}
+
+void Application::m_QueueJacketJob(CachedJacketImage *image)
+{
+	JacketLoadingJob *job = new JacketLoadingJob();
+	job->imagePath = image->path;
+	job->target = image;
+	job->w = image->maxSize.x;
+	job->h = image->maxSize.y;
+	job->web = image->web;
+	job->uploadQueue = m_textureUploads;
+	if (!image->web && m_jacketCache.IsOpen())
+		job->cache = &m_jacketCache;
+	image->loadingJob = Ref<JobBase>(job);
+	g_jobSheduler->Queue(image->loadingJob);
+}
+
+void Application::m_UpdateTextureResidency()
+{
+	// Skin textures, backgrounds and meshes hold their own references, they are counted but can't be evicted
+	size_t textureBytes = 0;
+	GetResourceManager<ResourceType::Texture>().ForEach([&](const Texture &texture) {
+		textureBytes += TextureResidency::GetTextureBytes(texture->GetSize());
+	});
+	m_textureResidency.SetExternalBytes(textureBytes);
+	m_textureResidency.EndFrame();
+}
+
 void Application::SetScriptPath(lua_State *s)
 {
 	//Set path for 'require' (https://stackoverflow.com/questions/4125971/setting-the-global-lua-path-variable-from-c-c?lq=1)
@@ -1515,9 +1813,14 @@ void Application::SetScriptPath(lua_State *s)
 
 std::set<String> g_luaErrorsSeen;
 
+lua_State *Application::NewLuaState(const String &name)
+{
+	return m_luaGC.NewState(name);
+}
+
 lua_State *Application::LoadScript(const String &name, bool noError)
 {
-	lua_State *s = luaL_newstate();
+	lua_State *s = m_luaGC.NewState(name);
 	luaL_openlibs(s);
 	SetScriptPath(s);
 
@@ -1546,7 +1849,7 @@ lua_State *Application::LoadScript(const String &name, bool noError)
 		Logf("Lua error: %s", Logger::Severity::Error, lua_tostring(s, -1));
 		if (!noError)
 			g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(s, -1), 0);
-		lua_close(s);
+		m_luaGC.Close(s);
 		return nullptr;
 	}
 	else
@@ -1579,7 +1882,7 @@ void Application::ReloadScript(const String &name, lua_State *L)
 	{
 		Logf("Lua error: %s", Logger::Severity::Error, lua_tostring(L, -1));
 		g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(L, -1), 0);
-		lua_close(L);
+		m_luaGC.Close(L);
 		assert(false);
 	}
 	else
@@ -1608,7 +1911,10 @@ void Application::ReloadSkin()
 	g_guiState.nextTextId.clear();
 	g_guiState.nextPaintId.clear();
 	g_guiState.paintCache.clear();
+	for (auto &img : m_jacketImages)
+		m_textureResidency.Remove(img.second->residency);
 	m_jacketImages.clear();
+	m_jacketHandles.clear();
 
 	for (auto &sample : m_samples)
 	{
@@ -1654,7 +1960,7 @@ void Application::DisposeLua(lua_State *state)
 	DisposeGUI(state);
 	m_skinHttp.ClearState(state);
 	m_skinIR.ClearState(state);
-	lua_close(state);
+	m_luaGC.Close(state);
 }
 
 void Application::DiscordError(int errorCode, const char *message)
@@ -1858,6 +2164,25 @@ int Application::IsNamedSamplePlaying(String name)
 }
 void Application::m_OnKeyPressed(SDL_Scancode code)
 {
+	// Profiling capture toggle, the capture is written when it is stopped
+	if (code == SDL_SCANCODE_P && (g_gameWindow->GetModifierKeys() & (ModifierKeys::Ctrl | ModifierKeys::Shift)) == (ModifierKeys::Ctrl | ModifierKeys::Shift))
+	{
+#ifdef PROFILING
+		if (Profiling::IsCapturing())
+		{
+			Path::CreateDir(Path::Absolute("profiles"));
+			Profiling::ExportChromeTrace(Path::Absolute("profiles/" + Shared::Time::Now().ToString() + ".json"));
+		}
+		else
+		{
+			PROFILE_THREAD("Main thread");
+			Profiling::StartCapture();
+			Log("Started profiling capture, press Ctrl+Shift+P again to save it", Logger::Severity::Info);
+		}
+#endif
+		return;
+	}
+
 	// Fullscreen toggle
 	if (code == SDL_SCANCODE_RETURN)
 	{
@@ -2553,7 +2878,9 @@ bool JacketLoadingJob::Run()
 	// Create loading task
 	if (web)
 	{
-		auto response = cpr::Get(imagePath);
+		HttpRequest request;
+		request.url = imagePath;
+		cpr::Response response = g_httpClient->Send(std::move(request), RequestPriority::Low).get();
 		if (response.error.code != cpr::ErrorCode::OK || response.status_code >= 300)
 		{
 			return false;
@@ -2561,7 +2888,7 @@ bool JacketLoadingJob::Run()
 		Buffer b;
 		b.resize(response.text.length());
 		memcpy(b.data(), response.text.c_str(), b.size());
-		loadedImage = ImageRes::Create(b);
+		loadedImage = ImageRes::Create(b, {w, h});
 		if (loadedImage)
 		{
 			if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h)
@@ -2571,9 +2898,14 @@ bool JacketLoadingJob::Run()
 		}
 		return loadedImage.get() != nullptr;
 	}
+	else if (cache)
+	{
+		loadedImage = cache->Load(imagePath, {w, h});
+		return loadedImage.get() != nullptr;
+	}
 	else
 	{
-		loadedImage = ImageRes::Create(imagePath);
+		loadedImage = ImageRes::Create(imagePath, {w, h});
 		if (loadedImage)
 		{
 			if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h)
@@ -2588,8 +2920,16 @@ void JacketLoadingJob::Finalize()
 {
 	if (IsSuccessfull())
 	{
-		///TODO: Maybe do the nvgCreateImage in Run() instead
-		target->texture = nvgCreateImageRGBA(g_guiState.vg, loadedImage->GetSize().x, loadedImage->GetSize().y, 0, (unsigned char *)loadedImage->GetBits());
-		target->loaded = true;
+		// Uploading is spread over multiple frames by the queue, see Application::LoadImageJob
+		if (uploadQueue)
+		{
+			target->upload = uploadQueue->Queue(loadedImage);
+		}
+		else
+		{
+			target->size = loadedImage->GetSize();
+			target->texture = nvgCreateImageRGBA(g_guiState.vg, target->size.x, target->size.y, 0, (unsigned char *)loadedImage->GetBits());
+			target->loaded = true;
+		}
 	}
 }
@@ -0,0 +1,173 @@
+#include "stdafx.h"
+#include "Audio/OffsetAnalyzer.hpp"
+#include "Audio/OffsetComputer.hpp"
+
+#include <Audio/Audio.hpp>
+#include <Beatmap/Beatmap.hpp>
+#include <Beatmap/MapDatabase.hpp>
+#include <Shared/Profiling.hpp>
+#include <Shared/Thread.hpp>
+
+OffsetAnalyzer::~OffsetAnalyzer()
+{
+	Stop();
+}
+
+void OffsetAnalyzer::Start(const Vector<ChartIndex*>& charts)
+{
+	Stop();
+	m_requests.clear();
+	for (const ChartIndex* chart : charts)
+		m_requests.push_back({ chart->hash, chart->path, chart->custom_offset });
+	std::sort(m_requests.begin(), m_requests.end(), [](const Request& a, const Request& b) { return a.path < b.path; });
+
+	m_numResults = 0;
+	m_numFailed = 0;
+	m_totalLoadTime = 0.0;
+	m_totalOnsetTime = 0.0;
+	m_totalCorrelationTime = 0.0;
+
+	if (m_requests.empty())
+		return;
+
+	Logf("Analysing the offsets of %d charts in the background", Logger::Severity::Info, m_requests.size());
+	m_stop = false;
+	m_finished = false;
+	m_thread = std::thread(&OffsetAnalyzer::m_Run, this);
+}
+
+void OffsetAnalyzer::Stop()
+{
+	if (!m_thread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+	}
+	m_resume.notify_all();
+	m_thread.join();
+	m_results.clear();
+}
+
+void OffsetAnalyzer::Pause()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_paused = true;
+}
+
+void OffsetAnalyzer::Resume()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_paused = false;
+	}
+	m_resume.notify_all();
+}
+
+void OffsetAnalyzer::Update(MapDatabase& database)
+{
+	Vector<Result> results;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_results.empty())
+			return;
+		results = std::move(m_results);
+		m_results.clear();
+	}
+
+	for (const Result& result : results)
+	{
+		const Request& request = *result.request;
+		m_numResults++;
+		if (result.success)
+		{
+			Logf("Offset of [%s]: %.2f ms (loading %.0f ms, onsets %.1f ms, correlation %.2f ms)",
+				Logger::Severity::Info, request.path, result.offset, result.loadTime, result.onsetTime, result.correlationTime);
+			m_totalLoadTime += result.loadTime;
+			m_totalOnsetTime += result.onsetTime;
+			m_totalCorrelationTime += result.correlationTime;
+		}
+		else
+		{
+			m_numFailed++;
+		}
+
+		ChartIndex* chart = database.FindFirstChartByHash(request.hash);
+		if (!chart || chart->custom_offset != request.offset)
+			continue;
+
+		// Charts that couldn't be analysed keep their offset, it is still stored so they are not analysed again
+		if (result.success)
+			chart->custom_offset = static_cast<int32>(std::lround(result.offset));
+		database.UpdateChartOffset(chart);
+	}
+
+	if (m_numResults == m_requests.size())
+	{
+		const uint32 numSucceeded = m_numResults - m_numFailed;
+		const double scale = numSucceeded > 0 ? 1.0 / numSucceeded : 0.0;
+		Logf("Analysed the offsets of %d charts, %d failed. Average loading %.0f ms, onsets %.1f ms, correlation %.2f ms", Logger::Severity::Info,
+			m_numResults, m_numFailed, m_totalLoadTime * scale, m_totalOnsetTime * scale, m_totalCorrelationTime * scale);
+	}
+}
+
+void OffsetAnalyzer::m_Run()
+{
+	PROFILE_THREAD("Offset analysis");
+	Thread::SetCurrentThreadBackgroundPriority();
+
+	for (const Request& request : m_requests)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_resume.wait(lock, [this]() { return !m_paused || m_stop; });
+		}
+		if (m_stop)
+			break;
+
+		Result result;
+		result.request = &request;
+		m_Analyse(request, result);
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_results.push_back(result);
+	}
+
+	m_music.reset();
+	m_audioPath.clear();
+	m_finished = true;
+}
+
+void OffsetAnalyzer::m_Analyse(const Request& request, Result& result)
+{
+	ProfilerScope $("OffsetAnalyzer::Analyse");
+
+	Timer timer;
+	Beatmap beatmap;
+	String audioPath;
+	if (!OffsetComputer::LoadChart(request.path, beatmap, audioPath))
+		return;
+	if (audioPath != m_audioPath)
+	{
+		m_music.reset();
+		m_music = g_audio->CreateStream(audioPath, true);
+		m_audioPath = audioPath;
+	}
+	if (!m_music)
+		return;
+	result.loadTime = timer.SecondsAsDouble() * 1000.0;
+
+	OffsetComputer computer(m_music, beatmap);
+	timer.Restart();
+	if (!computer.ComputeOnsets(request.offset))
+		return;
+	result.onsetTime = timer.SecondsAsDouble() * 1000.0;
+
+	timer.Restart();
+	result.offset = request.offset;
+	if (!computer.ComputePrecise(result.offset))
+		return;
+	result.correlationTime = timer.SecondsAsDouble() * 1000.0;
+
+	result.success = true;
+}
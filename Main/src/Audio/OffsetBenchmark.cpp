@@ -0,0 +1,102 @@
+#include "stdafx.h"
+#include "Audio/OffsetBenchmark.hpp"
+#include "Audio/OffsetComputer.hpp"
+
+#include <Audio/Audio.hpp>
+#include <Beatmap/Beatmap.hpp>
+
+bool RunOffsetBenchmark(const String& path)
+{
+	Vector<String> charts;
+	if (Path::IsDirectory(path))
+	{
+		for (const FileInfo& file : Files::ScanFilesRecursive(path, "ksh"))
+			charts.Add(file.fullPath);
+		std::sort(charts.begin(), charts.end());
+	}
+	else
+	{
+		charts.Add(path);
+	}
+	if (charts.empty())
+	{
+		Logf("No charts found for the offset benchmark in %s", Logger::Severity::Error, path);
+		return false;
+	}
+
+	// Streams are created through the audio output, even though nothing is played
+	new Audio();
+	if (!g_audio->Init(false))
+	{
+		Log("Audio initialization failed", Logger::Severity::Error);
+		delete g_audio;
+		g_audio = nullptr;
+		return false;
+	}
+
+	uint32 numSucceeded = 0;
+	uint32 numAgreeing = 0;
+	double totalLoadTime = 0.0;
+	double totalOnsetTime = 0.0;
+	double totalCorrelationTime = 0.0;
+	double totalBruteForceTime = 0.0;
+
+	// Charts are sorted by path so the music shared by the charts of a song is only decoded once
+	String musicPath;
+	Ref<AudioStream> music;
+	for (const String& chartPath : charts)
+	{
+		Timer timer;
+		Beatmap beatmap;
+		String audioPath;
+		if (!OffsetComputer::LoadChart(chartPath, beatmap, audioPath))
+			continue;
+		if (audioPath != musicPath)
+		{
+			music.reset();
+			music = g_audio->CreateStream(audioPath, true);
+			musicPath = audioPath;
+		}
+		if (!music)
+			continue;
+		const double loadTime = timer.SecondsAsDouble() * 1000.0;
+
+		OffsetComputer computer(music, beatmap);
+		timer.Restart();
+		if (!computer.ComputeOnsets(0))
+			continue;
+		const double onsetTime = timer.SecondsAsDouble() * 1000.0;
+
+		timer.Restart();
+		double offset = 0.0;
+		if (!computer.ComputePrecise(offset))
+			continue;
+		const double correlationTime = timer.SecondsAsDouble() * 1000.0;
+
+		timer.Restart();
+		int32 bruteForceOffset = 0;
+		if (!computer.ComputeBruteForce(bruteForceOffset))
+			continue;
+		const double bruteForceTime = timer.SecondsAsDouble() * 1000.0;
+
+		Logf("Offset of [%s]: %.2f ms, %d ms with the brute force search (loading %.0f ms, onsets %.1f ms, correlation %.2f ms, brute force %.2f ms)",
+			Logger::Severity::Info, chartPath, offset, bruteForceOffset, loadTime, onsetTime, correlationTime, bruteForceTime);
+		numSucceeded++;
+		if (fabs(offset - bruteForceOffset) <= 1.0)
+			numAgreeing++;
+		totalLoadTime += loadTime;
+		totalOnsetTime += onsetTime;
+		totalCorrelationTime += correlationTime;
+		totalBruteForceTime += bruteForceTime;
+	}
+	music.reset();
+	delete g_audio;
+	g_audio = nullptr;
+
+	const double scale = numSucceeded > 0 ? 1.0 / numSucceeded : 0.0;
+	Logf("Offset benchmark: %d charts, %d failed. %.1f%% are within 1 ms of the brute force search. "
+		"Average loading %.0f ms, onsets %.1f ms, correlation %.2f ms, brute force %.2f ms", Logger::Severity::Info,
+		charts.size(), charts.size() - numSucceeded, numAgreeing * scale * 100.0,
+		totalLoadTime * scale, totalOnsetTime * scale, totalCorrelationTime * scale, totalBruteForceTime * scale);
+	return numSucceeded > 0;
+}
@@ -2,11 +2,13 @@
 #include "Audio/AudioPlayback.hpp"
 #include "Audio/OffsetComputer.hpp"
 
+#include <Audio/Audio.hpp>
 #include <Audio/Audio_Impl.hpp>
 #include <Beatmap/Beatmap.hpp>
 #include <Beatmap/BeatmapPlayback.hpp>
 #include <Beatmap/MapDatabase.hpp>
 #include <Shared/Profiling.hpp>
+#include <Shared/FFT.hpp>
 #include <array>
 
 static inline double GetBeatWeight(double d)
@@ -27,34 +29,58 @@ OffsetComputer::OffsetComputer(Ref<AudioStream> music, const Beatmap& beatmap)
 {
 }
 
-bool OffsetComputer::Compute(const ChartIndex* chart, int& outOffset)
+bool OffsetComputer::LoadChart(const String& chartPath, Beatmap& outBeatmap, String& outAudioPath)
 {
-	const String chartPath = Path::Normalize(chart->path);
-	const String chartRootPath = Path::RemoveLast(chartPath, nullptr);
+	const String path = Path::Normalize(chartPath);
 
-	Beatmap beatmap;
-	File mapFile;
+	Buffer mapData;
+	if (!File::ReadAll(path, mapData))
+		return false;
 
-	if (!mapFile.OpenRead(chartPath))
+	MappedReader reader(mapData);
+	if (!outBeatmap.Load(reader))
 		return false;
 
-	FileReader reader(mapFile);
-	if (!beatmap.Load(reader))
+	// Same track AudioPlayback uses for its music
+	outAudioPath = Path::Normalize(Path::RemoveLast(path, nullptr) + Path::sep + outBeatmap.GetMapSettings().audioNoFX);
+	outAudioPath.TrimBack(' ');
+	if (!Path::FileExists(outAudioPath))
+	{
+		Logf("OffsetComputer: Audio file for beatmap does not exist at: \"%s\"", Logger::Severity::Warning, outAudioPath);
 		return false;
+	}
+	return true;
+}
 
-	BeatmapPlayback beatmapPlayback(beatmap);
-	beatmapPlayback.Reset();
+bool OffsetComputer::Compute(const ChartIndex* chart, int& outOffset)
+{
+	Beatmap beatmap;
+	String audioPath;
+	if (!LoadChart(chart->path, beatmap, audioPath))
+		return false;
 
-	AudioPlayback audioPlayback;
-	if (!audioPlayback.Init(beatmapPlayback, chartRootPath, false))
+	// Only the music is needed, not the effect tracks and samples an AudioPlayback loads
+	Ref<AudioStream> music = g_audio->CreateStream(audioPath, true);
+	if (!music)
 		return false;
 
-	return OffsetComputer(audioPlayback).Compute(outOffset);
+	return OffsetComputer(music, beatmap).Compute(outOffset);
 }
 
 bool OffsetComputer::Compute(int& outOffset)
 {
-	ProfilerScope $("OffsetComputer::Compute");
+	double offset = outOffset;
+	if (!ComputePrecise(offset))
+		return false;
+
+	outOffset = static_cast<int>(std::lround(offset));
+	return true;
+}
+
+bool OffsetComputer::ComputeOnsets(MapTime center)
+{
+	if (m_hasOnsets && center == m_offsetCenter)
+		return !m_energy.empty();
 
 	if (!m_pcm || m_pcmCount <= 0 || m_sampleRate <= 0)
 	{
@@ -73,15 +99,73 @@ bool OffsetComputer::Compute(int& outOffset)
 	Logf("OffsetComputer::Compute: Using %d beats starting from %d...", Logger::Severity::Info,
 		m_beats.size(), m_beats[0].time);
 
-	m_offsetCenter = outOffset;
+	m_offsetCenter = center;
 
 	ComputeEnergy();
+	m_hasOnsets = true;
 	
 	if (m_energy.empty())
 	{
 		Log("OffsetComputer::Compute: Insufficient data...", Logger::Severity::Warning);
 		return false;
 	}
+	return true;
+}
+
+bool OffsetComputer::ComputePrecise(double& outOffset)
+{
+	ProfilerScope $("OffsetComputer::ComputePrecise");
+
+	if (!ComputeOnsets(static_cast<MapTime>(std::lround(outOffset))))
+		return false;
+
+	// Weighted beats relative to the first beat, correlated with the onset scores from the start of the energy window
+	const MapTime firstBeat = m_beats.front().time;
+	Vector<float> beats(m_beats.back().time - firstBeat + 1, 0.0f);
+	for (const Beat& beat : m_beats)
+		beats[beat.time - firstBeat] += 10.0f * beat.weight;
+
+	Vector<float> onsets(m_onsetScore.size());
+	for (size_t i = 0; i < onsets.size(); ++i)
+		onsets[i] = GetOnsetScore(m_energyOffset + static_cast<MapTime>(i));
+
+	Vector<float> correlation;
+	FFT::CrossCorrelate(beats, onsets, correlation);
+
+	// Same value ComputeFitness(offset + m_offsetCenter) has before it is rounded
+	const int64 zeroLag = static_cast<int64>(beats.size()) - 1 + (firstBeat + m_offsetCenter - m_energyOffset);
+	auto fitness = [&](MapTime offset) { return correlation[zeroLag + offset]; };
+
+	MapTime best = -MAX_OFFSET;
+	for (MapTime offset = -MAX_OFFSET + 1; offset <= MAX_OFFSET; ++offset)
+	{
+		if (fitness(offset) > fitness(best))
+			best = offset;
+	}
+
+	// Vertex of the parabola through the peak and its neighbours
+	double subOffset = 0.0;
+	if (-MAX_OFFSET < best && best < MAX_OFFSET)
+	{
+		const double prev = fitness(best - 1);
+		const double peak = fitness(best);
+		const double next = fitness(best + 1);
+		const double curvature = prev - 2.0 * peak + next;
+		if (curvature < 0.0)
+			subOffset = Math::Clamp(0.5 * (prev - next) / curvature, -0.5, 0.5);
+	}
+
+	outOffset = best + m_offsetCenter + subOffset;
+	Logf("OffsetComputer::ComputePrecise: Determined offset: %.2f (fitness = %.0f)", Logger::Severity::Info, outOffset, fitness(best));
+	return true;
+}
+
+bool OffsetComputer::ComputeBruteForce(int& outOffset)
+{
+	ProfilerScope $("OffsetComputer::ComputeBruteForce");
+
+	if (!ComputeOnsets(outOffset))
+		return false;
 
 	std::array<int, MAX_OFFSET*2 + 1> fitnesses;
 
@@ -119,7 +203,7 @@ bool OffsetComputer::Compute(int& outOffset)
 
 	for (size_t i = 0; i < 5 && i < peaks.size(); ++i)
 	{
-		Logf("offset %3d | score = %d", Logger::Severity::Info, peaks[i]+m_offsetCenter, fitnesses[peaks[i] + MAX_OFFSET]);
+		Logf("offset %3d | score = %d", Logger::Severity::Debug, peaks[i]+m_offsetCenter, fitnesses[peaks[i] + MAX_OFFSET]);
 	}
 
 	Logf("OffsetComputer::Compute: Determined offset: %d (fitness = %d)", Logger::Severity::Info, peaks[0]+m_offsetCenter, fitnesses[peaks[0] + MAX_OFFSET]);
@@ -8,6 +8,7 @@
 #include "Camera.hpp"
 #include "lua.hpp"
 #include "Gauge.hpp"
+#include "GameplayThread.hpp"
 #include "Shared/LuaBindable.hpp"
 
 /* Background template for fullscreen effects */
@@ -37,6 +38,12 @@ public:
 	void UpdateRenderState(float deltaTime)
 	{
 		renderState = g_application->GetRenderStateBase();
+		if (resolution.x > 0 && resolution.y > 0)
+			renderState.viewportSize = resolution;
+	}
+	virtual bool SamplesFrame() const override
+	{
+		return samplesFrame;
 	}
 	virtual void Render(float deltaTime) override
 	{
@@ -59,6 +66,7 @@ protected:
 	float offsyncTimer = 0.0f;
 	float speedMult = 1.0f;
 	bool foreground = false;
+	bool samplesFrame = false;
 	bool errored = false;
 	Vector<String> defaultBGs;
 	LuaBindable *bindable = nullptr;
@@ -83,14 +91,9 @@ private:
 		CheckedLoad(fullscreenMaterial = LoadBackgroundMaterial(matPath));
 		fullscreenMaterial->opaque = false;
 
-		if (fullscreenMaterial->HasUniform("texFrameBuffer"))
-		{
-			frameBufferTexture = TextureRes::CreateFromFrameBuffer(g_gl, g_resolution);
-		}
-		else
-		{
-			frameBufferTexture = nullptr;
-		}
+		// The framebuffer copy is only created when the game doesn't provide the rendered frame
+		samplesFrame = fullscreenMaterial->HasUniform("texFrameBuffer");
+		frameBufferTexture = nullptr;
 
 		return true;
 	}
@@ -105,7 +108,7 @@ public:
 			Path::Absolute("skins/" + g_application->GetCurrentSkin() + "/backgrounds/")));
 
 		String skin = g_gameConfig.GetString(GameConfigKeys::Skin);
-		lua = luaL_newstate();
+		lua = g_application->NewLuaState("background");
 
 		auto openLib = [this](const char *name, lua_CFunction lib) {
 			luaL_requiref(lua, name, lib, 1);
@@ -224,13 +227,14 @@ public:
 		offsyncTimer = fmodf(offsyncTimer, 1.0f);
 		timing.y = offsyncTimer;
 
+		const GameplaySnapshot& gameplay = game->GetGameplaySnapshot();
 		float clearBorder = 0.70f;
-		if (game->GetScoring().GetTopGauge()->GetType() != GaugeType::Normal)
+		if (gameplay.gaugeType != GaugeType::Normal)
 		{
 			clearBorder = 0.30f;
 		}
 
-		bool cleared = game->GetScoring().GetTopGauge()->GetValue() >= clearBorder;
+		bool cleared = gameplay.gauge >= clearBorder;
 
 		if (cleared)
 			clearTransition += deltaTime / tp.beatDuration * 1000;
@@ -240,16 +244,30 @@ public:
 		clearTransition = Math::Clamp(clearTransition, 0.0f, 1.0f);
 
 		Vector2i screenCenter = game->GetCamera().GetScreenCenter();
+		if (resolution.x > 0 && resolution.y > 0)
+		{
+			screenCenter.x = screenCenter.x * resolution.x / g_resolution.x;
+			screenCenter.y = screenCenter.y * resolution.y / g_resolution.y;
+		}
 
 		tilt = {game->GetCamera().GetActualRoll(), game->GetCamera().GetBackgroundSpin()};
 		fullscreenMaterialParams.SetParameter("clearTransition", clearTransition);
 		fullscreenMaterialParams.SetParameter("tilt", tilt);
 		fullscreenMaterialParams.SetParameter("screenCenter", screenCenter);
 		fullscreenMaterialParams.SetParameter("timing", timing);
-		if (foreground && frameBufferTexture)
+		if (foreground && samplesFrame)
 		{
-			frameBufferTexture->SetFromFrameBuffer();
-			fullscreenMaterialParams.SetParameter("texFrameBuffer", frameBufferTexture);
+			if (frameTexture)
+			{
+				fullscreenMaterialParams.SetParameter("texFrameBuffer", frameTexture);
+			}
+			else
+			{
+				if (!frameBufferTexture || frameBufferTexture->GetSize().x != g_resolution.x || frameBufferTexture->GetSize().y != g_resolution.y)
+					frameBufferTexture = TextureRes::CreateFromFrameBuffer(g_gl, g_resolution);
+				frameBufferTexture->SetFromFrameBuffer();
+				fullscreenMaterialParams.SetParameter("texFrameBuffer", frameBufferTexture);
+			}
 		}
 
 		if (foreground)
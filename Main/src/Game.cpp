@@ -7,6 +7,7 @@
 #include <unordered_set>
 #include <Beatmap/BeatmapPlayback.hpp>
 #include <Shared/Profiling.hpp>
+#include <Shared/LuaTableCache.hpp>
 #include <Audio/Audio.hpp>
 
 #include "Scoring.hpp"
@@ -24,6 +25,7 @@
 #include "GameConfig.hpp"
 #include <Shared/Time.hpp>
 #include "Gauge.hpp"
+#include "GameplayThread.hpp"
 
 #include "PracticeModeSettingsDialog.hpp"
 #include "Audio/OffsetComputer.hpp"
@@ -33,13 +35,14 @@ Ref<Beatmap> TryLoadMap(const String& path)
 {
 	// Load map file
 	Beatmap* newMap = new Beatmap();
-	File mapFile;
-	if(!mapFile.OpenRead(path))
+	// Charts are read into memory instead of mapped, editors can rewrite them while they are loaded
+	Buffer mapData;
+	if(!File::ReadAll(path, mapData))
 	{
 		delete newMap;
 		return Ref<Beatmap>();
 	}
-	FileReader reader(mapFile);
+	MappedReader reader(mapData);
 	if(!newMap->Load(reader))
 	{
 		delete newMap;
@@ -48,6 +51,50 @@ Ref<Beatmap> TryLoadMap(const String& path)
 	return Ref<Beatmap>(newMap);
 }
 
+// Mirrors the lanes of all objects in a map
+void ApplyMirror(Beatmap& beatmap)
+{
+	int buttonSwaps[] = { 3,2,1,0,5,4 };
+
+	const Vector<ObjectState*> chartObjects = beatmap.GetLinearObjects();
+	for (ObjectState* currentobj : chartObjects)
+	{
+		if (currentobj->type == ObjectType::Single || currentobj->type == ObjectType::Hold)
+		{
+			ButtonObjectState* bos = (ButtonObjectState*)currentobj;
+			bos->index = buttonSwaps[bos->index];
+		}
+		else if (currentobj->type == ObjectType::Laser)
+		{
+			LaserObjectState* los = (LaserObjectState*)currentobj;
+			los->index = (los->index + 1) % 2;
+			for (size_t i = 0; i < 2; i++)
+			{
+				los->points[i] = fabsf(los->points[i] - 1.0f);
+			}
+		}
+	}
+}
+
+// Keys of the fields of the gameplay lua table that are set every frame
+enum GameplayLuaKey : uint32
+{
+	LuaKey_autoplay, LuaKey_practice_setup, LuaKey_progress, LuaKey_hispeed, LuaKey_playbackSpeed, LuaKey_bpm,
+	LuaKey_type, LuaKey_options, LuaKey_value, LuaKey_name, LuaKey_comboState,
+	LuaKey_hiddenFade, LuaKey_hiddenCutoff, LuaKey_suddenFade, LuaKey_suddenCutoff,
+	LuaKey_x, LuaKey_y, LuaKey_rotation, LuaKey_xOffset, LuaKey_x1, LuaKey_y1, LuaKey_x2, LuaKey_y2,
+	LuaKey_pos, LuaKey_alpha, LuaKey_skew, LuaKey_maxScore, LuaKey_currentScore,
+};
+// Tables inside the gameplay lua table
+enum GameplayLuaTable : uint32
+{
+	LuaTable_Gameplay, LuaTable_Gauge, LuaTable_NoteHeld, LuaTable_LaserActive,
+	LuaTable_CritLine, LuaTable_CritLineLine, LuaTable_Cursors, LuaTable_Cursor0, LuaTable_Cursor1,
+	LuaTable_ScoreReplays,
+	// One per score replay
+	LuaTable_ScoreReplay0,
+};
+
 /* 
 	Game implementation class
 */
@@ -111,6 +158,16 @@ private:
 	Scoring m_scoring;
 	// Beatmap playback manager (object and timing point selector)
 	BeatmapPlayback m_playback;
+	// Playback of the scoring, updated by the gameplay thread while it runs
+	BeatmapPlayback m_gameplayPlayback;
+	// Input read by the scoring, the buttons of g_input are forwarded to it
+	Input m_gameplayInput;
+	// Updates the playback and scoring at a fixed rate while the chart is playing
+	GameplayThread m_gameplayThread{ m_gameplayPlayback, m_scoring, m_gameplayInput };
+	// Latest gameplay state, rendering reads this instead of the scoring
+	GameplaySnapshot m_gameplay;
+	// Audio offset the gameplay thread clock was started with
+	int32 m_gameplayThreadOffset = 0;
 	// Audio playback manager (music and FX))
 	AudioPlayback m_audioPlayback;
 	// Applied audio offset
@@ -139,6 +196,13 @@ private:
 	Background* m_background = nullptr;
 	Background* m_foreground = nullptr;
 
+	// Offscreen targets for the frame sampled by the foreground and the reduced resolution background
+	RenderTargetGraph m_renderTargets;
+	bool m_useRenderTargets = false;
+	uint32 m_backgroundPass = 0;
+	uint32 m_scenePass = 0;
+	uint32 m_foregroundPass = 0;
+
 	// Lua state
 	lua_State* m_lua = nullptr;
 
@@ -169,6 +233,17 @@ private:
 	bool m_showCover = true;
 
 	Vector<ScoreReplay> m_scoreReplays;
+
+	// Tables and keys of the gameplay lua table, in the same order as LuaKey_ and LuaTable_
+	LuaTableCache m_luaCache{
+		"autoplay", "practice_setup", "progress", "hispeed", "playbackSpeed", "bpm",
+		"type", "options", "value", "name", "comboState",
+		"hiddenFade", "hiddenCutoff", "suddenFade", "suddenCutoff",
+		"x", "y", "rotation", "xOffset", "x1", "y1", "x2", "y2",
+		"pos", "alpha", "skew", "maxScore", "currentScore" };
+
+	// Input of this play, saved by the score screen
+	InputReplay m_inputReplay;
 	MapDatabase* m_db;
 	std::unordered_set<ObjectState*> m_hiddenObjects;
 
@@ -191,6 +266,9 @@ public:
 		m_hispeed = g_gameConfig.GetFloat(GameConfigKeys::HiSpeed);
 		m_speedMod = g_gameConfig.GetEnum<Enum_SpeedMods>(GameConfigKeys::SpeedMod);
 		m_modSpeed = g_gameConfig.GetFloat(GameConfigKeys::ModSpeed);
+
+		// Exposes the autoplay button state to skin scripts
+		g_application->autoplayInfo = &m_scoring.autoplayInfo;
 	}
 
 	Game_Impl(ChartIndex* chart, PlayOptions&& options) : m_playOptions(std::move(options))
@@ -205,10 +283,17 @@ public:
 		m_hispeed = g_gameConfig.GetFloat(GameConfigKeys::HiSpeed);
 		m_speedMod = g_gameConfig.GetEnum<Enum_SpeedMods>(GameConfigKeys::SpeedMod);
 		m_modSpeed = g_gameConfig.GetFloat(GameConfigKeys::ModSpeed);
+
+		// Exposes the autoplay button state to skin scripts
+		g_application->autoplayInfo = &m_scoring.autoplayInfo;
 	}
 
 	~Game_Impl()
 	{
+		m_gameplayThread.Stop();
+		if (g_application->autoplayInfo == &m_scoring.autoplayInfo)
+			g_application->autoplayInfo = nullptr;
+
         delete m_track;
 		delete m_background;
 		delete m_foreground;
@@ -238,6 +323,7 @@ public:
 		// In case the cursor was still hidden
 		g_gameWindow->SetCursorVisible(true); 
 		g_input.OnButtonPressed.RemoveAll(this);
+		g_input.OnButtonReleased.RemoveAll(this);
 		g_transition->OnLoadingComplete.RemoveAll(this);
 	}
 
@@ -453,6 +539,9 @@ public:
 		if (!loader.Finalize())
 			return false;
 
+		if (g_gameConfig.GetBool(GameConfigKeys::BakeLaserMeshes))
+			m_track->BakeLasers(m_playback);
+
 		// Always hide mouse during gameplay no matter what input mode.
 		g_gameWindow->SetCursorVisible(false);
 
@@ -488,8 +577,8 @@ public:
 
 		if (m_delayedHitEffects)
 		{
-			m_scoring.OnHoldEnter.Add(m_track, &Track::OnHoldEnter);
-			m_scoring.OnHoldLeave.Add(m_track, &Track::OnButtonReleased);
+			m_gameplayThread.Defer(m_scoring.OnHoldEnter, m_track, &Track::OnHoldEnter);
+			m_gameplayThread.Defer(m_scoring.OnHoldLeave, m_track, &Track::OnButtonReleased);
 		}
 
 		#ifdef EMBEDDED
@@ -528,17 +617,35 @@ public:
 			m_background = CreateBackground(this);
 			m_foreground = CreateBackground(this, true);
 		}
+		m_InitRenderTargets();
 
 		// Do this here so we don't get input events while still loading
 		m_scoring.SetOptions(GetPlaybackOptions());
-		m_scoring.SetPlayback(m_playback);
+		m_scoring.SetPlayback(m_gameplayPlayback);
 		m_scoring.SetEndTime(m_endTime);
-		m_scoring.SetInput(&g_input);
+		m_gameplayInput.InitHeadless();
+		m_scoring.SetInput(&m_gameplayInput);
 		m_scoring.Reset(m_playOptions.range);
 
 		m_scoring.SetHitWindow(GetHitWindow());
 
 		g_input.OnButtonPressed.Add(this, &Game_Impl::m_OnButtonPressed);
+		m_gameplayThread.ForwardButtons(g_input, [this]() { return m_GetEventPlaybackTime(); });
+		m_gameplayThread.SetReplay(&m_inputReplay);
+
+		// Settings needed to re-simulate the play from its input
+		const HitWindow& hitWindow = m_scoring.hitWindow;
+		m_inputReplay.options = GetPlaybackOptions();
+		m_inputReplay.hitWindowPerfect = hitWindow.perfect;
+		m_inputReplay.hitWindowGood = hitWindow.good;
+		m_inputReplay.hitWindowHold = hitWindow.hold;
+		m_inputReplay.hitWindowMiss = hitWindow.miss;
+		m_inputReplay.hitWindowSlam = hitWindow.slam;
+		m_inputReplay.inputOffset = g_gameConfig.GetInt(GameConfigKeys::InputOffset);
+		m_inputReplay.laserOffset = g_gameConfig.GetInt(GameConfigKeys::LaserOffset);
+		m_inputReplay.bounceGuard = g_gameConfig.GetInt(GameConfigKeys::InputBounceGuard);
+		// Gameplay thread steps without input are stored as repeats, lasers moved every rendered frame at 240 fps need a frame each
+		m_inputReplay.frames.reserve((m_endTime / 1000 + 10) * 240);
 
 		m_track->hitEffectAutoplay = m_scoring.autoplayInfo.IsAutoplayButtons();
 
@@ -592,26 +699,7 @@ public:
 
 		if (GetPlaybackOptions().mirror)
 		{
-			int buttonSwaps[] = { 3,2,1,0,5,4 };
-
-			const Vector<ObjectState*> chartObjects = m_playback.GetBeatmap().GetLinearObjects();
-			for (ObjectState* currentobj : chartObjects)
-			{
-				if (currentobj->type == ObjectType::Single || currentobj->type == ObjectType::Hold)
-				{
-					ButtonObjectState* bos = (ButtonObjectState*)currentobj;
-					bos->index = buttonSwaps[bos->index];
-				}
-				else if (currentobj->type == ObjectType::Laser)
-				{
-					LaserObjectState* los = (LaserObjectState*)currentobj;
-					los->index = (los->index + 1) % 2;
-					for (size_t i = 0; i < 2; i++)
-					{
-						los->points[i] = fabsf(los->points[i] - 1.0f);
-					}
-				}
-			}
+			ApplyMirror(*m_beatmap);
 		}
 
 		if (m_practiceSetupDialog)
@@ -658,6 +746,7 @@ public:
 	void JumpTo(MapTime newTime)
 	{
 		Logf("Game::JumpTo(%d)", Logger::Severity::Debug, newTime);
+		m_StopGameplayThread();
 
 		m_triggerEnd = false;
 		m_triggerPause = m_paused;
@@ -695,7 +784,7 @@ public:
 		m_hideLane = false;
 		m_transitioning = false;
 		m_scoring.Reset(m_playOptions.range);
-		m_scoring.SetInput(&g_input);
+		m_scoring.SetInput(&m_gameplayInput);
 		m_camera.pLaneZoom = m_playback.GetZoom(0);
 		m_camera.pLanePitch = m_playback.GetZoom(1);
 		m_camera.pLaneOffset = m_playback.GetZoom(2);
@@ -735,6 +824,12 @@ public:
 	{
 		if (m_ended && IsSuspended()) return;
 
+		// The handlers read the scoring, so the gameplay thread waits for them
+		{
+			GameplayThread::StateLock state = m_gameplayThread.LockState();
+			m_gameplayThread.DispatchCalls();
+		}
+
 		// Lock mouse to screen when playing
 		if(g_gameConfig.GetEnum<Enum_InputDevice>(GameConfigKeys::LaserInputDevice) == InputDevice::Mouse)
 		{
@@ -754,6 +849,8 @@ public:
 
 		if(!m_paused)
 			TickGameplay(deltaTime);
+		else
+			m_UpdateGameplayThread(false);
 
 		if (m_outroCompleted && !m_transitioning)
 			BeginAfterGameTransition();
@@ -835,6 +932,9 @@ public:
 	{
 		if (m_ended && IsSuspended()) return;
 
+		m_gameplay = m_gameplayThread.GetSnapshot();
+		const GameplaySnapshot& gameplay = m_gameplay;
+
 		// 8 beats (2 measures) in view at 1x hi-speed
 		if (m_speedMod == SpeedMods::CMod)
 		{
@@ -850,11 +950,11 @@ public:
 		// Get render state from the camera
 		// Get roll when there's no laser slam roll and roll ignore being applied
 		// This could be simplified but is necessary to have SDVX II-like roll keep and laser slams
-		float rollL = m_camera.GetRollIgnoreTimer(0) <= 0 ? m_scoring.GetLaserRollOutput(0) : m_camera.GetSlamAmount(0);
-		float rollR = m_camera.GetRollIgnoreTimer(1) <= 0 ? m_scoring.GetLaserRollOutput(1) : m_camera.GetSlamAmount(1);
+		float rollL = m_camera.GetRollIgnoreTimer(0) <= 0 ? gameplay.laserRollOutput[0] : m_camera.GetSlamAmount(0);
+		float rollR = m_camera.GetRollIgnoreTimer(1) <= 0 ? gameplay.laserRollOutput[1] : m_camera.GetSlamAmount(1);
 		bool slowTilt = (rollL == -1 && rollR == 1) || (rollL == 0 && rollR == 0);
-		rollL = m_camera.GetRollIgnoreTimer(0) <= 0 ? m_scoring.GetLaserRollOutput(0) : 0;
-		rollR = m_camera.GetRollIgnoreTimer(1) <= 0 ? m_scoring.GetLaserRollOutput(1) : 0;
+		rollL = m_camera.GetRollIgnoreTimer(0) <= 0 ? gameplay.laserRollOutput[0] : 0;
+		rollR = m_camera.GetRollIgnoreTimer(1) <= 0 ? gameplay.laserRollOutput[1] : 0;
 		m_camera.SetTargetRoll(rollL + rollR);
 		m_camera.SetSlowTilt(slowTilt);
 
@@ -872,9 +972,21 @@ public:
 		m_track->Tick(m_playback, deltaTime);
 		RenderState rs = m_camera.CreateRenderState(true);
 
+		// Portrait mode renders into a part of the window
+		const Recti screenViewport = g_gl->GetViewport();
+		const bool useRenderTargets = m_PrepareRenderTargets();
+
 		// Draw BG first
+		if (useRenderTargets)
+			m_renderTargets.BeginPass(g_gl, m_backgroundPass, screenViewport);
 		if(m_background)
 			m_background->Render(deltaTime);
+		if (useRenderTargets)
+		{
+			m_renderTargets.BeginPass(g_gl, m_scenePass, screenViewport);
+			if (!m_renderTargets.GetPasses()[m_scenePass].inputs.empty())
+				m_renderTargets.GetInput(0)->Draw(g_gl->GetViewport());
+		}
 
 		// Main render queue
 		RenderQueue renderQueue(g_gl, rs);
@@ -929,9 +1041,9 @@ public:
 			{
 				MultiObjectState* mobj = (MultiObjectState*)object;
 				if (object->type == ObjectType::Hold && (mobj->button.index == 4 || mobj->button.index == 5))
-					m_track->DrawObjectState(fxHoldObjectsRq, m_playback, object, m_scoring.IsObjectHeld(object), chipFXTimes);
+					m_track->DrawObjectState(fxHoldObjectsRq, m_playback, object, gameplay.IsObjectHeld(object), chipFXTimes);
 				else
-					m_track->DrawObjectState(hitObjectsTrackCoverRq, m_playback, object, m_scoring.IsObjectHeld(object), chipFXTimes);
+					m_track->DrawObjectState(hitObjectsTrackCoverRq, m_playback, object, gameplay.IsObjectHeld(object), chipFXTimes);
 			}
 		}
 		if(m_showCover)
@@ -947,18 +1059,18 @@ public:
 		// Copy over laser position and extend info
 		for(uint32 i = 0; i < 2; i++)
 		{
-			if(m_scoring.IsLaserHeld(i))
+			if(gameplay.laserHeld[i])
 			{
-				m_track->laserPositions[i] = m_scoring.laserTargetPositions[i];
-				m_track->lasersAreExtend[i] = m_scoring.lasersAreExtend[i];
+				m_track->laserPositions[i] = gameplay.laserTargetPositions[i];
+				m_track->lasersAreExtend[i] = gameplay.lasersAreExtend[i];
 			}
 			else
 			{
-				m_track->laserPositions[i] = m_scoring.laserPositions[i];
-				m_track->lasersAreExtend[i] = m_scoring.lasersAreExtend[i];
+				m_track->laserPositions[i] = gameplay.laserPositions[i];
+				m_track->lasersAreExtend[i] = gameplay.lasersAreExtend[i];
 			}
-			m_track->laserPositions[i] = m_scoring.laserPositions[i];
-			m_track->laserPointerOpacity[i] = (1.0f - Math::Clamp<float>(m_scoring.timeSinceLaserUsed[i] / 0.5f - 1.0f, 0, 1));
+			m_track->laserPositions[i] = gameplay.laserPositions[i];
+			m_track->laserPointerOpacity[i] = (1.0f - Math::Clamp<float>(gameplay.timeSinceLaserUsed[i] / 0.5f - 1.0f, 0, 1));
 		}
 		m_track->DrawHitEffects(hitEffectsRq);
 		m_track->DrawOverlays(scoringRq);
@@ -975,14 +1087,14 @@ public:
 		{
 			for (uint32 i = 0; i < 2; i++)
 			{
-				if (m_scoring.IsLaserHeld(i))
+				if (gameplay.laserHeld[i])
 				{
 					if (!m_laserFollowEmitters[i])
 						m_laserFollowEmitters[i] = CreateTrailEmitter(m_track->laserColors[i]);
 
 					// Set particle position to follow laser
-					float followPos = m_scoring.laserTargetPositions[i];
-					if (m_scoring.lasersAreExtend[i])
+					float followPos = gameplay.laserTargetPositions[i];
+					if (gameplay.lasersAreExtend[i])
 						followPos = followPos * 2.0f - 0.5f;
 
 					m_laserFollowEmitters[i]->position = m_track->TransformPoint(Vector3(m_track->trackWidth * followPos - m_track->trackWidth * 0.5f, 0.f, 0.f));
@@ -999,7 +1111,7 @@ public:
 			// Set hold button particle visibility
 			for (uint32 i = 0; i < 6; i++)
 			{
-				if (m_scoring.IsObjectHeld(i))
+				if (gameplay.IsObjectHeld(i))
 				{
 					if (!m_holdEmitters[i])
 					{
@@ -1065,8 +1177,21 @@ public:
 			NVG_FLUSH();
 
 		// Render foreground
+		if (useRenderTargets)
+		{
+			m_renderTargets.BeginPass(g_gl, m_foregroundPass, screenViewport);
+			if (m_foreground && m_foreground->SamplesFrame())
+			{
+				// The foreground is drawn over the frame it samples instead of a copy of the framebuffer
+				const RenderTarget& scene = m_renderTargets.GetInput(0);
+				scene->Draw(screenViewport);
+				m_foreground->frameTexture = scene->GetTexture();
+			}
+		}
 		if(m_foreground)
 			m_foreground->Render(deltaTime);
+		if (useRenderTargets)
+			m_renderTargets.EndFrame(g_gl, screenViewport);
 
 		// Render Lua HUD
 		lua_getglobal(m_lua, "render");
@@ -1193,6 +1318,12 @@ public:
 
 		m_playback.audioOffset = GetAudioOffset();
 		m_playback.Reset(m_lastMapTime, std::max(beginTime, m_playOptions.range.begin));
+		m_gameplayPlayback.audioOffset = GetAudioOffset();
+		m_gameplayPlayback.Reset(m_lastMapTime, std::max(beginTime, m_playOptions.range.begin));
+
+		m_inputReplay.Clear();
+		m_inputReplay.playbackInitTime = m_lastMapTime;
+		m_inputReplay.playbackStartTime = std::max(beginTime, m_playOptions.range.begin);
 
 		ApplyPlaybackSpeed();
 		m_LuaUpdateProgress();
@@ -1207,7 +1338,7 @@ public:
 		lua_setglobal(m_lua, "gameplay");
 	}
 
-	void m_LuaUpdateProgress(lua_State* L)
+	float m_GetProgress() const
 	{
 		MapTime progress = m_lastMapTime - m_playOptions.range.begin;
 		MapTime duration = m_playOptions.range.Length(m_endTime);
@@ -1219,8 +1350,13 @@ public:
 			duration = m_endTime;
 		}
 
+		return Math::Clamp((float)progress / duration, 0.f, 1.f);
+	}
+
+	void m_LuaUpdateProgress(lua_State* L)
+	{
 		lua_pushstring(L, "progress");
-		lua_pushnumber(L, Math::Clamp((float)progress / duration, 0.f, 1.f));
+		lua_pushnumber(L, m_GetProgress());
 		lua_settable(L, -3);
 	}
 
@@ -1270,6 +1406,8 @@ public:
 		m_playback.OnFXEnd.Add(this, &Game_Impl::OnFXEnd);
 		m_playback.OnLaserAlertEntered.Add(this, &Game_Impl::OnLaserAlertEntered);
 		m_playback.Reset();
+		m_gameplayPlayback = BeatmapPlayback(*m_beatmap);
+		m_gameplayPlayback.Reset();
 
 		// Set camera start position
 		m_camera.pLaneZoom = m_playback.GetZoom(0);
@@ -1301,21 +1439,30 @@ public:
 		CheckChallengeHispeed(m_playback.GetCurrentTimingPoint().GetBPM());
 		m_playback.cModSpeed = m_hispeed * m_playback.GetCurrentTimingPoint().GetBPM();
 
-		// Register input bindings
-		m_scoring.OnButtonMiss.Add(this, &Game_Impl::OnButtonMiss);
-		m_scoring.OnLaserSlamHit.Add(this, &Game_Impl::OnLaserSlamHit);
-		m_scoring.OnButtonHit.Add(this, &Game_Impl::OnButtonHit);
-		m_scoring.OnComboChanged.Add(this, &Game_Impl::OnComboChanged);
-		m_scoring.OnObjectHold.Add(this, &Game_Impl::OnObjectHold);
-		m_scoring.OnObjectReleased.Add(this, &Game_Impl::OnObjectReleased);
-		m_scoring.OnScoreChanged.Add(this, &Game_Impl::OnScoreChanged);
+		// Register input bindings, these are called on the main thread while the gameplay thread runs
+		m_gameplayThread.Defer(m_scoring.OnButtonMiss, this, &Game_Impl::OnButtonMiss);
+		m_gameplayThread.Defer(m_scoring.OnLaserSlamHit, this, &Game_Impl::OnLaserSlamHit);
+		m_gameplayThread.Defer(m_scoring.OnButtonHit, this, &Game_Impl::OnButtonHit);
+		m_gameplayThread.Defer(m_scoring.OnComboChanged, this, &Game_Impl::OnComboChanged);
+		m_gameplayThread.Defer(m_scoring.OnObjectHold, this, &Game_Impl::OnObjectHold);
+		m_gameplayThread.Defer(m_scoring.OnObjectReleased, this, &Game_Impl::OnObjectReleased);
+		m_gameplayThread.Defer(m_scoring.OnScoreChanged, this, &Game_Impl::OnScoreChanged);
+		// Only logs, the gauge it changed from is deleted right after the call
 		m_scoring.OnGaugeChanged.Add(this, &Game_Impl::OnGaugeChanged);
 
-		m_scoring.OnLaserSlam.Add(this, &Game_Impl::OnLaserSlam);
-		m_scoring.OnLaserExit.Add(this, &Game_Impl::OnLaserExit);
+		// The slam is marked as processed right away, the scoring checks the flag on every update
+		m_scoring.OnLaserSlam.AddLambda([](LaserObjectState* object)
+		{
+			if (object != nullptr)
+				object->flags |= LaserObjectState::flag_slamProcessed;
+		});
+		m_gameplayThread.Defer(m_scoring.OnLaserSlam, this, &Game_Impl::OnLaserSlam);
+		m_gameplayThread.Defer(m_scoring.OnLaserExit, this, &Game_Impl::OnLaserExit);
 
 		m_playback.hittableObjectEnter = m_scoring.hitWindow.miss + g_gameConfig.GetInt(GameConfigKeys::InputOffset);
 		m_playback.hittableObjectLeave = m_scoring.hitWindow.good;
+		m_gameplayPlayback.hittableObjectEnter = m_playback.hittableObjectEnter;
+		m_gameplayPlayback.hittableObjectLeave = m_playback.hittableObjectLeave;
 
 		if(g_application->GetAppCommandLine().Contains("-autobuttons"))
 		{
@@ -1363,9 +1510,13 @@ public:
 
 		const BeatmapSettings& beatmapSettings = m_beatmap->GetMapSettings();
 
-		// Update beatmap playback
+		// Update beatmap playback, the gameplay thread updates its own while the chart is playing
 		const MapTime playbackPositionMs = m_audioPlayback.GetPosition() - GetAudioOffset();
+		m_UpdateGameplayThread(m_introCompleted && !m_paused && !m_ended && !m_audioPlayback.IsPaused());
+		if (!m_gameplayThread.IsRunning())
+			m_gameplayPlayback.Update(playbackPositionMs);
 		m_playback.Update(playbackPositionMs);
+		m_gameplay = m_gameplayThread.GetSnapshot();
 
 		const MapTime delta = playbackPositionMs - m_lastMapTime;
 		int32 beatStart = 0;
@@ -1386,13 +1537,16 @@ public:
 
 		/// #Scoring
 		// Update music filter states
-		m_audioPlayback.SetLaserFilterInput(m_scoring.GetLaserOutput(), m_scoring.IsLaserHeld(0, false) || m_scoring.IsLaserHeld(1, false));
+		m_audioPlayback.SetLaserFilterInput(m_gameplay.laserOutput, m_gameplay.laserFilterHeld);
 		m_audioPlayback.Tick(deltaTime);
 
-		m_audioPlayback.SetFXTrackEnabled(m_scoring.GetLaserActive() || m_scoring.GetFXActive());
+		bool fxActive = false;
+		for (uint32 i = 4; i < 8; i++)
+			fxActive = fxActive || m_gameplay.IsObjectHeld(i);
+		m_audioPlayback.SetFXTrackEnabled(fxActive);
 
 		// Stop playing if last gauge has reached its failstate
-		if (m_scoring.IsFailOut())
+		if (m_gameplay.failed)
 		{
 			// In multiplayer we don't stop, but we send the final score
 			if (m_multiplayer == nullptr) {
@@ -1410,7 +1564,19 @@ public:
 		// Update scoring
 		if (!m_ended)
 		{
-			m_scoring.Tick(deltaTime);
+			if (m_gameplayThread.IsRunning())
+			{
+				for (uint32 i = 0; i < 2; i++)
+					m_gameplayThread.QueueLaserInput(i, g_input.GetInputLaserDir(i));
+			}
+			else
+			{
+				m_inputReplay.AddFrame(playbackPositionMs, deltaTime, g_input.GetInputLaserDir(0), g_input.GetInputLaserDir(1));
+				for (uint32 i = 0; i < 2; i++)
+					m_gameplayInput.SimulateLaserDir(i, g_input.GetInputLaserDir(i));
+				m_scoring.Tick(deltaTime);
+				m_gameplay = m_gameplayThread.GetSnapshot();
+			}
 		}
 
 		// Get the current timing point
@@ -1420,7 +1586,10 @@ public:
 		ObjectState *const* lastObj = &m_beatmap->GetLinearObjects().back();
 
 		if (m_multiplayer != nullptr)
+		{
+			GameplayThread::StateLock state = m_gameplayThread.LockState();
 			m_multiplayer->PerformScoreTick(m_scoring, m_lastMapTime);
+		}
 
 		if (delta >= 0)
 		{
@@ -1437,13 +1606,17 @@ public:
 		{
 			EndCurrentRun();
 		}
-		else if (!m_scoring.autoplayInfo.autoplay && !m_isPracticeSetup && m_playOptions.failCondition && m_playOptions.failCondition->IsFailed(m_scoring))
+		else if (!m_scoring.autoplayInfo.autoplay && !m_isPracticeSetup && m_playOptions.failCondition)
 		{
-			Gauge* gauge = m_scoring.GetTopGauge();
+			GameplayThread::StateLock state = m_gameplayThread.LockState();
+			if (m_playOptions.failCondition->IsFailed(m_scoring))
+			{
+				Gauge* gauge = m_scoring.GetTopGauge();
 
-			if (gauge) 
-				gauge->SetValue(0.0f);
-			FailCurrentRun();
+				if (gauge) 
+					gauge->SetValue(0.0f);
+				FailCurrentRun();
+			}
 		}
 	}
 
@@ -1501,6 +1674,7 @@ public:
 	void EndCurrentRun()
 	{
 		m_triggerEnd = false;
+		m_StopGameplayThread();
 
 		if (m_isPracticeSetup)
 		{
@@ -1524,6 +1698,7 @@ public:
 	// Called when the current play is failed for whatever reason
 	void FailCurrentRun()
 	{
+		m_StopGameplayThread();
 		if (!IsMultiplayerGame() && m_playOptions.loopOnFail)
 		{
 			m_OnEndRun(false);
@@ -1642,6 +1817,8 @@ public:
 		if(m_ended)
 			return;
 
+		m_StopGameplayThread();
+
 		// Send the final scores to the server
 		if (m_multiplayer)
 			m_multiplayer->SendFinalScore(this, m_getClearState());
@@ -1682,6 +1859,69 @@ public:
 		g_application->RemoveTickable(this);
 	}
 
+	// Sets up the render passes, offscreen targets are only used when the foreground samples the frame or the background is rendered at half resolution
+	void m_InitRenderTargets()
+	{
+		m_renderTargets.Reset();
+		m_useRenderTargets = false;
+
+		const bool foregroundSamplesFrame = m_foreground && m_foreground->SamplesFrame();
+		const bool halfResolutionBackground = m_background && g_gameConfig.GetBool(GameConfigKeys::HalfResolutionBackground);
+		if (!foregroundSamplesFrame && !halfResolutionBackground)
+			return;
+
+		// The frame is multisampled like the window
+		int32 samples = g_gameConfig.GetInt(GameConfigKeys::AntiAliasing);
+		if (samples > 0)
+			samples = 1 << samples;
+
+		uint32 scene = RenderTargetGraph::Screen;
+		if (foregroundSamplesFrame)
+			scene = m_renderTargets.AddTarget("Scene", 1.0f, samples);
+		if (halfResolutionBackground)
+		{
+			const uint32 background = m_renderTargets.AddTarget("Background", 0.5f);
+			m_backgroundPass = m_renderTargets.AddPass("Background", background);
+			m_scenePass = m_renderTargets.AddPass("Scene", scene, { background });
+		}
+		else
+		{
+			m_backgroundPass = m_renderTargets.AddPass("Background", scene);
+			m_scenePass = m_renderTargets.AddPass("Scene", scene);
+		}
+		if (foregroundSamplesFrame)
+			m_foregroundPass = m_renderTargets.AddPass("Foreground", RenderTargetGraph::Screen, { scene });
+		else
+			m_foregroundPass = m_renderTargets.AddPass("Foreground", RenderTargetGraph::Screen);
+		m_useRenderTargets = true;
+	}
+
+	// Creates the render targets for the current window size, returns false when rendering straight into the window
+	bool m_PrepareRenderTargets()
+	{
+		if (!m_useRenderTargets)
+			return false;
+		const Vector2i& screenSize = m_renderTargets.GetScreenSize();
+		if (m_renderTargets.IsCompiled() && screenSize.x == g_resolution.x && screenSize.y == g_resolution.y)
+			return true;
+
+		if (!m_renderTargets.Compile(g_resolution) || !m_renderTargets.CreateTargets(g_gl))
+		{
+			Log("Failed to create the render targets for the backgrounds, rendering into the window instead", Logger::Severity::Warning);
+			m_useRenderTargets = false;
+			if (m_background)
+				m_background->resolution = Vector2i();
+			if (m_foreground)
+				m_foreground->frameTexture = nullptr;
+			return false;
+		}
+
+		const int32 backgroundTarget = m_renderTargets.GetCompiledPasses()[m_backgroundPass].output;
+		if (m_background && backgroundTarget >= 0)
+			m_background->resolution = m_renderTargets.GetPhysicalTargets()[backgroundTarget].size;
+		return true;
+	}
+
 	void RenderParticles(const RenderState& rs, float deltaTime)
 	{
 		// Render particle effects
@@ -1781,6 +2021,9 @@ public:
 	// Main GUI/HUD Rendering loop
 	virtual void RenderDebugHUD(float deltaTime)
 	{
+		// The overlay reads the whole scoring, the gameplay thread waits while it's shown
+		GameplayThread::StateLock state = m_gameplayThread.LockState();
+
 		// Render debug overlay elements
 		//RenderQueue& debugRq = g_guiRenderer->Begin();
 		auto RenderText = [&](const String& text, const Vector2& pos, const Color& color = {1.0f, 1.0f, 0.5f, 1.0f})
@@ -1890,8 +2133,6 @@ public:
 		// a straight laser segment to the tail of the slam. This isn't exactly ideal for USC as it'll limit laser skinning.
 		if (object != nullptr)
 		{
-			// Set flag
-			object->flags |= LaserObjectState::flag_slamProcessed;
 			uint8 index = object->index;
 			float tail = m_scoring.GetLaserPosition(index, object->points[1]);
 			m_camera.SetSlamAmount(index, tail);
@@ -2167,7 +2408,7 @@ public:
 	}
 	void OnLaserAlertEntered(LaserObjectState* object)
 	{
-		if (m_scoring.timeSinceLaserUsed[object->index] > 3.0f)
+		if (m_gameplay.timeSinceLaserUsed[object->index] > 3.0f)
 		{
 			m_track->SendLaserAlert(object->index);
 			lua_getglobal(m_lua, "laser_alert");
@@ -2289,6 +2530,32 @@ public:
 			FinishGame();
 		}
 	}
+	// Time the buttons of g_input are queued with while the gameplay thread runs
+	MapTime m_GetEventPlaybackTime() const
+	{
+		return GameplayThread::GetEventTime(m_audioPlayback.GetPosition() - m_gameplayThreadOffset,
+			(int32)(SDL_GetTicks() - g_gameWindow->GetEventTime()), m_audioPlayback.GetPlaybackSpeed());
+	}
+
+	// Runs the playback and scoring on the gameplay thread while playing, TickGameplay updates them otherwise
+	void m_UpdateGameplayThread(bool playing)
+	{
+		// The clock has to be restarted when the offset changes
+		const int32 audioOffset = GetAudioOffset();
+		if (m_gameplayThread.IsRunning() && (!playing || audioOffset != m_gameplayThreadOffset))
+			m_StopGameplayThread();
+		if (playing && !m_gameplayThread.IsRunning())
+		{
+			m_gameplayThreadOffset = audioOffset;
+			m_gameplayThread.Start([this, audioOffset]() { return (MapTime)(m_audioPlayback.GetPosition() - audioOffset); });
+		}
+	}
+	void m_StopGameplayThread()
+	{
+		m_gameplayThread.Stop();
+		m_gameplayThread.DispatchCalls();
+	}
+
 	void m_OnButtonPressed(Input::Button buttonCode)
 	{
 		if (m_practiceSetupDialog && m_practiceSetupDialog->IsActive())
@@ -2585,6 +2852,7 @@ public:
 	void RevertToPracticeSetup()
 	{
 		assert(m_isPracticeMode);
+		m_StopGameplayThread();
 
 		m_isPracticeSetup = true;
 		m_scoring.autoplayInfo.autoplay = true;
@@ -2623,6 +2891,7 @@ public:
 	void StartPractice()
 	{
 		assert(m_isPracticeMode && m_isPracticeSetup);
+		m_StopGameplayThread();
 
 		m_isPracticeSetup = false;
 		m_scoring.autoplayInfo.autoplay = false;
@@ -2724,6 +2993,14 @@ public:
 	{
 		return m_scoring;
 	}
+	virtual const GameplaySnapshot& GetGameplaySnapshot() const override
+	{
+		return m_gameplay;
+	}
+	virtual const InputReplay& GetInputReplay() const override
+	{
+		return m_inputReplay;
+	}
 	virtual const std::array<float, 256>& GetGaugeSamples() override
 	{
 		return m_scoring.GetTopGauge()->GetSamples();
@@ -2738,6 +3015,7 @@ public:
 	}
 	virtual void SetGauge(float g) override
 	{
+		GameplayThread::StateLock state = m_gameplayThread.LockState();
 		auto gauge = m_scoring.GetTopGauge();
 		if (gauge)
 		{
@@ -2746,6 +3024,7 @@ public:
 	}
 	virtual void SetAllGaugeValues(const Vector<float> values)
 	{
+		GameplayThread::StateLock state = m_gameplayThread.LockState();
 		m_scoring.SetAllGaugeValues(values);
 	}
 	virtual bool IsStorableScore() override
@@ -2809,213 +3088,208 @@ public:
 		
 		if (m_isPracticeMode) LoadPracticeSetupIndex();
 	}
-	void SetGameplayLua(lua_State* L) override
+	// Registers the tables of the gameplay table, called when the cache was created or the table was replaced
+	void m_CacheGameplayLua(lua_State* L)
 	{
-		Gauge* gauge = m_scoring.GetTopGauge();
+		LuaTableCache& c = m_luaCache;
+		const int gameplay = lua_gettop(L);
+		c.SetTable(LuaTable_Gameplay, gameplay);
 
-		if (gauge == nullptr) //if gauge is null, assume something is wrong
-			return;
+		auto cacheField = [&](int parent, const char* name, uint32 id)
+		{
+			if (lua_getfield(L, parent, name) != LUA_TTABLE)
+			{
+				lua_pop(L, 1);
+				lua_newtable(L);
+				lua_pushvalue(L, -1);
+				lua_setfield(L, parent, name);
+			}
+			c.SetTable(id, -1);
+		};
+
+		cacheField(gameplay, "gauge", LuaTable_Gauge);
+		lua_pop(L, 1);
+		cacheField(gameplay, "noteHeld", LuaTable_NoteHeld);
+		lua_pop(L, 1);
+		cacheField(gameplay, "laserActive", LuaTable_LaserActive);
+		lua_pop(L, 1);
+
+		cacheField(gameplay, "critLine", LuaTable_CritLine);
+		const int critLine = lua_gettop(L);
+		cacheField(critLine, "line", LuaTable_CritLineLine);
+		lua_pop(L, 1);
+		cacheField(critLine, "cursors", LuaTable_Cursors);
+		for (int i = 0; i < 2; i++)
+		{
+			if (lua_geti(L, -1, i) != LUA_TTABLE)
+			{
+				lua_pop(L, 1);
+				lua_newtable(L);
+				lua_pushvalue(L, -1);
+				lua_seti(L, -3, i);
+			}
+			c.SetTable(LuaTable_Cursor0 + i, -1);
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 2); // cursors, critLine
+
+		// One table per score replay, the number of replays does not change during a game
+		cacheField(gameplay, "scoreReplays", LuaTable_ScoreReplays);
+		for (size_t i = 0; i < m_scoreReplays.size(); i++)
+		{
+			lua_newtable(L);
+			c.SetTable(LuaTable_ScoreReplay0 + (uint32)i, -1);
+			lua_seti(L, -2, i + 1);
+		}
+		lua_pop(L, 1);
+	}
 
+	void SetGameplayLua(lua_State* L) override
+	{
+		PROFILE_SCOPE("Gameplay Lua");
+		// Also called while rendering the background, so this only reads the latest gameplay snapshot
+		if (m_gameplay.gaugeName == nullptr) //if gauge is null, assume something is wrong
+			return;
 
-		//set lua
+		// The tables are created once, after that only their fields are updated
+		LuaTableCache& c = m_luaCache;
+		bool cached = c.Begin(L);
 		lua_getglobal(L, "gameplay");
+		if (!cached || !c.IsTable(LuaTable_Gameplay, -1))
+			m_CacheGameplayLua(L);
 
-		m_setLuaHolds(L);
+		//button
+		c.PushTable(LuaTable_NoteHeld);
+		for (size_t i = 0; i < 6; i++)
+		{
+			lua_pushboolean(L, m_gameplay.IsObjectHeld(i));
+			lua_rawseti(L, -2, i + 1);
+		}
+		lua_pop(L, 1);
+
+		//laser
+		c.PushTable(LuaTable_LaserActive);
+		for (size_t i = 0; i < 2; i++)
+		{
+			lua_pushboolean(L, m_gameplay.IsObjectHeld(6 + i));
+			lua_rawseti(L, -2, i + 1);
+		}
+		lua_pop(L, 1);
 
 		//set autoplay here as it's not set during the creation of the gameplay
-		lua_pushstring(L, "autoplay");
-		lua_pushboolean(L, m_scoring.autoplayInfo.autoplay);
-		lua_settable(L, -3);
+		c.SetBoolean(LuaKey_autoplay, m_scoring.autoplayInfo.autoplay);
 
 		if (m_isPracticeMode)
 		{
 			// Existence of this field implies that the game's in the practice mode.
-			lua_pushstring(L, "practice_setup");
-			lua_pushboolean(L, m_isPracticeSetup);
-			lua_settable(L, -3);
+			c.SetBoolean(LuaKey_practice_setup, m_isPracticeSetup);
 		}
 
 		// Update score replays
-		lua_getfield(L, -1, "scoreReplays");
-		int replayCounter = 1;
-		for (auto& replay: m_scoreReplays)
+		for (size_t i = 0; i < m_scoreReplays.size(); i++)
 		{
-			if (replay.replay.size() > 0)
+			ScoreReplay& replay = m_scoreReplays[i];
+			while (replay.nextHitStat < replay.replay.size()
+				&& replay.replay[replay.nextHitStat].time < m_lastMapTime)
 			{
-				while (replay.nextHitStat < replay.replay.size()
-					&& replay.replay[replay.nextHitStat].time < m_lastMapTime)
+				SimpleHitStat shs = replay.replay[replay.nextHitStat];
+				if (shs.rating < 3)
 				{
-					SimpleHitStat shs = replay.replay[replay.nextHitStat];
-					if (shs.rating < 3)
-					{
-						replay.currentMaxScore += 2;
-						replay.currentScore += shs.rating;
-					}
-					replay.nextHitStat++;
+					replay.currentMaxScore += 2;
+					replay.currentScore += shs.rating;
 				}
+				replay.nextHitStat++;
 			}
-			lua_pushnumber(L, replayCounter);
-			lua_newtable(L);
-
-			lua_pushstring(L, "maxScore");
-			lua_pushnumber(L, replay.maxScore);
-			lua_settable(L, -3);
 
-			lua_pushstring(L, "currentScore");
-			lua_pushnumber(L, m_scoring.CalculateCurrentDisplayScore(replay));
-			lua_settable(L, -3);
-
-			lua_settable(L, -3);
-			replayCounter++;
+			c.PushTable(LuaTable_ScoreReplay0 + (uint32)i);
+			c.SetNumber(LuaKey_maxScore, replay.maxScore);
+			c.SetNumber(LuaKey_currentScore, m_scoring.CalculateCurrentDisplayScore(replay));
+			lua_pop(L, 1);
 		}
-		lua_setfield(L, -1, "scoreReplays");
 
 		// progress
-		m_LuaUpdateProgress(L);
+		c.SetNumber(LuaKey_progress, m_GetProgress());
 
 		// hispeed
-		lua_pushstring(L, "hispeed");
-		lua_pushnumber(L, m_hispeed);
-		lua_settable(L, -3);
+		c.SetNumber(LuaKey_hispeed, m_hispeed);
 		// playback speed
-		lua_pushstring(L, "playbackSpeed");
-		lua_pushnumber(L, m_playOptions.playbackSpeed);
-		lua_settable(L, -3);
+		c.SetNumber(LuaKey_playbackSpeed, m_playOptions.playbackSpeed);
 		// bpm
-		lua_pushstring(L, "bpm");
-		lua_pushnumber(L, m_currentTiming->GetBPM());
-		lua_settable(L, -3);
+		c.SetNumber(LuaKey_bpm, m_currentTiming->GetBPM());
 		// gauge
 		{
-			Gauge* gauge = m_scoring.GetTopGauge();
-			lua_getfield(L, -1, "gauge");
-
-
-			lua_pushstring(L, "type");
-			lua_pushinteger(L, (uint32)gauge->GetType());
-			lua_settable(L, -3);
-
-			lua_pushstring(L, "options");
-			lua_pushinteger(L, gauge->GetOpts());
-			lua_settable(L, -3);
-
-			lua_pushstring(L, "value");
-			lua_pushnumber(L, gauge->GetValue());
-			lua_settable(L, -3);
-
-			lua_pushstring(L, "name");
-			lua_pushstring(L, gauge->GetName());
-			lua_settable(L, -3);
-
+			c.PushTable(LuaTable_Gauge);
+			c.SetInteger(LuaKey_type, (uint32)m_gameplay.gaugeType);
+			c.SetInteger(LuaKey_options, m_gameplay.gaugeOptions);
+			c.SetNumber(LuaKey_value, m_gameplay.gauge);
+			c.SetString(LuaKey_name, m_gameplay.gaugeName);
 			lua_pop(L, 1);
 		}
 		// combo state
-		lua_pushstring(L, "comboState");
-		lua_pushnumber(L, m_scoring.comboState);
-		lua_settable(L, -3);
+		c.SetNumber(LuaKey_comboState, m_gameplay.comboState);
 
 		// hidden/sudden
-		lua_pushstring(L, "hiddenFade");
-		lua_pushnumber(L, m_track->hiddenFadewindow);
-		lua_settable(L, -3);
-
-		lua_pushstring(L, "hiddenCutoff");
-		lua_pushnumber(L, m_track->hiddenCutoff);
-		lua_settable(L, -3);
-
-		lua_pushstring(L, "suddenFade");
-		lua_pushnumber(L, m_track->suddenFadewindow);
-		lua_settable(L, -3);
-
-		lua_pushstring(L, "suddenCutoff");
-		lua_pushnumber(L, m_track->suddenCutoff);
-		lua_settable(L, -3);
+		c.SetNumber(LuaKey_hiddenFade, m_track->hiddenFadewindow);
+		c.SetNumber(LuaKey_hiddenCutoff, m_track->hiddenCutoff);
+		c.SetNumber(LuaKey_suddenFade, m_track->suddenFadewindow);
+		c.SetNumber(LuaKey_suddenCutoff, m_track->suddenCutoff);
 
 		// critLine
 		// When the game's paused, the critline's coordinates are messed up.
 		if(!m_paused)
 		{
-			lua_getfield(L, -1, "critLine");
+			c.PushTable(LuaTable_CritLine);
 
 			Vector2 critPos = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3(0, 0, 0)));
 			Vector2 leftPos = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3(-m_track->trackWidth / 2.0, 0, 0)));
 			Vector2 rightPos = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3(m_track->trackWidth / 2.0, 0, 0)));
 			Vector2 line = rightPos - leftPos;
 
-			lua_pushstring(L, "x"); // x screen position
-			lua_pushnumber(L, critPos.x);
-			lua_settable(L, -3);
-
-			lua_pushstring(L, "y"); // y screen position
-			lua_pushnumber(L, critPos.y);
-			lua_settable(L, -3);
-
-			lua_pushstring(L, "rotation"); // rotation based on laser roll
-			lua_pushnumber(L, -atan2f(line.y, line.x));
-			lua_settable(L, -3);
-
-			lua_pushstring(L, "xOffset");
-			lua_pushnumber(L, -m_camera.GetCritLineRoll() * 360);
-			lua_settable(L, -3);
+			c.SetNumber(LuaKey_x, critPos.x); // x screen position
+			c.SetNumber(LuaKey_y, critPos.y); // y screen position
+			c.SetNumber(LuaKey_rotation, -atan2f(line.y, line.x)); // rotation based on laser roll
+			c.SetNumber(LuaKey_xOffset, -m_camera.GetCritLineRoll() * 360);
+			lua_pop(L, 1);
 
 			//track x critline corners
-			lua_getfield(L, -1, "line");
-			{
-				lua_pushstring(L, "x1");
-				lua_pushnumber(L, leftPos.x);
-				lua_settable(L, -3);
-				lua_pushstring(L, "y1");
-				lua_pushnumber(L, leftPos.y);
-				lua_settable(L, -3);
-
-				lua_pushstring(L, "x2");
-				lua_pushnumber(L, rightPos.x);
-				lua_settable(L, -3);
-				lua_pushstring(L, "y2");
-				lua_pushnumber(L, rightPos.y);
-				lua_settable(L, -3);
+			c.PushTable(LuaTable_CritLineLine);
+			{
+				c.SetNumber(LuaKey_x1, leftPos.x);
+				c.SetNumber(LuaKey_y1, leftPos.y);
+				c.SetNumber(LuaKey_x2, rightPos.x);
+				c.SetNumber(LuaKey_y2, rightPos.y);
 			}
 			lua_pop(L, 1);
 
 			auto setCursorData = [&](int ci)
 			{
-				lua_geti(L, -1, ci);
+				c.PushTable(LuaTable_Cursor0 + ci);
 
-#define TPOINT(name, y) Vector2 name = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3((m_scoring.laserPositions[ci] - Track::trackWidth * 0.5f) * (5.0f / 6), y, 0)))
+#define TPOINT(name, y) Vector2 name = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3((m_gameplay.laserPositions[ci] - Track::trackWidth * 0.5f) * (5.0f / 6), y, 0)))
 				TPOINT(cPos, 0);
 				TPOINT(cPosUp, 1);
 				TPOINT(cPosDown, -1);
 #undef TPOINT
 
 				Vector2 cursorAngleVector = cPosUp - cPosDown;
-				float distFromCritCenter = (critPos - cPos).Length() * (m_scoring.laserPositions[ci] < 0.5 ? -1 : 1);
+				float distFromCritCenter = (critPos - cPos).Length() * (m_gameplay.laserPositions[ci] < 0.5 ? -1 : 1);
 
 				float skewAngle = -atan2f(cursorAngleVector.y, cursorAngleVector.x) + 3.1415 / 2;
-				float alpha = (1.0f - Math::Clamp<float>(m_scoring.timeSinceLaserUsed[ci] / 0.5f - 1.0f, 0, 1));
-
-				lua_pushstring(L, "pos");
-				lua_pushnumber(L, distFromCritCenter * (m_scoring.lasersAreExtend[ci] ? 2 : 1));
-				lua_settable(L, -3);
-
-				lua_pushstring(L, "alpha");
-				lua_pushnumber(L, alpha);
-				lua_settable(L, -3);
+				float alpha = (1.0f - Math::Clamp<float>(m_gameplay.timeSinceLaserUsed[ci] / 0.5f - 1.0f, 0, 1));
 
-				lua_pushstring(L, "skew");
-				lua_pushnumber(L, skewAngle);
-				lua_settable(L, -3);
+				c.SetNumber(LuaKey_pos, distFromCritCenter * (m_gameplay.lasersAreExtend[ci] ? 2 : 1));
+				c.SetNumber(LuaKey_alpha, alpha);
+				c.SetNumber(LuaKey_skew, skewAngle);
 
 				lua_pop(L, 1);
 			};
 
-			lua_getfield(L, -1, "cursors");
 			setCursorData(0);
 			setCursorData(1);
-
-			lua_pop(L, 2); // cursors, critLine
 		}
 
-		lua_setglobal(L, "gameplay");
+		lua_pop(L, 1); // gameplay
+		c.End();
 	}
 	void SetInitialGameplayLua(lua_State* L) override
 	{
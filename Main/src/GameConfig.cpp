@@ -82,6 +82,8 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::InputOffset, 0);
 	Set(GameConfigKeys::LaserOffset, 0);
 	Set(GameConfigKeys::FPSTarget, 0);
+	Set(GameConfigKeys::JustInTimeRender, false);
+	Set(GameConfigKeys::TextureMemoryBudget, 512);
 	Set(GameConfigKeys::GaugeDrainNormal, 180);
 	Set(GameConfigKeys::GaugeDrainHalf, 300);
 	Set(GameConfigKeys::ModSpeed, 300.0f);
@@ -101,6 +103,7 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::DistantButtonScale, 1.0f);
 	Set(GameConfigKeys::BTOverFXScale, 0.8f);
 	Set(GameConfigKeys::DisableBackgrounds, false);
+	Set(GameConfigKeys::HalfResolutionBackground, false);
 	Set(GameConfigKeys::LeadInTime, 3000);
 	Set(GameConfigKeys::PracticeLeadInTime, 1500);
 	Set(GameConfigKeys::PracticeSetupNavEnabled, true);
@@ -193,6 +196,7 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::AutoResetToSpeed, 400.0f);
 	Set(GameConfigKeys::SlamThicknessMultiplier, 1.0f);
 	Set(GameConfigKeys::DelayedHitEffects, true);
+	Set(GameConfigKeys::BakeLaserMeshes, true);
 
 	SetEnum<Enum_AutoScoreScreenshotSettings>(GameConfigKeys::AutoScoreScreenshot, AutoScoreScreenshotSettings::Off);
 
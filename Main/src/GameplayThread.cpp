@@ -0,0 +1,230 @@
+#include "stdafx.h"
+#include "GameplayThread.hpp"
+#include "Gauge.hpp"
+#include <algorithm>
+
+GameplayThread::GameplayThread(BeatmapPlayback& playback, Scoring& scoring, Input& input)
+	: m_playback(playback), m_scoring(scoring), m_input(input), m_thread("Gameplay")
+{
+}
+
+GameplayThread::~GameplayThread()
+{
+	Stop();
+	for (auto& remove : m_deferred)
+		remove();
+}
+
+void GameplayThread::Start(Clock&& clock, uint32 rate)
+{
+	Stop();
+	m_clock = std::move(clock);
+	m_lastStepTime = 0.0;
+	m_laserInput[0] = m_laserInput[1] = 0.0f;
+	m_thread.Start(rate, [this](uint64 step, double time) { m_Step(step, time); });
+}
+
+void GameplayThread::Stop()
+{
+	if (!m_thread.IsRunning())
+		return;
+	// A step waiting for the state lock gives up, the caller might be holding it
+	m_stopping = true;
+	m_thread.Stop();
+	m_stopping = false;
+
+	// Buttons that were not applied yet are applied now, so the buttons stay in the same state as the ones they are forwarded from
+	std::lock_guard<std::mutex> lock(m_inputLock);
+	m_pendingInput.insert(m_pendingInput.end(), m_queuedInput.begin(), m_queuedInput.end());
+	m_queuedInput.clear();
+	std::stable_sort(m_pendingInput.begin(), m_pendingInput.end(), [](const QueuedInput& a, const QueuedInput& b) { return a.time < b.time; });
+	for (const QueuedInput& input : m_pendingInput)
+		m_ApplyButton(input);
+	m_pendingInput.clear();
+	m_queuedLaserInput[0] = m_queuedLaserInput[1] = 0.0f;
+}
+
+void GameplayThread::QueueButton(Input::Button button, bool pressed, MapTime time)
+{
+	std::lock_guard<std::mutex> lock(m_inputLock);
+	m_queuedInput.push_back({ time, button, pressed });
+}
+
+void GameplayThread::ForwardButtons(Input& source, Clock&& eventClock)
+{
+	m_eventClock = std::move(eventClock);
+	DelegateHandle pressed = source.OnButtonPressed.AddLambda([this](Input::Button button) { m_ForwardButton(button, true); });
+	DelegateHandle released = source.OnButtonReleased.AddLambda([this](Input::Button button) { m_ForwardButton(button, false); });
+	m_deferred.push_back([&source, pressed, released]()
+	{
+		source.OnButtonPressed.Remove(pressed);
+		source.OnButtonReleased.Remove(released);
+	});
+}
+
+MapTime GameplayThread::GetEventTime(MapTime now, int32 age, float playbackSpeed)
+{
+	return now - (MapTime)(Math::Max(0, age) * playbackSpeed);
+}
+
+void GameplayThread::QueueLaserInput(uint32 index, float dir)
+{
+	std::lock_guard<std::mutex> lock(m_inputLock);
+	m_queuedLaserInput[index] += dir;
+}
+
+const GameplaySnapshot& GameplayThread::GetSnapshot()
+{
+	if (!IsRunning())
+		m_PublishSnapshot(m_lastStep);
+	m_snapshots.Update();
+	return m_snapshots.GetReadBuffer();
+}
+
+void GameplayThread::DispatchCalls()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_callLock);
+		m_dispatching.swap(m_calls);
+	}
+	for (auto& call : m_dispatching)
+		call();
+	m_dispatching.clear();
+}
+
+void GameplayThread::SetThreadClock(FixedRateThread::NowFunction now, FixedRateThread::SleepFunction sleepUntil)
+{
+	m_thread.SetClock(std::move(now), std::move(sleepUntil));
+}
+
+void GameplayThread::m_Step(uint64 step, double time)
+{
+	StateLock state(m_stateLock, std::defer_lock);
+	while (!state.try_lock_for(std::chrono::milliseconds(1)))
+	{
+		if (m_stopping)
+			return;
+	}
+
+	const MapTime now = m_clock();
+	{
+		std::lock_guard<std::mutex> lock(m_inputLock);
+		m_pendingInput.insert(m_pendingInput.end(), m_queuedInput.begin(), m_queuedInput.end());
+		m_queuedInput.clear();
+		for (uint32 i = 0; i < 2; i++)
+		{
+			m_laserInput[i] += m_queuedLaserInput[i];
+			m_queuedLaserInput[i] = 0.0f;
+		}
+	}
+	std::stable_sort(m_pendingInput.begin(), m_pendingInput.end(), [](const QueuedInput& a, const QueuedInput& b) { return a.time < b.time; });
+
+	// Buttons are judged at the time they were pressed, the playback is moved there first
+	//	input that arrives after its time has passed is judged now
+	size_t numApplied = 0;
+	for (; numApplied < m_pendingInput.size() && m_pendingInput[numApplied].time <= now; numApplied++)
+	{
+		const QueuedInput& input = m_pendingInput[numApplied];
+		if (input.time > m_playback.GetLastTime())
+		{
+			m_playback.Update(input.time);
+			m_Tick(0.0f);
+		}
+		m_ApplyButton(input);
+	}
+	m_pendingInput.erase(m_pendingInput.begin(), m_pendingInput.begin() + numApplied);
+
+	m_playback.Update(now);
+	// Laser movement is consumed by a single scoring update
+	for (uint32 i = 0; i < 2; i++)
+		m_input.SimulateLaserDir(i, m_laserInput[i]);
+	m_Tick((float)(time - m_lastStepTime));
+	m_lastStepTime = time;
+	for (uint32 i = 0; i < 2; i++)
+	{
+		m_input.SimulateLaserDir(i, 0.0f);
+		m_laserInput[i] = 0.0f;
+	}
+
+	m_lastStep = step;
+	m_PublishSnapshot(step);
+}
+
+void GameplayThread::m_ForwardButton(Input::Button button, bool pressed)
+{
+	if (button >= Input::Button::Back)
+		return;
+	if (IsRunning())
+		QueueButton(button, pressed, m_eventClock());
+	else
+		m_ApplyButton({ 0, button, pressed });
+}
+
+void GameplayThread::m_ApplyButton(const QueuedInput& input)
+{
+	if (m_replay && input.button < Input::Button::Back)
+		m_replay->AddEvent((uint8)input.button, input.pressed);
+	m_input.SimulateButton(input.button, input.pressed);
+}
+
+void GameplayThread::m_Tick(float deltaTime)
+{
+	// Frames are recorded in the same order a replay is simulated in: button events, playback update and scoring update
+	if (m_replay)
+		m_replay->AddFrame(m_playback.GetLastTime(), deltaTime, m_input.GetInputLaserDir(0), m_input.GetInputLaserDir(1));
+	m_scoring.Tick(deltaTime);
+}
+
+void GameplayThread::m_PublishSnapshot(uint64 step)
+{
+	GameplaySnapshot& snapshot = m_snapshots.GetWriteBuffer();
+	snapshot.step = step;
+	snapshot.time = m_playback.GetLastTime();
+	snapshot.score = m_scoring.CalculateCurrentScore();
+	snapshot.combo = m_scoring.currentComboCounter;
+	snapshot.maxCombo = m_scoring.maxComboCounter;
+	snapshot.comboState = m_scoring.comboState;
+	for (uint32 i = 0; i < 3; i++)
+		snapshot.categorizedHits[i] = m_scoring.categorizedHits[i];
+	Gauge* gauge = m_scoring.GetTopGauge();
+	snapshot.gauge = gauge ? gauge->GetValue() : 0.0f;
+	snapshot.gaugeType = gauge ? gauge->GetType() : GaugeType::Normal;
+	snapshot.gaugeOptions = gauge ? gauge->GetOpts() : 0;
+	snapshot.gaugeName = gauge ? gauge->GetName() : nullptr;
+	for (uint32 i = 0; i < 2; i++)
+	{
+		snapshot.laserPositions[i] = m_scoring.laserPositions[i];
+		snapshot.laserTargetPositions[i] = m_scoring.laserTargetPositions[i];
+		snapshot.lasersAreExtend[i] = m_scoring.lasersAreExtend[i];
+		snapshot.timeSinceLaserUsed[i] = m_scoring.timeSinceLaserUsed[i];
+		snapshot.laserHeld[i] = m_scoring.IsLaserHeld(i);
+		snapshot.laserRollOutput[i] = m_scoring.GetLaserRollOutput(i);
+	}
+	snapshot.laserOutput = m_scoring.GetLaserOutput();
+	snapshot.laserFilterHeld = m_scoring.IsLaserHeld(0, false) || m_scoring.IsLaserHeld(1, false);
+	for (uint32 i = 0; i < 8; i++)
+		snapshot.heldObjects[i] = m_scoring.GetHeldObject(i);
+	snapshot.failed = m_scoring.IsFailOut();
+	m_snapshots.Publish();
+}
+
+bool GameplaySnapshot::IsObjectHeld(ObjectState* object) const
+{
+	if (object->type == ObjectType::Laser)
+		object = *((LaserObjectState*)object)->GetRoot();
+
+	auto isHeld = [this](ObjectState* held)
+	{
+		return std::find(std::begin(heldObjects), std::end(heldObjects), held) != std::end(heldObjects);
+	};
+	if (object->type == ObjectType::Hold)
+	{
+		for (HoldObjectState* root = ((HoldObjectState*)object)->GetRoot(); root != nullptr; root = root->next)
+		{
+			if (isHeld(*root))
+				return true;
+		}
+		return false;
+	}
+	return isHeld(object);
+}
@@ -0,0 +1,73 @@
+#include "stdafx.h"
+#include "HttpClient.hpp"
+
+HttpClient::HttpClient(uint32 numWorkers) : m_sessions(numWorkers), m_pool(numWorkers, "Http worker")
+{
+}
+
+String HttpClient::GetHost(const String& url)
+{
+	size_t start = url.find("://");
+	start = start == String::npos ? 0 : start + 3;
+	size_t end = url.find_first_of("/?#", start);
+	return url.substr(0, end);
+}
+
+RequestId HttpClient::Send(HttpRequest&& request, RequestPriority priority, const void* owner, Callback&& callback)
+{
+	String host = GetHost(request.url);
+	// std::function needs copyable captures
+	auto shared = std::make_shared<std::pair<HttpRequest, Callback>>(std::move(request), std::move(callback));
+	return m_pool.Queue(host, priority, owner, [this, shared](uint32 worker)
+	{
+		cpr::Response response = m_Perform(worker, shared->first);
+		if (!m_pool.IsCancelled(worker))
+			shared->second(std::move(response));
+	});
+}
+
+std::future<cpr::Response> HttpClient::Send(HttpRequest&& request, RequestPriority priority)
+{
+	auto promise = std::make_shared<std::promise<cpr::Response>>();
+	std::future<cpr::Response> future = promise->get_future();
+	Send(std::move(request), priority, nullptr, [promise](cpr::Response&& response)
+	{
+		promise->set_value(std::move(response));
+	});
+	return future;
+}
+
+bool HttpClient::Cancel(RequestId id)
+{
+	return m_pool.Cancel(id);
+}
+
+void HttpClient::CancelOwner(const void* owner)
+{
+	m_pool.CancelOwner(owner);
+}
+
+cpr::Response HttpClient::m_Perform(uint32 worker, HttpRequest& request)
+{
+	// Multipart uploads are rare, they get their own connection so the form options don't stick to a shared session
+	if (request.multipart)
+		return cpr::Post(cpr::Url{ request.url }, request.header, request.parameters, *request.multipart);
+
+	Ref<cpr::Session>& session = m_sessions[worker][GetHost(request.url)];
+	if (!session)
+	{
+		session = Ref<cpr::Session>(new cpr::Session());
+		m_numSessions++;
+	}
+
+	// Every option a request can set is set again so nothing carries over from the previous request
+	session->SetUrl(cpr::Url{ request.url });
+	session->SetParameters(request.parameters);
+	session->SetHeader(request.header);
+	if (request.method == HttpRequest::Method::Post)
+	{
+		session->SetBody(cpr::Body{ request.body });
+		return session->Post();
+	}
+	return session->Get();
+}
@@ -47,8 +47,16 @@ static cpr::Header CommonHeader()
     };
 }
 
+static HttpRequest MakeRequest(const String& url, cpr::Header&& header)
+{
+    HttpRequest request;
+    request.url = url;
+    request.header = std::move(header);
+    return request;
+}
+
 namespace IR {
-    cpr::AsyncResponse PostScore(const ScoreIndex& score, const BeatmapSettings& map)
+    HttpRequest PostScore(const ScoreIndex& score, const BeatmapSettings& map)
     {
         String host = g_gameConfig.GetString(GameConfigKeys::IRBaseURL) + "/scores";
 
@@ -56,53 +64,52 @@ namespace IR {
 
         PopulateScoreJSON(json, score, map);
 
-        return cpr::PostAsync(cpr::Url{host},
-                              CommonHeader(),
-                              cpr::Body{json.dump()});
+        HttpRequest request = MakeRequest(host, CommonHeader());
+        request.method = HttpRequest::Method::Post;
+        request.body = json.dump();
+        return request;
     }
 
-    cpr::AsyncResponse Heartbeat()
+    HttpRequest Heartbeat()
     {
         String host = g_gameConfig.GetString(GameConfigKeys::IRBaseURL);
 
-        return cpr::GetAsync(cpr::Url{host},
-                             CommonHeader());
+        return MakeRequest(host, CommonHeader());
     }
 
-    cpr::AsyncResponse ChartTracked(String chartHash)
+    HttpRequest ChartTracked(String chartHash)
     {
         String host = g_gameConfig.GetString(GameConfigKeys::IRBaseURL) + "/charts/" + chartHash;
 
-        return cpr::GetAsync(cpr::Url{host},
-                             CommonHeader());
+        return MakeRequest(host, CommonHeader());
     }
 
-    cpr::AsyncResponse Record(String chartHash)
+    HttpRequest Record(String chartHash)
     {
         String host = g_gameConfig.GetString(GameConfigKeys::IRBaseURL) + "/charts/" + chartHash + "/record";
 
-        return cpr::GetAsync(cpr::Url{host},
-                             CommonHeader());
+        return MakeRequest(host, CommonHeader());
     }
 
-    cpr::AsyncResponse Leaderboard(String chartHash, String mode, int n)
+    HttpRequest Leaderboard(String chartHash, String mode, int n)
     {
         String host = g_gameConfig.GetString(GameConfigKeys::IRBaseURL) + "/charts/" + chartHash + "/leaderboard";
 
-        return cpr::GetAsync(cpr::Url{host},
-                             cpr::Header{{"Authorization", "Bearer " + g_gameConfig.GetString(GameConfigKeys::IRToken)}}, //can't give the json header here so whatever
-                             cpr::Parameters{{"mode", mode},
-                                             {"n", std::to_string(n)}});
+        HttpRequest request = MakeRequest(host, cpr::Header{{"Authorization", "Bearer " + g_gameConfig.GetString(GameConfigKeys::IRToken)}}); //can't give the json header here so whatever
+        request.parameters = cpr::Parameters{{"mode", mode},
+                                             {"n", std::to_string(n)}};
+        return request;
     }
 
-    cpr::AsyncResponse PostReplay(String identifier, String replayPath)
+    HttpRequest PostReplay(String identifier, String replayPath)
     {
         String host = g_gameConfig.GetString(GameConfigKeys::IRBaseURL) + "/replays";
 
-        return cpr::PostAsync(cpr::Url{host},
-                              cpr::Header{{"Authorization", "Bearer " + g_gameConfig.GetString(GameConfigKeys::IRToken)}}, //can't give the json header here so whatever
-                              cpr::Multipart{{"identifier", identifier},
-                                             {"replay", cpr::File{replayPath}}});
+        HttpRequest request = MakeRequest(host, cpr::Header{{"Authorization", "Bearer " + g_gameConfig.GetString(GameConfigKeys::IRToken)}}); //can't give the json header here so whatever
+        request.method = HttpRequest::Method::Post;
+        request.multipart = Ref<cpr::Multipart>(new cpr::Multipart{{"identifier", identifier},
+                                                                    {"replay", cpr::File{replayPath}}});
+        return request;
     }
 
     bool ValidateReturn(const nlohmann::json& json)
@@ -83,6 +83,26 @@ void Input::Init(Graphics::Window& wnd)
 	// Init keyboard mapping
 	m_InitKeyboardMapping();
 }
+void Input::InitHeadless()
+{
+	Cleanup();
+	m_laserDevice = InputDevice::Keyboard;
+	m_buttonDevice = InputDevice::Keyboard;
+	m_keySensitivity = 0.0f;
+	m_keyLaserReleaseTime = 0.0f;
+	m_backComboHold = false;
+	m_backComboInstant = false;
+	memset(m_buttonStates, 0, sizeof(m_buttonStates));
+	for(uint32 i = 0; i < 2; i++)
+	{
+		m_laserStates[i] = 0.0f;
+		m_rawLaserStates[i] = 0.0f;
+		m_rawKeyLaserStates[i] = 0.0f;
+		m_prevLaserStates[i] = 0.0f;
+		m_absoluteLaserStates[i] = 0.0f;
+		m_laserDirections[i] = 1.0f;
+	}
+}
 void Input::Cleanup()
 {
 	if(m_gamepad)
@@ -270,6 +290,15 @@ float Input::GetInputLaserDir(uint32 laserIdx)
 {
 	return m_laserStates[laserIdx];
 }
+void Input::SimulateButton(Button button, bool pressed)
+{
+	m_OnButtonInput(button, pressed);
+}
+void Input::SimulateLaserDir(uint32 laserIdx, float dir)
+{
+	m_laserStates[laserIdx] = dir;
+	m_rawLaserStates[laserIdx] = dir;
+}
 float Input::GetAbsoluteInputLaserDir(uint32 laserIdx)
 {
 	return m_rawLaserStates[laserIdx];
@@ -8,6 +8,54 @@
 using Shared::Rect;
 using Shared::Rect3D;
 
+void ViewDistanceCurve::Build(BeatmapPlayback& playback)
+{
+	Clear();
+
+	// The scroll speed only changes at timing points and the start and end of stops
+	const Beatmap& beatmap = playback.GetBeatmap();
+	for (const TimingPoint* tp : beatmap.GetLinearTimingPoints())
+		m_times.Add(tp->time);
+	for (const ChartStop* cs : beatmap.GetLinearChartStops())
+	{
+		m_times.Add(cs->time);
+		m_times.Add(cs->time + cs->duration);
+	}
+	// Cover all objects with some margin
+	MapTime firstTime = 0, lastTime = 0;
+	for (const ObjectState* obj : beatmap.GetLinearObjects())
+	{
+		firstTime = Math::Min(firstTime, obj->time);
+		lastTime = Math::Max(lastTime, obj->time + (obj->type == ObjectType::Laser ? ((LaserObjectState*)obj)->duration : 0));
+	}
+	m_times.Add(firstTime - 10000);
+	m_times.Add(lastTime + 10000);
+
+	std::sort(m_times.begin(), m_times.end());
+	m_times.erase(std::unique(m_times.begin(), m_times.end()), m_times.end());
+
+	m_distances.resize(m_times.size());
+	m_distances[0] = 0.0;
+	for (size_t i = 1; i < m_times.size(); i++)
+		m_distances[i] = m_distances[i - 1] + playback.DurationToViewDistanceAtTime(m_times[i - 1], m_times[i] - m_times[i - 1]);
+}
+
+void ViewDistanceCurve::Clear()
+{
+	m_times.clear();
+	m_distances.clear();
+}
+
+double ViewDistanceCurve::Evaluate(MapTime time) const
+{
+	assert(m_times.size() >= 2);
+	// Times outside of the curve extend the first or last piece
+	size_t i = std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin();
+	i = Math::Clamp<size_t>(i, 1, m_times.size() - 1);
+	const double t = (double)(time - m_times[i - 1]) / (double)(m_times[i] - m_times[i - 1]);
+	return m_distances[i - 1] + (m_distances[i] - m_distances[i - 1]) * t;
+}
+
 
 LaserTrackBuilder::LaserTrackBuilder(class OpenGL* gl, class Track* track, uint32 laserIndex)
 {
@@ -27,6 +75,57 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 
 	Mesh newMesh = MeshRes::Create(m_gl);
 
+	Vector<MeshGenerators::SimpleVertex> verts;
+	m_GenerateTrackVertices(playback, laser, laserLengthScale, verts);
+	newMesh->SetData(verts);
+	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
+
+	// Cache this mesh
+	m_objectCache.Add(laser, newMesh);
+	return newMesh;
+}
+
+Mesh LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser)
+{
+	assert(laser->prev == nullptr);
+	if(m_cachedEntries.Contains(laser))
+		return m_cachedEntries[laser];
+
+	Mesh newMesh = MeshRes::Create(m_gl);
+
+	Vector<MeshGenerators::SimpleVertex> verts;
+	m_GenerateEntryVertices(laser, verts);
+	newMesh->SetData(verts);
+	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
+
+	// Cache this mesh
+	m_cachedEntries.Add(laser, newMesh);
+	return newMesh;
+
+}
+Mesh LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser)
+{
+	assert(laser->next == nullptr);
+	if(m_cachedExits.Contains(laser))
+		return m_cachedExits[laser];
+
+	Mesh newMesh = MeshRes::Create(m_gl);
+
+	// Length of this segment
+	float prevLength = m_GetSegmentLength(playback, laser) * laserLengthScale;
+
+	Vector<MeshGenerators::SimpleVertex> verts;
+	m_GenerateExitVertices(laser, prevLength, verts);
+	newMesh->SetData(verts);
+	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
+
+	// Cache this mesh
+	m_cachedExits.Add(laser, newMesh);
+	return newMesh;
+}
+
+void LaserTrackBuilder::m_GenerateTrackVertices(class BeatmapPlayback& playback, LaserObjectState* laser, float lengthScale, Vector<MeshGenerators::SimpleVertex>& verts)
+{
 	float length = playback.DurationToViewDistanceAtTime(laser->time, laser->duration);
 
 	if((laser->flags & LaserObjectState::flag_Instant) != 0) // Slam segment
@@ -61,11 +160,11 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 		}// else ------>
 
 		// Generate positions for middle top and bottom
-		float slamLength = playback.DurationToViewDistanceAtTime(laser->time, slamDuration) * laserLengthScale;
+		float slamLength = playback.DurationToViewDistanceAtTime(laser->time, slamDuration) * lengthScale;
 		float halfLength = slamLength * 0.5;
 		Rect3D centerMiddle = Rect3D(left, slamLength + halfLength, right, -halfLength);
 
-		Vector<MeshGenerators::SimpleVertex> verts =
+		verts =
 		{
 			{ { centerMiddle.Left() + offsetB, centerMiddle.Bottom(),  0.0f },{ uvB, 0.0f } }, // BL
 			{ { centerMiddle.Right() + offsetB, centerMiddle.Bottom(),  0.0f },{ uvB, 1.0f } }, // BR
@@ -131,9 +230,6 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 			for (auto& v : rightVerts)
 				verts.Add(v);
 		}
-
-		newMesh->SetData(verts);
-		newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
 	}
 	else
 	{
@@ -141,18 +237,18 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 		if(laser->prev && (laser->prev->flags & LaserObjectState::flag_Instant) != 0)
 		{
 			// Previous slam length
-			prevLength = playback.DurationToViewDistanceAtTime(laser->prev->time, slamDuration) * laserLengthScale;
+			prevLength = playback.DurationToViewDistanceAtTime(laser->prev->time, slamDuration) * lengthScale;
 		}
 
 		Vector2 points[2];
 
 		// Connecting center points
 		points[0] = Vector2(laser->points[0] * effectiveWidth - effectiveWidth * 0.5f, prevLength); // Bottom
-		points[1] = Vector2(laser->points[1] * effectiveWidth - effectiveWidth * 0.5f, length * laserLengthScale); // Top
+		points[1] = Vector2(laser->points[1] * effectiveWidth - effectiveWidth * 0.5f, length * lengthScale); // Top
 		if ((laser->flags & LaserObjectState::flag_Extended) != 0)
 		{
 			points[0] = Vector2((laser->points[0] * 2.0f - 0.5f) * effectiveWidth - effectiveWidth * 0.5f, prevLength); // Bottom
-			points[1] = Vector2((laser->points[1] * 2.0f - 0.5f) * effectiveWidth - effectiveWidth * 0.5f, length * laserLengthScale); // Top
+			points[1] = Vector2((laser->points[1] * 2.0f - 0.5f) * effectiveWidth - effectiveWidth * 0.5f, length * lengthScale); // Top
 		}
 
 		float uMin = -0.5f;
@@ -161,7 +257,7 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 		float vMin = 0.0f;
 		float vMax = (int)((length * laserLengthScale) / actualLaserHeight);
 
-		Vector<MeshGenerators::SimpleVertex> verts =
+		verts =
 		{
 			{ { points[0].x - actualLaserWidth, points[0].y,  0.0f },{ uMin, vMax } }, // BL
 			{ { points[0].x + actualLaserWidth, points[0].y,  0.0f },{ uMax, vMax } }, // BR
@@ -171,56 +267,26 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 			{ { points[1].x + actualLaserWidth, points[1].y,  0.0f },{ uMax, vMin } }, // TR
 			{ { points[1].x - actualLaserWidth, points[1].y,  0.0f },{ uMin, vMin } }, // TL
 		};
-
-
-		newMesh->SetData(verts);
-		newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
 	}
-
-	// Cache this mesh
-	m_objectCache.Add(laser, newMesh);
-	return newMesh;
 }
 
-Mesh LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser)
+void LaserTrackBuilder::m_GenerateEntryVertices(LaserObjectState* laser, Vector<MeshGenerators::SimpleVertex>& verts)
 {
-	assert(laser->prev == nullptr);
-	if(m_cachedEntries.Contains(laser))
-		return m_cachedEntries[laser];
-
-	Mesh newMesh = MeshRes::Create(m_gl);
-
 	// Starting point of laser
 	float startingX = laser->points[0] * effectiveWidth - effectiveWidth * 0.5f;
 	if ((laser->flags & LaserObjectState::flag_Extended) != 0)
 		startingX = (laser->points[0] * 2.0f - 0.5f) * effectiveWidth - effectiveWidth * 0.5f;
 
-
-
 	// Length of the tail
 	float length = (float)laserEntryTextureSize.y / (float)laserEntryTextureSize.x * actualLaserWidth;
 
-	Vector<MeshGenerators::SimpleVertex> verts;
 	Rect3D pos = Rect3D(Vector2(startingX - actualLaserWidth, -length), Vector2(actualLaserWidth * 2, length));
 	Rect uv = Rect(-0.5f, 0.0f, 1.5f, 1.0f);
 	MeshGenerators::GenerateSimpleXYQuad(pos, uv, verts);
-
-	newMesh->SetData(verts);
-	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
-
-	// Cache this mesh
-	m_cachedEntries.Add(laser, newMesh);
-	return newMesh;
-
 }
-Mesh LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser)
-{
-	assert(laser->next == nullptr);
-	if(m_cachedExits.Contains(laser))
-		return m_cachedExits[laser];
-
-	Mesh newMesh = MeshRes::Create(m_gl);
 
+void LaserTrackBuilder::m_GenerateExitVertices(LaserObjectState* laser, float offset, Vector<MeshGenerators::SimpleVertex>& verts)
+{
 	// Ending point of laser 
 	float startingX = laser->points[1] * effectiveWidth - effectiveWidth * 0.5f;
 	if ((laser->flags & LaserObjectState::flag_Extended) != 0)
@@ -229,28 +295,102 @@ Mesh LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, Laser
 	// Length of the tail
 	float length = (float)laserExitTextureSize.y / (float)laserExitTextureSize.x * actualLaserWidth;
 
-	// Length of this segment
-	float prevLength = 0.0f;
+	Rect3D pos = Rect3D(Vector2(startingX - actualLaserWidth, offset), Vector2(actualLaserWidth * 2, length));
+	Rect uv = Rect(-0.5f, 0.0f, 1.5f, 1.0f);
+	MeshGenerators::GenerateSimpleXYQuad(pos, uv, verts);
+}
+
+float LaserTrackBuilder::m_GetSegmentLength(class BeatmapPlayback& playback, LaserObjectState* laser)
+{
 	if((laser->flags & LaserObjectState::flag_Instant) != 0)
+		return playback.DurationToViewDistanceAtTime(laser->time, slamDuration);
+	return playback.DurationToViewDistanceAtTime(laser->time, laser->duration);
+}
+
+void LaserTrackBuilder::Bake(class BeatmapPlayback& playback, const ViewDistanceCurve& viewDistance)
+{
+	ClearBaked();
+
+	Vector<MeshGenerators::SimpleVertex> chunkVerts;
+	Vector<BakedLaser*> chunkLasers;
+	Vector<MeshGenerators::SimpleVertex> verts;
+	MapTime chunkEnd = 0;
+
+	auto FlushChunk = [&]()
 	{
-		prevLength = playback.DurationToViewDistanceAtTime(laser->time, slamDuration) * laserLengthScale;
-	}
-	else
+		if (chunkVerts.empty())
+			return;
+		Mesh chunk = MeshRes::Create(m_gl);
+		chunk->SetStatic(true);
+		chunk->SetData(chunkVerts);
+		chunk->SetPrimitiveType(PrimitiveType::TriangleList);
+		for (BakedLaser* baked : chunkLasers)
+		{
+			baked->body.mesh = chunk;
+			if (baked->entry.vertexCount > 0)
+				baked->entry.mesh = chunk;
+			if (baked->exit.vertexCount > 0)
+				baked->exit.mesh = chunk;
+		}
+		m_bakedChunks.Add(chunk);
+		chunkVerts.clear();
+		chunkLasers.clear();
+	};
+	auto AddVertices = [&](BakedMesh& baked, double distance)
 	{
-		prevLength = playback.DurationToViewDistanceAtTime(laser->time, laser->duration) * laserLengthScale;
-	}
+		baked.firstVertex = (uint32)chunkVerts.size();
+		baked.vertexCount = (uint32)verts.size();
+		baked.viewDistance = distance;
+		chunkVerts.insert(chunkVerts.end(), verts.begin(), verts.end());
+		verts.clear();
+	};
+
+	for (ObjectState* obj : playback.GetBeatmap().GetLinearObjects())
+	{
+		if (obj->type != ObjectType::Laser)
+			continue;
+		LaserObjectState* laser = (LaserObjectState*)obj;
+		if (laser->index != m_laserIndex)
+			continue;
 
-	Vector<MeshGenerators::SimpleVertex> verts;
-	Rect3D pos = Rect3D(Vector2(startingX - actualLaserWidth, prevLength), Vector2(actualLaserWidth * 2, length));
-	Rect uv = Rect(-0.5f, 0.0f, 1.5f, 1.0f);
-	MeshGenerators::GenerateSimpleXYQuad(pos, uv, verts);
+		if (laser->time >= chunkEnd)
+		{
+			FlushChunk();
+			chunkEnd = laser->time + bakedChunkDuration;
+		}
 
-	newMesh->SetData(verts);
-	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
+		BakedLaser& baked = m_bakedLasers[laser];
+		chunkLasers.Add(&baked);
+		const double start = viewDistance.Evaluate(laser->time);
 
-	// Cache this mesh
-	m_cachedExits.Add(laser, newMesh);
-	return newMesh;
+		// The body is scaled by laserLengthScale when drawn, tails keep their size
+		m_GenerateTrackVertices(playback, laser, 1.0f, verts);
+		AddVertices(baked.body, start);
+		if (!laser->prev)
+		{
+			m_GenerateEntryVertices(laser, verts);
+			AddVertices(baked.entry, start);
+		}
+		// Exits are only drawn on slams
+		if (!laser->next && (laser->flags & LaserObjectState::flag_Instant) != 0)
+		{
+			m_GenerateExitVertices(laser, 0.0f, verts);
+			AddVertices(baked.exit, start + m_GetSegmentLength(playback, laser));
+		}
+	}
+	FlushChunk();
+}
+
+void LaserTrackBuilder::ClearBaked()
+{
+	m_bakedChunks.clear();
+	m_bakedLasers.clear();
+}
+
+const LaserTrackBuilder::BakedLaser* LaserTrackBuilder::GetBaked(const LaserObjectState* laser) const
+{
+	auto it = m_bakedLasers.find(laser);
+	return it == m_bakedLasers.end() ? nullptr : &it->second;
 }
 
 float LaserTrackBuilder::GetLaserLengthScaleAt(MapTime time)
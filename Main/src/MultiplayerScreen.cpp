@@ -175,6 +175,7 @@ void MultiplayerScreen::m_authenticate()
 	packet["password"] = password;
 	packet["name"] = m_userName;
 	packet["version"] = MULTIPLAYER_VERSION;
+	packet["binary"] = MultiplayerProtocol::BinaryVersion;
 	m_tcp.SendJSON(packet);
 }
 
@@ -282,6 +283,10 @@ bool MultiplayerScreen::m_handleAuthResponse(nlohmann::json& packet)
 	g_application->DiscordPresenceMenu("Browsing multiplayer rooms");
 	packet["userid"].get_to(m_userId);
 	m_scoreInterval = packet.value("refresh_rate",1000);
+	// Servers that don't know the binary protocol don't send a version
+	m_binaryProtocol = packet.value("binary", 0u) == MultiplayerProtocol::BinaryVersion;
+	if (m_binaryProtocol)
+		Log("[Multiplayer] Using binary score updates", Logger::Severity::Info);
 
 	// If we are waiting to join a room, join now
 	if (m_joinToken != "")
@@ -365,6 +370,8 @@ bool MultiplayerScreen::m_handleStartPacket(nlohmann::json& packet)
 	m_failed = false;
 	m_syncState = SyncState::LOADING;
 	m_finalStats.clear();
+	m_finalStatKeys.clear();
+	m_scoreboard.users.clear();
 
 	// Grab the map from the database
 	FolderIndex* folder = m_mapDatabase->GetFolder(m_selectedMapId);
@@ -592,15 +599,15 @@ void  MultiplayerScreen::GetMapBPMForSpeed(String path, struct MultiplayerBPMInf
 
 	// Load map
 	Beatmap* newMap = new Beatmap();
-	File mapFile;
-	if (!mapFile.OpenRead(path))
+	Buffer mapData;
+	if (!File::ReadAll(path, mapData))
 	{
 		Logf("Could not read path for beatmap: %s", Logger::Severity::Error, path);
 		delete newMap;
 		info = { 0, 0, 0, 0 };
 		return;
 	}
-	FileReader reader(mapFile);
+	MappedReader reader(mapData);
 	if (!newMap->Load(reader))
 	{
 		delete newMap;
@@ -982,6 +989,16 @@ void MultiplayerScreen::PerformScoreTick(Scoring& scoring, MapTime time)
 
 	uint32 score = scoring.CalculateCurrentScore();
 
+	if (m_binaryProtocol)
+	{
+		MultiplayerProtocol::ScoreUpdate update;
+		update.time = Math::Max(0, scoreUpdateIndex) * m_scoreInterval;
+		update.score = score;
+		MultiplayerProtocol::Encode(update, m_binaryPacket);
+		m_tcp.SendBinary(m_binaryPacket);
+		return;
+	}
+
 	nlohmann::json packet;
 	packet["topic"] = "room.score.update";
 	packet["time"] = Math::Max(0, scoreUpdateIndex) * m_scoreInterval;
@@ -990,16 +1007,69 @@ void MultiplayerScreen::PerformScoreTick(Scoring& scoring, MapTime time)
 	m_tcp.SendJSON(packet);
 }
 
-void MultiplayerScreen::m_addFinalStat(nlohmann::json& data)
+bool MultiplayerScreen::m_handleScoreboard(nlohmann::json& packet)
+{
+	// Keep a typed copy, the packet itself is still passed on to lua
+	auto users = packet.find("users");
+	if (users == packet.end() || !users->is_array())
+		return true;
+
+	m_scoreboard.users.resize(users->size());
+	for (size_t i = 0; i < users->size(); i++)
+	{
+		const nlohmann::json& user = (*users)[i];
+		MultiplayerProtocol::ScoreboardUser& entry = m_scoreboard.users[i];
+		entry.id = user.value("id", "");
+		entry.name = user.value("name", "");
+		entry.score = user.value("score", 0u);
+	}
+	return true;
+}
+
+bool MultiplayerScreen::m_handleBinaryScoreboard(const String& packet)
 {
-	m_finalStats.push_back(data);
-	// Sort all scores
-	sort(m_finalStats.begin(), m_finalStats.end(),
-		[](const nlohmann::json& a, const nlohmann::json& b) -> bool
+	if (!MultiplayerProtocol::Decode(packet, m_scoreboard))
+	{
+		Log("[Multiplayer] Received an invalid scoreboard", Logger::Severity::Warning);
+		return false;
+	}
+
+	// Skins receive the same table as for the JSON packet
+	m_tcp.CallLuaTopicHandler("game.scoreboard", [&](lua_State* L)
+	{
+		lua_newtable(L);
+		lua_pushstring(L, "topic");
+		lua_pushstring(L, "game.scoreboard");
+		lua_settable(L, -3);
+		lua_pushstring(L, "users");
+		lua_createtable(L, (int)m_scoreboard.users.size(), 0);
+		for (size_t i = 0; i < m_scoreboard.users.size(); i++)
 		{
-			return (a["score"].get<int>() + (a["clear"].get<int>() > 1 ? 10000000 : 0)) >
-				(b["score"].get<int>() +( b["clear"].get<int>() > 1 ? 10000000 : 0));
-		});
+			const MultiplayerProtocol::ScoreboardUser& user = m_scoreboard.users[i];
+			lua_createtable(L, 0, 3);
+			lua_pushstring(L, "id");
+			lua_pushstring(L, *user.id);
+			lua_settable(L, -3);
+			lua_pushstring(L, "name");
+			lua_pushstring(L, *user.name);
+			lua_settable(L, -3);
+			lua_pushstring(L, "score");
+			lua_pushinteger(L, user.score);
+			lua_settable(L, -3);
+			lua_rawseti(L, -2, (lua_Integer)i + 1);
+		}
+		lua_settable(L, -3);
+	});
+	return true;
+}
+
+void MultiplayerScreen::m_addFinalStat(nlohmann::json& data)
+{
+	// Clears rank above everything else, the key is only computed once per entry
+	const int key = data.value("score", 0) + (data.value("clear", 0) > 1 ? 10000000 : 0);
+	const size_t index = std::upper_bound(m_finalStatKeys.begin(), m_finalStatKeys.end(), key, std::greater<int>()) - m_finalStatKeys.begin();
+	m_finalStatKeys.insert(m_finalStatKeys.begin() + index, key);
+	m_finalStats.insert(m_finalStats.begin() + index, data);
 }
 
 void MultiplayerScreen::SendFinalScore(class Game* game, ClearMark clearState)
@@ -1351,6 +1421,8 @@ bool MultiplayerScreen::AsyncLoad()
 	m_tcp.SetTopicHandler("server.error", this, &MultiplayerScreen::m_handleError);
 	m_tcp.SetTopicHandler("server.room.badpassword", this, &MultiplayerScreen::m_handleBadPassword);
 	m_tcp.SetTopicHandler("game.finalstats", this, &MultiplayerScreen::m_handleFinalStats);
+	m_tcp.SetTopicHandler("game.scoreboard", this, &MultiplayerScreen::m_handleScoreboard);
+	m_tcp.SetBinaryHandler(MultiplayerProtocol::BinaryTopic::Scoreboard, this, &MultiplayerScreen::m_handleBinaryScoreboard);
 
 	m_tcp.SetCloseHandler(this, &MultiplayerScreen::m_handleSocketClose);
 
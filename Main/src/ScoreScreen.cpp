@@ -47,7 +47,7 @@ private:
 	//promote this to higher scope so i can use it in tick
 	String m_replayPath;
 
-	cpr::AsyncResponse m_irResponse;
+	std::future<cpr::Response> m_irResponse;
 	nlohmann::json m_irResponseJson;
 
 	HitWindow m_hitWindow = HitWindow::NORMAL;
@@ -218,21 +218,12 @@ private:
 		// If chart file can't be opened, use existing hash.
 		String hash = chart->hash;
 
-		File chartFile;
-		if (chartFile.OpenRead(chart->path))
+		Buffer chartData;
+		if (File::ReadAll(chart->path, chartData))
 		{
-			char data_buffer[0x80];
 			uint32_t digest[5];
 			sha1::SHA1 s;
-
-			size_t amount_read = 0;
-			size_t read_size;
-			do
-			{
-				read_size = chartFile.Read(data_buffer, sizeof(data_buffer));
-				amount_read += read_size;
-				s.processBytes(data_buffer, read_size);
-			} while (read_size != 0);
+			s.processBytes(chartData.data(), chartData.size());
 
 			s.getDigest(digest);
 			hash = Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
@@ -259,6 +250,19 @@ private:
 			fw.Serialize(&m_hitWindow.slam, 4);
 		}
 
+		// Input replay next to the hit stat replay, can be used to re-simulate the play
+		InputReplay inputReplay = game->GetInputReplay();
+		inputReplay.score = m_score;
+		inputReplay.perfects = m_categorizedHits[2];
+		inputReplay.goods = m_categorizedHits[1];
+		inputReplay.misses = m_categorizedHits[0];
+		File inputReplayFile;
+		if (inputReplayFile.OpenWrite(Path::ReplaceExtension(m_replayPath, "uir")))
+		{
+			FileWriter fw(inputReplayFile);
+			inputReplay.Save(fw);
+		}
+
 		newScore->score = m_score;
 		newScore->crit = m_categorizedHits[2];
 		newScore->almost = m_categorizedHits[1];
@@ -288,7 +292,7 @@ private:
 		if (g_gameConfig.GetString(GameConfigKeys::IRBaseURL) != "")
 		{
 			m_irState = IR::ResponseState::Pending;
-			m_irResponse = IR::PostScore(*newScore, m_beatmapSettings);
+			m_irResponse = g_httpClient->Send(IR::PostScore(*newScore, m_beatmapSettings), RequestPriority::High);
 		}
 
 		const bool cleared = Scoring::CalculateBadge(*newScore) >= ClearMark::NormalClear;
@@ -983,7 +987,7 @@ public:
 									if(m_irResponseJson["body"].find("sendReplay") != m_irResponseJson["body"].end() && m_irResponseJson["body"]["sendReplay"].is_string())
 									{
 										//don't really care about the return of this, if it fails it's not the end of the world
-										IR::PostReplay(m_irResponseJson["body"]["sendReplay"].get<String>(), m_replayPath).get();
+										g_httpClient->Send(IR::PostReplay(m_irResponseJson["body"]["sendReplay"].get<String>(), m_replayPath), RequestPriority::Low);
 									}
 								}			
 							}
@@ -7,12 +7,10 @@
 
 Scoring::Scoring()
 {
-    g_application->autoplayInfo = &autoplayInfo;
 }
 
 Scoring::~Scoring()
 {
-    g_application->autoplayInfo = nullptr;
 	m_CleanupInput();
 	m_CleanupHitStats();
 	m_CleanupTicks();
@@ -123,8 +121,6 @@ void Scoring::Reset(const MapTimeRange& range)
 
 	memset(categorizedHits, 0, sizeof(categorizedHits));
 	memset(timedHits, 0, sizeof(timedHits));
-	// Clear hit statistics
-	hitStats.clear();
 
 	// Get input offset
 	m_inputOffset = g_gameConfig.GetInt(GameConfigKeys::InputOffset);
@@ -173,10 +169,22 @@ void Scoring::Reset(const MapTimeRange& range)
 	m_CleanupHitStats();
 	m_CleanupTicks();
 
+	// Prepare storage so no allocations are needed during the game
+	m_CalculateLongObjectTicks();
+	hitStats.reserve(mapTotals.numSingles + mapTotals.numTicks + m_longObjects.size());
+	m_hitStatArena.Reserve(hitStats.capacity());
+
 	OnScoreChanged.Call();
 	OnComboChanged.Call(0);
 }
 
+void Scoring::SetInputOffsets(int32 inputOffset, int32 laserOffset, int32 bounceGuard)
+{
+	m_inputOffset = inputOffset;
+	m_laserOffset = laserOffset;
+	m_bounceGuard = bounceGuard;
+}
+
 void Scoring::FinishGame()
 {
 	m_CleanupInput();
@@ -197,12 +205,12 @@ void Scoring::Tick(float deltaTime)
     {
         if (!m_ticks[i].empty())
         {
-            auto tick = m_ticks[i].front();
-            if (tick->HasFlag(TickFlags::Hold))
+            const ScoreTick& tick = m_ticks[i].front();
+            if (tick.HasFlag(TickFlags::Hold))
             {
-                bool autoplayHold = autoplayInfo.IsAutoplayButtons() && tick->object->time <= m_playback->GetLastTime();
+                bool autoplayHold = autoplayInfo.IsAutoplayButtons() && tick.object->time <= m_playback->GetLastTime();
                 if (autoplayHold)
-                    m_SetHoldObject(tick->object, i);
+                    m_SetHoldObject(tick.object, i);
                 // This check is only relevant if delay fade hit effects are on
                 if (autoplayHold || (HoldObjectAvailable(i, true) && m_input->GetButton((Input::Button)i)))
                     OnHoldEnter.Call(static_cast<Input::Button>(i));
@@ -336,45 +344,25 @@ HitStat* Scoring::m_AddOrUpdateHitStat(ObjectState* object)
 {
 	if (object->type == ObjectType::Single)
 	{
-		HitStat* stat = new HitStat(object);
+		HitStat* stat = m_hitStatArena.New(object);
 		hitStats.Add(stat);
 		return stat;
 	}
-	else if (object->type == ObjectType::Hold)
-	{
-		HoldObjectState* hold = (HoldObjectState*)object;
-		HitStat** foundStat = m_holdHitStats.Find(object);
-		if (foundStat)
-			return *foundStat;
-		HitStat* stat = new HitStat(object);
-		hitStats.Add(stat);
-		m_holdHitStats.Add(object, stat);
-
-		// Get tick count
-		Vector<MapTime> ticks;
-		m_CalculateHoldTicks(hold, ticks);
-		stat->holdMax = (uint32)ticks.size();
-		stat->forReplay = false;
-
-		return stat;
-	}
-	else if (object->type == ObjectType::Laser)
+	else if (object->type == ObjectType::Hold || object->type == ObjectType::Laser)
 	{
-		LaserObjectState* rootLaser = ((LaserObjectState*)object)->GetRoot();
-		HitStat** foundStat = m_holdHitStats.Find(*rootLaser);
-		if (foundStat)
-			return *foundStat;
-		HitStat* stat = new HitStat(*rootLaser);
-		hitStats.Add(stat);
-		m_holdHitStats.Add(object, stat);
-
-		// Get tick count
-		Vector<ScoreTick> ticks;
-		m_CalculateLaserTicks(rootLaser, ticks);
-		stat->holdMax = (uint32)ticks.size();
-		stat->forReplay = false;
+		// Lasers share a single hit stat per chain
+		if (object->type == ObjectType::Laser)
+			object = *((LaserObjectState*)object)->GetRoot();
 
-		return stat;
+		LongObjectInfo& info = m_longObjects[object];
+		if (!info.stat)
+		{
+			info.stat = m_hitStatArena.New(object);
+			info.stat->holdMax = info.numTicks;
+			info.stat->forReplay = false;
+			hitStats.Add(info.stat);
+		}
+		return info.stat;
 	}
 
 	// Shouldn't get here
@@ -382,12 +370,51 @@ HitStat* Scoring::m_AddOrUpdateHitStat(ObjectState* object)
 	return nullptr;
 }
 
+void Scoring::m_AddTickHitStat(const ScoreTick* tick, ScoreHitRating rating)
+{
+	HitStat* stat = m_hitStatArena.New(tick->object);
+	stat->time = m_playback->GetLastTime();
+	stat->rating = rating;
+	hitStats.Add(stat);
+}
+
 void Scoring::m_CleanupHitStats()
 {
-	for (HitStat* hit : hitStats)
-		delete hit;
 	hitStats.clear();
-	m_holdHitStats.clear();
+	m_hitStatArena.Clear();
+	for (auto& info : m_longObjects)
+		info.second.stat = nullptr;
+}
+
+void Scoring::m_CalculateLongObjectTicks()
+{
+	m_longObjects.clear();
+	// Upper bound of the ticks queued on each lane, the same ticks m_OnObjectEntered adds
+	size_t laneTicks[8] = { 0 };
+	for (auto& _obj : m_playback->GetBeatmap().GetLinearObjects())
+	{
+		MultiObjectState* obj = *_obj;
+		if (obj->type == ObjectType::Single)
+		{
+			laneTicks[obj->button.index]++;
+		}
+		else if (obj->type == ObjectType::Hold)
+		{
+			m_holdTickBuffer.clear();
+			m_CalculateHoldTicks((HoldObjectState*)obj, m_holdTickBuffer);
+			m_longObjects[*obj].numTicks = (uint32)m_holdTickBuffer.size();
+			laneTicks[obj->hold.index] += m_holdTickBuffer.size() + 1;
+		}
+		else if (obj->type == ObjectType::Laser && obj->laser.prev == nullptr)
+		{
+			m_laserTickBuffer.clear();
+			m_CalculateLaserTicks((LaserObjectState*)obj, m_laserTickBuffer);
+			m_longObjects[*obj].numTicks = (uint32)m_laserTickBuffer.size();
+			laneTicks[obj->laser.index + 6] += m_laserTickBuffer.size();
+		}
+	}
+	for (size_t i = 0; i < 8; i++)
+		m_ticks[i].Reserve(laneTicks[i]);
 }
 
 bool Scoring::IsObjectHeld(ObjectState* object)
@@ -421,6 +448,11 @@ bool Scoring::IsObjectHeld(uint32 index) const
 	assert(index < 8);
 	return m_holdObjects[index] != nullptr;
 }
+ObjectState* Scoring::GetHeldObject(uint32 index) const
+{
+	assert(index < 8);
+	return m_holdObjects[index];
+}
 bool Scoring::IsLaserHeld(uint32 laserIndex, bool includeSlams) const
 {
 	if (includeSlams)
@@ -615,9 +647,9 @@ void Scoring::m_OnObjectEntered(ObjectState* obj)
 	if (obj->type == ObjectType::Single)
 	{
 		ButtonObjectState* bt = (ButtonObjectState*)obj;
-		ScoreTick* t = m_ticks[bt->index].Add(new ScoreTick(obj));
-		t->time = bt->time;
-		t->SetFlag(TickFlags::Button);
+		ScoreTick& t = m_ticks[bt->index].AddBack(ScoreTick(obj));
+		t.time = bt->time;
+		t.SetFlag(TickFlags::Button);
 
 	}
 	else if (obj->type == ObjectType::Hold)
@@ -625,21 +657,21 @@ void Scoring::m_OnObjectEntered(ObjectState* obj)
         HoldObjectState* hold = (HoldObjectState*)obj;
 
 		// Add all hold ticks
-		Vector<MapTime> holdTicks;
-		m_CalculateHoldTicks(hold, holdTicks);
-		for (size_t i = 0; i < holdTicks.size(); i++)
+		m_holdTickBuffer.clear();
+		m_CalculateHoldTicks(hold, m_holdTickBuffer);
+		for (size_t i = 0; i < m_holdTickBuffer.size(); i++)
 		{
-			ScoreTick* t = m_ticks[hold->index].Add(new ScoreTick(obj));
-			t->SetFlag(TickFlags::Hold);
+			ScoreTick& t = m_ticks[hold->index].AddBack(ScoreTick(obj));
+			t.SetFlag(TickFlags::Hold);
 			if (i == 0 && m_IsRoot(hold))
-				t->SetFlag(TickFlags::Start);
-			if (i == holdTicks.size() - 1 && !hold->next)
-				t->SetFlag(TickFlags::End);
-			t->time = holdTicks[i];
+				t.SetFlag(TickFlags::Start);
+			if (i == m_holdTickBuffer.size() - 1 && !hold->next)
+				t.SetFlag(TickFlags::End);
+			t.time = m_holdTickBuffer[i];
 		}
-		auto t = m_ticks[hold->index].Add(new ScoreTick(obj));
-		t->SetFlag(TickFlags::Hold | TickFlags::End | TickFlags::Ignore);
-		t->time = hold->time + hold->duration;
+		ScoreTick& t = m_ticks[hold->index].AddBack(ScoreTick(obj));
+		t.SetFlag(TickFlags::Hold | TickFlags::End | TickFlags::Ignore);
+		t.time = hold->time + hold->duration;
 	}
 	else if (obj->type == ObjectType::Laser)
 	{
@@ -667,13 +699,10 @@ void Scoring::m_OnObjectEntered(ObjectState* obj)
 				}
 			}
 			// All laser ticks, including slam segments
-			Vector<ScoreTick> laserTicks;
-			m_CalculateLaserTicks(laser, laserTicks);
-			for (size_t i = 0; i < laserTicks.size(); i++)
-			{
-				// Add copy
-				m_ticks[laser->index + 6].Add(new ScoreTick(laserTicks[i]));
-			}
+			m_laserTickBuffer.clear();
+			m_CalculateLaserTicks(laser, m_laserTickBuffer);
+			for (const ScoreTick& tick : m_laserTickBuffer)
+				m_ticks[laser->index + 6].AddBack(tick);
 		}
 
 		// Add to laser segment queue
@@ -703,17 +732,17 @@ void Scoring::m_UpdateTicks()
 
 		// List of ticks for the current button code
 		auto& ticks = m_ticks[buttonCode];
-		for (uint32 i = 0; i < ticks.size(); i++)
+		while (!ticks.empty())
 		{
-			ScoreTick* tick = ticks[i];
+			ScoreTick* tick = &ticks.front();
 			MapTime delta;
 			if (tick->HasFlag(TickFlags::Laser))
 			{
-				delta = currentTime - ticks[i]->time + m_laserOffset;
+				delta = currentTime - tick->time + m_laserOffset;
 			}
 			else 
 			{
-				delta = currentTime - ticks[i]->time + m_inputOffset;
+				delta = currentTime - tick->time + m_inputOffset;
 			}
 			
 			bool processed = false;
@@ -734,10 +763,7 @@ void Scoring::m_UpdateTicks()
 						if (m_IsBeingHeld(tick) || autoplayInfo.IsAutoplayButtons())
 						{
 							m_TickHit(tick, buttonCode);
-							HitStat* stat = new HitStat(tick->object);
-							stat->time = currentTime;
-							stat->rating = ScoreHitRating::Perfect;
-							hitStats.Add(stat);
+							m_AddTickHitStat(tick, ScoreHitRating::Perfect);
 
 							m_prevHoldHit[buttonCode] = true;
 						}
@@ -745,10 +771,7 @@ void Scoring::m_UpdateTicks()
 						{
 							m_TickMiss(tick, buttonCode, 0);
 							// Add miss replay hitstat
-							HitStat* stat = new HitStat(tick->object);
-							stat->time = currentTime;
-							stat->rating = ScoreHitRating::Miss;
-							hitStats.Add(stat);
+							m_AddTickHitStat(tick, ScoreHitRating::Miss);
 
 							m_prevHoldHit[buttonCode] = false;
 						}
@@ -771,10 +794,7 @@ void Scoring::m_UpdateTicks()
 							|| tick->HasFlag(TickFlags::Processed))
 						{
 							m_TickHit(tick, buttonCode);
-							HitStat* stat = new HitStat(tick->object);
-							stat->time = currentTime;
-							stat->rating = ScoreHitRating::Perfect;
-							hitStats.Add(stat);
+							m_AddTickHitStat(tick, ScoreHitRating::Perfect);
 							processed = true;
 						}
 					}
@@ -786,19 +806,13 @@ void Scoring::m_UpdateTicks()
 						if (autoplayInfo.autoplay || laserDelta <= m_laserDistanceLeniency)
 						{
 							m_TickHit(tick, buttonCode);
-							HitStat* stat = new HitStat(tick->object);
-							stat->time = currentTime;
-							stat->rating = ScoreHitRating::Perfect;
-							hitStats.Add(stat);
+							m_AddTickHitStat(tick, ScoreHitRating::Perfect);
 						}
 						else
 						{
 							m_TickMiss(tick, buttonCode, 0);
 							// Add miss replay hitstat
-							HitStat* stat = new HitStat(tick->object);
-							stat->time = currentTime;
-							stat->rating = ScoreHitRating::Miss;
-							hitStats.Add(stat);
+							m_AddTickHitStat(tick, ScoreHitRating::Miss);
 						}
 						processed = true;
 					}
@@ -821,19 +835,14 @@ void Scoring::m_UpdateTicks()
 				if (tick->HasFlag(TickFlags::Hold) || tick->HasFlag(TickFlags::Laser))
 				{
 					// Add miss replay hitstat
-					HitStat* stat = new HitStat(tick->object);
-					stat->time = currentTime;
-					stat->rating = ScoreHitRating::Miss;
-					hitStats.Add(stat);
+					m_AddTickHitStat(tick, ScoreHitRating::Miss);
 				}
 				processed = true;
 			}
 
 			if (processed)
 			{
-				delete tick;
-				ticks.Remove(tick, false);
-				i--;
+				ticks.pop_front();
 			}
 			else
 			{
@@ -851,7 +860,7 @@ ObjectState* Scoring::m_ConsumeTick(uint32 buttonCode)
 
 	if (!m_ticks[buttonCode].empty())
 	{
-		ScoreTick* tick = m_ticks[buttonCode].front();
+		ScoreTick* tick = &m_ticks[buttonCode].front();
 
 		const MapTime delta = currentTime - tick->time;
 		ObjectState* hitObject = tick->object;
@@ -872,8 +881,7 @@ ObjectState* Scoring::m_ConsumeTick(uint32 buttonCode)
 			m_TickHit(tick, buttonCode, delta);
 		else
 			m_TickMiss(tick, buttonCode, delta);
-		delete tick;
-		m_ticks[buttonCode].Remove(tick, false);
+		m_ticks[buttonCode].pop_front();
 
 		return hitObject;
 	}
@@ -1046,12 +1054,8 @@ void Scoring::m_UpdateGaugeSamples()
 
 void Scoring::m_CleanupTicks()
 {
-	for (auto & m_tick : m_ticks)
-	{
-		for (ScoreTick* tick : m_tick)
-			delete tick;
-		m_tick.clear();
-	}
+	for (auto& ticks : m_ticks)
+		ticks.clear();
 }
 
 void Scoring::m_CleanupGauges()
@@ -1466,7 +1470,7 @@ bool Scoring::HoldObjectAvailable(uint32 index, bool checkIfPassedCritLine)
         return false;
 
     auto currentTime = m_playback->GetLastTime() + m_inputOffset;
-    auto tick = m_ticks[index].front();
+    const ScoreTick* tick = &m_ticks[index].front();
     auto obj = (HoldObjectState*)tick->object;
     if (obj->type != ObjectType::Hold)
 		return false;
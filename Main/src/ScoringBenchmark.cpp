@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "ScoringBenchmark.hpp"
+#include "Scoring.hpp"
+#include "Game.hpp"
+#include "Application.hpp"
+#include "Input.hpp"
+#include <Beatmap/Beatmap.hpp>
+#include <Beatmap/BeatmapPlayback.hpp>
+
+#ifdef COUNT_ALLOCATIONS
+#include <new>
+
+// Allocations made by the current thread, only the main thread is measured
+//	replacing the global operators counts allocations for the whole executable, so this is only built with the COUNT_ALLOCATIONS option
+//	aligned allocations keep the default operators and are not counted
+static thread_local uint64 g_threadAllocations = 0;
+
+void* operator new(size_t size)
+{
+	g_threadAllocations++;
+	if (void* ptr = malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	g_threadAllocations++;
+	return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	free(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	free(ptr);
+}
+
+static uint64 GetThreadAllocations()
+{
+	return g_threadAllocations;
+}
+#else
+static uint64 GetThreadAllocations()
+{
+	return 0;
+}
+#endif
+
+bool RunScoringBenchmark(const String& mapPath)
+{
+	Ref<Beatmap> beatmap = TryLoadMap(mapPath);
+	if (!beatmap)
+	{
+		Logf("Failed to load map for scoring benchmark: %s", Logger::Severity::Error, mapPath);
+		return false;
+	}
+
+	const MapTime endTime = beatmap->GetLastObjectTime() + 3000;
+	// Simulate a 1000Hz update rate
+	const MapTime step = 1;
+	const uint32 numRuns = 5;
+
+	// Autoplay doesn't read the input, but Scoring needs one to register with
+	Input input;
+	input.InitHeadless();
+
+	uint64 allocations = 0;
+	double seconds = 0.0;
+	for (uint32 run = 0; run < numRuns; run++)
+	{
+		BeatmapPlayback playback(*beatmap);
+		Scoring scoring;
+		scoring.SetPlayback(playback);
+		scoring.SetEndTime(endTime);
+		scoring.SetInput(&input);
+		scoring.autoplayInfo.autoplay = true;
+		playback.Reset(0);
+		scoring.Reset();
+
+		uint64 startAllocations = GetThreadAllocations();
+		Timer t;
+		for (MapTime time = 0; time < endTime; time += step)
+		{
+			playback.Update(time);
+			scoring.Tick(step / 1000.0f);
+		}
+		seconds += t.SecondsAsDouble();
+		allocations += GetThreadAllocations() - startAllocations;
+
+		if (run == 0)
+			Logf("Scoring benchmark: %d/%d hit stats, %d combo", Logger::Severity::Info,
+				(int32)scoring.hitStats.size(), scoring.mapTotals.numSingles + scoring.mapTotals.numTicks, scoring.maxComboCounter);
+		scoring.SetInput(nullptr);
+	}
+
+	const double chartSeconds = (double)endTime / 1000.0 * numRuns;
+	Logf("Scoring benchmark: %.2f ms per chart, %.1fx realtime", Logger::Severity::Info,
+		seconds / numRuns * 1000.0, chartSeconds / seconds);
+#ifdef COUNT_ALLOCATIONS
+	Logf("Scoring benchmark: %llu allocations per chart, %.1f allocations per second of gameplay", Logger::Severity::Info,
+		allocations / numRuns, (double)allocations / chartSeconds);
+#else
+	Log("Scoring benchmark: allocations are only counted in builds with the COUNT_ALLOCATIONS option", Logger::Severity::Info);
+#endif
+	input.Cleanup();
+	return true;
+}
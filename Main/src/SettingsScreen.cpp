@@ -453,7 +453,7 @@ protected:
 		IntSetting(GameConfigKeys::LeadInTime, "Lead-in time (ms)", 250, 10000, 250);
 		IntSetting(GameConfigKeys::PracticeLeadInTime, "(for practice mode)", 250, 10000, 250);
 
-		ToggleSetting(GameConfigKeys::AutoComputeSongOffset, "Before first-time play, compute and set the song offset automatically");
+		ToggleSetting(GameConfigKeys::AutoComputeSongOffset, "Compute song offsets automatically (before first-time play and for the library in the background)");
 
 		SectionHeader("After Playing");
 		ToggleSetting(GameConfigKeys::SkipScore, "Skip score screen on manual exit");
@@ -581,6 +581,7 @@ protected:
 		SectionHeader("Game Elements");
 
 		ToggleSetting(GameConfigKeys::DisableBackgrounds, "Disable song backgrounds");
+		ToggleSetting(GameConfigKeys::HalfResolutionBackground, "Render song backgrounds at half resolution");
 		ToggleSetting(GameConfigKeys::DelayedHitEffects, "Delayed fade button hit effects");
 		FloatSetting(GameConfigKeys::DistantButtonScale, "Distant button scale", 1.0f, 5.0f);
 
@@ -707,6 +708,8 @@ protected:
 
 		SelectionSetting(GameConfigKeys::AntiAliasing, m_aaModes, "Anti-aliasing (requires restart):");
 		SetApply(ToggleSetting(GameConfigKeys::VSync, "VSync"));
+		ToggleSetting(GameConfigKeys::JustInTimeRender, "Render frames just in time (lower input latency)");
+		IntSetting(GameConfigKeys::TextureMemoryBudget, "Texture memory budget (MB):", 64, 4096, 64);
 		SetApply(ToggleSetting(GameConfigKeys::ShowFps, "Show FPS"));
 
 		SectionHeader("Update");
@@ -0,0 +1,495 @@
+#include "stdafx.h"
+#include "Simulator.hpp"
+#include "Game.hpp"
+#include "GameConfig.hpp"
+#include "Gauge.hpp"
+#include "GameplayThread.hpp"
+#include <Shared/Files.hpp>
+#include <Shared/TextStream.hpp>
+#include <atomic>
+#include <thread>
+
+GameplaySimulator::GameplaySimulator()
+{
+	inputOffset = g_gameConfig.GetInt(GameConfigKeys::InputOffset);
+	laserOffset = g_gameConfig.GetInt(GameConfigKeys::LaserOffset);
+	bounceGuard = g_gameConfig.GetInt(GameConfigKeys::InputBounceGuard);
+	m_input.InitHeadless();
+}
+GameplaySimulator::~GameplaySimulator()
+{
+	m_input.Cleanup();
+}
+
+bool GameplaySimulator::Load(const String& mapPath)
+{
+	m_mapPath = mapPath;
+	m_beatmap = TryLoadMap(mapPath);
+	return (bool)m_beatmap;
+}
+
+void GameplaySimulator::m_InitPlay(BeatmapPlayback& playback, Scoring& scoring, bool autoplay, MapTime initTime, MapTime start)
+{
+	m_input.InitHeadless();
+
+	// Same setup as Game
+	playback.Reset(initTime, start);
+	scoring.SetOptions(options);
+	scoring.SetPlayback(playback);
+	scoring.SetEndTime(m_beatmap->GetLastObjectTime());
+	scoring.SetInput(&m_input);
+	scoring.autoplayInfo.autoplay = autoplay;
+	scoring.Reset();
+	scoring.SetInputOffsets(inputOffset, laserOffset, bounceGuard);
+	scoring.SetHitWindow(hitWindow);
+	playback.hittableObjectEnter = hitWindow.miss + inputOffset;
+	playback.hittableObjectLeave = hitWindow.good;
+}
+
+void GameplaySimulator::m_FinishPlay(Scoring& scoring, SimulationResult& result)
+{
+	scoring.FinishGame();
+	scoring.SetInput(nullptr);
+
+	result.success = true;
+	result.score = scoring.CalculateCurrentScore();
+	result.perfects = scoring.GetPerfects();
+	result.goods = scoring.GetGoods();
+	result.misses = scoring.GetMisses();
+	result.maxCombo = scoring.maxComboCounter;
+	result.gauge = scoring.GetTopGauge() ? scoring.GetTopGauge()->GetValue() : 0.0f;
+
+	ScoreIndex score = {};
+	score.score = result.score;
+	score.miss = result.misses;
+	score.gauge = result.gauge;
+	score.gaugeType = options.gaugeType;
+	result.clearMark = Scoring::CalculateBadge(score);
+
+	result.hitStats.reserve(scoring.hitStats.size());
+	for (const HitStat* stat : scoring.hitStats)
+		result.hitStats.push_back(*stat);
+}
+
+SimulationResult GameplaySimulator::Run(SimulationInput* input, MapTime step)
+{
+	SimulationResult result;
+	result.path = m_mapPath;
+	if (!m_beatmap || step <= 0)
+		return result;
+
+	Timer t;
+	BeatmapPlayback playback(*m_beatmap);
+	Scoring scoring;
+	m_InitPlay(playback, scoring, input == nullptr);
+
+	// Keep going for a bit after the last object so hold and laser ticks at the end are processed
+	const MapTime simulationEnd = m_beatmap->GetLastObjectTime() + hitWindow.miss + 1000;
+	for (MapTime time = 0; time < simulationEnd; time += step)
+	{
+		playback.Update(time);
+		if (input)
+			input->Update(time, m_input);
+		scoring.Tick(step / 1000.0f);
+	}
+	m_FinishPlay(scoring, result);
+
+	result.chartTime = simulationEnd;
+	result.seconds = t.SecondsAsDouble();
+	return result;
+}
+
+SimulationResult GameplaySimulator::Replay(const InputReplay& replay)
+{
+	SimulationResult result;
+	result.path = m_mapPath;
+	if (!m_beatmap || replay.frames.empty())
+		return result;
+	if (replay.options.random)
+	{
+		// The lane shuffle is not stored in the replay
+		Log("Input replays of plays with random lanes can not be simulated", Logger::Severity::Warning);
+		return result;
+	}
+
+	Timer t;
+	options = replay.options;
+	hitWindow = HitWindow(replay.hitWindowPerfect, replay.hitWindowGood, replay.hitWindowHold, replay.hitWindowSlam);
+	hitWindow.miss = replay.hitWindowMiss;
+	inputOffset = replay.inputOffset;
+	laserOffset = replay.laserOffset;
+	bounceGuard = replay.bounceGuard;
+	if (options.mirror)
+		ApplyMirror(*m_beatmap);
+
+	{
+		BeatmapPlayback playback(*m_beatmap);
+		Scoring scoring;
+		m_InitPlay(playback, scoring, false, replay.playbackInitTime, replay.playbackStartTime);
+
+		// Same order as a game update: button events, playback update and then the scoring update
+		for (const InputReplayFrame& frame : replay.frames)
+		{
+			for (uint32 i = 0; i < frame.numEvents; i++)
+			{
+				const InputReplayEvent& e = replay.events[frame.firstEvent + i];
+				m_input.SimulateButton((Input::Button)e.button, e.pressed);
+			}
+			playback.Update(frame.time);
+			m_input.SimulateLaserDir(0, frame.laserInput[0]);
+			m_input.SimulateLaserDir(1, frame.laserInput[1]);
+			scoring.Tick(frame.deltaTime);
+
+			// Gameplay thread steps without input
+			for (uint32 i = 1; i <= frame.numRepeats; i++)
+			{
+				playback.Update(frame.time + (MapTime)i);
+				m_input.SimulateLaserDir(0, 0.0f);
+				m_input.SimulateLaserDir(1, 0.0f);
+				scoring.Tick(frame.deltaTime);
+			}
+		}
+		m_FinishPlay(scoring, result);
+	}
+
+	// Undo the mirror by loading the map again
+	if (options.mirror)
+		result.success = Load(m_mapPath) && result.success;
+
+	result.chartTime = replay.frames.back().time + (MapTime)replay.frames.back().numRepeats - replay.frames.front().time;
+	result.seconds = t.SecondsAsDouble();
+	return result;
+}
+
+// Offset of a simulated press from the object it hits, differs from object to object and stays within the perfect window
+static MapTime PressOffset(const ButtonObjectState* object)
+{
+	const MapTime offset = (object->time / 7 + object->index * 3) % 21 - 10;
+	// Nothing can be pressed before the play starts
+	return Math::Max(offset, -object->time);
+}
+
+Vector<SimulatedPress> GameplaySimulator::CreatePresses() const
+{
+	Vector<SimulatedPress> presses;
+	if (!m_beatmap)
+		return presses;
+	for (const ObjectState* object : m_beatmap->GetLinearObjects())
+	{
+		if (object->type != ObjectType::Single && object->type != ObjectType::Hold)
+			continue;
+		const ButtonObjectState* button = (const ButtonObjectState*)object;
+		const MapTime pressTime = button->time + PressOffset(button);
+		// Singles are tapped, holds are released after their end
+		const MapTime releaseTime = object->type == ObjectType::Hold ? button->time + ((const HoldObjectState*)object)->duration + 5 : pressTime + 5;
+		presses.push_back({ pressTime, (Input::Button)button->index, true });
+		presses.push_back({ releaseTime, (Input::Button)button->index, false });
+	}
+	std::stable_sort(presses.begin(), presses.end(), [](const SimulatedPress& a, const SimulatedPress& b) { return a.time < b.time; });
+	return presses;
+}
+
+SimulationResult GameplaySimulator::RunThreaded(const Vector<SimulatedPress>& presses, MapTime stallInterval, MapTime stallLength)
+{
+	SimulationResult result;
+	result.path = m_mapPath;
+	if (!m_beatmap)
+		return result;
+
+	Timer t;
+	BeatmapPlayback playback(*m_beatmap);
+	Scoring scoring;
+	m_InitPlay(playback, scoring, false);
+
+	// The simulated time is moved by this thread, the gameplay thread waits for it to pass the time of its next step
+	std::atomic<MapTime> now(0);
+	std::atomic<bool> finished(false);
+	auto ToClock = [](MapTime time) { return FixedRateThread::Clock::time_point(std::chrono::milliseconds(time)); };
+	Input source;
+	source.InitHeadless();
+	GameplayThread thread(playback, scoring, m_input);
+	thread.SetThreadClock([&]() { return ToClock(now); }, [&](FixedRateThread::Clock::time_point time)
+	{
+		while (!finished && ToClock(now) < time)
+			std::this_thread::yield();
+	});
+	thread.Start([&]() { return now.load(); });
+
+	// Runs until the step for the current time is done
+	auto WaitForStep = [&]()
+	{
+		while (thread.GetNumSteps() <= (uint64)now)
+			std::this_thread::yield();
+	};
+
+	// The presses reach the thread the same way the ones of g_input do, the time of the event that is handled stands in for the SDL timestamp
+	MapTime eventTime = 0;
+	thread.ForwardButtons(source, [&]() { return GameplayThread::GetEventTime(now, now - eventTime, 1.0f); });
+	size_t nextPress = 0;
+
+	const MapTime simulationEnd = m_beatmap->GetLastObjectTime() + hitWindow.miss + 1000;
+	WaitForStep();
+	while (now < simulationEnd)
+	{
+		// Like Window::Update every frame starts by handling the events that happened since the last one
+		for (; nextPress < presses.size() && presses[nextPress].time <= now; nextPress++)
+		{
+			eventTime = presses[nextPress].time;
+			source.SimulateButton(presses[nextPress].button, presses[nextPress].pressed);
+		}
+
+		if (stallInterval > 0 && now % stallInterval == 0)
+		{
+			// The gameplay thread can't step while the lock is held
+			GameplayThread::StateLock state = thread.LockState();
+			now += stallLength;
+		}
+		else
+		{
+			now++;
+		}
+		WaitForStep();
+
+		// The render side always sees the state of the latest step
+		if (thread.GetSnapshot().time != now)
+		{
+			Logf("Gameplay snapshot is at %d ms instead of %d ms", Logger::Severity::Error, thread.GetSnapshot().time, now.load());
+			finished = true;
+			return result;
+		}
+	}
+	finished = true;
+	thread.Stop();
+	if (thread.GetNumDroppedSteps() > 0)
+		Logf("The gameplay thread dropped %d steps", Logger::Severity::Warning, (int32)thread.GetNumDroppedSteps());
+	m_FinishPlay(scoring, result);
+
+	result.chartTime = simulationEnd;
+	result.seconds = t.SecondsAsDouble();
+	return result;
+}
+
+bool RunGameplayThreadVerification(const String& mapPath)
+{
+	GameplaySimulator simulator;
+	if (!simulator.Load(mapPath))
+	{
+		Logf("Failed to load chart %s", Logger::Severity::Error, mapPath);
+		return false;
+	}
+	// Judge exactly at the time of the presses
+	simulator.inputOffset = 0;
+	simulator.bounceGuard = 0;
+	const Vector<SimulatedPress> presses = simulator.CreatePresses();
+
+	// Stalls of 50 ms after every 4 frames at 120 fps
+	const MapTime stallLength = 50;
+	SimulationResult steady = simulator.RunThreaded(presses);
+	SimulationResult stalled = simulator.RunThreaded(presses, 33, stallLength);
+	if (!steady.success || !stalled.success)
+		return false;
+	Logf("Steady: %08d (%d/%d/%d) in %.2f s", Logger::Severity::Info, steady.score, steady.perfects, steady.goods, steady.misses, steady.seconds);
+	Logf("Stalled: %08d (%d/%d/%d) in %.2f s", Logger::Severity::Info, stalled.score, stalled.perfects, stalled.goods, stalled.misses, stalled.seconds);
+
+	// Lasers are not played, how far their cursor drifts depends on how the steps line up with the stalls
+	auto IsButton = [](const HitStat& stat) { return stat.object->type == ObjectType::Single || stat.object->type == ObjectType::Hold; };
+	Vector<const HitStat*> steadyStats, stalledStats;
+	for (const HitStat& stat : steady.hitStats)
+	{
+		if (IsButton(stat))
+			steadyStats.push_back(&stat);
+	}
+	for (const HitStat& stat : stalled.hitStats)
+	{
+		if (IsButton(stat))
+			stalledStats.push_back(&stat);
+	}
+
+	// Ticks that are processed together after a stall can be recorded in a different order
+	auto ByObject = [](const HitStat* a, const HitStat* b)
+	{
+		const ButtonObjectState* objectA = (const ButtonObjectState*)a->object;
+		const ButtonObjectState* objectB = (const ButtonObjectState*)b->object;
+		if (objectA->time != objectB->time)
+			return objectA->time < objectB->time;
+		return objectA->index < objectB->index;
+	};
+	std::stable_sort(steadyStats.begin(), steadyStats.end(), ByObject);
+	std::stable_sort(stalledStats.begin(), stalledStats.end(), ByObject);
+
+	uint32 numMismatches = 0;
+	// Presses are handled by the frame after they happen and judged by the step after that,
+	//	so they are judged at most one step late, or one step after the end of the stall they waited for
+	auto CheckDelays = [&](const Vector<const HitStat*>& stats, MapTime maxDelay)
+	{
+		for (const HitStat* stat : stats)
+		{
+			if (stat->object->type != ObjectType::Single)
+				continue;
+			const MapTime offset = PressOffset((const ButtonObjectState*)stat->object);
+			if (stat->delta < offset || stat->delta > offset + maxDelay)
+			{
+				Logf("Object at %d ms was judged %d ms off, it was pressed %d ms off", Logger::Severity::Error,
+					stat->object->time, stat->delta, offset);
+				numMismatches++;
+			}
+		}
+	};
+	CheckDelays(steadyStats, 1);
+	CheckDelays(stalledStats, stallLength + 1);
+
+	if (steadyStats.size() != stalledStats.size())
+	{
+		Logf("%d button judgements with stalls, %d without", Logger::Severity::Error, (int32)stalledStats.size(), (int32)steadyStats.size());
+		numMismatches++;
+	}
+	// Late presses can lower the rating of a single or miss the first tick of a hold, but every single is still hit
+	uint32 numChangedHolds = 0;
+	for (size_t i = 0; i < Math::Min(steadyStats.size(), stalledStats.size()); i++)
+	{
+		const HitStat& a = *steadyStats[i];
+		const HitStat& b = *stalledStats[i];
+		if (a.object != b.object || (a.object->type == ObjectType::Single && a.hasMissed != b.hasMissed))
+		{
+			Logf("Judgement of the object at %d ms changed with stalls, delta %d -> %d", Logger::Severity::Error, a.object->time, a.delta, b.delta);
+			numMismatches++;
+		}
+		else if (a.object->type == ObjectType::Hold && (a.rating != b.rating || a.hold != b.hold))
+		{
+			numChangedHolds++;
+		}
+	}
+	if (numChangedHolds > 0)
+		Logf("%d hold judgements changed because their press waited for a stall", Logger::Severity::Info, numChangedHolds);
+	if (numMismatches > 0)
+		return false;
+	Logf("%d button judgements match", Logger::Severity::Info, (int32)stalledStats.size());
+	return true;
+}
+
+bool RunReplayVerification(const String& mapPath, const String& replayPath)
+{
+	InputReplay replay;
+	File replayFile;
+	if (!replayFile.OpenRead(replayPath))
+	{
+		Logf("Failed to open input replay %s", Logger::Severity::Error, replayPath);
+		return false;
+	}
+	FileReader reader(replayFile);
+	Timer t;
+	if (!replay.Load(reader))
+	{
+		Logf("Failed to load input replay %s", Logger::Severity::Error, replayPath);
+		return false;
+	}
+	const double loadTime = t.SecondsAsDouble();
+
+	GameplaySimulator simulator;
+	if (!simulator.Load(mapPath))
+	{
+		Logf("Failed to load chart %s", Logger::Severity::Error, mapPath);
+		return false;
+	}
+	SimulationResult result = simulator.Replay(replay);
+	if (!result.success)
+		return false;
+
+	Logf("Loaded %d frames in %.2f ms, simulated in %.2f ms", Logger::Severity::Info,
+		(int32)replay.frames.size(), loadTime * 1000.0, result.seconds * 1000.0);
+	Logf("Recorded: %08d (%d/%d/%d)", Logger::Severity::Info, replay.score, replay.perfects, replay.goods, replay.misses);
+	Logf("Simulated: %08d (%d/%d/%d)", Logger::Severity::Info, result.score, result.perfects, result.goods, result.misses);
+
+	const bool match = result.score == replay.score && result.perfects == replay.perfects
+		&& result.goods == replay.goods && result.misses == replay.misses;
+	if (!match)
+		Log("Simulated result does not match the recorded result", Logger::Severity::Error);
+	return match;
+}
+
+bool RunSimulation(const String& path, uint32 numThreads, const String& csvPath)
+{
+	Vector<String> charts;
+	if (Path::IsDirectory(path))
+	{
+		for (const FileInfo& file : Files::ScanFilesRecursive(path, "ksh"))
+			charts.Add(file.fullPath);
+		std::sort(charts.begin(), charts.end());
+	}
+	else
+	{
+		charts.Add(path);
+	}
+	if (charts.empty())
+	{
+		Logf("No charts found to simulate in %s", Logger::Severity::Error, path);
+		return false;
+	}
+
+	if (numThreads == 0)
+		numThreads = Math::Max(1u, std::thread::hardware_concurrency());
+	numThreads = Math::Min(numThreads, (uint32)charts.size());
+
+	Logf("Simulating %d charts on %d threads", Logger::Severity::Info, (int32)charts.size(), numThreads);
+
+	// Each worker takes the next chart until all are done
+	Vector<SimulationResult> results(charts.size());
+	std::atomic<size_t> nextChart(0);
+	auto worker = [&]()
+	{
+		GameplaySimulator simulator;
+		for (size_t i = nextChart++; i < charts.size(); i = nextChart++)
+		{
+			if (!simulator.Load(charts[i]))
+			{
+				Logf("Failed to load chart %s", Logger::Severity::Warning, charts[i]);
+				results[i].path = charts[i];
+				continue;
+			}
+			results[i] = simulator.Run();
+			const SimulationResult& r = results[i];
+			Logf("[%d/%d] %s: %08d (%d/%d/%d), %.1fx realtime", Logger::Severity::Info,
+				(int32)i + 1, (int32)charts.size(), r.path, r.score, r.perfects, r.goods, r.misses,
+				(double)r.chartTime / 1000.0 / Math::Max(r.seconds, 1e-6));
+		}
+	};
+
+	Timer t;
+	Vector<std::thread> threads;
+	for (uint32 i = 1; i < numThreads; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+	const double seconds = t.SecondsAsDouble();
+
+	uint32 numFailed = 0;
+	double chartSeconds = 0.0;
+	for (const SimulationResult& r : results)
+	{
+		if (!r.success)
+			numFailed++;
+		chartSeconds += (double)r.chartTime / 1000.0;
+	}
+	Logf("Simulated %d charts (%d failed) in %.2f s, %.1fx realtime", Logger::Severity::Info,
+		(int32)charts.size(), numFailed, seconds, chartSeconds / Math::Max(seconds, 1e-6));
+
+	if (!csvPath.empty())
+	{
+		File csvFile;
+		if (!csvFile.OpenWrite(csvPath))
+		{
+			Logf("Failed to open %s for writing", Logger::Severity::Error, csvPath);
+			return false;
+		}
+		FileWriter writer(csvFile);
+		TextStream::WriteLine(writer, "path,success,score,perfect,good,miss,maxcombo,gauge,clear,seconds");
+		for (const SimulationResult& r : results)
+		{
+			TextStream::WriteLine(writer, Utility::Sprintf("\"%s\",%d,%d,%d,%d,%d,%d,%.3f,%d,%.4f",
+				r.path, r.success ? 1 : 0, r.score, r.perfects, r.goods, r.misses, r.maxCombo,
+				r.gauge, (int32)r.clearMark, r.seconds));
+		}
+	}
+	return numFailed == 0;
+}
@@ -2,36 +2,15 @@
 #include "Shared/LuaBindable.hpp"
 #include "SkinHttp.hpp"
 
-void SkinHttp::m_requestLoop()
+void SkinHttp::m_SendAsync(lua_State* L, HttpRequest&& request)
 {
-	while (m_running)
+	int callback = luaL_ref(L, LUA_REGISTRYINDEX);
+	g_httpClient->Send(std::move(request), RequestPriority::Normal, L, [this, L, callback](cpr::Response&& response)
 	{
-		m_mutex.lock(); ///TODO: use semaphore?
-		if (m_requests.size() > 0)
-		{
-			//get request
-			AsyncRequest* r = m_requests.front();
-			m_mutex.unlock();
-
-			//process request
-			CompleteRequest cr;
-			cr.L = r->L;
-			cr.callback = r->callback;
-			cr.r = r->r.get();
-
-			//push result and pop request
-			m_mutex.lock();
-			delete r;
-			m_callbackQueue.push(cr);
-			m_requests.pop();
-			m_mutex.unlock();
-		}
-		else
-		{
-			m_mutex.unlock();
-			std::this_thread::sleep_for(std::chrono::milliseconds(50));
-		}
-	}
+		m_mutex.lock();
+		m_callbackQueue.push_back({ L, std::move(response), callback });
+		m_mutex.unlock();
+	});
 }
 
 //https://stackoverflow.com/a/6142700
@@ -91,24 +70,14 @@ void SkinHttp::m_PushResponse(lua_State * L, const cpr::Response & r)
 
 SkinHttp::SkinHttp()
 {
-	m_running = true;
-	m_requestThread = Thread(&SkinHttp::m_requestLoop, this);
 }
 
 SkinHttp::~SkinHttp()
 {
-	m_running = false;
-	if(m_requestThread.joinable())
-		m_requestThread.join();
-
-	while (!m_requests.empty())
-	{
-		delete m_requests.front();
-		m_requests.pop();
-	}
-
 	for (auto& s : m_boundStates)
 	{
+		if (g_httpClient)
+			g_httpClient->CancelOwner(s.first);
 		delete s.second;
 	}
 	m_boundStates.clear();
@@ -116,32 +85,21 @@ SkinHttp::~SkinHttp()
 
 int SkinHttp::lGetAsync(lua_State * L)
 {
-	String url = luaL_checkstring(L, 2);
-	cpr::Header header = HeaderFromLuaTable(L, 3);
-	int callback = luaL_ref(L, LUA_REGISTRYINDEX);
-	AsyncRequest* r = new AsyncRequest();
-	r->r = cpr::GetAsync(cpr::Url{ url }, header);
-	r->callback = callback;
-	r->L = L;
-	m_mutex.lock();
-	m_requests.push(r);
-	m_mutex.unlock();
+	HttpRequest request;
+	request.url = luaL_checkstring(L, 2);
+	request.header = HeaderFromLuaTable(L, 3);
+	m_SendAsync(L, std::move(request));
 	return 0;
 }
 
 int SkinHttp::lPostAsync(lua_State * L)
 {
-	String url = luaL_checkstring(L, 2);
-	String payload = luaL_checkstring(L, 3);
-	cpr::Header header = HeaderFromLuaTable(L, 4);
-	int callback = luaL_ref(L, LUA_REGISTRYINDEX);
-	AsyncRequest* r = new AsyncRequest();
-	r->r = cpr::PostAsync(cpr::Url{ url }, cpr::Body{ *payload }, header);
-	r->callback = callback;
-	r->L = L;
-	m_mutex.lock();
-	m_requests.push(r);
-	m_mutex.unlock();
+	HttpRequest request;
+	request.method = HttpRequest::Method::Post;
+	request.url = luaL_checkstring(L, 2);
+	request.body = luaL_checkstring(L, 3);
+	request.header = HeaderFromLuaTable(L, 4);
+	m_SendAsync(L, std::move(request));
 	return 0;
 }
 
@@ -167,29 +125,25 @@ int SkinHttp::lPost(lua_State * L)
 void SkinHttp::ProcessCallbacks()
 {
 	m_mutex.lock();
-	if (m_callbackQueue.size() > 0)
+	std::swap(m_processing, m_callbackQueue);
+	m_mutex.unlock();
+
+	for (CompleteRequest& cr : m_processing)
 	{
-		//get response
-		CompleteRequest& cr = m_callbackQueue.front();
-		m_mutex.unlock();
+		if (!m_boundStates.Contains(cr.L))
+			continue;
 
-		if (m_boundStates.Contains(cr.L))
+		//process response
+		lua_rawgeti(cr.L, LUA_REGISTRYINDEX, cr.callback);
+		m_PushResponse(cr.L, cr.r);
+		if (lua_pcall(cr.L, 1, 0, 0) != 0)
 		{
-			//process response
-			lua_rawgeti(cr.L, LUA_REGISTRYINDEX, cr.callback);
-			m_PushResponse(cr.L, cr.r);
-			if (lua_pcall(cr.L, 1, 0, 0) != 0)
-			{
-				Logf("Lua error on calling http callback: %s", Logger::Severity::Error, lua_tostring(cr.L, -1));
-			}
-			lua_settop(cr.L, 0);
-			luaL_unref(cr.L, LUA_REGISTRYINDEX, cr.callback);
+			Logf("Lua error on calling http callback: %s", Logger::Severity::Error, lua_tostring(cr.L, -1));
 		}
-		//pop response
-		m_mutex.lock();
-		m_callbackQueue.pop();
+		lua_settop(cr.L, 0);
+		luaL_unref(cr.L, LUA_REGISTRYINDEX, cr.callback);
 	}
-	m_mutex.unlock();
+	m_processing.clear();
 }
 
 void SkinHttp::PushFunctions(lua_State * L)
@@ -208,6 +162,8 @@ void SkinHttp::ClearState(lua_State * L)
 {
 	if (!m_boundStates.Contains(L))
 		return;
+	if (g_httpClient)
+		g_httpClient->CancelOwner(L);
 	delete m_boundStates.at(L);
 	m_boundStates.erase(L);
 }
@@ -44,36 +44,15 @@ void SkinIR::m_PushJSON(lua_State* L, const nlohmann::json& json)
     else if(json.is_null()) lua_pushnil(L);
 }
 
-void SkinIR::m_requestLoop()
+void SkinIR::m_SendAsync(lua_State* L, HttpRequest&& request)
 {
-	while (m_running)
+	int callback = luaL_ref(L, LUA_REGISTRYINDEX);
+	g_httpClient->Send(std::move(request), RequestPriority::Normal, L, [this, L, callback](cpr::Response&& response)
 	{
-		m_mutex.lock(); ///TODO: use semaphore?
-		if (m_requests.size() > 0)
-		{
-			//get request
-			AsyncRequest* r = m_requests.front();
-			m_mutex.unlock();
-
-			//process request
-			CompleteRequest cr;
-			cr.L = r->L;
-			cr.callback = r->callback;
-			cr.r = r->r.get();
-
-			//push result and pop request
-			m_mutex.lock();
-			delete r;
-			m_callbackQueue.push(cr);
-			m_requests.pop();
-			m_mutex.unlock();
-		}
-		else
-		{
-			m_mutex.unlock();
-			std::this_thread::sleep_for(std::chrono::milliseconds(50));
-		}
-	}
+		m_mutex.lock();
+		m_callbackQueue.push_back({ L, std::move(response), callback });
+		m_mutex.unlock();
+	});
 }
 
 void SkinIR::m_PushResponse(lua_State * L, const cpr::Response & r)
@@ -115,24 +94,14 @@ void SkinIR::m_PushResponse(lua_State * L, const cpr::Response & r)
 
 SkinIR::SkinIR()
 {
-	m_running = true;
-	m_requestThread = Thread(&SkinIR::m_requestLoop, this);
 }
 
 SkinIR::~SkinIR()
 {
-	m_running = false;
-	if(m_requestThread.joinable())
-		m_requestThread.join();
-
-	while (!m_requests.empty())
-	{
-		delete m_requests.front();
-		m_requests.pop();
-	}
-
 	for (auto& s : m_boundStates)
 	{
+		if (g_httpClient)
+			g_httpClient->CancelOwner(s.first);
 		delete s.second;
 	}
 	m_boundStates.clear();
@@ -140,43 +109,22 @@ SkinIR::~SkinIR()
 
 int SkinIR::lHeartbeat(struct lua_State* L)
 {
-    int callback = luaL_ref(L, LUA_REGISTRYINDEX);
-    AsyncRequest* r = new AsyncRequest();
-    r->r = IR::Heartbeat();
-    r->callback = callback;
-    r->L = L;
-    m_mutex.lock();
-    m_requests.push(r);
-    m_mutex.unlock();
+    m_SendAsync(L, IR::Heartbeat());
     return 0;
 }
 
 int SkinIR::lChartTracked(struct lua_State* L)
 {
     String hash = luaL_checkstring(L, 2);
-	int callback = luaL_ref(L, LUA_REGISTRYINDEX);
-	AsyncRequest* r = new AsyncRequest();
-	r->r = IR::ChartTracked(hash);
-	r->callback = callback;
-	r->L = L;
-	m_mutex.lock();
-	m_requests.push(r);
-	m_mutex.unlock();
-	return 0;
+    m_SendAsync(L, IR::ChartTracked(hash));
+    return 0;
 }
 
 int SkinIR::lRecord(struct lua_State* L)
 {
     String hash = luaL_checkstring(L, 2);
-	int callback = luaL_ref(L, LUA_REGISTRYINDEX);
-	AsyncRequest* r = new AsyncRequest();
-	r->r = IR::Record(hash);
-	r->callback = callback;
-	r->L = L;
-	m_mutex.lock();
-	m_requests.push(r);
-	m_mutex.unlock();
-	return 0;
+    m_SendAsync(L, IR::Record(hash));
+    return 0;
 }
 
 int SkinIR::lLeaderboard(struct lua_State* L)
@@ -184,44 +132,33 @@ int SkinIR::lLeaderboard(struct lua_State* L)
     String hash = luaL_checkstring(L, 2);
     String mode = luaL_checkstring(L, 3);
     int n = luaL_checkinteger(L, 4);
-	int callback = luaL_ref(L, LUA_REGISTRYINDEX);
-	AsyncRequest* r = new AsyncRequest();
-	r->r = IR::Leaderboard(hash, mode, n);
-	r->callback = callback;
-	r->L = L;
-	m_mutex.lock();
-	m_requests.push(r);
-	m_mutex.unlock();
-	return 0;
+    m_SendAsync(L, IR::Leaderboard(hash, mode, n));
+    return 0;
 }
 
 
 void SkinIR::ProcessCallbacks()
 {
 	m_mutex.lock();
-	if (m_callbackQueue.size() > 0)
+	std::swap(m_processing, m_callbackQueue);
+	m_mutex.unlock();
+
+	for (CompleteRequest& cr : m_processing)
 	{
-		//get response
-		CompleteRequest& cr = m_callbackQueue.front();
-		m_mutex.unlock();
+		if (!m_boundStates.Contains(cr.L))
+			continue;
 
-		if (m_boundStates.Contains(cr.L))
+		//process response
+		lua_rawgeti(cr.L, LUA_REGISTRYINDEX, cr.callback);
+		m_PushResponse(cr.L, cr.r);
+		if (lua_pcall(cr.L, 1, 0, 0) != 0)
 		{
-			//process response
-			lua_rawgeti(cr.L, LUA_REGISTRYINDEX, cr.callback);
-			m_PushResponse(cr.L, cr.r);
-			if (lua_pcall(cr.L, 1, 0, 0) != 0)
-			{
-				Logf("Lua error on calling IR callback: %s", Logger::Severity::Error, lua_tostring(cr.L, -1));
-			}
-			lua_settop(cr.L, 0);
-			luaL_unref(cr.L, LUA_REGISTRYINDEX, cr.callback);
+			Logf("Lua error on calling IR callback: %s", Logger::Severity::Error, lua_tostring(cr.L, -1));
 		}
-		//pop response
-		m_mutex.lock();
-		m_callbackQueue.pop();
+		lua_settop(cr.L, 0);
+		luaL_unref(cr.L, LUA_REGISTRYINDEX, cr.callback);
 	}
-	m_mutex.unlock();
+	m_processing.clear();
 }
 
 void SkinIR::PushFunctions(lua_State * L)
@@ -240,6 +177,8 @@ void SkinIR::ClearState(lua_State * L)
 {
 	if (!m_boundStates.Contains(L))
 		return;
+	if (g_httpClient)
+		g_httpClient->CancelOwner(L);
 	delete m_boundStates.at(L);
 	m_boundStates.erase(L);
 }
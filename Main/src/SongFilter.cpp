@@ -4,7 +4,7 @@
 Map<int32, SongSelectIndex> LevelFilter::GetFiltered(const Map<int32, SongSelectIndex>& source)
 {
 	Map<int32, SongSelectIndex> filtered;
-	for (auto kvp : source)
+	for (const auto& kvp : source)
 	{
 		for (auto chart: kvp.second.GetCharts())
 		{
@@ -18,6 +18,11 @@ Map<int32, SongSelectIndex> LevelFilter::GetFiltered(const Map<int32, SongSelect
 	return filtered;
 }
 
+void LevelFilter::FilterCharts(const SongTable& table, BitSet& charts)
+{
+	charts &= table.GetLevelCharts(m_level);
+}
+
 String LevelFilter::GetName() const
 {
 	return Utility::Sprintf("Level: %d", m_level);
@@ -41,6 +46,11 @@ Map<int32, SongSelectIndex> FolderFilter::GetFiltered(const Map<int32, SongSelec
 	return filtered;
 }
 
+void FolderFilter::FilterCharts(const SongTable& table, BitSet& charts)
+{
+	table.SelectFolders(m_mapDatabase->FindFoldersByFolder(m_folder), charts);
+}
+
 String FolderFilter::GetName() const
 {
 	return "Folder: " + m_folder;
@@ -64,6 +74,11 @@ Map<int32, SongSelectIndex> CollectionFilter::GetFiltered(const Map<int32, SongS
 	return filtered;
 }
 
+void CollectionFilter::FilterCharts(const SongTable& table, BitSet& charts)
+{
+	table.SelectFolders(m_mapDatabase->FindFoldersByCollection(m_collection), charts);
+}
+
 String CollectionFilter::GetName() const
 {
 	return "Collection: " + m_collection;
@@ -77,7 +92,7 @@ bool CollectionFilter::IsAll() const
 Map<int32, ChallengeSelectIndex> ChallengeLevelFilter::GetFiltered(const Map<int32, ChallengeSelectIndex>& source)
 {
 	Map<int32, ChallengeSelectIndex> filtered;
-	for (auto kvp : source)
+	for (const auto& kvp : source)
 	{
 		const auto& chal = kvp.second.GetChallenge();
 		if (chal->level == m_level)
@@ -23,6 +23,7 @@
 #include "PreviewPlayer.hpp"
 #include "ItemSelectionWheel.hpp"
 #include "Audio/OffsetComputer.hpp"
+#include "Audio/OffsetAnalyzer.hpp"
 
 /*
 	Song preview player with fade-in/out
@@ -136,6 +137,9 @@ class SelectionWheel : public SongItemSelectionWheel
 	// Current difficulty index
 	int32 m_currentlySelectedDiff = 0;
 
+	// Sort keys and filter bitsets of all items
+	SongTable m_table;
+
 public:
 	SelectionWheel(IApplicationTickable* owner) : SongItemSelectionWheel(owner)
 	{
@@ -194,6 +198,8 @@ public:
 
 	void ResetLuaTables()
 	{
+		// Scores and clear marks might have changed
+		m_table.Invalidate();
 		const SortType sort = GetSortType();
 		if (sort == SortType::SCORE_ASC || sort == SortType::SCORE_DESC)
 			m_doSort();
@@ -313,26 +319,74 @@ public:
 
 	void OnItemsAdded(Vector<FolderIndex*> items) override
 	{
+		m_table.Invalidate();
 		SongItemSelectionWheel::OnItemsAdded(items);
 	}
 
 	void OnItemsRemoved(Vector<FolderIndex*> items) override
 	{
+		m_table.Invalidate();
 		SongItemSelectionWheel::OnItemsRemoved(items);
 	}
 
 	void OnItemsUpdated(Vector<FolderIndex*> items) override
 	{
+		m_table.Invalidate();
 		SongItemSelectionWheel::OnItemsUpdated(items);
 	}
 
 	void OnItemsCleared(Map<int32, FolderIndex*> newList) override
 	{
+		m_table.Invalidate();
 		SongItemSelectionWheel::OnItemsCleared(newList);
 	}
 
+	using SongItemSelectionWheel::SetFilter;
+	// Intersects the charts of every filter in the table instead of filtering copies of all items
+	void SetFilter(SongFilter* filter[2])
+	{
+		m_UpdateTable();
+		BitSet charts(m_table.GetNumCharts(), true);
+		bool isFiltered = false;
+		bool splitCharts = false;
+		for (size_t i = 0; i < 2; i++)
+		{
+			if (!filter[i] || filter[i]->IsAll())
+				continue;
+			filter[i]->FilterCharts(m_table, charts);
+			isFiltered = true;
+			// Level filters show single charts instead of folders
+			if (filter[i]->GetType() == FilterType::Level)
+				splitCharts = true;
+		}
+
+		m_itemFilter.clear();
+		if (isFiltered)
+			m_table.GetItems(charts, splitCharts, m_itemFilter);
+		m_filterSet = isFiltered;
+		m_OnFilterChanged();
+	}
+
 
 private:
+	void m_UpdateTable()
+	{
+		if (!m_table.IsValid())
+			m_table.Build(m_items);
+	}
+
+	void m_doSort() override
+	{
+		if (m_currentSort == nullptr)
+		{
+			Log("No sorting set", Logger::Severity::Warning);
+			return;
+		}
+		m_UpdateTable();
+		// Every sort of the song wheel is a SongSort
+		static_cast<SongSort*>(m_currentSort)->SortInplace(m_sortVec, m_table);
+	}
+
 	// grab the actual FolderIndex from a given selection
 	FolderIndex* m_getDBEntryFromItemIndex(const SongSelectIndex ind) const {
 		return ind.GetFolder();
@@ -401,7 +455,7 @@ private:
 			for (auto& mapIndex : m_sortVec)
 			{
 				// Grab the song for this sort index
-				SongSelectIndex song = collection.find(mapIndex)->second;
+				const SongSelectIndex& song = collection.find(mapIndex)->second;
 				m_PushSongToLua(song, ++songIndex);
 			}
 		}
@@ -416,7 +470,7 @@ private:
 		lua_setglobal(m_lua, "songwheel");
 	}
 
-	void m_PushSongToLua(SongSelectIndex song, int index)
+	void m_PushSongToLua(const SongSelectIndex& song, int index)
 	{
 		lua_pushinteger(m_lua, index);
 		lua_newtable(m_lua);
@@ -960,6 +1014,9 @@ private:
 	// Player of preview music
 	PreviewPlayer m_previewPlayer;
 
+	// Computes the offsets of the library while the song select is shown
+	OffsetAnalyzer m_offsetAnalyzer;
+
 	// Select sound
 	Sample m_selectSound;
 
@@ -1066,6 +1123,9 @@ public:
 		m_selectionWheel->OnItemsChanged.Add(m_filterSelection.get(), &FilterSelection::OnSongsChanged);
 		m_mapDatabase->StartSearching();
 
+		if (g_gameConfig.GetBool(GameConfigKeys::AutoComputeSongOffset))
+			m_offsetAnalyzer.Start(m_mapDatabase->FindChartsWithoutOffset());
+
 		m_filterSelection->SetFiltersByIndex(g_gameConfig.GetInt(GameConfigKeys::LevelFilter), g_gameConfig.GetInt(GameConfigKeys::FolderFilter));
 
 		//sort selection
@@ -1165,6 +1225,8 @@ public:
 	}
 	~SongSelect_Impl()
 	{
+		m_offsetAnalyzer.Stop();
+
 		// Clear callbacks
 		if (m_mapDatabase)
 		{
@@ -1584,6 +1646,7 @@ public:
 		if (m_dbUpdateTimer.Milliseconds() > 500)
 		{
 			m_mapDatabase->Update();
+			m_offsetAnalyzer.Update(*m_mapDatabase);
 			m_dbUpdateTimer.Restart();
 		}
 
@@ -1701,6 +1764,7 @@ public:
 		m_suspended = true;
 		m_previewPlayer.Pause();
 		m_mapDatabase->PauseSearching();
+		m_offsetAnalyzer.Pause();
 		if (m_lockMouse)
 			m_lockMouse.reset();
 	}
@@ -1714,6 +1778,7 @@ public:
 		m_mapDatabase->Update(); //flush pending db changes before setting lua tables
 		m_selectionWheel->ResetLuaTables();
 		m_mapDatabase->ResumeSearching();
+		m_offsetAnalyzer.Resume();
 		if (g_gameConfig.GetBool(GameConfigKeys::AutoResetSettings))
 		{
 			g_gameConfig.SetEnum<Enum_SpeedMods>(GameConfigKeys::SpeedMod, SpeedMods::XMod);
@@ -2,206 +2,45 @@
 #include "SongSort.hpp"
 #include "Shared/Profiling.hpp"
 
-const SongSelectIndex& getSongFromCollection(uint32 index, const Map<int32,
-	SongSelectIndex>& collection)
-{
-	auto it = collection.find(index);
-	if (it == collection.end())
-	{
-		Logf("Could not find song id %u", Logger::Severity::Error, index);
-	}
-	return it->second;
-}
-
-void TitleSort::SortInplace(Vector<uint32>& vec, const Map<int32, 
+void SongSort::SortInplace(Vector<uint32>& vec, const Map<int32,
 		SongSelectIndex>& collection)
 {
-	ProfilerScope $(Utility::Sprintf("Sort by: %s", m_name));
-	std::sort (vec.begin(), vec.end(),
-		[&](uint32 a, uint32 b) -> bool
-	{
-		const SongSelectIndex& song_a = getSongFromCollection(a, collection);
-		const SongSelectIndex& song_b = getSongFromCollection(b, collection);
-		bool res = CompareSongs(song_a, song_b);
-		return m_dir ? !res : res;
-	});
-}
-
-bool TitleSort::CompareSongs(const SongSelectIndex& song_a,
-		const SongSelectIndex& song_b)
-{
-	String a = song_a.GetCharts()[0]->title;
-	String b = song_b.GetCharts()[0]->title;
-	a.ToUpper();
-	b.ToUpper();
-	int strres = a.compare(b);
-	if (strres == 0)
-		return song_a.id < song_b.id;
-	return strres < 0;
+	SongTable table;
+	table.Build(collection);
+	SortInplace(vec, table);
 }
 
-void ScoreSort::SortInplace(Vector<uint32>& vec, const Map<int32, 
-		SongSelectIndex>& collection)
+void SongSort::SortInplace(Vector<uint32>& vec, const SongTable& table)
 {
 	ProfilerScope $(Utility::Sprintf("Sort by: %s", m_name));
-	m_scoreMap.clear();
-	for (uint32 mapIndex : vec)
-	{
-		const SongSelectIndex& song = getSongFromCollection(mapIndex, collection);
-		uint32 maxScore = 0;
-		for (auto& diff : song.GetCharts())
-		{
-			for (auto& score : diff->scores)
-			{
-				if (score->score < (int32)maxScore)
-					continue;
-				maxScore = score->score;
-			}
-		}
-		m_scoreMap[mapIndex] = maxScore;
-	}
-
-	std::sort (vec.begin(), vec.end(),
-		[&](uint32 a, uint32 b) -> bool
-	{
-		const uint32 score_a = m_scoreMap.find(a)->second;
-		const uint32 score_b = m_scoreMap.find(b)->second;
-
-		// For same scores sort by title
-		if (score_a == score_b) {
-			const SongSelectIndex& song_a = getSongFromCollection(a, collection);
-			const SongSelectIndex& song_b = getSongFromCollection(b, collection);
-			bool res = CompareSongs(song_a, song_b);
-			return res;
-		}
-		bool res = score_a < score_b;
-		return m_dir ? !res : res;
-	});
-
-	m_scoreMap.clear();
-}
-
-void DateSort::SortInplace(Vector<uint32>& vec, const Map<int32, 
-		SongSelectIndex>& collection)
-{
-	ProfilerScope $(Utility::Sprintf("Sort by: %s", m_name));
-	m_dateMap.clear();
-	for (uint32 mapIndex : vec)
-	{
-		const SongSelectIndex& song = getSongFromCollection(mapIndex, collection);
-		uint64 maxDate = 0;
-		for (auto& diff : song.GetCharts())
-		{
-			if (diff->lwt < maxDate)
-				continue;
-			maxDate = diff->lwt;
-		}
-		m_dateMap[mapIndex] = maxDate;
-	}
 
-	std::sort (vec.begin(), vec.end(),
-		[&](uint32 a, uint32 b) -> bool
-	{
-		const uint64 date_a = m_dateMap.find(a)->second;
-		const uint64 date_b = m_dateMap.find(b)->second;
-
-		// For same scores sort by title
-		if (date_a == date_b) {
-			const SongSelectIndex& song_a = getSongFromCollection(a, collection);
-			const SongSelectIndex& song_b = getSongFromCollection(b, collection);
-			bool res = CompareSongs(song_a, song_b);
-			return res;
-		}
-		bool res = date_a < date_b;
-		return m_dir ? !res : res;
-	});
-
-	m_dateMap.clear();
-}
-
-void ArtistSort::SortInplace(Vector<uint32>& vec, const Map<int32,
-	SongSelectIndex>& collection)
-{
-	std::sort (vec.begin(), vec.end(),
-		[&](uint32 ia, uint32 ib) -> bool
+	struct SortEntry
 	{
-		const SongSelectIndex& song_a = getSongFromCollection(ia, collection);
-		const SongSelectIndex& song_b = getSongFromCollection(ib, collection);
-
-		String a = song_a.GetCharts()[0]->artist;
-		String b = song_b.GetCharts()[0]->artist;
-		a.ToUpper();
-		b.ToUpper();
-		int strres = a.compare(b);
-		if (strres == 0)
-			return CompareSongs(song_a, song_b);
-
-		bool res = strres < 0;
-		return m_dir ? !res : res;
-	});
-}
-
-void EffectorSort::SortInplace(Vector<uint32>& vec, const Map<int32,
-	SongSelectIndex>& collection)
-{
-	std::sort (vec.begin(), vec.end(),
-		[&](uint32 ia, uint32 ib) -> bool
+		uint64 key;
+		uint64 title;
+		uint32 id;
+	};
+
+	// Gather the keys once so the comparisons don't need any lookups
+	const SongTable::Key key = m_GetKey();
+	Vector<SortEntry> entries;
+	entries.reserve(vec.size());
+	for (uint32 id : vec)
+		entries.push_back({ table.GetKey(key, id), table.GetKey(SongTable::Key::Title, id), id });
+
+	std::sort(entries.begin(), entries.end(),
+		[this](const SortEntry& a, const SortEntry& b) -> bool
 	{
-		const SongSelectIndex& song_a = getSongFromCollection(ia, collection);
-		const SongSelectIndex& song_b = getSongFromCollection(ib, collection);
-
-		String a = song_a.GetCharts()[0]->effector;
-		String b = song_b.GetCharts()[0]->effector;
-		a.ToUpper();
-		b.ToUpper();
-		int strres = a.compare(b);
-		if (strres == 0)
-			return CompareSongs(song_a, song_b);
-
-		bool res = strres < 0;
-		return m_dir ? !res : res;
-	});
-}
-
-void ClearMarkSort::SortInplace(Vector<uint32>& vec, const Map<int32, 
-		SongSelectIndex>& collection)
-{
-	ProfilerScope $(Utility::Sprintf("Sort by: %s", m_name));
-	m_clearMap.clear();
-	for (uint32 mapIndex : vec)
-	{
-		const SongSelectIndex& song = getSongFromCollection(mapIndex, collection);
-		ClearMark maxClear = ClearMark::NotPlayed;
-		for (auto& diff : song.GetCharts())
-		{
-			for (auto& score : diff->scores)
-			{
-				ClearMark smark = Scoring::CalculateBadge(*score);
-				if (smark > maxClear)
-					maxClear = smark;
-			}
-		}
-		m_clearMap[mapIndex] = static_cast<uint32>(maxClear);
-	}
-
-	std::sort (vec.begin(), vec.end(),
-		[&](uint32 a, uint32 b) -> bool
-	{
-		const uint32 score_a = m_clearMap.find(a)->second;
-		const uint32 score_b = m_clearMap.find(b)->second;
-
-		// For same scores sort by title
-		if (score_a == score_b) {
-			const SongSelectIndex& song_a = getSongFromCollection(a, collection);
-			const SongSelectIndex& song_b = getSongFromCollection(b, collection);
-			bool res = CompareSongs(song_a, song_b);
-			return res;
-		}
-		bool res = score_a < score_b;
-		return m_dir ? !res : res;
+		if (a.key != b.key)
+			return m_dir ? a.key > b.key : a.key < b.key;
+		// For same keys sort by title
+		if (a.title != b.title)
+			return a.title < b.title;
+		return a.id < b.id;
 	});
 
-	m_clearMap.clear();
+	for (size_t i = 0; i < entries.size(); i++)
+		vec[i] = entries[i].id;
 }
 
 
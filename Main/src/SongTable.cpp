@@ -0,0 +1,191 @@
+#include "stdafx.h"
+#include "SongTable.hpp"
+#include "Scoring.hpp"
+#include <Shared/Profiling.hpp>
+#include <algorithm>
+#include <numeric>
+
+// Replaces every string by its rank in the sorted list of distinct strings
+static void RankStrings(const Vector<String>& strings, Vector<uint32>& ranks)
+{
+	Vector<uint32> order(strings.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b)
+	{
+		return strings[a].compare(strings[b]) < 0;
+	});
+
+	ranks.resize(strings.size());
+	uint32 rank = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		if (i > 0 && strings[order[i]] != strings[order[i - 1]])
+			rank++;
+		ranks[order[i]] = rank;
+	}
+}
+
+static String UpperCase(const String& str)
+{
+	String res = str;
+	res.ToUpper();
+	return res;
+}
+
+void SongTable::Build(const Map<int32, SongSelectIndex>& items)
+{
+	ProfilerScope $("Build song table");
+
+	m_charts.clear();
+	m_chartFolder.clear();
+	m_chartScore.clear();
+	m_chartClearMark.clear();
+	m_chartDate.clear();
+	m_folders.clear();
+	m_folderFirstChart.clear();
+	m_folderNumCharts.clear();
+	m_folderScore.clear();
+	m_folderClearMark.clear();
+	m_folderDate.clear();
+	m_selectIdRows.clear();
+	m_folderIdRows.clear();
+
+	Vector<String> titles, artists, effectors;
+	for (const auto& it : items)
+	{
+		const SongSelectIndex& item = it.second;
+		const uint32 folderRow = (uint32)m_folders.size();
+		m_selectIdRows[item.id / 10] = folderRow;
+		m_folderIdRows[item.GetFolder()->id] = folderRow;
+		m_folders.push_back(item.GetFolder());
+		m_folderFirstChart.push_back((uint32)m_charts.size());
+		m_folderNumCharts.push_back((uint32)item.GetCharts().size());
+
+		int32 folderScore = 0;
+		uint8 folderClearMark = 0;
+		uint64 folderDate = 0;
+		for (ChartIndex* chart : item.GetCharts())
+		{
+			int32 score = 0;
+			for (const ScoreIndex* s : chart->scores)
+				score = Math::Max(score, s->score);
+			const uint8 clearMark = (uint8)Scoring::CalculateBestBadge(chart->scores);
+
+			m_charts.push_back(chart);
+			m_chartFolder.push_back(folderRow);
+			m_chartScore.push_back(score);
+			m_chartClearMark.push_back(clearMark);
+			m_chartDate.push_back(chart->lwt);
+			titles.push_back(UpperCase(chart->title));
+			artists.push_back(UpperCase(chart->artist));
+			effectors.push_back(UpperCase(chart->effector));
+
+			folderScore = Math::Max(folderScore, score);
+			folderClearMark = Math::Max(folderClearMark, clearMark);
+			folderDate = Math::Max(folderDate, chart->lwt);
+		}
+		m_folderScore.push_back(folderScore);
+		m_folderClearMark.push_back(folderClearMark);
+		m_folderDate.push_back(folderDate);
+	}
+
+	RankStrings(titles, m_chartTitle);
+	RankStrings(artists, m_chartArtist);
+	RankStrings(effectors, m_chartEffector);
+
+	m_levelCharts.clear();
+	m_noCharts = BitSet(m_charts.size());
+	for (size_t i = 0; i < m_charts.size(); i++)
+	{
+		const int32 level = m_charts[i]->level;
+		if (level < 0)
+			continue;
+		if ((size_t)level >= m_levelCharts.size())
+			m_levelCharts.resize(level + 1, m_noCharts);
+		m_levelCharts[level].Set(i);
+	}
+
+	m_valid = true;
+}
+
+int64 SongTable::m_GetChartRow(int32 itemId, uint32& folderRow) const
+{
+	auto it = m_selectIdRows.find(itemId / 10);
+	if (it == m_selectIdRows.end())
+		return -1;
+	folderRow = it->second;
+	const uint32 chart = itemId % 10 == 0 ? 0 : itemId % 10 - 1;
+	if (chart >= m_folderNumCharts[folderRow])
+		return -1;
+	return m_folderFirstChart[folderRow] + chart;
+}
+
+uint64 SongTable::GetKey(Key key, int32 itemId) const
+{
+	uint32 folderRow;
+	const int64 chartRow = m_GetChartRow(itemId, folderRow);
+	if (chartRow < 0)
+		return 0;
+
+	// Single charts use their own values, folders their best ones
+	const bool isFolder = itemId % 10 == 0;
+	switch (key)
+	{
+	case Key::Title:
+		return m_chartTitle[chartRow];
+	case Key::Artist:
+		return m_chartArtist[chartRow];
+	case Key::Effector:
+		return m_chartEffector[chartRow];
+	case Key::Score:
+		return (uint64)(isFolder ? m_folderScore[folderRow] : m_chartScore[chartRow]);
+	case Key::ClearMark:
+		return isFolder ? m_folderClearMark[folderRow] : m_chartClearMark[chartRow];
+	case Key::Date:
+		return isFolder ? m_folderDate[folderRow] : m_chartDate[chartRow];
+	}
+	return 0;
+}
+
+const BitSet& SongTable::GetLevelCharts(int32 level) const
+{
+	if (level < 0 || (size_t)level >= m_levelCharts.size())
+		return m_noCharts;
+	return m_levelCharts[level];
+}
+
+void SongTable::SelectFolders(const Map<int32, FolderIndex*>& folders, BitSet& charts) const
+{
+	BitSet selected(m_charts.size());
+	for (const auto& it : folders)
+	{
+		auto row = m_folderIdRows.find(it.first);
+		if (row == m_folderIdRows.end())
+			continue;
+		const uint32 first = m_folderFirstChart[row->second];
+		for (uint32 i = 0; i < m_folderNumCharts[row->second]; i++)
+			selected.Set(first + i);
+	}
+	charts &= selected;
+}
+
+void SongTable::GetItems(const BitSet& charts, bool splitCharts, Map<int32, SongSelectIndex>& items) const
+{
+	if (splitCharts)
+	{
+		charts.ForEach([&](size_t row)
+		{
+			SongSelectIndex index(m_folders[m_chartFolder[row]], m_charts[row]);
+			items.Add(index.id, index);
+		});
+		return;
+	}
+
+	for (size_t i = 0; i < m_folders.size(); i++)
+	{
+		if (!charts.Any(m_folderFirstChart[i], m_folderFirstChart[i] + m_folderNumCharts[i]))
+			continue;
+		SongSelectIndex index(m_folders[i]);
+		items.Add(index.id, index);
+	}
+}
@@ -8,22 +8,11 @@
 
 TCPSocket::TCPSocket()
 {
-	m_open = false;
-	m_socket = INVALID_SOCKET;
-
-#ifdef _WIN32
-	// Startup winsock
-	WSADATA wsa_data;
-	if (WSAStartup(MAKEWORD(1, 1), &wsa_data) != 0)
-	{
-		Logf("[Socket] Unable to start winsock!", Logger::Severity::Error);
-	}
-#endif
 }
 
 TCPSocket::~TCPSocket()
 {
-	if (m_open)
+	if (IsOpen())
 		Close();
 
 	// Clear bound states
@@ -32,17 +21,12 @@ TCPSocket::~TCPSocket()
 		delete s.second;
 	}
 	m_boundStates.clear();
-
-#ifdef _WIN32
-	// Clean up winsock
-	WSACleanup();
-#endif
 }
 
 // Connect this TCP socket to a given host and port
 bool TCPSocket::Connect(String host)
 {
-	if (m_open)
+	if (IsOpen())
 		return false;
 
 	size_t port_index = host.find_first_of(":");
@@ -52,41 +36,7 @@ bool TCPSocket::Connect(String host)
 
 	Logf("[Socket] Connecting to %s:%s", Logger::Severity::Info, host.c_str(), port.c_str());
 
-	struct addrinfo* result = nullptr;
-	struct addrinfo* ptr = nullptr;
-	struct addrinfo hints;
-	memset(&hints, 0, sizeof(hints));
-
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-
-
-	// Resolve the ip of the host
-	int res = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
-	if (res != 0)
-	{
-		Logf("[Socket] Unable to resolve address %s:%s %d", Logger::Severity::Error, host.c_str(), port.c_str(), res);
-		return false;
-	}
-
-	// Create a TCP socket
-	m_socket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-	if (invalid_socket(m_socket))
-	{
-		Logf("[Socket] Unable to create socket to address %s port %s", Logger::Severity::Error, host.c_str(), port.c_str());
-		return false;
-	}
-
-	// Try to connect to host (blocking)
-	if (connect(m_socket, result->ai_addr, (int)result->ai_addrlen) != 0)
-	{
-		Logf("[Socket] Unable to connect to address %s port %s", Logger::Severity::Error, host.c_str(), port.c_str());
-		return false;
-	}
-
-	m_open = true;
-	return true;
+	return m_connection.Connect(host, port);
 }
 
 
@@ -95,7 +45,7 @@ int TCPSocket::lConnect(struct lua_State* L)
 {
 	String host = luaL_checkstring(L, 2);
 
-	if (m_open)
+	if (IsOpen())
 	{
 		lua_pushboolean(L, false);
 		return 1;
@@ -119,14 +69,8 @@ int TCPSocket::lSendLine(struct lua_State* L)
 // Send a line of data to the socket
 void TCPSocket::SendLine(String data)
 {
-	// For now send a 0 to say it is line deliniated
-	char zeroByte = (char)TCPPacketMode::JSON_LINE;
-	send(m_socket, (char*)& zeroByte, 1, 0);
-
-	send(m_socket, data.c_str(), data.length(), 0);
-
-	char new_line = '\n';
-	send(m_socket, (char*)& new_line, 1, 0);
+	// Queued and written by the connection's I/O thread
+	m_connection.Send(TCPPacketMode::JSON_LINE, data.c_str(), data.length());
 }
 
 // Send a JSON packet to the server
@@ -135,58 +79,29 @@ void TCPSocket::SendJSON(nlohmann::json packet)
 	SendLine(packet.dump());
 }
 
+// Send a binary packet to the server
+void TCPSocket::SendBinary(const Buffer& packet)
+{
+	m_connection.Send(TCPPacketMode::BINARY, (const char*)packet.data(), packet.size());
+}
+
 // Lua function to close the socket
 int TCPSocket::lClose(struct lua_State* L)
 {
-	if (!m_open)
+	if (!IsOpen())
 		return 0;
 	Close();
 	return 0;
 }
 
-// Check if the socket is ready to read using select
-bool TCPSocket::m_readyToRead()
-{
-	if (!m_open)
-		return false;
-
-	fd_set fds;
-	FD_ZERO(&fds);
-	FD_SET(m_socket, &fds);
-
-	// Non blocking time
-	timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
-	return select(m_socket + 1, &fds, 0, 0, &tv) == 1;
-}
-
 // Close the socket if it is open
 void TCPSocket::Close()
 {
-	if (!m_open)
+	if (!IsOpen())
 		return;
 
-	int status = 0;
-#ifdef _WIN32
-	status = shutdown(m_socket, SD_BOTH);
-	if (status == 0) { status = closesocket(m_socket); }
-#else
-	status = shutdown(m_socket, SHUT_RDWR);
-	if (status == 0) { status = close(m_socket); }
-#endif
-
-	m_open = false;
-
-	// Reset buffering
-	if (m_dataBuff)
-	{
-		free(m_dataBuff);
-		m_dataBuff = nullptr;
-	}
-	m_dataLength = 0;
-	m_amountRead = 0;
-	m_readingMode = TCPPacketMode::NOT_READING;
+	m_connection.Close();
+	m_packets.clear();
 
 	Log("[Socket] Socket closed", Logger::Severity::Info);
 
@@ -197,18 +112,27 @@ void TCPSocket::Close()
 }
 
 
-void TCPSocket::m_processPacket(char* ptr, size_t length, TCPPacketMode mode)
+void TCPSocket::m_processPacket(const TCPPacket& packet)
 {
-	String packetData = String(ptr, length);
-	if (mode != TCPPacketMode::JSON_LINE)
+	if (packet.mode == TCPPacketMode::BINARY)
+	{
+		MultiplayerProtocol::BinaryTopic topic = MultiplayerProtocol::GetTopic(packet.data);
+		if (m_binaryHandlers.Contains(topic))
+			m_binaryHandlers[topic]->Call(packet.data);
+		else
+			Logf("[Socket] No handler for binary topic %u", Logger::Severity::Warning, (uint8)topic);
+		return;
+	}
+
+	if (packet.mode != TCPPacketMode::JSON_LINE)
 	{
-		Logf("[Socket] Could not handle packet with mode %u", Logger::Severity::Error, mode);
+		Logf("[Socket] Could not handle packet with mode %u", Logger::Severity::Error, packet.mode);
 		return;
 	}
 
 	// TODO(itszn) Line handler callback?
 
-	auto jsonPacket = nlohmann::json::parse(packetData);
+	auto jsonPacket = nlohmann::json::parse(packet.data);
 
 	// TODO(itszn) Raw json handler callback?
 
@@ -234,20 +158,26 @@ void TCPSocket::m_processPacket(char* ptr, size_t length, TCPPacketMode mode)
 	}
 
 	// Call any lua topic handlers
-	if (m_luaTopicHandlers.find(topic) != m_luaTopicHandlers.end())
+	CallLuaTopicHandler(topic, [&](lua_State* L) { PushJsonObject(L, jsonPacket); });
+}
+
+void TCPSocket::CallLuaTopicHandler(const String& topic, std::function<void(lua_State*)> push)
+{
+	auto it = m_luaTopicHandlers.find(topic);
+	if (it == m_luaTopicHandlers.end())
+		return;
+
+	LuaTCPHandler* handler = it->second;
+	if (!m_boundStates.Contains(handler->L))
+		return;
+
+	lua_rawgeti(handler->L, LUA_REGISTRYINDEX, handler->callback);
+	push(handler->L);
+	if (lua_pcall(handler->L, 1, 0, 0) != 0)
 	{
-		LuaTCPHandler* handler = m_luaTopicHandlers[topic];
-		if (m_boundStates.Contains(handler->L))
-		{
-			lua_rawgeti(handler->L, LUA_REGISTRYINDEX, handler->callback);
-			PushJsonObject(handler->L, jsonPacket);
-			if (lua_pcall(handler->L, 1, 0, 0) != 0)
-			{
-				Logf("[Socket] Lua error on calling TCP handler: %s", Logger::Severity::Error, lua_tostring(handler->L, -1));
-			}
-			lua_settop(handler->L, 0);
-		}
+		Logf("[Socket] Lua error on calling TCP handler: %s", Logger::Severity::Error, lua_tostring(handler->L, -1));
 	}
+	lua_settop(handler->L, 0);
 }
 
 // Push a single json value as a lua table
@@ -313,163 +243,25 @@ void TCPSocket::PushJsonObject(lua_State* L, const nlohmann::json& packet)
 	}
 }
 
-// Buffer data from the socket and try to read packets out of it
+// Handle the packets received by the I/O thread since the last update
 void TCPSocket::ProcessSocket()
 {
-	if (!m_open)
+	if (!IsOpen())
 		return;
 
-	// This is the case where we don't have any data in the buffer
-	if (m_readingMode == TCPPacketMode::NOT_READING)
+	m_connection.Receive(m_packets);
+	for (size_t i = 0; i < m_packets.size(); i++)
 	{
-		// If we for some reason are still not reading yet we have stuff in the buffer
-		// then our state is bad (server sent a packet we couldn't understand)
-		if (m_amountRead != 0)
-		{
-			Close();
-			return;
-		}
-
-		if (!m_readyToRead())
-			return;
-		
-		// Get a byte to indicate the packet type
-		unsigned char mode;
-		if (recv(m_socket, (char*)&mode, 1, 0) <= 0)
-		{
-			Close();
-			return;
-		}
-
-		m_readingMode = static_cast<TCPPacketMode>(
-			std::min(mode, (unsigned char)TCPPacketMode::UNKNOWN));
-
-		// Create the buffer if it doesn't exist
-		if (m_dataBuff == nullptr)
-		{
-			m_dataLength = 4096;
-			m_amountRead = 0;
-			m_dataBuff = (char*)malloc(m_dataLength + 1); // Plus one for potential null byte
-		}
-
-		if (!m_readyToRead())
+		m_processPacket(m_packets[i]);
+		// A handler might have closed the socket
+		if (!IsOpen())
 			return;
 	}
+	m_packets.clear();
 
-	// We don't know the kind of packet this is so bail on the stream
-	if (m_readingMode == TCPPacketMode::UNKNOWN)
-	{
+	// Connection lost or the server sent a packet we couldn't understand
+	if (m_connection.IsClosed())
 		Close();
-		return;
-	}
-
-	// We will start reading into the buffer and try to parse at least one packet
-	// We may parse more packets if they happen to have been buffered in
-	while (m_readyToRead() && m_readingMode != TCPPacketMode::NOT_READING)
-	{
-		// Fill up the buffer as much as we can
-		int newRead = recv(m_socket, m_dataBuff + m_amountRead,
-			std::min(m_dataLength - m_amountRead, 4096u), 0);
-
-		if (newRead <= 0)
-		{
-			Close();
-			return;
-		}
-
-		// First packet scan only looks at the new data
-		uint32 newDataStart = m_amountRead;
-
-		// Update total amount read
-		m_amountRead += newRead;
-		
-		// Parse out any packets in the buffer currently
-		while (m_readingMode != TCPPacketMode::NOT_READING)
-		{
-			if (m_readingMode == TCPPacketMode::JSON_LINE)
-			{
-				// Scan the new bytes for line break
-				uint32 tokenIndex;
-				for (tokenIndex = newDataStart;
-					tokenIndex < m_amountRead && m_dataBuff[tokenIndex] != '\n'; tokenIndex++);
-
-				if (tokenIndex < m_amountRead)
-				{
-					// We have a valid packet in the buffer
-
-					// Replace newline with null terminator
-					m_dataBuff[tokenIndex] = '\0';
-
-					m_processPacket(m_dataBuff, tokenIndex, m_readingMode);
-
-					// Check if we can have an extra byte in the buffer to start next packet
-					if (tokenIndex + 1 < m_amountRead)
-					{
-						unsigned char mode = m_dataBuff[++tokenIndex];
-						m_readingMode = static_cast<TCPPacketMode>(
-							std::min(mode, (unsigned char)TCPPacketMode::UNKNOWN));
-					}
-					else
-					{
-						// In this case we used up the whole buffer, so wait for next recv
-						m_readingMode = TCPPacketMode::NOT_READING;
-					}
-
-					// Clear out used data from buffer
-					m_eraseBuffer(tokenIndex + 1);
-
-					// Next packet scan will begin at the start
-					newDataStart = 0;
-					continue;
-				}
-
-				// There is no complete packet in the buffer currently, so stop scanning
-				break;
-			}
-
-			// If we hit a bad packet, bail
-			else if (m_readingMode == TCPPacketMode::UNKNOWN)
-			{
-				Close();
-				return;
-			}
-			
-		}
-
-		// Check if we need to expand the buffer
-		if (m_amountRead >= m_dataLength)
-		{
-			m_dataLength *= 2;
-
-			// Some max limit incase we have bad data coming to us
-			if (m_dataLength > 0x1000000)
-			{
-				Close();
-				return;
-			}
-
-			// Resize the buffer
-			m_dataBuff = (char*)realloc(m_dataBuff, m_dataLength + 1);
-		}
-	}
-}
-
-// This erases the data in the buffer up to start
-void TCPSocket::m_eraseBuffer(size_t end)
-{
-	// Copy data to start of buffer
-	m_amountRead -= end;
-	memmove(m_dataBuff, m_dataBuff + end, m_amountRead);
-
-	// Find the new smallest buffer size to contain the data
-	// Should always be less than 4096 but check to be safe
-	for (m_dataLength = 4096; m_dataLength < m_amountRead; m_dataLength *= 2);
-
-	// Resize buffer to new buffer size
-	char* new_dataBuff = static_cast<char*>(realloc(m_dataBuff, m_dataLength + 1));
-	if (!new_dataBuff)
-		free(m_dataBuff);
-	m_dataBuff = new_dataBuff;
 }
 
 void TCPSocket::PushFunctions(lua_State* L)
@@ -5,6 +5,7 @@
 #include "Track.hpp"
 #include "LaserTrackBuilder.hpp"
 #include "AsyncAssetLoader.hpp"
+#include <Shared/Profiling.hpp>
 #include <unordered_set>
 
 const float Track::trackWidth = 1.0f;
@@ -29,6 +30,7 @@ Track::~Track()
 	delete loader;
 	for (auto & i : m_laserTrackBuilder)
 		delete i;
+	delete m_laserViewDistance;
 	for (auto & m_hitEffect : m_hitEffects)
 		delete m_hitEffect;
 	delete timedHitEffect;
@@ -259,6 +261,25 @@ bool Track::AsyncFinalize()
 
 	return success;
 }
+void Track::BakeLasers(class BeatmapPlayback& playback)
+{
+	ProfilerScope $("Bake lasers");
+
+	if (!m_laserViewDistance)
+		m_laserViewDistance = new ViewDistanceCurve();
+	m_laserViewDistance->Build(playback);
+	size_t numLasers = 0;
+	size_t numChunks = 0;
+	for (auto & i : m_laserTrackBuilder)
+	{
+		i->Bake(playback, *m_laserViewDistance);
+		numLasers += i->GetNumBakedLasers();
+		numChunks += i->GetNumBakedChunks();
+	}
+	// Without baking every segment creates a mesh for its body and tails when it comes into view
+	Logf("Baked %d laser segments into %d meshes", Logger::Severity::Info, numLasers, numChunks);
+}
+
 void Track::Tick(class BeatmapPlayback& playback, float deltaTime)
 {
 	const TimingPoint& currentTimingPoint = playback.GetCurrentTimingPoint();
@@ -375,15 +396,25 @@ void Track::DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, cons
 		if ((laser->flags & LaserObjectState::flag_Extended) != 0 || m_trackHide > 0.f)
 		{
 			// Calculate height based on time on current track
-			float viewRange = GetViewRange();
-			float position = playback.TimeToViewDistance(obj->time);
 			float posmult = trackLength / (m_viewRange * laserSpeedOffset);
 
-			Mesh laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
-
 			MaterialParameterSet laserParams;
 			laserParams.SetParameter("mainTex", laserTextures[laser->index]);
 
+			const LaserTrackBuilder::BakedLaser* baked = m_laserTrackBuilder[laser->index]->GetBaked(laser);
+			if (baked)
+			{
+				float position = (float)(baked->body.viewDistance - m_laserViewDistance->Evaluate(playback.GetLastTime()));
+				Transform laserTransform = trackOrigin;
+				laserTransform *= Transform::Translation(Vector3{ 0.0f, posmult * position, 0.0f });
+				laserTransform *= Transform::Scale({ 1.0f, posmult, 1.0f });
+				rq.DrawRange(laserTransform, baked->body.mesh, baked->body.firstVertex, baked->body.vertexCount, blackLaserMaterial, laserParams);
+				continue;
+			}
+
+			float position = playback.TimeToViewDistance(obj->time);
+			Mesh laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
+
 			// Get the length of this laser segment
 			Transform laserTransform = trackOrigin;
 			laserTransform *= Transform::Translation(Vector3{ 0.0f, posmult * position, 0.0f });
@@ -541,16 +572,16 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 	}
 	else if(obj->type == ObjectType::Laser) // Draw laser
 	{
-		position = playback.TimeToViewDistance(obj->time);
 		float posmult = trackLength / (m_viewRange * laserSpeedOffset);
 		LaserObjectState* laser = (LaserObjectState*)obj;
 
-		// Draw segment function
-		auto DrawSegment = [&](Mesh mesh, Texture texture, int part)
+		// Draw segment function, meshes with a vertexCount of 0 are drawn whole
+		// lengthScale stretches meshes that were generated without the current laser length scale
+		auto DrawSegment = [&](Mesh mesh, size_t firstVertex, size_t vertexCount, float segmentPosition, float lengthScale, Texture texture, int part)
 		{
 			MaterialParameterSet laserParams;
-			laserParams.SetParameter("trackPos", posmult * position / trackLength);
-			laserParams.SetParameter("trackScale", 1.0f / trackLength);
+			laserParams.SetParameter("trackPos", posmult * segmentPosition / trackLength);
+			laserParams.SetParameter("trackScale", lengthScale / trackLength);
 			laserParams.SetParameter("hiddenCutoff", hiddenCutoff); // Hidden cutoff (% of track)
 			laserParams.SetParameter("hiddenFadeWindow", hiddenFadewindow); // Hidden cutoff (% of track)
 			laserParams.SetParameter("suddenCutoff", suddenCutoff); // Hidden cutoff (% of track)
@@ -572,34 +603,58 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 
 			// Get the length of this laser segment
 			Transform laserTransform = trackOrigin;
-			laserTransform *= Transform::Translation(Vector3{ 0.0f, posmult * position,
+			laserTransform *= Transform::Translation(Vector3{ 0.0f, posmult * segmentPosition,
 				0.0f });
+			if (lengthScale != 1.0f)
+				laserTransform *= Transform::Scale({ 1.0f, lengthScale, 1.0f });
 
 			// Set laser color
 			laserParams.SetParameter("color", laserColors[laser->index]);
 
 			if(mesh)
 			{
-				rq.Draw(laserTransform, mesh, laserMaterial, laserParams);
+				rq.DrawRange(laserTransform, mesh, firstVertex, vertexCount, laserMaterial, laserParams);
 			}
 		};
 
+		// Only draw exit on slams
+		const bool drawExit = !laser->next && (laser->flags & LaserObjectState::flag_Instant) != 0;
+
+		const LaserTrackBuilder::BakedLaser* baked = m_laserTrackBuilder[laser->index]->GetBaked(laser);
+		if (baked)
+		{
+			const double now = m_laserViewDistance->Evaluate(playback.GetLastTime());
+			auto DrawBaked = [&](const LaserTrackBuilder::BakedMesh& part, float lengthScale, Texture texture, int partIndex)
+			{
+				DrawSegment(part.mesh, part.firstVertex, part.vertexCount, (float)(part.viewDistance - now), lengthScale, texture, partIndex);
+			};
+
+			if (!laser->prev)
+				DrawBaked(baked->entry, 1.0f, laserTailTextures[laser->index], 1);
+			DrawBaked(baked->body, posmult, laserTextures[laser->index], 0);
+			if (drawExit)
+				DrawBaked(baked->exit, 1.0f, laserTailTextures[2 + laser->index], 2);
+			return;
+		}
+
+		position = playback.TimeToViewDistance(obj->time);
+
 		// Draw entry?
 		if(!laser->prev)
 		{
 			Mesh laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackEntry(playback, laser);
-			DrawSegment(laserTail, laserTailTextures[laser->index], 1);
+			DrawSegment(laserTail, 0, 0, position, 1.0f, laserTailTextures[laser->index], 1);
 		}
 
 		// Body
 		Mesh laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
-		DrawSegment(laserMesh, laserTextures[laser->index], 0);
+		DrawSegment(laserMesh, 0, 0, position, 1.0f, laserTextures[laser->index], 0);
 
 		// Draw exit?
-		if(!laser->next && (laser->flags & LaserObjectState::flag_Instant) != 0) // Only draw exit on slams
+		if(drawExit)
 		{
 			Mesh laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackExit(playback, laser);
-			DrawSegment(laserTail, laserTailTextures[2 + laser->index], 2);
+			DrawSegment(laserTail, 0, 0, position, 1.0f, laserTailTextures[2 + laser->index], 2);
 		}
 	}
 }
@@ -757,7 +812,7 @@ void Track::SetViewRange(float newRange)
 		m_laserTrackBuilder[0]->laserLengthScale = newLaserLengthScale;
 		m_laserTrackBuilder[1]->laserLengthScale = newLaserLengthScale;
 
-		// Reset laser tracks cause these won't be correct anymore
+		// Reset laser tracks cause these won't be correct anymore, baked lasers are scaled when drawn
 		m_laserTrackBuilder[0]->Reset();
 		m_laserTrackBuilder[1]->Reset();
 	}
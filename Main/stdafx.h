@@ -45,6 +45,8 @@
 #include <Graphics/Image.hpp>
 #include <Graphics/ImageLoader.hpp>
 #include <Graphics/Texture.hpp>
+#include <Graphics/RenderTarget.hpp>
+#include <Graphics/RenderTargetGraph.hpp>
 #include <Graphics/Material.hpp>
 #include <Graphics/Mesh.hpp>
 #include <Graphics/RenderQueue.hpp>
@@ -0,0 +1,138 @@
+#pragma once
+#include "Shared/Vector.hpp"
+#include "Shared/Math.hpp"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+	Dynamically sized set of bits stored in 64 bit words
+	used to combine large selections with plain word operations instead of looking up every element
+*/
+class BitSet
+{
+public:
+	BitSet() = default;
+	BitSet(size_t size, bool value = false)
+	{
+		Resize(size, value);
+	}
+
+	// Resizes the set, new bits get the given value
+	void Resize(size_t size, bool value = false)
+	{
+		const size_t oldSize = m_size;
+		m_size = size;
+		m_words.resize((size + 63) / 64, 0);
+		if (value)
+		{
+			for (size_t i = oldSize; i < size && (i & 63) != 0; i++)
+				Set(i);
+			for (size_t i = (oldSize + 63) / 64; i < m_words.size(); i++)
+				m_words[i] = ~(uint64)0;
+		}
+		m_ClearUnused();
+	}
+
+	void Set(size_t index) { m_words[index >> 6] |= (uint64)1 << (index & 63); }
+	void Reset(size_t index) { m_words[index >> 6] &= ~((uint64)1 << (index & 63)); }
+	bool IsSet(size_t index) const { return (m_words[index >> 6] >> (index & 63)) & 1; }
+
+	void SetAll()
+	{
+		for (uint64& w : m_words)
+			w = ~(uint64)0;
+		m_ClearUnused();
+	}
+	void ResetAll()
+	{
+		for (uint64& w : m_words)
+			w = 0;
+	}
+
+	// Keeps only bits that are also set in other, both sets must have the same size
+	BitSet& operator&=(const BitSet& other)
+	{
+		assert(other.m_size == m_size);
+		for (size_t i = 0; i < m_words.size(); i++)
+			m_words[i] &= other.m_words[i];
+		return *this;
+	}
+	BitSet& operator|=(const BitSet& other)
+	{
+		assert(other.m_size == m_size);
+		for (size_t i = 0; i < m_words.size(); i++)
+			m_words[i] |= other.m_words[i];
+		return *this;
+	}
+
+	// Checks if any bit in the range [begin, end) is set
+	bool Any(size_t begin, size_t end) const
+	{
+		while (begin < end)
+		{
+			const size_t word = begin >> 6;
+			const size_t wordEnd = Math::Min<size_t>(end, (word + 1) * 64);
+			uint64 mask = ~(uint64)0 << (begin & 63);
+			const size_t endBit = wordEnd - word * 64;
+			if (endBit < 64)
+				mask &= ((uint64)1 << endBit) - 1;
+			if (m_words[word] & mask)
+				return true;
+			begin = wordEnd;
+		}
+		return false;
+	}
+
+	// Number of set bits
+	size_t Count() const
+	{
+		size_t count = 0;
+		for (uint64 w : m_words)
+		{
+			w = w - ((w >> 1) & 0x5555555555555555ull);
+			w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+			w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+			count += (size_t)((w * 0x0101010101010101ull) >> 56);
+		}
+		return count;
+	}
+
+	// Calls func with the index of every set bit in ascending order
+	template<typename F>
+	void ForEach(F&& func) const
+	{
+		for (size_t i = 0; i < m_words.size(); i++)
+		{
+			uint64 w = m_words[i];
+			while (w != 0)
+			{
+				func(i * 64 + m_LowestBit(w));
+				w &= w - 1;
+			}
+		}
+	}
+
+	size_t size() const { return m_size; }
+
+private:
+	static uint32 m_LowestBit(uint64 w)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, w);
+		return (uint32)index;
+#else
+		return (uint32)__builtin_ctzll(w);
+#endif
+	}
+	// Bits past the size are always kept 0
+	void m_ClearUnused()
+	{
+		if (m_size & 63)
+			m_words.back() &= ~(~(uint64)0 << (m_size & 63));
+	}
+
+	Vector<uint64> m_words;
+	size_t m_size = 0;
+};
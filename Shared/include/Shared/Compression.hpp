@@ -0,0 +1,13 @@
+#pragma once
+#include "Shared/Buffer.hpp"
+
+/*
+	Deflate (zlib) compression of memory buffers
+*/
+namespace Compression
+{
+	// Compresses the input into out, level ranges from 1 (fastest) to 9 (smallest)
+	bool Deflate(const Buffer& in, Buffer& out, int32 level = 6);
+	// Decompresses the input into out, the size of the uncompressed data needs to be known
+	bool Inflate(const Buffer& in, Buffer& out, size_t uncompressedSize);
+}
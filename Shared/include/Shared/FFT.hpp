@@ -0,0 +1,20 @@
+#pragma once
+#include "Shared/Vector.hpp"
+#include <complex>
+
+/*
+	Radix-2 fast fourier transform and the correlation of real signals built on it
+*/
+namespace FFT
+{
+	// Smallest power of two that is at least size
+	size_t GetSize(size_t size);
+
+	// In place transform, the size of data must be a power of two. The inverse transform is not scaled
+	void Transform(Vector<std::complex<double>>& data, bool inverse = false);
+
+	// Correlation of a and b for every lag from -(a.size() - 1) to b.size() - 1:
+	//	out[lag + a.size() - 1] = sum of a[t] * b[t + lag]
+	// costs O(n log n) instead of O(a.size() * b.size())
+	void CrossCorrelate(const Vector<float>& a, const Vector<float>& b, Vector<float>& out);
+}
@@ -24,12 +24,18 @@ public:
 	size_t GetSize() const;
 	size_t Read(void* data, size_t len);
 	size_t Write(const void* data, size_t len);
+	// Cuts the file off at the given size, the position is moved to the new end
+	bool Truncate(size_t size);
 
 	// Get the last write time of the file
 	uint64 GetLastWriteTime() const;
 
 	// Get the last write time of a file at a given path
 	static uint64 GetLastWriteTime(const String& path);
+
+	// Reads a whole file into memory, for files that can be rewritten while they are in use
+	//	(a MappedFile would fault when such a file is truncated)
+	static bool ReadAll(const String& path, Buffer& out);
 };
 
 /* 
@@ -4,12 +4,14 @@
 // File API
 #include "Path.hpp"
 #include "File.hpp"
+#include "MappedFile.hpp"
 
 // Binary Streams
 #include "Buffer.hpp"
 #include "BinaryStream.hpp"
 #include "MemoryStream.hpp"
 #include "FileStream.hpp"
+#include "MappedStream.hpp"
 
 // Text layer above binary streams
 #include "TextStream.hpp"
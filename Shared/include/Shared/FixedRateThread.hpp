@@ -0,0 +1,58 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+/*
+	Thread that calls a step function at a fixed rate, no matter how long frames on other threads take
+
+	Every step gets its index and the time it was scheduled at, steps that were missed because the thread didn't get scheduled in time
+	are run back to back. If the thread falls behind by more than MaxCatchUp steps the missed steps are skipped and counted as dropped
+*/
+class FixedRateThread : public Unique
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	typedef std::function<Clock::time_point()> NowFunction;
+	typedef std::function<void(Clock::time_point)> SleepFunction;
+	// Time is the time the step was scheduled at in seconds since Start
+	typedef std::function<void(uint64 step, double time)> StepFunction;
+
+	FixedRateThread(const char* name = "Fixed rate");
+	~FixedRateThread();
+
+	void Start(uint32 rate, StepFunction&& function);
+	// Waits for the running step to finish
+	void Stop();
+	bool IsRunning() const { return m_thread.joinable(); }
+	// True when called from inside the step function
+	bool IsCurrentThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+	uint32 GetRate() const { return m_rate; }
+	uint64 GetNumSteps() const { return m_numSteps; }
+	uint64 GetNumDroppedSteps() const { return m_numDroppedSteps; }
+
+	// Replaces the clock and the sleep of the thread, so tests can run it on simulated time
+	//	empty functions restore the real ones, only call this while the thread is stopped
+	void SetClock(NowFunction now, SleepFunction sleepUntil);
+
+	static const uint32 MaxCatchUp = 100;
+
+private:
+	void m_Run();
+	Clock::time_point m_Now() const;
+	void m_SleepUntil(Clock::time_point time);
+
+	String m_name;
+	std::thread m_thread;
+	std::atomic<bool> m_stop{ false };
+	StepFunction m_function;
+	NowFunction m_now;
+	SleepFunction m_sleepUntil;
+	uint32 m_rate = 0;
+	std::atomic<uint64> m_numSteps{ 0 };
+	std::atomic<uint64> m_numDroppedSteps{ 0 };
+};
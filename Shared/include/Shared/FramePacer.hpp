@@ -0,0 +1,82 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include <chrono>
+#include <functional>
+
+/*
+	Limits the frame rate of a render loop by waiting for absolute frame deadlines
+
+	Waiting sleeps until shortly before the deadline and spins the rest, the time left for spinning is the largest oversleep
+	that was measured recently, so the spin stays short on systems with precise timers without missing deadlines on others.
+
+	In just in time mode the wait happens before the frame instead of after it, BeginFrame sleeps until the predicted work
+	time before the deadline so input is sampled as late as possible and the frame is presented right after it is done
+*/
+class FramePacer : public Unique
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	typedef std::function<Clock::time_point()> NowFunction;
+	typedef std::function<void(Clock::time_point)> SleepFunction;
+
+	enum class Mode
+	{
+		// Wait after the frame is done, before presenting it
+		Normal,
+		// Wait before input is sampled
+		JustInTime,
+	};
+
+	struct Stats
+	{
+		uint64 numFrames = 0;
+		// Frames that were done after their deadline
+		uint64 numLateFrames = 0;
+		// Time spent sleeping and spinning in seconds
+		double sleepTime = 0.0;
+		double spinTime = 0.0;
+		// Largest recent oversleep, this is how early the pacer wakes up
+		double sleepSlack = 0.0005;
+		// Predicted time between BeginFrame and EndFrame in seconds
+		double workEstimate = 0.0;
+	};
+
+	// No limit when fps is 0 or less
+	void SetTarget(int32 fps, Mode mode = Mode::Normal);
+	int32 GetTargetFPS() const { return m_fps; }
+	Mode GetMode() const { return m_mode; }
+
+	// Call before input is sampled
+	void BeginFrame();
+	// Call right before the frame is presented
+	void EndFrame();
+
+	// Seconds until the deadline of the current frame, 0 if there is no limit or the deadline has passed
+	double GetTimeLeft() const;
+
+	// Sleeps until the given time, wakes up early by the sleep slack and spins the rest
+	void SleepUntil(Clock::time_point time);
+
+	const Stats& GetStats() const { return m_stats; }
+
+	// Sleeps until at most the given time using the most precise timer of the platform
+	static void PlatformSleepUntil(Clock::time_point time);
+
+	// Replaces the clock and the platform sleep, so tests can run the pacer on simulated time
+	//	empty functions restore the real ones
+	void SetClock(NowFunction now, SleepFunction sleepUntil);
+
+private:
+	Clock::time_point m_Now() const;
+	void m_PlatformSleepUntil(Clock::time_point time);
+
+	NowFunction m_now;
+	SleepFunction m_sleepUntil;
+	int32 m_fps = 0;
+	Mode m_mode = Mode::Normal;
+	Clock::duration m_period = Clock::duration::zero();
+	Clock::time_point m_deadline;
+	Clock::time_point m_frameStart;
+	bool m_hasDeadline = false;
+	Stats m_stats;
+};
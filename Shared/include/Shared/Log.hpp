@@ -4,11 +4,16 @@
 #include "Shared/Enum.hpp"
 #include "Shared/String.hpp"
 #include "Shared/Unique.hpp"
+#include <atomic>
 
 /* 
 	Logging utility class
 	formats loggin messages with time stamps and module names
 	allows message coloring on platforms that support it
+
+	Messages are formatted on the calling thread and pushed to a lock-free queue,
+	a background thread writes them to the console and the log file in batches
+	so logging never blocks on I/O
 */
 
 
@@ -45,7 +50,8 @@ public:
 	static Logger& Get();
 	// Sets the foreground color of the output, if applicable
 	void SetColor(Color color);
-	// Log a string to the logging output, 
+	// Log a string to the logging output, queued messages are written by a background thread
+	//	errors are written before this returns
 	void Log(const String& msg, Logger::Severity severity);
 
 	// Write log message header, (timestamp, etc..)
@@ -56,6 +62,22 @@ public:
 	// Sets the log level, logs for >= level
 	void SetLogLevel(Logger::Severity level);
 
+	// Waits until all queued messages are written
+	void Flush();
+
+	// Limits how often a single call site logs, see LogfRateLimited
+	class RateLimit
+	{
+	public:
+		RateLimit(uint32 intervalMs) : m_interval(intervalMs) {}
+		// Returns true if a message may be logged now, suppressed is set to the number of messages dropped since the last one
+		bool Allow(uint32& suppressed);
+	private:
+		const uint32 m_interval;
+		std::atomic<uint64> m_next{ 0 };
+		std::atomic<uint32> m_suppressed{ 0 };
+	};
+
 private:
 	class Logger_Impl* m_impl;
 };
@@ -70,6 +92,19 @@ void Logf(const char* format, Logger::Severity severity, Args... args)
 // Log to Logger::Get()
 void Log(const String& msg, Logger::Severity severity = Logger::Severity::Normal);
 
+// Logf that logs at most once every intervalMs from the same call site, for messages that can repeat every frame or audio buffer
+#define LogfRateLimited(intervalMs, format, severity, ...) do { \
+		static Logger::RateLimit _logRateLimit(intervalMs); \
+		uint32 _logSuppressed; \
+		if (_logRateLimit.Allow(_logSuppressed)) \
+		{ \
+			if (_logSuppressed > 0) \
+				Logf(format " (%d similar messages suppressed)", severity, ##__VA_ARGS__, _logSuppressed); \
+			else \
+				Logf(format, severity, ##__VA_ARGS__); \
+		} \
+	} while (false)
+
 #ifdef _WIN32
 namespace Utility
 {
@@ -0,0 +1,53 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/Vector.hpp"
+
+/*
+	lua_Alloc implementation that serves small allocations from size class free lists
+	Most lua allocations are small strings, tables and closures that are freed again within a few frames,
+	the free lists avoid going through the system allocator for them
+
+	Memory used by the pools is only released when the allocator is destroyed,
+	the allocator must outlive the lua state and a state must only be used by one thread at a time
+*/
+class LuaAllocator : public Unique
+{
+public:
+	// Allocations larger than this use the system allocator
+	static const size_t MaxPooledSize = 256;
+	static const size_t SizeClassStep = 16;
+	static const size_t NumSizeClasses = MaxPooledSize / SizeClassStep;
+	// Size of the chunks pooled blocks are taken from
+	static const size_t ChunkSize = 64 * 1024;
+
+	~LuaAllocator();
+
+	// Pass to lua_newstate with the allocator as user data
+	static void* Alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+	// Bytes in use by the lua state
+	size_t GetBytesInUse() const { return m_bytesInUse; }
+	// Bytes reserved for pooled blocks
+	size_t GetBytesReserved() const { return m_chunks.size() * ChunkSize; }
+	// Number of allocations made, including reallocations to a different size class
+	uint64 GetNumAllocations() const { return m_numAllocations; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	void* m_Realloc(void* ptr, size_t osize, size_t nsize);
+	void* m_AllocateBlock(size_t sizeClass);
+	void m_FreeBlock(void* ptr, size_t sizeClass);
+	static size_t m_SizeClass(size_t size) { return (size - 1) / SizeClassStep; }
+
+	FreeBlock* m_freeLists[NumSizeClasses] = { nullptr };
+	Vector<uint8*> m_chunks;
+	uint8* m_chunkPos = nullptr;
+	uint8* m_chunkEnd = nullptr;
+
+	size_t m_bytesInUse = 0;
+	uint64 m_numAllocations = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include "lua.hpp"
+#include "Shared/LuaAllocator.hpp"
+#include "Shared/Ref.hpp"
+#include "Shared/String.hpp"
+
+// Garbage collector settings of a lua state
+struct LuaGCParams
+{
+	// Memory growth since the last completed cycle after which the scheduler starts a new cycle in idle time
+	float idleGrowth = 1.25f;
+	// Memory growth after which a cycle is finished even if there is no idle time left
+	float maxGrowth = 3.0f;
+	// Amount of work done in a single step relative to the allocated memory (in percent)
+	int stepMul = 200;
+};
+
+// Allocation and collection statistics of a single lua state
+struct LuaStateStats
+{
+	String name;
+	size_t bytesInUse = 0;
+	// Allocations and time spent in scheduled gc steps during the last frame
+	uint64 frameAllocations = 0;
+	double frameGCTime = 0.0;
+	// Longest time spent in scheduled gc steps during a single frame
+	double maxFrameGCTime = 0.0;
+	uint32 completedCycles = 0;
+};
+
+/*
+	Creates lua states with a pooled allocator and runs their garbage collection in the idle time of a frame
+	Lua 5.3 only has the incremental collector, automatic collection is stopped for the states and the scheduler
+	steps them round-robin while the frame limiter would sleep. States that grow too much before their cycle
+	is finished are collected outside of the budget so memory stays bounded when there is no idle time
+
+	Only used from the main thread
+*/
+class LuaGCScheduler : public Unique
+{
+public:
+	~LuaGCScheduler();
+
+	// Creates a new state without any libraries opened
+	lua_State* NewState(const String& name, const LuaGCParams& params = LuaGCParams());
+	// Closes a state, states not created by the scheduler are closed normally
+	void Close(lua_State* L);
+	void SetParams(lua_State* L, const LuaGCParams& params);
+
+	// Runs gc steps until the given amount of time has passed or there is nothing left to collect
+	//	returns the time spent in seconds
+	double Step(double budget);
+	// Collects the per frame statistics, call once per frame
+	void EndFrame();
+
+	const Vector<LuaStateStats>& GetStats() const { return m_stats; }
+	size_t GetNumStates() const { return m_states.size(); }
+
+private:
+	struct ManagedState
+	{
+		lua_State* L = nullptr;
+		String name;
+		LuaAllocator allocator;
+		LuaGCParams params;
+		// Memory in use after the last completed cycle
+		size_t collectedBytes = 0;
+		bool collecting = false;
+		uint64 lastAllocations = 0;
+		double frameGCTime = 0.0;
+		double maxFrameGCTime = 0.0;
+		uint32 completedCycles = 0;
+	};
+
+	bool m_NeedsCollection(const ManagedState& state) const;
+	void m_GCStep(ManagedState& state);
+
+	Vector<Ref<ManagedState>> m_states;
+	Vector<LuaStateStats> m_stats;
+	// State that gets the next step, rotates so all states get idle time
+	size_t m_next = 0;
+};
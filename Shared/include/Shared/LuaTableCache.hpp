@@ -0,0 +1,63 @@
+#pragma once
+#include "lua.hpp"
+#include "Shared/String.hpp"
+#include "Shared/Vector.hpp"
+#include <initializer_list>
+
+/*
+	Keeps references to lua tables and key strings that are updated every frame
+	so fields can be set in place without creating new tables or looking up strings
+
+	The references are stored in a table in the registry of each lua state, so they are released together with the state
+	Key ids are the index in the list of keys given to the constructor, table ids are chosen by the user
+
+	Example:
+	{
+		if(!cache.Begin(L))
+		{
+			// First use for this state, register the tables
+			lua_getglobal(L, "gameplay");
+			cache.SetTable(0, -1);
+			lua_pop(L, 1);
+		}
+		cache.PushTable(0);
+		cache.SetNumber(Key_score, score);
+		lua_pop(L, 1);
+		cache.End();
+	}
+*/
+class LuaTableCache
+{
+public:
+	LuaTableCache(std::initializer_list<const char*> keys);
+
+	// Pushes the cache of the given state, creates it if it does not exist yet
+	//	returns false when the cache was just created and tables need to be registered
+	bool Begin(lua_State* L);
+	// Pops the cache
+	void End();
+
+	// Registers the table at the given stack index under an id
+	void SetTable(uint32 id, int index);
+	// Pushes a registered table, pushes nil if the id is not registered
+	void PushTable(uint32 id);
+	// Checks if the value at the given stack index is the registered table
+	bool IsTable(uint32 id, int index);
+
+	// Pushes an interned key string
+	void PushKey(uint32 key);
+
+	// Set a field of the table at the top of the stack
+	void SetNumber(uint32 key, lua_Number value);
+	void SetInteger(uint32 key, lua_Integer value);
+	void SetBoolean(uint32 key, bool value);
+	void SetString(uint32 key, const char* value);
+
+	lua_State* GetState() const { return m_lua; }
+
+private:
+	Vector<String> m_keys;
+	lua_State* m_lua = nullptr;
+	// Absolute stack index of the cache table
+	int m_cache = 0;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+
+/* How a mapped file is going to be read, lets the OS tune read ahead */
+enum class MappedFileAccess
+{
+	Normal,
+	// Read once from front to back, pages are read ahead further and can be dropped once they were read
+	Sequential,
+	// Small reads all over the file, read ahead is disabled
+	Random,
+};
+
+/*
+	Read-only memory mapping of a whole file
+	the mapping reflects the size of the file at the time it was opened
+
+	Reading a page past the end of a file that was truncated after it was mapped raises SIGBUS on Unix,
+	so only map files that nothing else writes to or truncates while they are mapped,
+	use File::ReadAll for files that can be rewritten while they are in use (charts, songs, images)
+*/
+class MappedFile : Unique
+{
+private:
+	class MappedFile_Impl* m_impl = nullptr;
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	bool Open(const String& path, MappedFileAccess access = MappedFileAccess::Normal);
+	void Close();
+	bool IsOpen() const;
+
+	// Changes the access pattern hint of the whole mapping
+	void Advise(MappedFileAccess access);
+	// Starts reading the whole file into memory in the background
+	//	when wait is set, every page is read before this returns so later reads don't block on the disk
+	void Prefetch(bool wait = false);
+
+	// Null for empty files
+	const uint8* GetData() const;
+	size_t GetSize() const;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include "Shared/BinaryStream.hpp"
+#include "Shared/Buffer.hpp"
+#include "Shared/MappedFile.hpp"
+
+/*
+	Stream that reads from memory it doesn't own, like a mapped file, without copying it first
+	the memory has to stay valid while the stream is used
+*/
+class MappedReader : public BinaryStream
+{
+protected:
+	const uint8* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_cursor = 0;
+public:
+	MappedReader() = default;
+	MappedReader(const uint8* data, size_t size);
+	MappedReader(const MappedFile& file);
+	MappedReader(const Buffer& buffer);
+	virtual size_t Serialize(void* data, size_t len);
+	virtual void Seek(size_t pos);
+	virtual size_t Tell() const;
+	virtual size_t GetSize() const;
+
+	// Memory at the current position, for decoders that take a pointer
+	const uint8* GetData() const { return m_data + m_cursor; }
+	size_t GetRemaining() const { return m_size - m_cursor; }
+};
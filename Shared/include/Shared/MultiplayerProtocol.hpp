@@ -0,0 +1,53 @@
+#pragma once
+#include "Shared/String.hpp"
+#include "Shared/Vector.hpp"
+#include "Shared/Buffer.hpp"
+
+/*
+	Binary encoding of the high frequency multiplayer topics
+	sent with TCPPacketMode::BINARY once both sides agreed on the version during authentication,
+	everything else stays JSON
+
+	The first byte of a packet is its topic, integers are varint encoded and strings are prefixed by their length
+*/
+namespace MultiplayerProtocol
+{
+	// Sent as "binary" in user.auth, servers that support it send the same value back in server.info
+	static const uint32 BinaryVersion = 1;
+
+	enum class BinaryTopic : uint8
+	{
+		Invalid = 0,
+		// room.score.update
+		ScoreUpdate,
+		// game.scoreboard
+		Scoreboard,
+	};
+
+	struct ScoreUpdate
+	{
+		uint32 time = 0;
+		uint32 score = 0;
+	};
+
+	struct ScoreboardUser
+	{
+		String id;
+		String name;
+		uint32 score = 0;
+	};
+
+	struct Scoreboard
+	{
+		Vector<ScoreboardUser> users;
+	};
+
+	void Encode(const ScoreUpdate& update, Buffer& out);
+	void Encode(const Scoreboard& scoreboard, Buffer& out);
+
+	// Topic of an encoded packet
+	BinaryTopic GetTopic(const String& data);
+	// Returns false if the packet is of another topic or malformed
+	bool Decode(const String& data, ScoreUpdate& update);
+	bool Decode(const String& data, Scoreboard& scoreboard);
+}
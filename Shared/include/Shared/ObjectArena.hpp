@@ -0,0 +1,75 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/Vector.hpp"
+#include <algorithm>
+#include <functional>
+
+/*
+	Allocates objects of a single type in fixed size blocks
+	objects can't be freed individually, they are all destroyed at once by Clear
+	the blocks are kept and reused for new objects after clearing
+*/
+template<typename T, size_t BlockSize = 256>
+class ObjectArena : public Unique
+{
+public:
+	ObjectArena() = default;
+	~ObjectArena()
+	{
+		Clear();
+		for(T* block : m_blocks)
+			::operator delete(block);
+	}
+
+	// Constructs a new object, the pointer stays valid until Clear is called
+	template<typename... Args>
+	T* New(Args&&... args)
+	{
+		if(m_count == m_blocks.size() * BlockSize)
+			m_AddBlock();
+		T* ptr = m_blocks[m_count / BlockSize] + m_count % BlockSize;
+		new(ptr) T(std::forward<Args>(args)...);
+		m_count++;
+		return ptr;
+	}
+
+	// Destroys all objects
+	void Clear()
+	{
+		for(size_t i = 0; i < m_count; i++)
+			m_blocks[i / BlockSize][i % BlockSize].~T();
+		m_count = 0;
+	}
+
+	// Allocates enough blocks to hold the given number of objects
+	void Reserve(size_t count)
+	{
+		while(m_blocks.size() * BlockSize < count)
+			m_AddBlock();
+	}
+
+	// Checks if an object was allocated by this arena, for owners that also hold objects allocated with new
+	bool Contains(const T* ptr) const
+	{
+		auto it = std::upper_bound(m_sortedBlocks.begin(), m_sortedBlocks.end(), ptr, std::less<const T*>());
+		if(it == m_sortedBlocks.begin())
+			return false;
+		--it;
+		return std::less<const T*>()(ptr, *it + BlockSize);
+	}
+
+	size_t GetCount() const { return m_count; }
+
+private:
+	void m_AddBlock()
+	{
+		T* block = (T*)::operator new(sizeof(T) * BlockSize);
+		m_blocks.push_back(block);
+		m_sortedBlocks.insert(std::upper_bound(m_sortedBlocks.begin(), m_sortedBlocks.end(), block, std::less<T*>()), block);
+	}
+
+	Vector<T*> m_blocks;
+	// Blocks ordered by address
+	Vector<T*> m_sortedBlocks;
+	size_t m_count = 0;
+};
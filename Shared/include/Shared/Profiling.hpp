@@ -1,17 +1,118 @@
 #pragma once
 
+/*
+	Instrumentation for profiling
+	Spans, counters and frame markers are recorded into a ring buffer per thread while a capture is running
+	and can be exported as a Chrome trace (chrome://tracing or https://ui.perfetto.dev)
+
+	Names passed to spans and counters must stay valid until the capture is exported, use string literals
+	or Profiling::InternName for names that are built at runtime
+
+	The PROFILE_* macros compile to nothing when PROFILING is not defined
+*/
+namespace Profiling
+{
+	enum class EventType : uint8
+	{
+		Begin,
+		End,
+		Counter,
+		Frame,
+	};
+
+	struct Event
+	{
+		// Nanoseconds since the start of the application
+		uint64 time;
+		const char* name;
+		double value;
+		EventType type;
+	};
+
+	// Number of events kept per thread, older events are overwritten
+	static const uint32 EventsPerThread = 1 << 16;
+
+	uint64 Now();
+	// Recording only happens while a capture is running
+	bool IsCapturing();
+	void StartCapture();
+	void StopCapture();
+	// Stops the capture and writes everything recorded since it was started, returns false if the file could not be written
+	bool ExportChromeTrace(const String& path);
+
+	void BeginSpan(const char* name);
+	void EndSpan();
+	void Counter(const char* name, double value);
+	void FrameMark();
+	// Name shown for the calling thread in the trace
+	void SetThreadName(const char* name);
+	// Returns a copy of the name that stays valid for the lifetime of the application
+	const char* InternName(const String& name);
+
+	class Span
+	{
+	public:
+		Span(const char* name)
+		{
+			if (IsCapturing())
+			{
+				m_active = true;
+				BeginSpan(name);
+			}
+		}
+		~Span()
+		{
+			if (m_active)
+				EndSpan();
+		}
+	private:
+		bool m_active = false;
+	};
+}
+
+#ifdef PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) Profiling::Span PROFILE_CONCAT(_profileSpan, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) do { if (Profiling::IsCapturing()) Profiling::Counter(name, value); } while (false)
+#define PROFILE_FRAME() do { if (Profiling::IsCapturing()) Profiling::FrameMark(); } while (false)
+#define PROFILE_THREAD(name) Profiling::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_FRAME()
+#define PROFILE_THREAD(name)
+#endif
+
+/*
+	Logs the duration of a longer task and records it as a span
+*/
 class ProfilerScope
 {
 public:
 	ProfilerScope(const String& name) : name(name)
 	{
 		Logf("Starting task \"%s\"", Logger::Severity::Info, name);
+#ifdef PROFILING
+		if (Profiling::IsCapturing())
+		{
+			m_span = true;
+			Profiling::BeginSpan(Profiling::InternName(name));
+		}
+#endif
 	}
 	~ProfilerScope()
 	{
+#ifdef PROFILING
+		if (m_span)
+			Profiling::EndSpan();
+#endif
 		Logf("Finished task \"%s\" in  %d ms", Logger::Severity::Info, name, t.Milliseconds());
 	}
 private:
 	Timer t;
 	String name;
-};
\ No newline at end of file
+#ifdef PROFILING
+	bool m_span = false;
+#endif
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+#include "Shared/Vector.hpp"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+enum class RequestPriority : uint8
+{
+	// Prefetching and uploads nobody waits for
+	Low = 0,
+	Normal,
+	// Requests the user is waiting for
+	High,
+};
+
+typedef uint64 RequestId;
+
+/*
+	Fixed size pool of threads for blocking network requests
+
+	Workers sleep until a request is queued. The request with the highest priority is taken first,
+	among requests of the same priority the oldest one to a host the worker already sent requests to is preferred so its connection can be reused.
+	Connections are kept by the caller per worker, the worker index is passed to the request function
+*/
+class RequestPool : public Unique
+{
+public:
+	typedef std::function<void(uint32 worker)> RequestFunction;
+
+	RequestPool(uint32 numWorkers, const char* name = "Request worker");
+	~RequestPool();
+
+	// Owner is only used to cancel all requests of an object
+	RequestId Queue(const String& host, RequestPriority priority, const void* owner, RequestFunction&& function);
+	// Removes a request that hasn't started yet, returns false if it is already running or finished
+	bool Cancel(RequestId id);
+	// Removes all queued requests of owner and flags its running ones as cancelled
+	void CancelOwner(const void* owner);
+	// Checked by request functions before delivering their result
+	bool IsCancelled(uint32 worker);
+
+	uint32 GetNumWorkers() const { return (uint32)m_workers.size(); }
+	size_t GetNumQueued();
+
+	// Number of hosts a worker remembers for choosing requests
+	static const size_t MaxWorkerHosts = 8;
+
+private:
+	struct Request
+	{
+		RequestId id;
+		String host;
+		RequestPriority priority;
+		const void* owner;
+		RequestFunction function;
+	};
+	struct Worker
+	{
+		std::thread thread;
+		// Hosts of recent requests, most recent last
+		Vector<String> hosts;
+		RequestId activeId = 0;
+		const void* activeOwner = nullptr;
+		bool cancelled = false;
+	};
+
+	void m_WorkerThread(uint32 index);
+	// Index of the request a worker should take next
+	size_t m_SelectRequest(const Worker& worker) const;
+
+	String m_name;
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	bool m_stop = false;
+	RequestId m_nextId = 1;
+	// Queued requests in the order they were added
+	Vector<Request> m_queue;
+	Vector<Worker*> m_workers;
+};
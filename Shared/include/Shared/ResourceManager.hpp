@@ -64,6 +64,15 @@ public:
 			//Logf("Cleaned up %d resource(s) of %s", Logger::Info, numCleanedUp, Utility::TypeInfo<T>::name);
 		}
 	}
+	// Calls a function for every managed object, including ones that are no longer referenced but not collected yet
+	template<typename F>
+	void ForEach(F&& function)
+	{
+		m_lock.lock();
+		for(const Ref<T>& object : m_objects)
+			function(object);
+		m_lock.unlock();
+	}
 	void ReleaseAll() override
 	{
 		m_lock.lock();
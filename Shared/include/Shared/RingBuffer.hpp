@@ -0,0 +1,81 @@
+#pragma once
+#include "Shared/Vector.hpp"
+#include "Shared/Math.hpp"
+
+/*
+	First in first out queue stored in a single circular array
+	adding and removing items doesn't allocate memory unless the capacity is exceeded, the capacity is always a power of two
+*/
+template<typename I>
+class RingBuffer
+{
+public:
+	RingBuffer(size_t capacity = 16)
+	{
+		Reserve(capacity);
+	}
+
+	// Grows the buffer to hold at least the given amount of items
+	void Reserve(size_t capacity)
+	{
+		if(capacity <= m_data.size())
+			return;
+		size_t newCapacity = Math::Max<size_t>(m_data.size(), 1);
+		while(newCapacity < capacity)
+			newCapacity <<= 1;
+
+		Vector<I> newData(newCapacity);
+		for(size_t i = 0; i < m_size; i++)
+			newData[i] = std::move((*this)[i]);
+		m_data = std::move(newData);
+		m_head = 0;
+	}
+
+	I& AddBack(const I& item = I())
+	{
+		if(m_size == m_data.size())
+			Reserve(m_size * 2);
+		I& ret = m_data[(m_head + m_size) & (m_data.size() - 1)];
+		ret = item;
+		m_size++;
+		return ret;
+	}
+
+	// Pop and return
+	I PopFront()
+	{
+		I r = std::move(front());
+		pop_front();
+		return r;
+	}
+	void pop_front()
+	{
+		assert(m_size > 0);
+		m_head = (m_head + 1) & (m_data.size() - 1);
+		m_size--;
+	}
+
+	I& front() { assert(m_size > 0); return m_data[m_head]; }
+	const I& front() const { assert(m_size > 0); return m_data[m_head]; }
+	I& back() { assert(m_size > 0); return (*this)[m_size - 1]; }
+	const I& back() const { assert(m_size > 0); return (*this)[m_size - 1]; }
+
+	// Index relative to the front of the queue
+	I& operator[](size_t index) { return m_data[(m_head + index) & (m_data.size() - 1)]; }
+	const I& operator[](size_t index) const { return m_data[(m_head + index) & (m_data.size() - 1)]; }
+
+	size_t size() const { return m_size; }
+	size_t capacity() const { return m_data.size(); }
+	bool empty() const { return m_size == 0; }
+	// Removes all items but keeps the memory
+	void clear()
+	{
+		m_head = 0;
+		m_size = 0;
+	}
+
+private:
+	Vector<I> m_data;
+	size_t m_head = 0;
+	size_t m_size = 0;
+};
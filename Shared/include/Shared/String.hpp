@@ -79,7 +79,7 @@ namespace Utility
 	template<typename... Args>
 	String Sprintf(const char* fmt, Args... args)
 	{
-		static char buffer[8000];
+		static thread_local char buffer[8000];
 		BufferSprintf(buffer, fmt, args...);
 
 		return String(buffer);
@@ -90,7 +90,7 @@ namespace Utility
 	template<typename... Args>
 	WString WSprintf(const wchar_t* fmt, Args... args)
 	{
-		static wchar_t buffer[8000];
+		static thread_local wchar_t buffer[8000];
 #ifdef _WIN32
 		swprintf(buffer, 8000-1, fmt, WSprintfArgFilter(args)...);
 #else
@@ -19,6 +19,10 @@ enum class StringEncoding
 	CP954, EUC_JP = CP954
 };
 
+// Length of the leading run of characters that are the same in every supported encoding (printable ASCII, tabs and line breaks)
+// Vectorized, so plain text can skip the per byte encoding heuristics and conversions
+size_t GetPlainASCIILength(const char* str, const size_t len);
+
 constexpr const char* GetDisplayString(const StringEncoding encoding)
 {
 	switch (encoding)
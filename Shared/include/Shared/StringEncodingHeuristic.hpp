@@ -237,6 +237,9 @@ public:
 	bool Consume(const uint8_t ch) override;
 	bool Finalize() override { if (m_remaining) MarkInvalid(); return IsValid();}
 
+	// True between the bytes of a multi-byte character
+	inline bool IsInsideChar() const { return m_remaining != 0; }
+
 protected:
 	CharClass GetCharClass(const uint16_t ch) const override;
 
@@ -0,0 +1,127 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+#include "Shared/Vector.hpp"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+/* See http://stackoverflow.com/questions/12765743/getaddrinfo-on-win32 */
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0501  /* Windows XP. */
+#endif
+#include <winsock2.h>
+#include <Ws2tcpip.h>
+// XXX should be tracked elsewhere (not in source)?
+#pragma comment( lib, "ws2_32.lib")
+
+#define invalid_socket(s) (s == INVALID_SOCKET)
+#else
+/* Assume that any non-Windows platform uses POSIX-style sockets instead. */
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netdb.h>  /* Needed for getaddrinfo() and freeaddrinfo() */
+#include <unistd.h> /* Needed for close() */
+
+#define INVALID_SOCKET -1
+
+#define invalid_socket(s) (s < 0)
+
+typedef int SOCKET;
+#endif
+
+// First byte of every packet, tells how the rest of the packet is delimited
+enum TCPPacketMode
+{
+	NOT_READING = 0,
+	// Text terminated by a line break
+	JSON_LINE,
+	// Binary data prefixed by its length as a VarInt
+	BINARY,
+	UNKNOWN
+};
+
+// A complete packet without the mode byte and delimiter
+struct TCPPacket
+{
+	TCPPacketMode mode;
+	String data;
+	// Time the packet was read from the socket, Profiling::Now() based
+	uint64 receiveTime;
+};
+
+/*
+	TCP connection that does all socket I/O on its own thread
+	The socket is non-blocking and waited on with epoll (select on other platforms),
+	queued packets are written with a single gathered write and received data is split into packets on the I/O thread.
+	Sending and receiving never blocks the calling thread
+*/
+class TCPConnection : public Unique
+{
+public:
+	TCPConnection();
+	~TCPConnection();
+
+	// Connects to the given host (blocking) and starts the I/O thread
+	bool Connect(const String& host, const String& port);
+	// Takes ownership of an already connected socket and starts the I/O thread
+	bool Open(SOCKET socket);
+	// Stops the I/O thread and closes the socket, unsent packets are dropped
+	void Close();
+
+	bool IsOpen() const { return m_open; }
+	// True when the connection was lost or the peer sent invalid data, Close still needs to be called
+	bool IsClosed() const { return m_closed; }
+
+	// Queues a packet, the data is framed according to the mode
+	void Send(TCPPacketMode mode, const char* data, size_t length);
+	// Moves all packets received since the last call to the end of out
+	void Receive(Vector<TCPPacket>& out);
+
+	// Largest packet that can be received, the connection is closed when a packet exceeds it
+	static const size_t MaxPacketSize = 0x1000000;
+
+private:
+	void m_IOThread();
+	// Returns false if the connection was closed
+	bool m_Read();
+	bool m_Write();
+	void m_ParsePackets();
+	// Copies length bytes starting offset bytes into the read buffer to a new packet
+	void m_TakePacket(size_t offset, size_t length);
+	void m_Wake();
+	void m_SetClosed();
+
+	SOCKET m_socket = INVALID_SOCKET;
+	std::thread m_thread;
+	std::atomic<bool> m_stop{ false };
+	std::atomic<bool> m_closed{ false };
+	bool m_open = false;
+#ifdef __linux__
+	int m_epoll = -1;
+	// Wakes up the I/O thread when packets are queued or the connection is closed
+	int m_wakeEvent = -1;
+#endif
+
+	// Packets queued by Send, taken by the I/O thread
+	std::mutex m_sendLock;
+	Vector<String> m_pendingSend;
+	// Packets being written by the I/O thread, m_writeOffset bytes of the first one were already sent
+	std::deque<String> m_writeQueue;
+	size_t m_writeOffset = 0;
+
+	// Packets parsed by the I/O thread
+	std::mutex m_receiveLock;
+	Vector<TCPPacket> m_received;
+	Vector<TCPPacket> m_parsed;
+
+	// Received data, circular with a power of two size
+	Vector<char> m_readBuffer;
+	size_t m_readStart = 0;
+	size_t m_readSize = 0;
+	// Bytes of the current packet already scanned for its end
+	size_t m_scanned = 0;
+	TCPPacketMode m_readingMode = TCPPacketMode::NOT_READING;
+};
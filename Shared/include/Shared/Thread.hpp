@@ -11,6 +11,8 @@ public:
 	using std::thread::thread;
 	size_t SetAffinityMask(size_t affinityMask);
 	static size_t SetCurrentThreadAffinityMask(size_t affinityMask);
+	// Only lets the current thread run when the CPU would otherwise be idle, returns false if not supported
+	static bool SetCurrentThreadBackgroundPriority();
 };
 
 /* 
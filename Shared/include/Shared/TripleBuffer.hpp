@@ -0,0 +1,42 @@
+#pragma once
+#include "Shared/Types.hpp"
+#include <atomic>
+
+/*
+	Hands the latest value from a single writer thread to a single reader thread without locking
+	the writer always owns one buffer and the reader another, the third one holds the last published value.
+	Values that are published while the reader doesn't look are skipped, so neither side ever waits for the other
+*/
+template<typename T>
+class TripleBuffer
+{
+public:
+	// Buffer owned by the writer, still contains the value from 3 publishes ago
+	T& GetWriteBuffer() { return m_buffers[m_write]; }
+	// Makes the write buffer the latest value
+	void Publish()
+	{
+		m_write = m_middle.exchange((uint8)(m_write | newFlag), std::memory_order_acq_rel) & indexMask;
+	}
+
+	// Switches to the latest published value, returns false if nothing was published since the last call
+	bool Update()
+	{
+		if((m_middle.load(std::memory_order_relaxed) & newFlag) == 0)
+			return false;
+		m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+	// Buffer owned by the reader, stays the same until the next Update
+	const T& GetReadBuffer() const { return m_buffers[m_read]; }
+
+private:
+	static const uint8 indexMask = 3;
+	static const uint8 newFlag = 4;
+
+	T m_buffers[3];
+	uint8 m_write = 0;
+	// Index of the last published buffer and if the reader has seen it yet
+	std::atomic<uint8> m_middle{ 1 };
+	uint8 m_read = 2;
+};
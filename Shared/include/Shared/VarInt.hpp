@@ -0,0 +1,67 @@
+#pragma once
+#include "Shared/Buffer.hpp"
+
+/*
+	Variable length integer encoding (LEB128)
+	small values take up a single byte, signed values are zigzag encoded so small negative values are small as well
+*/
+namespace VarInt
+{
+	inline uint64 ZigZag(int64 value)
+	{
+		return ((uint64)value << 1) ^ (uint64)(value >> 63);
+	}
+	inline int64 UnZigZag(uint64 value)
+	{
+		return (int64)(value >> 1) ^ -(int64)(value & 1);
+	}
+
+	inline void Write(Buffer& out, uint64 value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((uint8)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((uint8)value);
+	}
+	// Writes a value to out, which needs room for MaxBytes, returns the number of bytes written
+	static const size_t MaxBytes = 10;
+	inline size_t Encode(uint8* out, uint64 value)
+	{
+		size_t n = 0;
+		while (value >= 0x80)
+		{
+			out[n++] = (uint8)(value | 0x80);
+			value >>= 7;
+		}
+		out[n++] = (uint8)value;
+		return n;
+	}
+	inline void WriteSigned(Buffer& out, int64 value)
+	{
+		Write(out, ZigZag(value));
+	}
+
+	// Reads a value and advances the read pointer, returns false if the data ended before the value did
+	inline bool Read(const uint8*& data, const uint8* end, uint64& value)
+	{
+		value = 0;
+		for (uint32 shift = 0; shift < 64 && data < end; shift += 7)
+		{
+			uint8 byte = *data++;
+			value |= (uint64)(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+	inline bool ReadSigned(const uint8*& data, const uint8* end, int64& value)
+	{
+		uint64 raw;
+		if (!Read(data, end, raw))
+			return false;
+		value = UnZigZag(raw);
+		return true;
+	}
+}
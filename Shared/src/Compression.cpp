@@ -0,0 +1,31 @@
+#include "stdafx.h"
+#include "Compression.hpp"
+#include <zlib.h>
+
+namespace Compression
+{
+	bool Deflate(const Buffer& in, Buffer& out, int32 level)
+	{
+		uLongf size = compressBound((uLong)in.size());
+		out.resize(size);
+		if (compress2(out.data(), &size, in.data(), (uLong)in.size(), level) != Z_OK)
+		{
+			out.clear();
+			return false;
+		}
+		out.resize(size);
+		return true;
+	}
+
+	bool Inflate(const Buffer& in, Buffer& out, size_t uncompressedSize)
+	{
+		uLongf size = (uLongf)uncompressedSize;
+		out.resize(uncompressedSize);
+		if (uncompress(out.data(), &size, in.data(), (uLong)in.size()) != Z_OK || size != uncompressedSize)
+		{
+			out.clear();
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,90 @@
+#include "stdafx.h"
+#include "FFT.hpp"
+
+namespace FFT
+{
+	// Math::pi is only a float
+	static const double Pi = 3.14159265358979323846;
+
+	size_t GetSize(size_t size)
+	{
+		size_t result = 1;
+		while (result < size)
+			result <<= 1;
+		return result;
+	}
+
+	void Transform(Vector<std::complex<double>>& data, bool inverse)
+	{
+		const size_t n = data.size();
+		assert((n & (n - 1)) == 0);
+
+		// Bit reversal permutation
+		for (size_t i = 1, j = 0; i < n; i++)
+		{
+			size_t bit = n >> 1;
+			for (; j & bit; bit >>= 1)
+				j ^= bit;
+			j ^= bit;
+			if (i < j)
+				std::swap(data[i], data[j]);
+		}
+
+		for (size_t length = 2; length <= n; length <<= 1)
+		{
+			const double angle = 2.0 * Pi / length * (inverse ? 1.0 : -1.0);
+			const std::complex<double> step(cos(angle), sin(angle));
+			for (size_t i = 0; i < n; i += length)
+			{
+				std::complex<double> w(1.0, 0.0);
+				for (size_t k = 0; k < length / 2; k++)
+				{
+					const std::complex<double> even = data[i + k];
+					const std::complex<double> odd = data[i + k + length / 2] * w;
+					data[i + k] = even + odd;
+					data[i + k + length / 2] = even - odd;
+					w *= step;
+				}
+			}
+		}
+	}
+
+	void CrossCorrelate(const Vector<float>& a, const Vector<float>& b, Vector<float>& out)
+	{
+		out.clear();
+		if (a.empty() || b.empty())
+			return;
+
+		const size_t numLags = a.size() + b.size() - 1;
+		const size_t n = GetSize(numLags);
+
+		// Both real signals are transformed at once as the real and imaginary part of one complex signal
+		Vector<std::complex<double>> data(n);
+		for (size_t i = 0; i < a.size(); i++)
+			data[i].real(a[i]);
+		for (size_t i = 0; i < b.size(); i++)
+			data[i].imag(b[i]);
+		Transform(data);
+
+		// Separate the spectra of a and b and multiply the conjugate of A with B
+		Vector<std::complex<double>> product(n);
+		for (size_t k = 0; k < n; k++)
+		{
+			const std::complex<double> x = data[k];
+			const std::complex<double> y = std::conj(data[(n - k) & (n - 1)]);
+			const std::complex<double> spectrumA = (x + y) * 0.5;
+			const std::complex<double> spectrumB = (x - y) * std::complex<double>(0.0, -0.5);
+			product[k] = std::conj(spectrumA) * spectrumB;
+		}
+		Transform(product, true);
+
+		// Negative lags wrap around to the end
+		out.resize(numLags);
+		const double scale = 1.0 / n;
+		for (size_t i = 0; i < numLags; i++)
+		{
+			const int64 lag = (int64)i - (int64)(a.size() - 1);
+			out[i] = (float)(product[(size_t)(lag < 0 ? lag + (int64)n : lag)].real() * scale);
+		}
+	}
+}
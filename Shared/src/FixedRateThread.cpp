@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "FixedRateThread.hpp"
+#include "Log.hpp"
+#include "Timer.hpp"
+#include "Profiling.hpp"
+
+FixedRateThread::FixedRateThread(const char* name) : m_name(name)
+{
+}
+
+FixedRateThread::~FixedRateThread()
+{
+	Stop();
+}
+
+void FixedRateThread::Start(uint32 rate, StepFunction&& function)
+{
+	Stop();
+	assert(rate > 0);
+	m_rate = rate;
+	m_function = std::move(function);
+	m_numSteps = 0;
+	m_numDroppedSteps = 0;
+	m_stop = false;
+	m_thread = std::thread(&FixedRateThread::m_Run, this);
+}
+
+void FixedRateThread::Stop()
+{
+	if(!m_thread.joinable())
+		return;
+	m_stop = true;
+	m_thread.join();
+}
+
+void FixedRateThread::SetClock(NowFunction now, SleepFunction sleepUntil)
+{
+	assert(!IsRunning());
+	m_now = std::move(now);
+	m_sleepUntil = std::move(sleepUntil);
+}
+
+FixedRateThread::Clock::time_point FixedRateThread::m_Now() const
+{
+	return m_now ? m_now() : Clock::now();
+}
+
+void FixedRateThread::m_SleepUntil(Clock::time_point time)
+{
+	if(m_sleepUntil)
+		m_sleepUntil(time);
+	else
+		std::this_thread::sleep_until(time);
+}
+
+void FixedRateThread::m_Run()
+{
+	PROFILE_THREAD(*m_name);
+
+	// Step times are counted in whole nanoseconds so they don't drift on long runs
+	const Clock::time_point start = m_Now();
+	const uint64 second = 1000000000;
+
+	uint64 step = 0;
+	while(!m_stop)
+	{
+		const uint64 elapsed = (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(m_Now() - start).count();
+		const uint64 due = elapsed * m_rate / second;
+		if(due >= step + MaxCatchUp)
+		{
+			m_numDroppedSteps += due - step;
+			step = due;
+		}
+
+		// Run every step that is due
+		for(; step <= due && !m_stop; step++)
+		{
+			m_function(step, (double)step / m_rate);
+			m_numSteps++;
+		}
+
+		m_SleepUntil(start + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(step * second / m_rate)));
+	}
+}
@@ -0,0 +1,127 @@
+#include "stdafx.h"
+#include "FramePacer.hpp"
+#include "Math.hpp"
+#include <thread>
+
+using namespace std::chrono;
+
+// Bounds of the time the pacer wakes up before a deadline to spin the rest
+static const double MinSleepSlack = 0.00005;
+static const double MaxSleepSlack = 0.004;
+// How fast a large oversleep is forgotten, per sleep
+static const double SleepSlackDecay = 0.99;
+// Extra time given to a frame in just in time mode on top of the predicted work time
+static const double JustInTimeMargin = 0.0005;
+
+static double Seconds(FramePacer::Clock::duration duration)
+{
+	return duration_cast<std::chrono::duration<double>>(duration).count();
+}
+static FramePacer::Clock::duration Duration(double seconds)
+{
+	return duration_cast<FramePacer::Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+void FramePacer::SetTarget(int32 fps, Mode mode)
+{
+	if(fps == m_fps && mode == m_mode)
+		return;
+	m_fps = fps;
+	m_mode = mode;
+	m_period = fps > 0 ? Duration(1.0 / fps) : Clock::duration::zero();
+	// Start a new sequence of deadlines on the next frame
+	m_hasDeadline = false;
+}
+
+void FramePacer::BeginFrame()
+{
+	if(m_fps > 0)
+	{
+		const Clock::time_point now = m_Now();
+		if(!m_hasDeadline)
+		{
+			m_deadline = now + m_period;
+			m_hasDeadline = true;
+		}
+		if(m_mode == Mode::JustInTime)
+		{
+			const double workTime = Math::Min(m_stats.workEstimate + JustInTimeMargin, Seconds(m_period));
+			const Clock::time_point wakeTime = m_deadline - Duration(workTime);
+			if(wakeTime > now)
+				SleepUntil(wakeTime);
+		}
+	}
+	m_frameStart = m_Now();
+}
+
+void FramePacer::EndFrame()
+{
+	Clock::time_point now = m_Now();
+	m_stats.numFrames++;
+	if(m_fps <= 0)
+		return;
+
+	// Follow longer frames immediately and shorter ones slowly, a single slow frame in just in time mode is a missed deadline
+	const double workTime = Seconds(now - m_frameStart);
+	m_stats.workEstimate = Math::Max(workTime, m_stats.workEstimate * 0.98 + workTime * 0.02);
+
+	if(now > m_deadline)
+		m_stats.numLateFrames++;
+	else
+		SleepUntil(m_deadline);
+
+	// Deadlines are absolute so errors don't add up, if the loop is more than a frame behind it doesn't try to catch up
+	m_deadline += m_period;
+	now = m_Now();
+	if(m_deadline < now)
+		m_deadline = now + m_period;
+}
+
+double FramePacer::GetTimeLeft() const
+{
+	if(m_fps <= 0 || !m_hasDeadline)
+		return 0.0;
+	return Math::Max(0.0, Seconds(m_deadline - m_Now()));
+}
+
+void FramePacer::SleepUntil(Clock::time_point time)
+{
+	const Clock::time_point start = m_Now();
+	if(time <= start)
+		return;
+
+	const Clock::time_point sleepTarget = time - Duration(m_stats.sleepSlack);
+	if(sleepTarget > start)
+	{
+		m_PlatformSleepUntil(sleepTarget);
+		const Clock::time_point wakeTime = m_Now();
+		const double oversleep = Seconds(wakeTime - sleepTarget);
+		m_stats.sleepSlack = Math::Clamp(Math::Max(oversleep, m_stats.sleepSlack * SleepSlackDecay), MinSleepSlack, MaxSleepSlack);
+		m_stats.sleepTime += Seconds(wakeTime - start);
+	}
+
+	const Clock::time_point spinStart = m_Now();
+	while(m_Now() < time)
+		std::this_thread::yield();
+	m_stats.spinTime += Seconds(m_Now() - spinStart);
+}
+
+void FramePacer::SetClock(NowFunction now, SleepFunction sleepUntil)
+{
+	m_now = std::move(now);
+	m_sleepUntil = std::move(sleepUntil);
+	m_hasDeadline = false;
+}
+
+FramePacer::Clock::time_point FramePacer::m_Now() const
+{
+	return m_now ? m_now() : Clock::now();
+}
+
+void FramePacer::m_PlatformSleepUntil(Clock::time_point time)
+{
+	if(m_sleepUntil)
+		m_sleepUntil(time);
+	else
+		PlatformSleepUntil(time);
+}
@@ -6,6 +6,7 @@
 #include "Thread.hpp"
 #include <thread>
 #include "Timer.hpp"
+#include "Profiling.hpp"
 
 JobFlags operator|(JobFlags a, JobFlags b)
 {
@@ -134,6 +135,7 @@ private:
 	// Single job thread
 	void m_JobThread(JobThread* myThread)
 	{
+		PROFILE_THREAD(*Utility::Sprintf("Job thread %d", myThread->index));
 		while(!myThread->terminate)
 		{
 			if(!m_jobQueue.empty())
@@ -151,7 +153,10 @@ private:
 						m_lock.unlock();
 
 						// Run
-						myThread->activeJob->m_ret = myThread->activeJob->Run();
+						{
+							PROFILE_SCOPE("Job");
+							myThread->activeJob->m_ret = myThread->activeJob->Run();
+						}
 						myThread->activeJob->m_finished = true;
 
 						// Add to finished queue
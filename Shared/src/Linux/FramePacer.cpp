@@ -0,0 +1,16 @@
+#include "stdafx.h"
+#include "FramePacer.hpp"
+#include <time.h>
+#include <errno.h>
+
+void FramePacer::PlatformSleepUntil(Clock::time_point time)
+{
+	// steady_clock is CLOCK_MONOTONIC, an absolute sleep doesn't add the time it took to get here
+	const std::chrono::nanoseconds sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+	timespec ts;
+	ts.tv_sec = (time_t)(sinceEpoch.count() / 1000000000);
+	ts.tv_nsec = (long)(sinceEpoch.count() % 1000000000);
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+	{
+	}
+}
@@ -30,3 +30,9 @@ size_t Thread::SetCurrentThreadAffinityMask(size_t affinityMask)
 	pthread_setaffinity_np(h, sizeof(cpu_set_t), &cpuset);
 	return 0;
 }
+
+bool Thread::SetCurrentThreadBackgroundPriority()
+{
+	sched_param param = {};
+	return pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0;
+}
@@ -2,20 +2,46 @@
 #include "Log.hpp"
 #include "Path.hpp"
 #include "File.hpp"
-#include "FileStream.hpp"
-#include "TextStream.hpp"
 #include <ctime>
-#include <map>
 #include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+// A queued message, either text or a console color change
+struct LogMessage
+{
+	std::atomic<LogMessage*> next{ nullptr };
+	// -1 if the color does not change
+	int32 color = -1;
+	String text;
+};
 
 class Logger_Impl
 {
 private:
 	File m_logFile;
-	FileWriter m_writer;
 	bool m_failedToOpen;
-	std::mutex m_lock;
-	Logger::Severity m_logLevel;
+	std::atomic<Logger::Severity> m_logLevel;
+
+	// Multiple producer, single consumer queue
+	// producers swap themselves in at the head, the writer thread pops from the tail
+	std::atomic<LogMessage*> m_head;
+	LogMessage* m_tail;
+	LogMessage m_stub;
+
+	std::atomic<uint64> m_numPushed{ 0 };
+	uint64 m_numWritten = 0;
+
+	std::thread m_writerThread;
+	std::mutex m_writerLock;
+	std::condition_variable m_wakeWriter;
+	std::condition_variable m_written;
+	bool m_stop = false;
+	bool m_flushRequested = false;
+
+	// Interval in which the writer thread writes new messages
+	static constexpr std::chrono::milliseconds m_writeInterval{ 20 };
 
 public:
 	Logger_Impl()
@@ -23,6 +49,8 @@ public:
 		// Store the name of the executable
 		moduleName = Path::GetModuleName();
 		m_logLevel = Logger::Severity::Debug;
+		m_head = &m_stub;
+		m_tail = &m_stub;
 		
 #ifdef _WIN32
 		// Store console output handle
@@ -31,23 +59,18 @@ public:
 
 		// Log to file
 		String logPath = Path::Absolute(Utility::Sprintf("log_%s.txt", moduleName));
-		if (!m_logFile.OpenWrite(logPath, false, true))
-		{
-			m_failedToOpen = true;
-			return;
-		}
-		m_failedToOpen = false;
-		m_writer = FileWriter(m_logFile);
-	}
+		m_failedToOpen = !m_logFile.OpenWrite(logPath, false, true);
 
-	void Lock()
-	{
-		m_lock.lock();
+		m_writerThread = std::thread(&Logger_Impl::m_WriterThread, this);
 	}
-
-	void Unlock()
+	~Logger_Impl()
 	{
-		m_lock.unlock();
+		{
+			std::lock_guard<std::mutex> lock(m_writerLock);
+			m_stop = true;
+		}
+		m_wakeWriter.notify_one();
+		m_writerThread.join();
 	}
 
 	void SetLogLevel(Logger::Severity level)
@@ -59,45 +82,186 @@ public:
 		return m_logLevel;
 	}
 
-	void WriteHeader(Logger::Severity severity)
+	void FormatHeader(String& out, Logger::Severity severity)
 	{
-		
 		// Format a timestamp string
 		char timeStr[64];
 		time_t currentTime = time(0);
-		tm* currentLocalTime = localtime(&currentTime);
-		strftime(timeStr, sizeof(timeStr), "%T", currentLocalTime);
+		tm currentLocalTime;
+#ifdef _WIN32
+		localtime_s(&currentLocalTime, &currentTime);
+#else
+		localtime_r(&currentTime, &currentLocalTime);
+#endif
+		strftime(timeStr, sizeof(timeStr), "%T", &currentLocalTime);
 
-		// Write the formated header
-		Write(Utility::Sprintf("[%s][%s] ", timeStr, Logger::Enum_Severity::ToString(severity)));
+		out += '[';
+		out += timeStr;
+		out += "][";
+		out += Logger::Enum_Severity::ToString(severity);
+		out += "] ";
 	}
-	void Write(const String& msg)
+
+	// Never blocks, safe to call from any thread
+	void Push(int32 color, const String& text)
 	{
-#ifdef _WIN32
-		OutputDebugStringW(*Utility::ConvertToWString(msg));
-#endif
-		printf("%s", msg.c_str());
-		if(!m_failedToOpen)
-			TextStream::Write(m_writer, msg);
+		LogMessage* msg = new LogMessage();
+		msg->color = color;
+		msg->text = text;
+		LogMessage* prev = m_head.exchange(msg, std::memory_order_acq_rel);
+		prev->next.store(msg, std::memory_order_release);
+		m_numPushed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Flush()
+	{
+		const uint64 target = m_numPushed.load();
+		std::unique_lock<std::mutex> lock(m_writerLock);
+		m_flushRequested = true;
+		m_wakeWriter.notify_one();
+		m_written.wait(lock, [&]() { return m_numWritten >= target || m_stop; });
 	}
 
 #ifdef _WIN32
 	HANDLE consoleHandle;
 #endif
 	String moduleName;
+
+private:
+	// Pops the oldest message, returns nullptr if the queue is empty or a message is being pushed
+	LogMessage* m_Pop()
+	{
+		LogMessage* tail = m_tail;
+		LogMessage* next = tail->next.load(std::memory_order_acquire);
+		if (tail == &m_stub)
+		{
+			if (!next)
+				return nullptr;
+			m_tail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+		if (next)
+		{
+			m_tail = next;
+			return tail;
+		}
+		if (tail != m_head.load(std::memory_order_acquire))
+			return nullptr;
+		// Put the stub back so the last message can be taken out
+		m_stub.next.store(nullptr, std::memory_order_relaxed);
+		LogMessage* prev = m_head.exchange(&m_stub, std::memory_order_acq_rel);
+		prev->next.store(&m_stub, std::memory_order_release);
+		next = tail->next.load(std::memory_order_acquire);
+		if (next)
+		{
+			m_tail = next;
+			return tail;
+		}
+		return nullptr;
+	}
+
+	void m_SetConsoleColor(int32 color)
+	{
+#ifdef _WIN32
+		if(consoleHandle)
+		{
+			static uint8 params[] =
+			{
+				FOREGROUND_INTENSITY | FOREGROUND_RED,
+				FOREGROUND_INTENSITY | FOREGROUND_GREEN,
+				FOREGROUND_INTENSITY | FOREGROUND_BLUE,
+				FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_GREEN, // Yellow,
+				FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_RED, // Cyan,
+				FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_RED, // Magenta,
+				FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY, // White
+				FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN, // Gray
+			};
+			SetConsoleTextAttribute(consoleHandle, params[color]);
+		}
+#else
+		static const char* params[] = {
+			"200;0;0", // Red
+			"0;200;0", // Green
+			"0;70;200", // Blue
+			"200;180;0", // Yellow
+			"0;200;200", // Cyan
+			"200;0;200", // Magenta
+			nullptr, // White
+			"140;140;140", // Gray
+		};
+		if(color == Logger::White)
+			printf("\x1b[39m");
+		else
+			printf("\x1b[38;2;%sm", params[color]);
+#endif
+	}
+
+	// Writes all queued messages, the log file gets a single write per batch
+	void m_WriteQueued()
+	{
+		String fileBatch;
+		uint64 numWritten = 0;
+		while (LogMessage* msg = m_Pop())
+		{
+			if (msg->color >= 0)
+				m_SetConsoleColor(msg->color);
+			if (!msg->text.empty())
+			{
+#ifdef _WIN32
+				OutputDebugStringW(*Utility::ConvertToWString(msg->text));
+#endif
+				fwrite(msg->text.data(), 1, msg->text.size(), stdout);
+				fileBatch += msg->text;
+			}
+			delete msg;
+			numWritten++;
+		}
+		if (numWritten == 0)
+			return;
+
+		fflush(stdout);
+		if (!m_failedToOpen && !fileBatch.empty())
+			m_logFile.Write(fileBatch.data(), fileBatch.size());
+
+		std::lock_guard<std::mutex> lock(m_writerLock);
+		m_numWritten += numWritten;
+		m_written.notify_all();
+	}
+
+	void m_WriterThread()
+	{
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_writerLock);
+				m_wakeWriter.wait_for(lock, m_writeInterval, [&]() { return m_stop || m_flushRequested; });
+				m_flushRequested = false;
+				if (m_stop)
+					break;
+			}
+			m_WriteQueued();
+		}
+		m_WriteQueued();
+	}
 };
 
+constexpr std::chrono::milliseconds Logger_Impl::m_writeInterval;
+
+// Buffer the message is formatted into before it is queued
+static thread_local String t_logLine;
+
 Logger::Logger()
 {
 	m_impl = new Logger_Impl;
 }
 Logger::~Logger()
 {
+	delete m_impl;
 #ifndef _WIN32
 	// Reset terminal colors
 	printf("\x1b[39m\x1b[0m");
 #endif
-	delete m_impl;
 }
 Logger& Logger::Get()
 {
@@ -106,79 +270,71 @@ Logger& Logger::Get()
 }
 void Logger::SetColor(Color color)
 {
-#ifdef _WIN32
-	if(m_impl->consoleHandle)
-	{
-		static uint8 params[] =
-		{
-			FOREGROUND_INTENSITY | FOREGROUND_RED,
-			FOREGROUND_INTENSITY | FOREGROUND_GREEN,
-			FOREGROUND_INTENSITY | FOREGROUND_BLUE,
-			FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_GREEN, // Yellow,
-			FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_RED, // Cyan,
-			FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_RED, // Magenta,
-			FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY, // White
-			FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN, // Gray
-		};
-		SetConsoleTextAttribute(m_impl->consoleHandle, params[(size_t)color]);
-	}
-#else
-	static std::map<Color, const char*> params = {
-		{Color::Red,     "200;0;0"},
-		{Color::Green,   "0;200;0"},
-		{Color::Blue,    "0;70;200"},
-		{Color::Yellow,  "200;180;0"},
-		{Color::Cyan,    "0;200;200"},
-		{Color::Magenta, "200;0;200"},
-		{Color::Gray,    "140;140;140"}
-	};
-	if(color == Color::White)
-		printf("\x1b[39m");
-	else
-		printf("\x1b[38;2;%sm", params[color]);
-#endif
+	m_impl->Push((int32)color, String());
 }
 void Logger::Log(const String& msg, Logger::Severity severity)
 {
 	if (severity < m_impl->GetLogLevel())
 		return;
+	Color color = White;
 	switch(severity)
 	{
 	case Severity::Normal:
-		SetColor(White);
+		color = White;
 		break;
 	case Severity::Info:
-		SetColor(Gray);
+		color = Gray;
 		break;
 	case Severity::Warning:
-		SetColor(Yellow);
+		color = Yellow;
 		break;
 	case Severity::Error:
-		SetColor(Red);
+		color = Red;
 		break;
 	case Severity::Debug:
-		SetColor(Blue);
+		color = Blue;
 		break;
 	}
 
-	m_impl->Lock();
-	m_impl->WriteHeader(severity);
-	m_impl->Write(msg);
-	m_impl->Write("\n");
-	m_impl->Unlock();
+	t_logLine.clear();
+	m_impl->FormatHeader(t_logLine, severity);
+	t_logLine += msg;
+	t_logLine += '\n';
+	m_impl->Push((int32)color, t_logLine);
+	// Errors are often the last thing logged before a crash or abort, so they are written right away
+	if (severity == Severity::Error)
+		m_impl->Flush();
 }
 void Logger::WriteHeader(Severity severity)
 {
-	m_impl->WriteHeader(severity);
+	t_logLine.clear();
+	m_impl->FormatHeader(t_logLine, severity);
+	m_impl->Push(-1, t_logLine);
 }
 void Logger::Write(const String& msg)
 {
-	m_impl->Write(msg);
+	m_impl->Push(-1, msg);
 }
 void Logger::SetLogLevel(Logger::Severity level)
 {
 	m_impl->SetLogLevel(level);
 }
+void Logger::Flush()
+{
+	m_impl->Flush();
+}
+bool Logger::RateLimit::Allow(uint32& suppressed)
+{
+	const uint64 now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	uint64 next = m_next.load(std::memory_order_relaxed);
+	if (now < next || !m_next.compare_exchange_strong(next, now + m_interval))
+	{
+		m_suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+	return true;
+}
 void Log(const String& msg, Logger::Severity severity)
 {
 	Logger::Get().Log(msg, severity);
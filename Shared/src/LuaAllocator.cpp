@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "LuaAllocator.hpp"
+#include "Math.hpp"
+
+LuaAllocator::~LuaAllocator()
+{
+	for (uint8* chunk : m_chunks)
+		free(chunk);
+}
+
+void* LuaAllocator::Alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	return ((LuaAllocator*)ud)->m_Realloc(ptr, osize, nsize);
+}
+
+void* LuaAllocator::m_Realloc(void* ptr, size_t osize, size_t nsize)
+{
+	// For new allocations osize contains the type of the object instead of a size
+	if (!ptr)
+		osize = 0;
+
+	if (nsize == 0)
+	{
+		if (ptr)
+		{
+			if (osize <= MaxPooledSize)
+				m_FreeBlock(ptr, m_SizeClass(osize));
+			else
+				free(ptr);
+			m_bytesInUse -= osize;
+		}
+		return nullptr;
+	}
+
+	const bool oldPooled = ptr && osize <= MaxPooledSize;
+	const bool newPooled = nsize <= MaxPooledSize;
+
+	void* result;
+	if (oldPooled && newPooled && m_SizeClass(osize) == m_SizeClass(nsize))
+	{
+		// Still fits in the same block
+		result = ptr;
+	}
+	else if (!newPooled && ptr && !oldPooled)
+	{
+		result = realloc(ptr, nsize);
+		if (!result)
+			return nullptr;
+		m_numAllocations++;
+	}
+	else
+	{
+		result = newPooled ? m_AllocateBlock(m_SizeClass(nsize)) : malloc(nsize);
+		// The old block must stay valid when an allocation fails
+		if (!result)
+			return nullptr;
+		m_numAllocations++;
+		if (ptr)
+		{
+			memcpy(result, ptr, Math::Min(osize, nsize));
+			if (oldPooled)
+				m_FreeBlock(ptr, m_SizeClass(osize));
+			else
+				free(ptr);
+		}
+	}
+
+	m_bytesInUse += nsize;
+	m_bytesInUse -= osize;
+	return result;
+}
+
+void* LuaAllocator::m_AllocateBlock(size_t sizeClass)
+{
+	FreeBlock*& freeList = m_freeLists[sizeClass];
+	if (freeList)
+	{
+		FreeBlock* block = freeList;
+		freeList = block->next;
+		return block;
+	}
+
+	const size_t blockSize = (sizeClass + 1) * SizeClassStep;
+	if (m_chunkPos + blockSize > m_chunkEnd)
+	{
+		// Put the remainder of the current chunk in the smaller free lists
+		while (m_chunkPos && (size_t)(m_chunkEnd - m_chunkPos) >= SizeClassStep)
+		{
+			const size_t remaining = Math::Min((size_t)(m_chunkEnd - m_chunkPos), MaxPooledSize);
+			const size_t remainderClass = remaining / SizeClassStep - 1;
+			m_FreeBlock(m_chunkPos, remainderClass);
+			m_chunkPos += (remainderClass + 1) * SizeClassStep;
+		}
+
+		uint8* chunk = (uint8*)malloc(ChunkSize);
+		if (!chunk)
+			return nullptr;
+		m_chunks.push_back(chunk);
+		m_chunkPos = chunk;
+		m_chunkEnd = chunk + ChunkSize;
+	}
+
+	void* block = m_chunkPos;
+	m_chunkPos += blockSize;
+	return block;
+}
+
+void LuaAllocator::m_FreeBlock(void* ptr, size_t sizeClass)
+{
+	FreeBlock* block = (FreeBlock*)ptr;
+	block->next = m_freeLists[sizeClass];
+	m_freeLists[sizeClass] = block;
+}
@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "LuaGCScheduler.hpp"
+#include "Timer.hpp"
+#include "Math.hpp"
+#include "Log.hpp"
+
+static int LuaPanic(lua_State* L)
+{
+	Logf("Unprotected lua error: %s", Logger::Severity::Error, lua_tostring(L, -1));
+	return 0;
+}
+
+LuaGCScheduler::~LuaGCScheduler()
+{
+	for (auto& state : m_states)
+		lua_close(state->L);
+}
+
+lua_State* LuaGCScheduler::NewState(const String& name, const LuaGCParams& params)
+{
+	Ref<ManagedState> state = Ref<ManagedState>(new ManagedState());
+	state->L = lua_newstate(&LuaAllocator::Alloc, &state->allocator);
+	if (!state->L)
+		return nullptr;
+	lua_atpanic(state->L, &LuaPanic);
+	state->name = name;
+	m_states.push_back(state);
+	SetParams(state->L, params);
+	return state->L;
+}
+
+void LuaGCScheduler::Close(lua_State* L)
+{
+	for (size_t i = 0; i < m_states.size(); i++)
+	{
+		if (m_states[i]->L == L)
+		{
+			lua_close(L);
+			m_states.erase(m_states.begin() + i);
+			return;
+		}
+	}
+	lua_close(L);
+}
+
+void LuaGCScheduler::SetParams(lua_State* L, const LuaGCParams& params)
+{
+	lua_gc(L, LUA_GCSTOP, 0);
+	lua_gc(L, LUA_GCSETSTEPMUL, params.stepMul);
+	for (auto& state : m_states)
+	{
+		if (state->L == L)
+		{
+			state->params = params;
+			state->collectedBytes = state->allocator.GetBytesInUse();
+		}
+	}
+}
+
+bool LuaGCScheduler::m_NeedsCollection(const ManagedState& state) const
+{
+	return state.collecting || state.allocator.GetBytesInUse() > state.collectedBytes * state.params.idleGrowth;
+}
+
+void LuaGCScheduler::m_GCStep(ManagedState& state)
+{
+	// A single basic step, the amount of work depends on the step multiplier
+	//	explicit steps still run while automatic collection is stopped
+	state.collecting = true;
+	if (lua_gc(state.L, LUA_GCSTEP, 0))
+	{
+		state.collecting = false;
+		state.collectedBytes = state.allocator.GetBytesInUse();
+		state.completedCycles++;
+	}
+}
+
+double LuaGCScheduler::Step(double budget)
+{
+	Timer timer;
+
+	// States that grew too much are collected regardless of the budget
+	for (auto& state : m_states)
+	{
+		if (state->allocator.GetBytesInUse() <= state->collectedBytes * state->params.maxGrowth)
+			continue;
+		double start = timer.SecondsAsDouble();
+		do
+		{
+			m_GCStep(*state);
+		} while (state->collecting);
+		state->frameGCTime += timer.SecondsAsDouble() - start;
+	}
+
+	size_t idleStates = 0;
+	while (!m_states.empty() && idleStates < m_states.size())
+	{
+		double elapsed = timer.SecondsAsDouble();
+		if (elapsed >= budget)
+			break;
+
+		m_next %= m_states.size();
+		ManagedState& state = *m_states[m_next++];
+		if (!m_NeedsCollection(state))
+		{
+			idleStates++;
+			continue;
+		}
+		idleStates = 0;
+
+		m_GCStep(state);
+		state.frameGCTime += timer.SecondsAsDouble() - elapsed;
+	}
+	return timer.SecondsAsDouble();
+}
+
+void LuaGCScheduler::EndFrame()
+{
+	m_stats.resize(m_states.size());
+	for (size_t i = 0; i < m_states.size(); i++)
+	{
+		ManagedState& state = *m_states[i];
+		LuaStateStats& stats = m_stats[i];
+		const uint64 allocations = state.allocator.GetNumAllocations();
+		state.maxFrameGCTime = Math::Max(state.maxFrameGCTime, state.frameGCTime);
+
+		stats.name = state.name;
+		stats.bytesInUse = state.allocator.GetBytesInUse();
+		stats.frameAllocations = allocations - state.lastAllocations;
+		stats.frameGCTime = state.frameGCTime;
+		stats.maxFrameGCTime = state.maxFrameGCTime;
+		stats.completedCycles = state.completedCycles;
+
+		state.lastAllocations = allocations;
+		state.frameGCTime = 0.0;
+	}
+}
@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include "LuaTableCache.hpp"
+
+LuaTableCache::LuaTableCache(std::initializer_list<const char*> keys)
+{
+	for (const char* key : keys)
+		m_keys.Add(key);
+}
+
+bool LuaTableCache::Begin(lua_State* L)
+{
+	assert(!m_lua);
+	m_lua = L;
+	if (lua_rawgetp(L, LUA_REGISTRYINDEX, this) == LUA_TTABLE)
+	{
+		m_cache = lua_gettop(L);
+		return true;
+	}
+	lua_pop(L, 1);
+
+	// Keys are stored first, tables after them
+	lua_createtable(L, (int)m_keys.size() + 16, 0);
+	m_cache = lua_gettop(L);
+	for (size_t i = 0; i < m_keys.size(); i++)
+	{
+		lua_pushstring(L, *m_keys[i]);
+		lua_rawseti(L, m_cache, (lua_Integer)i + 1);
+	}
+	lua_pushvalue(L, m_cache);
+	lua_rawsetp(L, LUA_REGISTRYINDEX, this);
+	return false;
+}
+
+void LuaTableCache::End()
+{
+	assert(m_lua);
+	lua_remove(m_lua, m_cache);
+	m_lua = nullptr;
+	m_cache = 0;
+}
+
+void LuaTableCache::SetTable(uint32 id, int index)
+{
+	lua_pushvalue(m_lua, index);
+	lua_rawseti(m_lua, m_cache, (lua_Integer)(m_keys.size() + id + 1));
+}
+
+void LuaTableCache::PushTable(uint32 id)
+{
+	lua_rawgeti(m_lua, m_cache, (lua_Integer)(m_keys.size() + id + 1));
+}
+
+bool LuaTableCache::IsTable(uint32 id, int index)
+{
+	index = lua_absindex(m_lua, index);
+	PushTable(id);
+	bool equal = lua_rawequal(m_lua, -1, index) != 0;
+	lua_pop(m_lua, 1);
+	return equal;
+}
+
+void LuaTableCache::PushKey(uint32 key)
+{
+	lua_rawgeti(m_lua, m_cache, (lua_Integer)key + 1);
+}
+
+void LuaTableCache::SetNumber(uint32 key, lua_Number value)
+{
+	PushKey(key);
+	lua_pushnumber(m_lua, value);
+	lua_rawset(m_lua, -3);
+}
+
+void LuaTableCache::SetInteger(uint32 key, lua_Integer value)
+{
+	PushKey(key);
+	lua_pushinteger(m_lua, value);
+	lua_rawset(m_lua, -3);
+}
+
+void LuaTableCache::SetBoolean(uint32 key, bool value)
+{
+	PushKey(key);
+	lua_pushboolean(m_lua, value);
+	lua_rawset(m_lua, -3);
+}
+
+void LuaTableCache::SetString(uint32 key, const char* value)
+{
+	PushKey(key);
+	lua_pushstring(m_lua, value);
+	lua_rawset(m_lua, -3);
+}
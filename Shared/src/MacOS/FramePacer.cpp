@@ -0,0 +1,8 @@
+#include "stdafx.h"
+#include "FramePacer.hpp"
+#include <thread>
+
+void FramePacer::PlatformSleepUntil(Clock::time_point time)
+{
+	std::this_thread::sleep_until(time);
+}
@@ -1,4 +1,5 @@
 #include "Thread.hpp"
+#include <pthread.h>
 
 size_t Thread::SetAffinityMask(size_t affinityMask)
 {
@@ -9,3 +10,8 @@ size_t Thread::SetCurrentThreadAffinityMask(size_t affinityMask)
 {
 	return 0;
 }
+
+bool Thread::SetCurrentThreadBackgroundPriority()
+{
+	return pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0) == 0;
+}
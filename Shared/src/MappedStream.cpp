@@ -0,0 +1,38 @@
+#include "stdafx.h"
+#include "MappedStream.hpp"
+#include <algorithm>
+
+MappedReader::MappedReader(const uint8* data, size_t size) : BinaryStream(true), m_data(data), m_size(size)
+{
+}
+MappedReader::MappedReader(const MappedFile& file) : BinaryStream(true), m_data(file.GetData()), m_size(file.GetSize())
+{
+}
+MappedReader::MappedReader(const Buffer& buffer) : BinaryStream(true), m_data(buffer.data()), m_size(buffer.size())
+{
+}
+size_t MappedReader::Serialize(void* data, size_t len)
+{
+	if(m_cursor >= m_size)
+		return 0;
+	len = std::min(len, m_size - m_cursor);
+	if(len > 0)
+	{
+		memcpy(data, m_data + m_cursor, len);
+		m_cursor += len;
+	}
+	return len;
+}
+void MappedReader::Seek(size_t pos)
+{
+	assert(pos <= m_size);
+	m_cursor = pos;
+}
+size_t MappedReader::Tell() const
+{
+	return m_cursor;
+}
+size_t MappedReader::GetSize() const
+{
+	return m_size;
+}
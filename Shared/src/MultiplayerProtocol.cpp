@@ -0,0 +1,97 @@
+#include "stdafx.h"
+#include "MultiplayerProtocol.hpp"
+#include "VarInt.hpp"
+
+namespace MultiplayerProtocol
+{
+	static void WriteString(Buffer& out, const String& str)
+	{
+		VarInt::Write(out, str.size());
+		out.insert(out.end(), str.begin(), str.end());
+	}
+
+	static bool ReadString(const uint8*& data, const uint8* end, String& str)
+	{
+		uint64 length;
+		if (!VarInt::Read(data, end, length) || length > (uint64)(end - data))
+			return false;
+		str.assign((const char*)data, (size_t)length);
+		data += length;
+		return true;
+	}
+
+	static bool ReadUInt32(const uint8*& data, const uint8* end, uint32& value)
+	{
+		uint64 raw;
+		if (!VarInt::Read(data, end, raw) || raw > UINT32_MAX)
+			return false;
+		value = (uint32)raw;
+		return true;
+	}
+
+	// Checks the topic and returns the data after it
+	static bool BeginDecode(const String& data, BinaryTopic topic, const uint8*& begin, const uint8*& end)
+	{
+		if (GetTopic(data) != topic)
+			return false;
+		begin = (const uint8*)data.data() + 1;
+		end = (const uint8*)data.data() + data.size();
+		return true;
+	}
+
+	void Encode(const ScoreUpdate& update, Buffer& out)
+	{
+		out.clear();
+		out.push_back((uint8)BinaryTopic::ScoreUpdate);
+		VarInt::Write(out, update.time);
+		VarInt::Write(out, update.score);
+	}
+
+	void Encode(const Scoreboard& scoreboard, Buffer& out)
+	{
+		out.clear();
+		out.push_back((uint8)BinaryTopic::Scoreboard);
+		VarInt::Write(out, scoreboard.users.size());
+		for (const ScoreboardUser& user : scoreboard.users)
+		{
+			WriteString(out, user.id);
+			WriteString(out, user.name);
+			VarInt::Write(out, user.score);
+		}
+	}
+
+	BinaryTopic GetTopic(const String& data)
+	{
+		if (data.empty() || (uint8)data[0] > (uint8)BinaryTopic::Scoreboard)
+			return BinaryTopic::Invalid;
+		return (BinaryTopic)data[0];
+	}
+
+	bool Decode(const String& data, ScoreUpdate& update)
+	{
+		const uint8 *ptr, *end;
+		if (!BeginDecode(data, BinaryTopic::ScoreUpdate, ptr, end))
+			return false;
+		return ReadUInt32(ptr, end, update.time) && ReadUInt32(ptr, end, update.score);
+	}
+
+	bool Decode(const String& data, Scoreboard& scoreboard)
+	{
+		const uint8 *ptr, *end;
+		if (!BeginDecode(data, BinaryTopic::Scoreboard, ptr, end))
+			return false;
+
+		uint64 numUsers;
+		// Every user takes at least 3 bytes
+		if (!VarInt::Read(ptr, end, numUsers) || numUsers > (uint64)(end - ptr) / 3)
+			return false;
+		// Existing entries are reused so their strings keep their allocations
+		scoreboard.users.resize((size_t)numUsers);
+		for (ScoreboardUser& user : scoreboard.users)
+		{
+			if (!ReadString(ptr, end, user.id) || !ReadString(ptr, end, user.name) || !ReadUInt32(ptr, end, user.score))
+				return false;
+		}
+		return true;
+	}
+}
@@ -69,6 +69,15 @@ String Path::GetExtension(const String& path)
 		return path.substr(dotPos + 1);
 	return String();
 }
+String Path::ReplaceExtension(String path, String newExt)
+{
+	String ext = GetExtension(path);
+	if(!ext.empty())
+		path.resize(path.size() - ext.size() - 1);
+	if(!newExt.empty())
+		path += "." + newExt;
+	return path;
+}
 String Path::ExtractPathFromCmdLine(String& input)
 {
 	String r;
@@ -0,0 +1,247 @@
+#include "stdafx.h"
+#include "String.hpp"
+#include "Vector.hpp"
+#include "Utility.hpp"
+#include "Log.hpp"
+#include "Timer.hpp"
+#include "Profiling.hpp"
+#include "File.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_set>
+
+namespace Profiling
+{
+	// Events of a single thread, only the owning thread writes to it
+	struct ThreadBuffer
+	{
+		uint32 id = 0;
+		String name;
+		Vector<Event> events;
+		// Total number of events written, the write position is head % EventsPerThread
+		std::atomic<uint64> head{ 0 };
+		bool inUse = false;
+	};
+
+	static const auto g_startTime = std::chrono::steady_clock::now();
+	static std::atomic<bool> g_capturing{ false };
+	static uint64 g_captureStart = 0;
+
+	// Buffers of threads that exited are reused by new threads
+	static std::mutex g_buffersLock;
+	static Vector<ThreadBuffer*> g_buffers;
+	static uint32 g_nextThreadId = 1;
+
+	static std::mutex g_namesLock;
+	static std::unordered_set<std::string> g_names;
+
+	// Returns the buffer to the pool when the thread exits
+	struct ThreadBufferHolder
+	{
+		ThreadBuffer* buffer = nullptr;
+		// Name set before the buffer was created
+		String name;
+		~ThreadBufferHolder()
+		{
+			if (buffer)
+			{
+				std::lock_guard<std::mutex> lock(g_buffersLock);
+				buffer->inUse = false;
+			}
+		}
+	};
+	static thread_local ThreadBufferHolder t_buffer;
+
+	static ThreadBuffer* GetThreadBuffer()
+	{
+		if (t_buffer.buffer)
+			return t_buffer.buffer;
+
+		std::lock_guard<std::mutex> lock(g_buffersLock);
+		ThreadBuffer* buffer = nullptr;
+		// Events of threads that exited during a capture are kept until it is exported
+		for (ThreadBuffer* b : g_buffers)
+		{
+			if (!b->inUse && !g_capturing.load(std::memory_order_relaxed))
+			{
+				buffer = b;
+				break;
+			}
+		}
+		if (!buffer)
+		{
+			buffer = new ThreadBuffer();
+			buffer->events.resize(EventsPerThread);
+			g_buffers.push_back(buffer);
+		}
+		buffer->id = g_nextThreadId++;
+		buffer->name = t_buffer.name.empty() ? Utility::Sprintf("Thread %d", buffer->id) : t_buffer.name;
+		buffer->head.store(0, std::memory_order_relaxed);
+		buffer->inUse = true;
+		t_buffer.buffer = buffer;
+		return buffer;
+	}
+
+	static void Record(EventType type, const char* name, double value)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+		const uint64 head = buffer->head.load(std::memory_order_relaxed);
+		Event& e = buffer->events[head % EventsPerThread];
+		e.time = Now();
+		e.name = name;
+		e.value = value;
+		e.type = type;
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	uint64 Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_startTime).count();
+	}
+
+	bool IsCapturing()
+	{
+		return g_capturing.load(std::memory_order_relaxed);
+	}
+
+	void StartCapture()
+	{
+		g_captureStart = Now();
+		g_capturing.store(true);
+	}
+
+	void StopCapture()
+	{
+		g_capturing.store(false);
+	}
+
+	void BeginSpan(const char* name)
+	{
+		Record(EventType::Begin, name, 0.0);
+	}
+
+	void EndSpan()
+	{
+		Record(EventType::End, nullptr, 0.0);
+	}
+
+	void Counter(const char* name, double value)
+	{
+		Record(EventType::Counter, name, value);
+	}
+
+	void FrameMark()
+	{
+		Record(EventType::Frame, "Frame", 0.0);
+	}
+
+	void SetThreadName(const char* name)
+	{
+		// Buffers are only created for threads that record something
+		t_buffer.name = name;
+		if (t_buffer.buffer)
+		{
+			std::lock_guard<std::mutex> lock(g_buffersLock);
+			t_buffer.buffer->name = name;
+		}
+	}
+
+	const char* InternName(const String& name)
+	{
+		std::lock_guard<std::mutex> lock(g_namesLock);
+		return g_names.insert(name).first->c_str();
+	}
+
+	static void WriteJsonString(String& out, const char* str)
+	{
+		out += '"';
+		for (const char* c = str; *c; c++)
+		{
+			switch (*c)
+			{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if ((uint8)*c < 0x20)
+					out += Utility::Sprintf("\\u%04x", (uint32)(uint8)*c);
+				else
+					out += *c;
+			}
+		}
+		out += '"';
+	}
+
+	bool ExportChromeTrace(const String& path)
+	{
+		StopCapture();
+
+		String json = "{\"traceEvents\":[\n";
+		bool first = true;
+		auto beginEvent = [&](const char* name, const char* phase, uint32 tid)
+		{
+			if (!first)
+				json += ",\n";
+			first = false;
+			json += "{\"name\":";
+			WriteJsonString(json, name);
+			json += Utility::Sprintf(",\"ph\":\"%s\",\"pid\":1,\"tid\":%d", phase, tid);
+		};
+
+		std::lock_guard<std::mutex> lock(g_buffersLock);
+		size_t numEvents = 0;
+		for (ThreadBuffer* buffer : g_buffers)
+		{
+			beginEvent("thread_name", "M", buffer->id);
+			json += ",\"args\":{\"name\":";
+			WriteJsonString(json, *buffer->name);
+			json += "}}";
+
+			const uint64 head = buffer->head.load(std::memory_order_acquire);
+			const uint64 begin = head > EventsPerThread ? head - EventsPerThread : 0;
+			for (uint64 i = begin; i < head; i++)
+			{
+				const Event& e = buffer->events[i % EventsPerThread];
+				if (e.time < g_captureStart)
+					continue;
+				const double ts = (e.time - g_captureStart) / 1000.0;
+				switch (e.type)
+				{
+				case EventType::Begin:
+					beginEvent(e.name, "B", buffer->id);
+					json += Utility::Sprintf(",\"ts\":%.3f}", ts);
+					break;
+				case EventType::End:
+					if (!first)
+						json += ",\n";
+					first = false;
+					json += Utility::Sprintf("{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", buffer->id, ts);
+					break;
+				case EventType::Counter:
+					beginEvent(e.name, "C", buffer->id);
+					json += Utility::Sprintf(",\"ts\":%.3f,\"args\":{\"value\":%f}}", ts, e.value);
+					break;
+				case EventType::Frame:
+					beginEvent(e.name, "i", buffer->id);
+					json += Utility::Sprintf(",\"ts\":%.3f,\"s\":\"g\"}", ts);
+					break;
+				}
+				numEvents++;
+			}
+		}
+		json += "\n]}\n";
+
+		File file;
+		if (!file.OpenWrite(path))
+		{
+			Logf("Failed to write profiling capture to \"%s\"", Logger::Severity::Error, path);
+			return false;
+		}
+		file.Write(json.data(), json.size());
+		file.Close();
+		Logf("Wrote %d profiling events to \"%s\"", Logger::Severity::Info, numEvents, path);
+		return true;
+	}
+}
@@ -0,0 +1,142 @@
+#include "stdafx.h"
+#include "RequestPool.hpp"
+#include "Utility.hpp"
+#include "Log.hpp"
+#include "Timer.hpp"
+#include "Profiling.hpp"
+#include <algorithm>
+
+RequestPool::RequestPool(uint32 numWorkers, const char* name) : m_name(name)
+{
+	for (uint32 i = 0; i < std::max(numWorkers, 1u); i++)
+		m_workers.push_back(new Worker());
+	// Started after all workers exist since they look at each other's state
+	for (uint32 i = 0; i < m_workers.size(); i++)
+		m_workers[i]->thread = std::thread(&RequestPool::m_WorkerThread, this, i);
+}
+
+RequestPool::~RequestPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+		m_queue.clear();
+	}
+	m_wake.notify_all();
+	for (Worker* worker : m_workers)
+	{
+		if (worker->thread.joinable())
+			worker->thread.join();
+		delete worker;
+	}
+	m_workers.clear();
+}
+
+RequestId RequestPool::Queue(const String& host, RequestPriority priority, const void* owner, RequestFunction&& function)
+{
+	RequestId id;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		id = m_nextId++;
+		m_queue.push_back({ id, host, priority, owner, std::move(function) });
+	}
+	m_wake.notify_one();
+	return id;
+}
+
+bool RequestPool::Cancel(RequestId id)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	for (size_t i = 0; i < m_queue.size(); i++)
+	{
+		if (m_queue[i].id == id)
+		{
+			m_queue.erase(m_queue.begin() + i);
+			return true;
+		}
+	}
+	return false;
+}
+
+void RequestPool::CancelOwner(const void* owner)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [owner](const Request& r) { return r.owner == owner; }), m_queue.end());
+	for (Worker* worker : m_workers)
+	{
+		if (worker->activeId != 0 && worker->activeOwner == owner)
+			worker->cancelled = true;
+	}
+}
+
+bool RequestPool::IsCancelled(uint32 worker)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_workers[worker]->cancelled;
+}
+
+size_t RequestPool::GetNumQueued()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_queue.size();
+}
+
+size_t RequestPool::m_SelectRequest(const Worker& worker) const
+{
+	size_t best = 0;
+	bool bestKnownHost = false;
+	for (size_t i = 0; i < m_queue.size(); i++)
+	{
+		const Request& r = m_queue[i];
+		if (r.priority < m_queue[best].priority)
+			continue;
+		const bool knownHost = worker.hosts.Contains(r.host);
+		// Older requests come first, so only a higher priority or a reusable connection wins over the current pick
+		if (r.priority > m_queue[best].priority || (knownHost && !bestKnownHost))
+		{
+			best = i;
+			bestKnownHost = knownHost;
+		}
+	}
+	return best;
+}
+
+void RequestPool::m_WorkerThread(uint32 index)
+{
+	PROFILE_THREAD(*Utility::Sprintf("%s %d", m_name, index));
+	Worker& worker = *m_workers[index];
+
+	std::unique_lock<std::mutex> lock(m_lock);
+	while (true)
+	{
+		m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+		if (m_stop)
+			break;
+
+		const size_t selected = m_SelectRequest(worker);
+		Request request = std::move(m_queue[selected]);
+		m_queue.erase(m_queue.begin() + selected);
+
+		auto it = std::find(worker.hosts.begin(), worker.hosts.end(), request.host);
+		if (it != worker.hosts.end())
+			worker.hosts.erase(it);
+		else if (worker.hosts.size() >= MaxWorkerHosts)
+			worker.hosts.erase(worker.hosts.begin());
+		worker.hosts.push_back(request.host);
+
+		worker.activeId = request.id;
+		worker.activeOwner = request.owner;
+		worker.cancelled = false;
+		lock.unlock();
+
+		{
+			PROFILE_SCOPE("Request");
+			request.function(index);
+		}
+
+		lock.lock();
+		worker.activeId = 0;
+		worker.activeOwner = nullptr;
+		worker.cancelled = false;
+	}
+}
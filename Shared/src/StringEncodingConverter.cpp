@@ -12,6 +12,9 @@ String StringEncodingConverter::ToUTF8(StringEncoding encoding, const char* str,
 {
 	if (!NeedsConversion(encoding)) return String(str);
 
+	// Every supported encoding is a superset of ASCII, so plain text is returned without opening iconv
+	if (GetPlainASCIILength(str, str_len) == str_len) return String(str, str_len);
+
 	iconv_t conv_d = iconv_open("UTF-8", GetIConvArg(encoding));
 	if (conv_d == (iconv_t)-1)
 	{
@@ -18,7 +18,82 @@ class StringEncodingDetectorInternal final : public TieredStringEncodingHeuristi
 	// Disabled because they are not as frequent as ShiftJIS or EUC-JP
 	// StringEncodingHeuristicCollection<CP949Heuristic, CP850Heuristic, CP923Heuristic>
 >
-{};
+{
+public:
+	void Feed(const char* data, const size_t len);
+	StringEncoding End();
+
+private:
+	void FeedHeuristics(const char* data, const size_t len);
+
+	// UTF-8 always wins when it is valid, so the other heuristics only need to run when it isn't.
+	// Plain ASCII is skipped in bulk, it is valid in every encoding.
+	UTF8Heuristic m_utf8;
+	bool m_validUTF8 = true;
+
+	// Input fed while it was still valid UTF-8, for the heuristics if it turns out not to be
+	String m_input;
+};
+
+void StringEncodingDetectorInternal::Feed(const char* data, const size_t len)
+{
+	if (!m_validUTF8)
+	{
+		FeedHeuristics(data, len);
+		return;
+	}
+
+	size_t i = 0;
+	while (i < len)
+	{
+		if (!m_utf8.IsInsideChar())
+		{
+			i += GetPlainASCIILength(data + i, len - i);
+			if (i == len) break;
+		}
+
+		if (!m_utf8.Consume(static_cast<uint8_t>(data[i])))
+		{
+			m_validUTF8 = false;
+
+			FeedHeuristics(m_input.data(), m_input.size());
+			FeedHeuristics(data, len);
+			m_input = String();
+
+			return;
+		}
+
+		++i;
+	}
+
+	m_input.append(data, len);
+}
+
+StringEncoding StringEncodingDetectorInternal::End()
+{
+	if (m_validUTF8)
+	{
+		if (m_utf8.Finalize()) return StringEncoding::UTF8;
+
+		// Truncated multi-byte character at the end
+		FeedHeuristics(m_input.data(), m_input.size());
+		m_input = String();
+	}
+
+	Finalize();
+
+	const StringEncodingHeuristic& best = GetBestHeuristic();
+	if (best.IsValid()) return best.GetEncoding();
+	else return StringEncoding::Unknown;
+}
+
+void StringEncodingDetectorInternal::FeedHeuristics(const char* data, const size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+	{
+		Consume(data[i]);
+	}
+}
 
 StringEncodingDetector::StringEncodingDetector()
 {
@@ -34,21 +109,14 @@ void StringEncodingDetector::Feed(const char* data, const size_t len)
 {
 	assert(!m_done);
 
-	for (size_t i = 0; i < len; ++i)
-	{
-		m_internal->Consume(data[i]);
-	}
+	m_internal->Feed(data, len);
 }
 
 void StringEncodingDetector::End()
 {
 	assert(!m_done);
 
-	m_internal->Finalize();
-	
-	const StringEncodingHeuristic& best = m_internal->GetBestHeuristic();
-	if (best.IsValid()) m_encoding = best.GetEncoding();
-	else m_encoding = StringEncoding::Unknown;
+	m_encoding = m_internal->End();
 
 	// m_internal->DebugPrint();
 
@@ -3,6 +3,11 @@
 
 #include "Shared/Log.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USC_STRING_ENCODING_SSE2
+#include <emmintrin.h>
+#endif
+
 static inline CharClass GetAsciiCharClass(uint8_t ch)
 {
 	if (0x30 <= ch && ch <= 0x39 || 0x41 <= ch && ch <= 0x5A || 0x61 <= ch && ch <= 0x7A)
@@ -13,6 +18,47 @@ static inline CharClass GetAsciiCharClass(uint8_t ch)
 		return CharClass::INVALID;
 }
 
+static inline bool IsPlainAscii(uint8_t ch)
+{
+	return 0x20 <= ch && ch <= 0x7E || ch == 0x09 || ch == 0x0A || ch == 0x0D;
+}
+
+size_t GetPlainASCIILength(const char* str, const size_t len)
+{
+	size_t i = 0;
+
+#ifdef USC_STRING_ENCODING_SSE2
+	const __m128i space = _mm_set1_epi8(0x1F);
+	const __m128i del = _mm_set1_epi8(0x7F);
+	const __m128i tab = _mm_set1_epi8(0x09);
+	const __m128i lf = _mm_set1_epi8(0x0A);
+	const __m128i cr = _mm_set1_epi8(0x0D);
+
+	// Bytes above 0x7F are negative, so they fail the signed comparison with 0x1F
+	for (; i + 32 <= len; i += 32)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i + 16));
+		__m128i plainA = _mm_and_si128(_mm_cmpgt_epi8(a, space), _mm_cmplt_epi8(a, del));
+		__m128i plainB = _mm_and_si128(_mm_cmpgt_epi8(b, space), _mm_cmplt_epi8(b, del));
+		plainA = _mm_or_si128(plainA, _mm_or_si128(_mm_cmpeq_epi8(a, tab), _mm_or_si128(_mm_cmpeq_epi8(a, lf), _mm_cmpeq_epi8(a, cr))));
+		plainB = _mm_or_si128(plainB, _mm_or_si128(_mm_cmpeq_epi8(b, tab), _mm_or_si128(_mm_cmpeq_epi8(b, lf), _mm_cmpeq_epi8(b, cr))));
+
+		// The exact position is found by the loop below
+		if (_mm_movemask_epi8(_mm_and_si128(plainA, plainB)) != 0xFFFF)
+			break;
+	}
+#endif
+
+	for (; i < len; ++i)
+	{
+		if (!IsPlainAscii(static_cast<uint8_t>(str[i])))
+			break;
+	}
+
+	return i;
+}
+
 bool TwoByteEncodingHeuristic::Consume(const uint8_t ch)
 {
 	if (!IsValid())
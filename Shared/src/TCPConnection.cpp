@@ -0,0 +1,532 @@
+#include "stdafx.h"
+#include "TCPConnection.hpp"
+#include "Log.hpp"
+#include "Timer.hpp"
+#include "Profiling.hpp"
+#include "VarInt.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <errno.h>
+#include <sys/uio.h>
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Number of packets written with a single call
+static const size_t maxWriteBuffers = 64;
+static const size_t initialReadBufferSize = 4096;
+
+static bool WouldBlock()
+{
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+static void CloseSocket(SOCKET s)
+{
+#ifdef _WIN32
+	shutdown(s, SD_BOTH);
+	closesocket(s);
+#else
+	shutdown(s, SHUT_RDWR);
+	close(s);
+#endif
+}
+
+TCPConnection::TCPConnection()
+{
+#ifdef _WIN32
+	// Startup winsock
+	WSADATA wsa_data;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+	{
+		Logf("[Socket] Unable to start winsock!", Logger::Severity::Error);
+	}
+#endif
+}
+
+TCPConnection::~TCPConnection()
+{
+	Close();
+#ifdef _WIN32
+	// Clean up winsock
+	WSACleanup();
+#endif
+}
+
+bool TCPConnection::Connect(const String& host, const String& port)
+{
+	if (m_open)
+		return false;
+
+	struct addrinfo* result = nullptr;
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	// Resolve the ip of the host
+	int res = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+	if (res != 0)
+	{
+		Logf("[Socket] Unable to resolve address %s:%s %d", Logger::Severity::Error, host.c_str(), port.c_str(), res);
+		return false;
+	}
+
+	// Create a TCP socket
+	SOCKET s = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (invalid_socket(s))
+	{
+		Logf("[Socket] Unable to create socket to address %s port %s", Logger::Severity::Error, host.c_str(), port.c_str());
+		freeaddrinfo(result);
+		return false;
+	}
+
+	// Try to connect to host (blocking)
+	if (connect(s, result->ai_addr, (int)result->ai_addrlen) != 0)
+	{
+		Logf("[Socket] Unable to connect to address %s port %s", Logger::Severity::Error, host.c_str(), port.c_str());
+		freeaddrinfo(result);
+		CloseSocket(s);
+		return false;
+	}
+	freeaddrinfo(result);
+
+	return Open(s);
+}
+
+bool TCPConnection::Open(SOCKET s)
+{
+	if (m_open)
+		return false;
+
+	// Switch to non-blocking I/O
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+	int noSigPipe = 1;
+	setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+#endif
+	// Packets are small and latency matters more than throughput
+	int noDelay = 1;
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+#ifdef __linux__
+	m_epoll = epoll_create1(0);
+	m_wakeEvent = eventfd(0, EFD_NONBLOCK);
+	if (m_epoll < 0 || m_wakeEvent < 0)
+	{
+		Log("[Socket] Failed to create epoll instance", Logger::Severity::Error);
+		if (m_epoll >= 0)
+			close(m_epoll);
+		if (m_wakeEvent >= 0)
+			close(m_wakeEvent);
+		m_epoll = m_wakeEvent = -1;
+		CloseSocket(s);
+		return false;
+	}
+	epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.fd = m_wakeEvent;
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeEvent, &ev);
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	ev.data.fd = s;
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, s, &ev);
+#endif
+
+	m_socket = s;
+	m_readBuffer.resize(initialReadBufferSize);
+	m_readStart = 0;
+	m_readSize = 0;
+	m_scanned = 0;
+	m_readingMode = TCPPacketMode::NOT_READING;
+	m_writeQueue.clear();
+	m_writeOffset = 0;
+	m_stop = false;
+	m_closed = false;
+	m_open = true;
+	m_thread = std::thread(&TCPConnection::m_IOThread, this);
+	return true;
+}
+
+void TCPConnection::Close()
+{
+	if (!m_open)
+		return;
+
+	m_stop = true;
+	m_Wake();
+	if (m_thread.joinable())
+		m_thread.join();
+
+	CloseSocket(m_socket);
+	m_socket = INVALID_SOCKET;
+#ifdef __linux__
+	close(m_epoll);
+	close(m_wakeEvent);
+	m_epoll = m_wakeEvent = -1;
+#endif
+
+	m_open = false;
+	m_pendingSend.clear();
+	m_received.clear();
+	m_readBuffer.clear();
+}
+
+void TCPConnection::Send(TCPPacketMode mode, const char* data, size_t length)
+{
+	// The whole packet is a single buffer so it can be written in one go
+	String packet;
+	packet.reserve(length + 1 + VarInt::MaxBytes);
+	packet.push_back((char)mode);
+	if (mode == TCPPacketMode::BINARY)
+	{
+		uint8 header[VarInt::MaxBytes];
+		packet.append((const char*)header, VarInt::Encode(header, length));
+	}
+	packet.append(data, length);
+	if (mode == TCPPacketMode::JSON_LINE)
+		packet.push_back('\n');
+
+	bool wasEmpty;
+	{
+		std::lock_guard<std::mutex> lock(m_sendLock);
+		wasEmpty = m_pendingSend.empty();
+		m_pendingSend.push_back(std::move(packet));
+	}
+	// The I/O thread takes all pending packets at once, it only needs to be woken up for the first one
+	if (wasEmpty)
+		m_Wake();
+}
+
+void TCPConnection::Receive(Vector<TCPPacket>& out)
+{
+	std::lock_guard<std::mutex> lock(m_receiveLock);
+	if (out.empty())
+	{
+		std::swap(out, m_received);
+		return;
+	}
+	for (TCPPacket& packet : m_received)
+		out.push_back(std::move(packet));
+	m_received.clear();
+}
+
+void TCPConnection::m_Wake()
+{
+#ifdef __linux__
+	if (m_wakeEvent >= 0)
+	{
+		uint64 one = 1;
+		ssize_t written = write(m_wakeEvent, &one, sizeof(one));
+		(void)written;
+	}
+#endif
+}
+
+void TCPConnection::m_SetClosed()
+{
+	m_closed = true;
+}
+
+void TCPConnection::m_IOThread()
+{
+	PROFILE_THREAD("Socket I/O");
+	bool wantWrite = false;
+	while (!m_stop && !m_closed)
+	{
+		bool readable = false;
+		bool writable = false;
+#ifdef __linux__
+		epoll_event ev = {};
+		ev.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? (uint32_t)EPOLLOUT : (uint32_t)0);
+		ev.data.fd = m_socket;
+		epoll_ctl(m_epoll, EPOLL_CTL_MOD, m_socket, &ev);
+
+		epoll_event events[2];
+		int numEvents = epoll_wait(m_epoll, events, 2, -1);
+		for (int i = 0; i < numEvents; i++)
+		{
+			if (events[i].data.fd == m_wakeEvent)
+			{
+				uint64 value;
+				ssize_t r = read(m_wakeEvent, &value, sizeof(value));
+				(void)r;
+				continue;
+			}
+			if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+				readable = true;
+			if (events[i].events & EPOLLOUT)
+				writable = true;
+		}
+#else
+		// No wake up event, poll for queued packets in short intervals
+		fd_set readFds, writeFds;
+		FD_ZERO(&readFds);
+		FD_ZERO(&writeFds);
+		FD_SET(m_socket, &readFds);
+		if (wantWrite)
+			FD_SET(m_socket, &writeFds);
+		timeval tv;
+		tv.tv_sec = 0;
+		tv.tv_usec = 2000;
+		if (select((int)m_socket + 1, &readFds, &writeFds, 0, &tv) > 0)
+		{
+			readable = FD_ISSET(m_socket, &readFds) != 0;
+			writable = FD_ISSET(m_socket, &writeFds) != 0;
+		}
+#endif
+		if (m_stop)
+			break;
+
+		if (readable && !m_Read())
+		{
+			m_SetClosed();
+			break;
+		}
+
+		// Take the packets queued since the last write
+		{
+			std::lock_guard<std::mutex> lock(m_sendLock);
+			for (String& packet : m_pendingSend)
+				m_writeQueue.push_back(std::move(packet));
+			m_pendingSend.clear();
+		}
+		if ((writable || !wantWrite) && !m_writeQueue.empty())
+		{
+			if (!m_Write())
+			{
+				m_SetClosed();
+				break;
+			}
+		}
+		wantWrite = !m_writeQueue.empty();
+	}
+}
+
+bool TCPConnection::m_Read()
+{
+	PROFILE_SCOPE("Socket Read");
+	while (true)
+	{
+		// Grow the buffer when it's full
+		if (m_readSize == m_readBuffer.size())
+		{
+			if (m_readBuffer.size() * 2 > MaxPacketSize)
+			{
+				Log("[Socket] Packet exceeds the maximum size", Logger::Severity::Error);
+				return false;
+			}
+			Vector<char> newBuffer(m_readBuffer.size() * 2);
+			for (size_t i = 0; i < m_readSize; i++)
+				newBuffer[i] = m_readBuffer[(m_readStart + i) & (m_readBuffer.size() - 1)];
+			m_readBuffer = std::move(newBuffer);
+			m_readStart = 0;
+		}
+
+		// Read into the free space up to the end of the buffer
+		const size_t mask = m_readBuffer.size() - 1;
+		const size_t writePos = (m_readStart + m_readSize) & mask;
+		const size_t contiguous = std::min(m_readBuffer.size() - m_readSize, m_readBuffer.size() - writePos);
+		int received = recv(m_socket, m_readBuffer.data() + writePos, (int)contiguous, 0);
+		if (received == 0)
+			return false; // Closed by the peer
+		if (received < 0)
+		{
+			if (WouldBlock())
+				break;
+			return false;
+		}
+		m_readSize += received;
+		m_ParsePackets();
+		if (m_readingMode == TCPPacketMode::UNKNOWN)
+		{
+			Log("[Socket] Received a packet with an unknown mode", Logger::Severity::Error);
+			return false;
+		}
+	}
+
+	if (!m_parsed.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_receiveLock);
+		for (TCPPacket& packet : m_parsed)
+			m_received.push_back(std::move(packet));
+		m_parsed.clear();
+	}
+	return true;
+}
+
+void TCPConnection::m_ParsePackets()
+{
+	const size_t mask = m_readBuffer.size() - 1;
+	auto at = [&](size_t i) { return m_readBuffer[(m_readStart + i) & mask]; };
+	auto consume = [&](size_t n)
+	{
+		m_readStart = (m_readStart + n) & mask;
+		m_readSize -= n;
+	};
+
+	while (m_readSize > 0)
+	{
+		if (m_readingMode == TCPPacketMode::NOT_READING)
+		{
+			// Get a byte to indicate the packet type
+			m_readingMode = (TCPPacketMode)std::min((uint8)at(0), (uint8)TCPPacketMode::UNKNOWN);
+			consume(1);
+			m_scanned = 0;
+			continue;
+		}
+
+		if (m_readingMode == TCPPacketMode::JSON_LINE)
+		{
+			// Continue scanning for the line break where the last scan stopped
+			size_t end = m_scanned;
+			while (end < m_readSize && at(end) != '\n')
+				end++;
+			if (end == m_readSize)
+			{
+				m_scanned = end;
+				return;
+			}
+
+			m_TakePacket(0, end);
+			consume(end + 1);
+			m_readingMode = TCPPacketMode::NOT_READING;
+			continue;
+		}
+
+		if (m_readingMode == TCPPacketMode::BINARY)
+		{
+			// Decode the length, it might not be complete yet
+			uint64 length = 0;
+			size_t header = 0;
+			bool complete = false;
+			for (uint32 shift = 0; shift < 64 && header < m_readSize; shift += 7)
+			{
+				const uint8 byte = (uint8)at(header++);
+				length |= (uint64)(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					complete = true;
+					break;
+				}
+			}
+			if (!complete)
+			{
+				if (header >= VarInt::MaxBytes)
+					m_readingMode = TCPPacketMode::UNKNOWN;
+				return;
+			}
+			if (length > MaxPacketSize)
+			{
+				m_readingMode = TCPPacketMode::UNKNOWN;
+				return;
+			}
+			if (m_readSize < header + length)
+				return;
+
+			m_TakePacket(header, (size_t)length);
+			consume(header + (size_t)length);
+			m_readingMode = TCPPacketMode::NOT_READING;
+			continue;
+		}
+
+		// We don't know the kind of packet this is so bail on the stream
+		m_readingMode = TCPPacketMode::UNKNOWN;
+		return;
+	}
+}
+
+void TCPConnection::m_TakePacket(size_t offset, size_t length)
+{
+	TCPPacket packet;
+	packet.mode = m_readingMode;
+	packet.receiveTime = Profiling::Now();
+	packet.data.resize(length);
+	if (length > 0)
+	{
+		// The packet can wrap around the end of the buffer
+		const size_t start = (m_readStart + offset) & (m_readBuffer.size() - 1);
+		const size_t first = std::min(length, m_readBuffer.size() - start);
+		memcpy(&packet.data[0], m_readBuffer.data() + start, first);
+		memcpy(&packet.data[0] + first, m_readBuffer.data(), length - first);
+	}
+	m_parsed.push_back(std::move(packet));
+}
+
+bool TCPConnection::m_Write()
+{
+	PROFILE_SCOPE("Socket Write");
+	while (!m_writeQueue.empty())
+	{
+		// Gather as many queued packets as possible into a single write
+		const size_t numBuffers = std::min(m_writeQueue.size(), maxWriteBuffers);
+		int64 written;
+#ifdef _WIN32
+		WSABUF buffers[maxWriteBuffers];
+		for (size_t i = 0; i < numBuffers; i++)
+		{
+			const size_t offset = i == 0 ? m_writeOffset : 0;
+			buffers[i].buf = &m_writeQueue[i][0] + offset;
+			buffers[i].len = (ULONG)(m_writeQueue[i].size() - offset);
+		}
+		DWORD bytesSent = 0;
+		if (WSASend(m_socket, buffers, (DWORD)numBuffers, &bytesSent, 0, nullptr, nullptr) != 0)
+			written = -1;
+		else
+			written = bytesSent;
+#else
+		iovec buffers[maxWriteBuffers];
+		for (size_t i = 0; i < numBuffers; i++)
+		{
+			const size_t offset = i == 0 ? m_writeOffset : 0;
+			buffers[i].iov_base = &m_writeQueue[i][0] + offset;
+			buffers[i].iov_len = m_writeQueue[i].size() - offset;
+		}
+		msghdr msg = {};
+		msg.msg_iov = buffers;
+		msg.msg_iovlen = numBuffers;
+		written = sendmsg(m_socket, &msg, MSG_NOSIGNAL);
+#endif
+		if (written < 0)
+		{
+			if (WouldBlock())
+				return true; // Continue when the socket is writable again
+			return false;
+		}
+
+		// Remove everything that was written
+		size_t remaining = (size_t)written;
+		while (remaining > 0)
+		{
+			const size_t left = m_writeQueue.front().size() - m_writeOffset;
+			if (remaining < left)
+			{
+				m_writeOffset += remaining;
+				break;
+			}
+			remaining -= left;
+			m_writeOffset = 0;
+			m_writeQueue.pop_front();
+		}
+	}
+	return true;
+}
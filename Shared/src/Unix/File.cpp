@@ -59,6 +59,8 @@ bool File::OpenWrite(const String& path, bool append /*= false*/, bool noLog /*=
 	int flags = O_WRONLY | O_CREAT;
 	if(append)
 		flags |= O_APPEND;
+	else
+		flags |= O_TRUNC; // Same as CREATE_ALWAYS on Windows
 	int handle = open(*path, flags, S_IRUSR | S_IWUSR | S_IROTH);
 	if(handle == -1)
 	{
@@ -116,6 +118,13 @@ size_t File::Write(const void* data, size_t len)
 	assert(m_impl);
 	return write(m_impl->handle, data, (uint32)len);
 }
+bool File::Truncate(size_t size)
+{
+	assert(m_impl);
+	if(ftruncate(m_impl->handle, size) != 0)
+		return false;
+	return lseek(m_impl->handle, size, SEEK_SET) == (off_t)size;
+}
 
 uint64 File::GetLastWriteTime() const
 {
@@ -143,6 +152,15 @@ uint64 File::GetLastWriteTime(const String& path)
 	#endif
 }
 
+bool File::ReadAll(const String& path, Buffer& out)
+{
+	File file;
+	if(!file.OpenRead(path))
+		return false;
+	out.resize(file.GetSize());
+	return file.Read(out.data(), out.size()) == out.size();
+}
+
 bool LoadResourceInternal(const char* name, const char* type, Buffer& out)
 {
 	return false;
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+#include "Log.hpp"
+
+/*
+	Unix implementation
+*/
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+class MappedFile_Impl
+{
+public:
+	MappedFile_Impl(void* data, size_t size) : data(data), size(size) {};
+	~MappedFile_Impl()
+	{
+		if(data)
+			munmap(data, size);
+	}
+	void* data;
+	size_t size;
+};
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+// Reads one byte of every page so it is in memory
+static void TouchPages(const uint8* data, size_t size)
+{
+	const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	volatile uint8 sum = 0;
+	for(size_t i = 0; i < size; i += pageSize)
+		sum += data[i];
+}
+
+bool MappedFile::Open(const String& path, MappedFileAccess access)
+{
+	Close();
+
+	int handle = open(*path, O_RDONLY);
+	if(handle == -1)
+	{
+		Logf("Failed to open file for mapping %s: %d", Logger::Severity::Warning, *path, errno);
+		return false;
+	}
+
+	struct stat sb;
+	if(fstat(handle, &sb) != 0)
+	{
+		close(handle);
+		return false;
+	}
+
+	void* data = nullptr;
+	size_t size = (size_t)sb.st_size;
+	if(size > 0)
+	{
+		data = mmap(nullptr, size, PROT_READ, MAP_SHARED, handle, 0);
+		if(data == MAP_FAILED)
+		{
+			Logf("Failed to map file %s: %d", Logger::Severity::Warning, *path, errno);
+			close(handle);
+			return false;
+		}
+	}
+	// The mapping stays valid after closing the descriptor
+	close(handle);
+
+	m_impl = new MappedFile_Impl(data, size);
+	if(access != MappedFileAccess::Normal)
+		Advise(access);
+	return true;
+}
+void MappedFile::Close()
+{
+	if(m_impl)
+	{
+		delete m_impl;
+		m_impl = nullptr;
+	}
+}
+bool MappedFile::IsOpen() const
+{
+	return m_impl != nullptr;
+}
+void MappedFile::Advise(MappedFileAccess access)
+{
+	assert(m_impl);
+	if(!m_impl->data)
+		return;
+	int advice = MADV_NORMAL;
+	if(access == MappedFileAccess::Sequential)
+		advice = MADV_SEQUENTIAL;
+	else if(access == MappedFileAccess::Random)
+		advice = MADV_RANDOM;
+	madvise(m_impl->data, m_impl->size, advice);
+}
+void MappedFile::Prefetch(bool wait)
+{
+	assert(m_impl);
+	if(!m_impl->data)
+		return;
+	madvise(m_impl->data, m_impl->size, MADV_WILLNEED);
+	if(wait)
+		TouchPages((const uint8*)m_impl->data, m_impl->size);
+}
+const uint8* MappedFile::GetData() const
+{
+	assert(m_impl);
+	return (const uint8*)m_impl->data;
+}
+size_t MappedFile::GetSize() const
+{
+	assert(m_impl);
+	return m_impl->size;
+}
@@ -131,6 +131,13 @@ size_t File::Write(const void* data, size_t len)
 	WriteFile(m_impl->handle, data, (DWORD)len, (DWORD*)&actual, 0);
 	return actual;
 }
+bool File::Truncate(size_t size)
+{
+	assert(m_impl);
+	LARGE_INTEGER pos;
+	pos.QuadPart = size;
+	return SetFilePointerEx(m_impl->handle, pos, nullptr, FILE_BEGIN) && SetEndOfFile(m_impl->handle);
+}
 
 uint64 File::GetLastWriteTime() const
 {
@@ -155,6 +162,15 @@ uint64 File::GetLastWriteTime(const String& path)
 	return (uint64&)ftWrite;
 }
 
+bool File::ReadAll(const String& path, Buffer& out)
+{
+	File file;
+	if(!file.OpenRead(path))
+		return false;
+	out.resize(file.GetSize());
+	return file.Read(out.data(), out.size()) == out.size();
+}
+
 static bool LoadResourceInternal(const char* name, const char* type, Buffer& out)
 {
 	HMODULE module = GetModuleHandle(nullptr);
@@ -0,0 +1,30 @@
+#include "stdafx.h"
+#include "FramePacer.hpp"
+#include <thread>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+void FramePacer::PlatformSleepUntil(Clock::time_point time)
+{
+	// High resolution timers are not bound to the scheduler tick, they are only available since Windows 10 1803
+	thread_local HANDLE timer = []()
+	{
+		HANDLE handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if(!handle)
+			handle = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		return handle;
+	}();
+
+	// Due time is relative in units of 100ns
+	const int64 delay = std::chrono::duration_cast<std::chrono::nanoseconds>(time - Clock::now()).count() / 100;
+	if(delay <= 0)
+		return;
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -delay;
+	if(timer && SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE))
+		WaitForSingleObject(timer, INFINITE);
+	else
+		std::this_thread::sleep_until(time);
+}
@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+#include "Log.hpp"
+
+/*
+	Windows implementation
+*/
+class MappedFile_Impl
+{
+public:
+	MappedFile_Impl(HANDLE mapping, void* data, size_t size) : mapping(mapping), data(data), size(size) {};
+	~MappedFile_Impl()
+	{
+		if(data)
+			UnmapViewOfFile(data);
+		if(mapping)
+			CloseHandle(mapping);
+	}
+	HANDLE mapping;
+	void* data;
+	size_t size;
+};
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+// Reads one byte of every page so it is in memory
+static void TouchPages(const uint8* data, size_t size)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	volatile uint8 sum = 0;
+	for(size_t i = 0; i < size; i += info.dwPageSize)
+		sum += data[i];
+}
+
+bool MappedFile::Open(const String& path, MappedFileAccess access)
+{
+	Close();
+	WString wstringPath = Utility::ConvertToWString(path);
+	// Allow other handles to keep writing to the file
+	HANDLE h = CreateFileW(*wstringPath,
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE,
+		nullptr,
+		OPEN_EXISTING,
+		access == MappedFileAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : (access == MappedFileAccess::Random ? FILE_FLAG_RANDOM_ACCESS : 0), 0);
+	if(h == INVALID_HANDLE_VALUE)
+	{
+		Logf("Failed to open file for mapping %s: %s", Logger::Severity::Warning, *path, Utility::WindowsFormatMessage(GetLastError()));
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(h, &fileSize))
+	{
+		CloseHandle(h);
+		return false;
+	}
+
+	HANDLE mapping = nullptr;
+	void* data = nullptr;
+	size_t size = (size_t)fileSize.QuadPart;
+	if(size > 0)
+	{
+		mapping = CreateFileMappingW(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mapping)
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if(!data)
+		{
+			Logf("Failed to map file %s: %s", Logger::Severity::Warning, *path, Utility::WindowsFormatMessage(GetLastError()));
+			if(mapping)
+				CloseHandle(mapping);
+			CloseHandle(h);
+			return false;
+		}
+	}
+	// The mapping keeps its own reference to the file
+	CloseHandle(h);
+
+	m_impl = new MappedFile_Impl(mapping, data, size);
+	return true;
+}
+void MappedFile::Close()
+{
+	if(m_impl)
+	{
+		delete m_impl;
+		m_impl = nullptr;
+	}
+}
+bool MappedFile::IsOpen() const
+{
+	return m_impl != nullptr;
+}
+void MappedFile::Advise(MappedFileAccess access)
+{
+	// The access pattern can only be given when the file is opened on Windows
+	assert(m_impl);
+}
+void MappedFile::Prefetch(bool wait)
+{
+	assert(m_impl);
+	if(m_impl->data && wait)
+		TouchPages((const uint8*)m_impl->data, m_impl->size);
+}
+const uint8* MappedFile::GetData() const
+{
+	assert(m_impl);
+	return (const uint8*)m_impl->data;
+}
+size_t MappedFile::GetSize() const
+{
+	assert(m_impl);
+	return m_impl->size;
+}
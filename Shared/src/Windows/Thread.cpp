@@ -15,4 +15,10 @@ size_t Thread::SetCurrentThreadAffinityMask(size_t affinityMask)
 	HANDLE h = (HANDLE)GetCurrentThread();
 	size_t res = (uint32)SetThreadAffinityMask(h, affinityMask);
 	return res;
-}
\ No newline at end of file
+}
+
+bool Thread::SetCurrentThreadBackgroundPriority()
+{
+	// Also lowers the IO priority of the thread
+	return SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) != 0;
+}
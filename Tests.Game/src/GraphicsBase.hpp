@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Graphics/Graphics.hpp>
+#include <algorithm>
 using namespace Graphics;
 
 class GraphicsTest : public Unique
@@ -13,4 +14,39 @@ public:
 protected:
 	Graphics::Window* m_window = nullptr;
 	Graphics::OpenGL* m_gl = nullptr;
-};
\ No newline at end of file
+};
+
+// Frame times in milliseconds bucketed as a histogram
+class FrameHistogram
+{
+public:
+	void Add(double ms)
+	{
+		times.Add(ms);
+		for(uint32 i = 0; i < numBuckets; i++)
+		{
+			if(ms < bucketLimits[i] || i == numBuckets - 1)
+			{
+				counts[i]++;
+				break;
+			}
+		}
+	}
+	void Print(const char* name)
+	{
+		Vector<double> sorted = times;
+		std::sort(sorted.begin(), sorted.end());
+		Logf("%s: %d frames, p50 %.2f ms, p99 %.2f ms, max %.2f ms", Logger::Severity::Info, name, (int32)sorted.size(),
+			sorted[sorted.size() / 2], sorted[sorted.size() * 99 / 100], sorted.back());
+		for(uint32 i = 0; i < numBuckets; i++)
+		{
+			String label = i == numBuckets - 1 ? Utility::Sprintf(">= %.0f ms", bucketLimits[i - 1]) : Utility::Sprintf("< %.0f ms", bucketLimits[i]);
+			Logf("  %-10s %5d %s", Logger::Severity::Info, label, counts[i], String(counts[i] * 60 / sorted.size(), '#'));
+		}
+	}
+
+	static const uint32 numBuckets = 7;
+	const double bucketLimits[numBuckets] = { 2.0, 4.0, 8.0, 16.7, 33.3, 50.0, 0.0 };
+	uint32 counts[numBuckets] = { 0 };
+	Vector<double> times;
+};
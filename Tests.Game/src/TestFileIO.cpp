@@ -0,0 +1,203 @@
+#include "stdafx.h"
+#include <Shared/Files.hpp>
+#include <Beatmap/Beatmap.hpp>
+#include <Beatmap/TinySHA1.hpp>
+#include <functional>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace Graphics;
+
+// Folder that is scanned for charts, songs and jackets
+static String testSongsPath = Path::Normalize("songs");
+// Files read per benchmark, keeps the cold runs short on slow disks
+static const size_t maxTestFiles = 500;
+
+// Drops a file from the page cache so the next read has to go to the disk
+//	only possible on Linux, the cold runs read from the cache on other platforms
+static bool DropFromPageCache(const String& path)
+{
+#ifdef __linux__
+	int handle = open(*path, O_RDONLY);
+	if(handle == -1)
+		return false;
+	bool dropped = posix_fadvise(handle, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(handle);
+	return dropped;
+#else
+	return false;
+#endif
+}
+
+static Vector<FileInfo> ScanTestFiles(const Vector<String>& extensions)
+{
+	Vector<FileInfo> files;
+	for(const String& extension : extensions)
+	{
+		Vector<FileInfo> found = Files::ScanFilesRecursive(testSongsPath, extension);
+		files.insert(files.end(), found.begin(), found.end());
+	}
+	if(files.size() > maxTestFiles)
+		files.resize(maxTestFiles);
+	return files;
+}
+
+// Reads all files with the buffered path and the mapped path, first with the files dropped from the page cache, then with them cached
+static void BenchmarkFileIO(const String& name, const Vector<FileInfo>& files,
+	const std::function<bool(const String&)>& buffered, const std::function<bool(const String&)>& mapped)
+{
+	TestEnsure(!files.empty());
+	size_t totalBytes = 0;
+	for(const FileInfo& file : files)
+	{
+		File f;
+		if(f.OpenRead(file.fullPath))
+			totalBytes += f.GetSize();
+	}
+
+	bool cold = true;
+	auto run = [&](const std::function<bool(const String&)>& read, bool dropCache)
+	{
+		if(dropCache)
+		{
+			for(const FileInfo& file : files)
+				cold &= DropFromPageCache(file.fullPath);
+		}
+		Timer timer;
+		for(const FileInfo& file : files)
+			TestEnsure(read(file.fullPath));
+		return timer.SecondsAsDouble();
+	};
+	const double bufferedCold = run(buffered, true);
+	const double mappedCold = run(mapped, true);
+	const double bufferedWarm = run(buffered, false);
+	const double mappedWarm = run(mapped, false);
+
+	const double megabytes = totalBytes / (1024.0 * 1024.0);
+	Logf("%s, %d files, %.1f MB%s", Logger::Severity::Info, name, files.size(), megabytes, cold ? "" : " (the page cache could not be dropped)");
+	Logf("\tCold cache: buffered %.3f ms/file %.1f MB/s, mapped %.3f ms/file %.1f MB/s", Logger::Severity::Info,
+		bufferedCold * 1000.0 / files.size(), megabytes / bufferedCold, mappedCold * 1000.0 / files.size(), megabytes / mappedCold);
+	Logf("\tWarm cache: buffered %.3f ms/file %.1f MB/s, mapped %.3f ms/file %.1f MB/s", Logger::Severity::Info,
+		bufferedWarm * 1000.0 / files.size(), megabytes / bufferedWarm, mappedWarm * 1000.0 / files.size(), megabytes / mappedWarm);
+}
+
+static String FormatDigest(sha1::SHA1& s)
+{
+	uint32_t digest[5];
+	s.getDigest(digest);
+	return Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
+}
+
+// Metadata load and hash of every chart, the work the chart database does for new charts
+Test("FileIO.Charts")
+{
+	Vector<FileInfo> files = ScanTestFiles({ "ksh" });
+	Map<String, String> hashes;
+
+	auto buffered = [&](const String& path)
+	{
+		File file;
+		if(!file.OpenRead(path))
+			return false;
+		FileReader reader(file);
+		Beatmap map;
+		map.Load(reader, true);
+
+		file.Seek(0);
+		char buffer[0x80];
+		sha1::SHA1 s;
+		size_t readSize;
+		while((readSize = file.Read(buffer, sizeof(buffer))) != 0)
+			s.processBytes(buffer, readSize);
+		hashes[path] = FormatDigest(s);
+		return true;
+	};
+	auto mapped = [&](const String& path)
+	{
+		MappedFile file;
+		if(!file.Open(path, MappedFileAccess::Sequential))
+			return false;
+		MappedReader reader(file);
+		Beatmap map;
+		map.Load(reader, true);
+
+		sha1::SHA1 s;
+		s.processBytes(file.GetData(), file.GetSize());
+		return FormatDigest(s) == hashes[path];
+	};
+	BenchmarkFileIO("Charts", files, buffered, mapped);
+}
+
+// Full load of every chart, as done when a chart is played
+Test("FileIO.ChartLoad")
+{
+	Vector<FileInfo> files = ScanTestFiles({ "ksh" });
+
+	auto buffered = [](const String& path)
+	{
+		File file;
+		if(!file.OpenRead(path))
+			return false;
+		FileReader reader(file);
+		Beatmap map;
+		return map.Load(reader);
+	};
+	auto mapped = [](const String& path)
+	{
+		MappedFile file;
+		if(!file.Open(path, MappedFileAccess::Sequential))
+			return false;
+		MappedReader reader(file);
+		Beatmap map;
+		return map.Load(reader);
+	};
+	BenchmarkFileIO("Charts, full load", files, buffered, mapped);
+}
+
+// Reading songs for preloaded audio streams, without decoding
+Test("FileIO.Audio")
+{
+	Vector<FileInfo> files = ScanTestFiles({ "ogg", "mp3", "wav", "flac" });
+
+	auto buffered = [](const String& path)
+	{
+		File file;
+		if(!file.OpenRead(path))
+			return false;
+		Buffer data(file.GetSize());
+		return file.Read(data.data(), data.size()) == data.size();
+	};
+	auto mapped = [](const String& path)
+	{
+		MappedFile file;
+		if(!file.Open(path))
+			return false;
+		file.Prefetch(true);
+		return true;
+	};
+	BenchmarkFileIO("Audio", files, buffered, mapped);
+}
+
+// Loading and decoding jackets
+Test("FileIO.Images")
+{
+	Vector<FileInfo> files = ScanTestFiles({ "jpg", "png" });
+
+	auto buffered = [](const String& path)
+	{
+		File file;
+		if(!file.OpenRead(path))
+			return false;
+		Buffer data(file.GetSize());
+		file.Read(data.data(), data.size());
+		ImageRes::Create(data);
+		return true;
+	};
+	auto mapped = [](const String& path)
+	{
+		ImageRes::Create(path);
+		return true;
+	};
+	BenchmarkFileIO("Images", files, buffered, mapped);
+}
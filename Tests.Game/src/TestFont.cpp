@@ -0,0 +1,99 @@
+#include "stdafx.h"
+#include "GraphicsBase.hpp"
+
+static String testFontPath = Path::Normalize("fonts/settings/NotoSans-Regular.ttf");
+static String testFontVS = Path::Normalize("skins/Default/shaders/font.vs");
+static String testFontFS = Path::Normalize("skins/Default/shaders/font.fs");
+
+// Renders 500 strings that change every frame
+//	the first half of the frames draws each text separately, the second half uses a single TextBatch
+Test("Font.Benchmark")
+{
+	class FontBenchmark : public GraphicsTest
+	{
+	public:
+		const uint32 numStrings = 500;
+		const uint32 numFrames = 600;
+
+		Graphics::Font font;
+		Material material;
+		Ref<TextBatch> batch;
+		uint32 frame = 0;
+		double textTime[2] = { 0.0 };
+		double frameTime[2] = { 0.0 };
+
+		bool Init()
+		{
+			font = FontRes::Create(m_gl, testFontPath);
+			material = MaterialRes::Create(m_gl, testFontVS, testFontFS);
+			if(!font || !material)
+				return false;
+			material->opaque = false;
+			batch = Ref<TextBatch>(new TextBatch(m_gl));
+			return true;
+		}
+
+		void Render(float deltaTime) override
+		{
+			if(!font && !Init())
+			{
+				m_window->Close();
+				return;
+			}
+
+			const uint32 mode = frame < numFrames / 2 ? 0 : 1;
+			Timer frameTimer;
+
+			Vector2i size = m_window->GetWindowSize();
+			RenderState rs;
+			rs.viewportSize = size;
+			rs.aspectRatio = (float)size.x / (float)size.y;
+			rs.projectionTransform = ProjectionMatrix::CreateOrthographic(0.0f, (float)size.x, (float)size.y, 0.0f, 0.0f, 100.0f);
+			RenderQueue rq(m_gl, rs);
+			MaterialParameterSet params;
+			params.SetParameter("color", Color::White);
+
+			// Score, combo and timer style strings that are different every frame
+			Timer textTimer;
+			batch->Clear();
+			for(uint32 i = 0; i < numStrings; i++)
+			{
+				WString str = Utility::ConvertToWString(Utility::Sprintf("%08d x%d", frame * 997 + i * 7919, (frame + i) % 2500));
+				Text text = font->CreateText(str, 12 + (i % 4) * 4);
+				Transform transform = Transform::Translation(Vector2((float)(i % 10) * 120.0f, (float)(i / 10) * 14.0f));
+				if(mode == 0)
+					rq.Draw(transform, text, material, params);
+				else
+					batch->Add(text, transform);
+			}
+			if(mode == 1)
+				rq.Draw(Transform(), *batch, material, params);
+			textTime[mode] += textTimer.SecondsAsDouble();
+
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			rq.Process();
+			m_gl->SwapBuffers();
+			FontRes::EndFrame();
+			frameTime[mode] += frameTimer.SecondsAsDouble();
+
+			frame++;
+			if(frame == numFrames)
+			{
+				const double frames = numFrames / 2;
+				Logf("Separate draws: %.3f ms text, %.3f ms frame", Logger::Severity::Info,
+					textTime[0] / frames * 1000.0, frameTime[0] / frames * 1000.0);
+				Logf("Batched draw: %.3f ms text, %.3f ms frame", Logger::Severity::Info,
+					textTime[1] / frames * 1000.0, frameTime[1] / frames * 1000.0);
+				m_window->Close();
+			}
+		}
+	};
+
+	TestEnsure(FontRes::InitLibrary());
+	{
+		FontBenchmark benchmark;
+		TestEnsure(benchmark.Run());
+	}
+	FontRes::FreeLibrary();
+}
@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include <Shared/Files.hpp>
+#include <cmath>
+using namespace Graphics;
+
+// Folder that is scanned for jacket images
+static String testJacketPath = Path::Normalize("songs");
+static const Vector2i testJacketSize = Vector2i(256, 256);
+
+// Nearest neighbour scaling, as jackets were resized before the area averaging filter
+static Vector<Colori> ResizeNearest(const Image& image, Vector2i size)
+{
+	Vector<Colori> ret(size.x * size.y);
+	Vector2i srcSize = image->GetSize();
+	for(int32 ix = 0; ix < size.x; ++ix)
+	{
+		for(int32 iy = 0; iy < size.y; ++iy)
+		{
+			int32 sampledX = ix * ((double)srcSize.x / (double)size.x);
+			int32 sampledY = iy * ((double)srcSize.y / (double)size.y);
+			ret[size.x * iy + ix] = image->GetBits()[srcSize.x * sampledY + sampledX];
+		}
+	}
+	return ret;
+}
+
+static double PSNR(const Colori* a, const Colori* b, size_t numPixels)
+{
+	double sum = 0.0;
+	for(size_t i = 0; i < numPixels; i++)
+	{
+		double dr = (double)a[i].x - (double)b[i].x;
+		double dg = (double)a[i].y - (double)b[i].y;
+		double db = (double)a[i].z - (double)b[i].z;
+		sum += dr * dr + dg * dg + db * db;
+	}
+	double mse = sum / (numPixels * 3);
+	if(mse == 0.0)
+		return 99.0;
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+// Compares the old jacket path (full decode + nearest neighbour) with the new one (scaled decode + area averaging)
+//	quality is measured against a full resolution decode that is area averaged
+Test("Image.JacketDownscale")
+{
+	Vector<FileInfo> files = Files::ScanFilesRecursive(testJacketPath, "jpg");
+	Vector<FileInfo> pngFiles = Files::ScanFilesRecursive(testJacketPath, "png");
+	files.insert(files.end(), pngFiles.begin(), pngFiles.end());
+	TestEnsure(!files.empty());
+
+	double oldTime = 0.0, newTime = 0.0;
+	double oldPSNR = 0.0, newPSNR = 0.0;
+	uint32 numJackets = 0;
+	const size_t numPixels = testJacketSize.x * testJacketSize.y;
+	for(const FileInfo& file : files)
+	{
+		Timer t;
+		Image full = ImageRes::Create(file.fullPath);
+		if(!full || full->GetSize().x < testJacketSize.x || full->GetSize().y < testJacketSize.y)
+			continue;
+		Vector<Colori> nearest = ResizeNearest(full, testJacketSize);
+		oldTime += t.SecondsAsDouble();
+
+		t.Restart();
+		Image scaled = ImageRes::Create(file.fullPath, testJacketSize);
+		TestEnsure(scaled);
+		scaled->ReSize(testJacketSize);
+		newTime += t.SecondsAsDouble();
+
+		full->ReSize(testJacketSize);
+		oldPSNR += PSNR(full->GetBits(), nearest.data(), numPixels);
+		newPSNR += PSNR(full->GetBits(), scaled->GetBits(), numPixels);
+		numJackets++;
+	}
+	TestEnsure(numJackets > 0);
+
+	Logf("%d jackets scaled to %dx%d", Logger::Severity::Info, numJackets, testJacketSize.x, testJacketSize.y);
+	Logf("Nearest neighbour: %.1f jackets/s, %.2f dB PSNR", Logger::Severity::Info, numJackets / oldTime, oldPSNR / numJackets);
+	Logf("Scaled decode + area average: %.1f jackets/s, %.2f dB PSNR", Logger::Severity::Info, numJackets / newTime, newPSNR / numJackets);
+}
@@ -0,0 +1,207 @@
+#include "stdafx.h"
+#include <Beatmap/InputReplay.hpp>
+#include <Beatmap/MapDatabase.hpp>
+#include <Shared/MemoryStream.hpp>
+#include <random>
+
+// Generates the input of a 2 minute play at 240 fps with mouse lasers
+static InputReplay GenerateTestReplay()
+{
+	InputReplay replay;
+	replay.hitWindowPerfect = 46;
+	replay.hitWindowGood = 150;
+	replay.hitWindowHold = 150;
+	replay.hitWindowMiss = 300;
+	replay.hitWindowSlam = 84;
+	replay.inputOffset = -12;
+	replay.score = 9876543;
+	replay.perfects = 1400;
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> jitter(-0.0002f, 0.0002f);
+	std::uniform_int_distribution<int32> mouse(-12, 12);
+	std::uniform_int_distribution<int32> chance(0, 99);
+
+	bool buttons[6] = { false };
+	bool laserActive = false;
+	double time = 0.0;
+	while (time < 120.0)
+	{
+		const float deltaTime = 1.0f / 240.0f + jitter(random);
+		time += deltaTime;
+
+		// Roughly 10 button presses per second
+		for (uint8 i = 0; i < 6; i++)
+		{
+			if (chance(random) < 1)
+			{
+				buttons[i] = !buttons[i];
+				replay.AddEvent(i, buttons[i]);
+			}
+		}
+		if (chance(random) < 1)
+			laserActive = !laserActive;
+
+		float lasers[2] = { 0.0f };
+		if (laserActive)
+		{
+			lasers[0] = 0.0025f * mouse(random);
+			lasers[1] = 0.0025f * mouse(random);
+		}
+		replay.AddFrame((MapTime)(time * 1000.0), deltaTime, lasers[0], lasers[1]);
+	}
+	return replay;
+}
+
+// Judgements of the same play as stored in the current .urf replays
+static Vector<SimpleHitStat> GenerateTestHitStats()
+{
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<int32> delta(-40, 40);
+	Vector<SimpleHitStat> stats;
+	// 1500 notes and 1000 hold/laser ticks
+	for (int32 i = 0; i < 2500; i++)
+	{
+		SimpleHitStat stat;
+		stat.rating = 2;
+		stat.lane = i % 8;
+		stat.time = i * 48;
+		stat.delta = i < 1500 ? delta(random) : 0;
+		stats.Add(stat);
+	}
+	return stats;
+}
+
+Test("InputReplay.RoundTrip")
+{
+	InputReplay replay = GenerateTestReplay();
+	for (bool compress : { false, true })
+	{
+		Buffer buffer;
+		MemoryWriter writer(buffer);
+		TestEnsure(replay.Save(writer, compress));
+
+		InputReplay loaded;
+		MemoryReader reader(buffer);
+		TestEnsure(loaded.Load(reader));
+		TestEnsure(loaded.score == replay.score);
+		TestEnsure(loaded.inputOffset == replay.inputOffset);
+		TestEnsure(loaded.frames.size() == replay.frames.size());
+		TestEnsure(loaded.events.size() == replay.events.size());
+		for (size_t i = 0; i < replay.frames.size(); i++)
+		{
+			const InputReplayFrame& a = replay.frames[i];
+			const InputReplayFrame& b = loaded.frames[i];
+			TestEnsure(a.time == b.time);
+			TestEnsure(memcmp(&a.deltaTime, &b.deltaTime, sizeof(float)) == 0);
+			TestEnsure(memcmp(a.laserInput, b.laserInput, sizeof(a.laserInput)) == 0);
+			TestEnsure(a.firstEvent == b.firstEvent && a.numEvents == b.numEvents);
+			TestEnsure(a.numRepeats == b.numRepeats);
+		}
+		for (size_t i = 0; i < replay.events.size(); i++)
+		{
+			TestEnsure(replay.events[i].button == loaded.events[i].button);
+			TestEnsure(replay.events[i].pressed == loaded.events[i].pressed);
+		}
+	}
+
+	// Truncated files should fail to load
+	Buffer buffer;
+	MemoryWriter writer(buffer);
+	TestEnsure(replay.Save(writer, false));
+	buffer.resize(buffer.size() / 2);
+	InputReplay truncated;
+	MemoryReader reader(buffer);
+	TestEnsure(!truncated.Load(reader));
+}
+
+// Steps of the gameplay thread without input are merged into the frame before them
+Test("InputReplay.Repeats")
+{
+	const float deltaTime = 0.001f;
+	InputReplay replay;
+	Vector<MapTime> times;
+	for (MapTime time = 0; time < 10000; time++)
+	{
+		// A missed step
+		if (time == 5000)
+			continue;
+		if (time % 100 == 50)
+			replay.AddEvent(0, (time / 100) % 2 == 0);
+		const float laser = time % 500 == 0 ? 0.1f : 0.0f;
+		replay.AddFrame(time, deltaTime, laser, 0.0f);
+		times.push_back(time);
+	}
+	TestEnsure(replay.frames.size() < 250);
+
+	Buffer buffer;
+	MemoryWriter writer(buffer);
+	TestEnsure(replay.Save(writer, false));
+	InputReplay loaded;
+	MemoryReader reader(buffer);
+	TestEnsure(loaded.Load(reader));
+
+	// Every step comes back at its time, with its events attached to it
+	Vector<MapTime> loadedTimes;
+	for (const InputReplayFrame& frame : loaded.frames)
+	{
+		TestEnsure(frame.deltaTime == deltaTime);
+		TestEnsure(frame.numEvents == (frame.time % 100 == 50 ? 1 : 0));
+		for (uint32 i = 0; i <= frame.numRepeats; i++)
+			loadedTimes.push_back(frame.time + (MapTime)i);
+	}
+	TestEnsure(loadedTimes == times);
+	TestEnsure(loaded.events.size() == replay.events.size());
+}
+
+// Compares the size and decoding time with the hit stat replays (.urf)
+Test("InputReplay.Size")
+{
+	const uint32 numIterations = 50;
+	InputReplay replay = GenerateTestReplay();
+	Vector<SimpleHitStat> hitStats = GenerateTestHitStats();
+
+	Buffer urf;
+	{
+		MemoryWriter writer(urf);
+		writer.SerializeObject(hitStats);
+		int32 hitWindow[5] = { 46, 150, 150, 300, 84 };
+		writer.Serialize(hitWindow, sizeof(hitWindow));
+	}
+	Buffer raw, compressed;
+	{
+		MemoryWriter rawWriter(raw);
+		TestEnsure(replay.Save(rawWriter, false));
+		MemoryWriter compressedWriter(compressed);
+		TestEnsure(replay.Save(compressedWriter, true));
+	}
+
+	Timer t;
+	for (uint32 i = 0; i < numIterations; i++)
+	{
+		Vector<SimpleHitStat> loaded;
+		MemoryReader reader(urf);
+		reader.SerializeObject(loaded);
+		TestEnsure(loaded.size() == hitStats.size());
+	}
+	const double urfTime = t.SecondsAsDouble() / numIterations;
+
+	double inputTime[2];
+	Buffer* buffers[2] = { &raw, &compressed };
+	for (uint32 b = 0; b < 2; b++)
+	{
+		t.Restart();
+		for (uint32 i = 0; i < numIterations; i++)
+		{
+			InputReplay loaded;
+			MemoryReader reader(*buffers[b]);
+			TestEnsure(loaded.Load(reader));
+		}
+		inputTime[b] = t.SecondsAsDouble() / numIterations;
+	}
+
+	Logf("%d frames, %d button events", Logger::Severity::Info, (int32)replay.frames.size(), (int32)replay.events.size());
+	Logf(".urf (%d hit stats): %d bytes, %.3f ms to decode", Logger::Severity::Info, (int32)hitStats.size(), (int32)urf.size(), urfTime * 1000.0);
+	Logf("Input replay: %d bytes, %.3f ms to decode", Logger::Severity::Info, (int32)raw.size(), inputTime[0] * 1000.0);
+	Logf("Input replay (deflate): %d bytes, %.3f ms to decode", Logger::Severity::Info, (int32)compressed.size(), inputTime[1] * 1000.0);
+}
@@ -0,0 +1,154 @@
+#include "stdafx.h"
+#include "GraphicsBase.hpp"
+#include <Graphics/MeshGenerators.hpp>
+
+// Simulates a laser heavy chart scrolling by at high speed, every laser segment is a few quads
+//	the first half of the frames creates a mesh per segment when it becomes visible and destroys it after it passed,
+//	the second half draws ranges of static meshes that contain all segments of a few seconds
+Test("LaserMeshes.Scroll")
+{
+	class LaserBenchmark : public GraphicsTest
+	{
+	public:
+		const uint32 numFrames = 1200;
+		// Dense zigzags on both lasers
+		const int32 segmentDuration = 15;
+		const int32 chartDuration = 120000;
+		const int32 viewDuration = 1500;
+		const int32 frameDuration = 50;
+		const int32 chunkDuration = 10000;
+
+		struct Segment
+		{
+			int32 time;
+			Vector<MeshGenerators::SimpleVertex> verts;
+			// Range in the chunk mesh
+			uint32 chunk = 0;
+			uint32 firstVertex = 0;
+		};
+		Vector<Segment> segments;
+		Map<uint32, Mesh> dynamicMeshes;
+		Vector<Mesh> chunks;
+		FrameHistogram histograms[2];
+		uint32 numMeshesCreated[2] = { 0 };
+		// Both modes draw every visible segment separately
+		uint32 numDraws[2] = { 0 };
+		uint32 frame = 0;
+
+		void GenerateChart()
+		{
+			for(int32 t = 0; t < chartDuration; t += segmentDuration)
+			{
+				for(uint32 laser = 0; laser < 2; laser++)
+				{
+					Segment segment;
+					segment.time = t;
+					const float x = (float)((t / segmentDuration) % 2) - 0.5f + (float)laser * 0.1f;
+					MeshGenerators::GenerateSimpleXYQuad(Shared::Rect3D(Vector2(x, 0.0f), Vector2(0.1f, 0.5f)), Shared::Rect(0.0f, 0.0f, 1.0f, 1.0f), segment.verts);
+					// Every fourth segment is a slam with corners
+					if((t / segmentDuration) % 4 == 0)
+					{
+						MeshGenerators::GenerateSimpleXYQuad(Shared::Rect3D(Vector2(x - 0.1f, 0.0f), Vector2(0.1f, 0.1f)), Shared::Rect(0.0f, 0.0f, 1.0f, 1.0f), segment.verts);
+						MeshGenerators::GenerateSimpleXYQuad(Shared::Rect3D(Vector2(x + 0.1f, 0.0f), Vector2(0.1f, 0.1f)), Shared::Rect(0.0f, 0.0f, 1.0f, 1.0f), segment.verts);
+					}
+					segments.Add(segment);
+				}
+			}
+		}
+
+		void BakeChunks()
+		{
+			Vector<MeshGenerators::SimpleVertex> chunkVerts;
+			int32 chunkEnd = chunkDuration;
+			for(Segment& segment : segments)
+			{
+				if(segment.time >= chunkEnd)
+				{
+					Mesh chunk = MeshRes::Create(m_gl);
+					chunk->SetStatic(true);
+					chunk->SetData(chunkVerts);
+					chunk->SetPrimitiveType(PrimitiveType::TriangleList);
+					chunks.Add(chunk);
+					chunkVerts.clear();
+					chunkEnd += chunkDuration;
+				}
+				segment.chunk = (uint32)chunks.size();
+				segment.firstVertex = (uint32)chunkVerts.size();
+				chunkVerts.insert(chunkVerts.end(), segment.verts.begin(), segment.verts.end());
+			}
+			Mesh chunk = MeshRes::Create(m_gl);
+			chunk->SetStatic(true);
+			chunk->SetData(chunkVerts);
+			chunk->SetPrimitiveType(PrimitiveType::TriangleList);
+			chunks.Add(chunk);
+			numMeshesCreated[1] = (uint32)chunks.size();
+		}
+
+		void Render(float deltaTime) override
+		{
+			if(segments.empty())
+			{
+				GenerateChart();
+				BakeChunks();
+			}
+
+			const uint32 mode = frame < numFrames / 2 ? 0 : 1;
+			const int32 now = (int32)(frame % (numFrames / 2)) * frameDuration;
+			Timer frameTimer;
+
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			// Segments are sorted by time, find the visible ones
+			auto first = std::lower_bound(segments.begin(), segments.end(), now, [](const Segment& s, int32 t) { return s.time < t; });
+			for(auto it = first; it != segments.end() && it->time < now + viewDuration; ++it)
+			{
+				const uint32 index = (uint32)(it - segments.begin());
+				numDraws[mode]++;
+				if(mode == 0)
+				{
+					// Same as LaserTrackBuilder::GenerateTrackMesh
+					Mesh* mesh = dynamicMeshes.Find(index);
+					if(!mesh)
+					{
+						Mesh newMesh = MeshRes::Create(m_gl);
+						newMesh->SetData(it->verts);
+						newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
+						mesh = &dynamicMeshes.Add(index, newMesh);
+						numMeshesCreated[0]++;
+					}
+					(*mesh)->Draw();
+				}
+				else
+				{
+					chunks[it->chunk]->DrawRange(it->firstVertex, it->verts.size());
+				}
+			}
+			// Same as LaserTrackBuilder::m_Cleanup
+			for(auto it = dynamicMeshes.begin(); it != dynamicMeshes.end();)
+			{
+				if(segments[it->first].time < now)
+					it = dynamicMeshes.erase(it);
+				else
+					++it;
+			}
+
+			glFinish();
+			histograms[mode].Add(frameTimer.SecondsAsDouble() * 1000.0);
+			m_gl->SwapBuffers();
+
+			frame++;
+			if(frame == numFrames)
+			{
+				histograms[0].Print("Mesh per segment");
+				Logf("  %d meshes created, %d draws", Logger::Severity::Info, numMeshesCreated[0], numDraws[0]);
+				histograms[1].Print("Static chunks");
+				Logf("  %d meshes created, %d draws", Logger::Severity::Info, numMeshesCreated[1], numDraws[1]);
+				m_window->Close();
+			}
+		}
+	};
+
+	LaserBenchmark benchmark;
+	TestEnsure(benchmark.Run());
+}
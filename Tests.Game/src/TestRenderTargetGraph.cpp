@@ -0,0 +1,187 @@
+#include "stdafx.h"
+#include "GraphicsBase.hpp"
+#include <Graphics/RenderTargetGraph.hpp>
+
+static const Vector2i testScreenSize = Vector2i(1280, 720);
+
+// Background at half resolution, the scene samples it and the foreground samples the scene
+Test("RenderTargetGraph.Game")
+{
+	RenderTargetGraph graph;
+	uint32 scene = graph.AddTarget("Scene", 1.0f, 4);
+	uint32 background = graph.AddTarget("Background", 0.5f);
+	graph.AddPass("Background", background);
+	graph.AddPass("Scene", scene, { background });
+	graph.AddPass("Foreground", RenderTargetGraph::Screen, { scene });
+	TestEnsure(graph.Compile(testScreenSize));
+
+	const auto& physical = graph.GetPhysicalTargets();
+	const auto& passes = graph.GetCompiledPasses();
+	TestEnsure(physical.size() == 2);
+	TestEnsure(passes.size() == 3);
+
+	const auto& backgroundTarget = physical[passes[0].output];
+	TestEnsure(backgroundTarget.size.x == 640 && backgroundTarget.size.y == 360);
+	TestEnsure(backgroundTarget.samples == 0);
+	const auto& sceneTarget = physical[passes[1].output];
+	TestEnsure(sceneTarget.size.x == 1280 && sceneTarget.size.y == 720);
+	TestEnsure(sceneTarget.samples == 4);
+
+	TestEnsure(passes[1].inputs.size() == 1 && passes[1].inputs[0] == passes[0].output);
+	TestEnsure(passes[2].output == -1);
+	TestEnsure(passes[2].inputs.size() == 1 && passes[2].inputs[0] == passes[1].output);
+	TestEnsure(passes[0].clear && passes[1].clear && !passes[2].clear);
+}
+
+// Passes that sample the target they render into alternate between two targets
+Test("RenderTargetGraph.PingPong")
+{
+	RenderTargetGraph graph;
+	uint32 target = graph.AddTarget("Effect");
+	graph.AddPass("Base", target);
+	graph.AddPass("Blur0", target, { target });
+	graph.AddPass("Blur1", target, { target });
+	graph.AddPass("Present", RenderTargetGraph::Screen, { target });
+	TestEnsure(graph.Compile(testScreenSize));
+
+	const auto& passes = graph.GetCompiledPasses();
+	TestEnsure(graph.GetPhysicalTargets().size() == 2);
+	TestEnsure(passes[0].output == 0);
+	TestEnsure(passes[1].output == 1 && passes[1].inputs[0] == 0);
+	TestEnsure(passes[2].output == 0 && passes[2].inputs[0] == 1);
+	TestEnsure(passes[3].inputs[0] == 0);
+	TestEnsure(passes[0].clear && passes[1].clear && passes[2].clear);
+}
+
+// Targets of the same size that are not needed at the same time share one render target
+Test("RenderTargetGraph.Aliasing")
+{
+	RenderTargetGraph graph;
+	uint32 a = graph.AddTarget("A");
+	uint32 b = graph.AddTarget("B");
+	uint32 c = graph.AddTarget("C", 0.25f);
+	graph.AddPass("A", a);
+	graph.AddPass("UseA", RenderTargetGraph::Screen, { a });
+	graph.AddPass("B", b);
+	graph.AddPass("C", c, { b });
+	graph.AddPass("UseC", RenderTargetGraph::Screen, { c });
+	TestEnsure(graph.Compile(testScreenSize));
+
+	const auto& passes = graph.GetCompiledPasses();
+	TestEnsure(graph.GetPhysicalTargets().size() == 2);
+	TestEnsure(passes[0].output == passes[2].output);
+	TestEnsure(passes[3].output != passes[2].output);
+	TestEnsure(graph.GetPhysicalTargets()[passes[3].output].size.x == 320);
+}
+
+// Passes that keep rendering into a target don't clear it
+Test("RenderTargetGraph.Continue")
+{
+	RenderTargetGraph graph;
+	uint32 scene = graph.AddTarget("Scene");
+	graph.AddPass("Background", scene);
+	graph.AddPass("Track", scene);
+	graph.AddPass("Foreground", RenderTargetGraph::Screen, { scene });
+	TestEnsure(graph.Compile(testScreenSize));
+
+	const auto& passes = graph.GetCompiledPasses();
+	TestEnsure(graph.GetPhysicalTargets().size() == 1);
+	TestEnsure(passes[0].output == 0 && passes[0].clear);
+	TestEnsure(passes[1].output == 0 && !passes[1].clear);
+}
+
+Test("RenderTargetGraph.Invalid")
+{
+	RenderTargetGraph graph;
+	uint32 target = graph.AddTarget("Target");
+	graph.AddPass("SampleScreen", target, { RenderTargetGraph::Screen });
+	TestEnsure(!graph.Compile(testScreenSize));
+	TestEnsure(!graph.IsCompiled());
+
+	graph.Reset();
+	target = graph.AddTarget("Target");
+	graph.AddPass("SampleEmpty", RenderTargetGraph::Screen, { target });
+	TestEnsure(!graph.Compile(testScreenSize));
+}
+
+// Compares the frame time of giving the foreground the rendered frame by copying the framebuffer,
+//	by rendering into a render target and drawing it to the screen and with the background at half resolution
+Test("RenderTarget.Foreground")
+{
+	class ForegroundBenchmark : public GraphicsTest
+	{
+	public:
+		const uint32 numFrames = 900;
+		const uint32 numLayers = 8;
+
+		Texture frameBufferTexture;
+		RenderTargetGraph graphs[2];
+		FrameHistogram histograms[3];
+		uint32 frame = 0;
+
+		void Render(float deltaTime) override
+		{
+			const Vector2i size = m_window->GetWindowSize();
+			const Recti screenViewport = Recti(Vector2i(), size);
+			if(!frameBufferTexture)
+			{
+				frameBufferTexture = TextureRes::CreateFromFrameBuffer(m_gl, size);
+				for(uint32 i = 0; i < 2; i++)
+				{
+					uint32 scene = graphs[i].AddTarget("Scene");
+					uint32 background = graphs[i].AddTarget("Background", i == 0 ? 1.0f : 0.5f);
+					graphs[i].AddPass("Background", background);
+					graphs[i].AddPass("Scene", scene, { background });
+					graphs[i].AddPass("Foreground", RenderTargetGraph::Screen, { scene });
+					graphs[i].Compile(size);
+					graphs[i].CreateTargets(m_gl);
+				}
+			}
+
+			const uint32 mode = frame * 3 / numFrames;
+			Timer frameTimer;
+			if(mode == 0)
+			{
+				// Layers rendered into the window, the foreground samples a copy of it
+				for(uint32 i = 0; i < numLayers; i++)
+				{
+					glClearColor(i / (float)numLayers, 0.0f, 0.0f, 1.0f);
+					glClear(GL_COLOR_BUFFER_BIT);
+				}
+				frameBufferTexture->SetFromFrameBuffer();
+			}
+			else
+			{
+				RenderTargetGraph& graph = graphs[mode - 1];
+				graph.BeginPass(m_gl, 0, screenViewport);
+				glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT);
+				graph.BeginPass(m_gl, 1, screenViewport);
+				graph.GetInput(0)->Draw(m_gl->GetViewport());
+				for(uint32 i = 1; i < numLayers; i++)
+				{
+					glClearColor(i / (float)numLayers, 0.0f, 0.0f, 1.0f);
+					glClear(GL_COLOR_BUFFER_BIT);
+				}
+				graph.BeginPass(m_gl, 2, screenViewport);
+				graph.GetInput(0)->Draw(screenViewport);
+				graph.EndFrame(m_gl, screenViewport);
+			}
+			glFinish();
+			histograms[mode].Add(frameTimer.SecondsAsDouble() * 1000.0);
+			m_gl->SwapBuffers();
+
+			frame++;
+			if(frame == numFrames)
+			{
+				histograms[0].Print("Framebuffer copy");
+				histograms[1].Print("Render targets");
+				histograms[2].Print("Render targets, half resolution background");
+				m_window->Close();
+			}
+		}
+	};
+
+	ForegroundBenchmark benchmark;
+	TestEnsure(benchmark.Run());
+}
@@ -0,0 +1,186 @@
+#include "stdafx.h"
+#include <Graphics/TextureResidency.hpp>
+using namespace Graphics;
+
+// Jackets that are loaded and evicted without a GPU, loads finish a few frames after they are requested like the async jacket jobs
+class JacketLibrary
+{
+public:
+	struct Jacket
+	{
+		uint32 id = 0;
+		bool loaded = false;
+		bool loading = false;
+		uint64 lastUsedFrame = 0;
+	};
+
+	const uint32 loadFrames = 3;
+	const size_t jacketBytes = TextureResidency::GetTextureBytes(Vector2i(512, 512));
+
+	TextureResidency residency;
+	Vector<Jacket> jackets;
+	Map<uint32, uint32> loading;
+	uint64 frame = 1;
+	uint32 numLoads = 0;
+	uint32 evictedWhileUsed = 0;
+
+	JacketLibrary(uint32 numJackets)
+	{
+		jackets.resize(numJackets);
+		for(uint32 i = 0; i < numJackets; i++)
+		{
+			Jacket* jacket = &jackets[i];
+			jacket->id = residency.Add([this, jacket]()
+			{
+				if(jacket->lastUsedFrame == frame)
+					evictedWhileUsed++;
+				jacket->loaded = false;
+			});
+		}
+	}
+
+	// Same as Application::LoadImageJob, returns true if the jacket can be drawn
+	bool Use(uint32 index)
+	{
+		Jacket& jacket = jackets[index];
+		jacket.lastUsedFrame = frame;
+		if(residency.Touch(jacket.id))
+			return true;
+		if(!jacket.loading)
+		{
+			jacket.loading = true;
+			loading.Add(index, loadFrames);
+			numLoads++;
+		}
+		return false;
+	}
+
+	void EndFrame()
+	{
+		for(auto it = loading.begin(); it != loading.end();)
+		{
+			if(--it->second == 0)
+			{
+				Jacket& jacket = jackets[it->first];
+				jacket.loading = false;
+				jacket.loaded = true;
+				residency.SetResident(jacket.id, jacketBytes);
+				it = loading.erase(it);
+			}
+			else
+				++it;
+		}
+		residency.EndFrame();
+		frame++;
+	}
+
+	// Renders the song wheel around the given position, jackets a bit outside of the screen are requested too
+	void RenderWheel(uint32 position)
+	{
+		const uint32 first = position >= 10 ? position - 10 : 0;
+		const uint32 last = Math::Min(position + 30, (uint32)jackets.size());
+		for(uint32 i = first; i < last; i++)
+			Use(i);
+	}
+};
+
+Test("TextureResidency.Basic")
+{
+	TextureResidency residency;
+	residency.SetBudget(100);
+	uint32 evicted = 0;
+	uint32 a = residency.Add([&]() { evicted++; });
+	uint32 b = residency.Add([&]() { evicted++; });
+	uint32 pinned = residency.Add();
+	TestEnsure(a != 0 && b != 0 && a != b);
+	TestEnsure(!residency.Touch(a));
+
+	residency.SetResident(a, 40);
+	residency.SetResident(pinned, 40);
+	residency.EndFrame();
+	TestEnsure(residency.GetStats().residentBytes == 40);
+	TestEnsure(residency.GetStats().pinnedBytes == 40);
+
+	// b is used this frame, a is the least recently used one
+	residency.SetResident(b, 40);
+	TestEnsure(evicted == 1);
+	residency.EndFrame();
+	TestEnsure(residency.GetStats().frameEvicted == 1);
+	TestEnsure(!residency.IsResident(a) && residency.IsResident(b) && residency.IsResident(pinned));
+	TestEnsure(residency.GetStats().residentBytes + residency.GetStats().pinnedBytes <= 100);
+
+	// Textures used in the current frame are kept even when they don't fit
+	residency.Touch(b);
+	residency.SetResident(a, 40);
+	residency.EndFrame();
+	TestEnsure(evicted == 1);
+	TestEnsure(residency.GetStats().numReloaded == 1);
+
+	// Memory outside of the manager counts against the budget too
+	residency.SetExternalBytes(50);
+	residency.EndFrame();
+	TestEnsure(evicted == 3);
+	TestEnsure(residency.GetStats().residentBytes == 0);
+
+	residency.Remove(a);
+	residency.Remove(pinned);
+	TestEnsure(residency.GetStats().numTextures == 1);
+	TestEnsure(residency.GetStats().pinnedBytes == 50);
+}
+
+// Scrolls through a library of 20000 charts and back with 512x512 jackets, 64MB of skin textures and a 256MB budget
+Test("TextureResidency.Scroll")
+{
+	const size_t budget = 256 * 1024 * 1024;
+	const uint32 numJackets = 20000;
+	JacketLibrary library(numJackets);
+	library.residency.SetBudget(budget);
+	library.residency.SetExternalBytes(64 * 1024 * 1024);
+
+	Timer timer;
+	double maxFrameTime = 0.0;
+	uint32 numFrames = 0;
+	auto renderFrame = [&](uint32 position)
+	{
+		Timer frameTimer;
+		library.RenderWheel(position);
+		library.EndFrame();
+		maxFrameTime = Math::Max(maxFrameTime, frameTimer.SecondsAsDouble());
+		numFrames++;
+
+		const TextureResidencyStats& stats = library.residency.GetStats();
+		TestEnsure(stats.residentBytes + stats.pinnedBytes <= budget);
+	};
+
+	// Scroll down a few jackets per frame, pausing now and then
+	for(uint32 position = 0; position < numJackets; position += 4)
+	{
+		renderFrame(position);
+		if(position % 1000 == 0)
+		{
+			for(uint32 i = 0; i < 30; i++)
+				renderFrame(position);
+		}
+	}
+	const TextureResidencyStats forward = library.residency.GetStats();
+	TestEnsure(forward.numEvicted > 0);
+	TestEnsure(forward.numReloaded == 0);
+	TestEnsure(library.numLoads == numJackets);
+
+	// Jump back to the top and scroll back down, the jackets are loaded again
+	for(uint32 position = 0; position < 2000; position += 4)
+		renderFrame(position);
+	for(uint32 i = 0; i < 10; i++)
+		renderFrame(1000);
+
+	const TextureResidencyStats& stats = library.residency.GetStats();
+	TestEnsure(stats.numReloaded > 0);
+	TestEnsure(stats.peakBytes <= budget);
+	TestEnsure(library.evictedWhileUsed == 0);
+	for(uint32 i = 990; i < 1030; i++)
+		TestEnsure(library.jackets[i].loaded);
+
+	Logf("%d frames, %.3f ms average, %.3f ms max. %d loads, %llu evicted, %llu reloaded, peak %.1f MB", Logger::Severity::Info,
+		numFrames, timer.SecondsAsDouble() * 1000.0 / numFrames, maxFrameTime * 1000.0, library.numLoads,
+		(unsigned long long)stats.numEvicted, (unsigned long long)stats.numReloaded, stats.peakBytes / (1024.0 * 1024.0));
+}
@@ -0,0 +1,109 @@
+#include "stdafx.h"
+#include "GraphicsBase.hpp"
+#include <Shared/Files.hpp>
+#include <Graphics/TextureUploadQueue.hpp>
+
+static String testJacketPath = Path::Normalize("songs");
+static const Vector2i testJacketSize = Vector2i(512, 512);
+
+// Simulates fast scrolling through song select, a burst of jackets finishes loading every few frames
+//	the first half of the frames creates the textures directly, the second half goes through a TextureUploadQueue
+Test("TextureUpload.Scroll")
+{
+	class UploadBenchmark : public GraphicsTest
+	{
+	public:
+		const uint32 numFrames = 600;
+		const uint32 burstInterval = 10;
+		const uint32 burstSize = 24;
+
+		Vector<Image> jackets;
+		TextureUploadQueue* queue = nullptr;
+		Vector<Ref<TextureUpload>> uploads;
+		Vector<uint32> textures;
+		FrameHistogram histograms[2];
+		uint32 frame = 0;
+		uint32 nextJacket = 0;
+
+		~UploadBenchmark()
+		{
+			delete queue;
+		}
+
+		void Render(float deltaTime) override
+		{
+			if(!queue)
+				queue = new TextureUploadQueue(m_gl);
+
+			const uint32 mode = frame < numFrames / 2 ? 0 : 1;
+			Timer frameTimer;
+
+			if(frame % burstInterval == 0)
+			{
+				for(uint32 i = 0; i < burstSize; i++)
+				{
+					Image& image = jackets[nextJacket++ % jackets.size()];
+					if(mode == 0)
+					{
+						// Same as nvgCreateImageRGBA
+						uint32 texture;
+						glGenTextures(1, &texture);
+						glBindTexture(GL_TEXTURE_2D, texture);
+						glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->GetSize().x, image->GetSize().y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->GetBits());
+						glBindTexture(GL_TEXTURE_2D, 0);
+						textures.Add(texture);
+					}
+					else
+					{
+						uploads.Add(queue->Queue(image));
+					}
+				}
+			}
+			queue->Update();
+			for(auto it = uploads.begin(); it != uploads.end();)
+			{
+				if((*it)->IsFinished())
+				{
+					textures.Add((*it)->Release());
+					it = uploads.erase(it);
+				}
+				else
+					++it;
+			}
+
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			// Include the time the driver needs to finish the transfers
+			glFinish();
+			histograms[mode].Add(frameTimer.SecondsAsDouble() * 1000.0);
+			m_gl->SwapBuffers();
+
+			frame++;
+			if(frame == numFrames)
+			{
+				histograms[0].Print("Direct upload");
+				histograms[1].Print("Upload queue");
+				glDeleteTextures((GLsizei)textures.size(), textures.data());
+				m_window->Close();
+			}
+		}
+	};
+
+	Vector<FileInfo> files = Files::ScanFilesRecursive(testJacketPath, "jpg");
+	Vector<FileInfo> pngFiles = Files::ScanFilesRecursive(testJacketPath, "png");
+	files.insert(files.end(), pngFiles.begin(), pngFiles.end());
+	TestEnsure(!files.empty());
+
+	UploadBenchmark benchmark;
+	for(const FileInfo& file : files)
+	{
+		Image image = ImageRes::Create(file.fullPath, testJacketSize);
+		if(!image)
+			continue;
+		if(image->GetSize().x > testJacketSize.x || image->GetSize().y > testJacketSize.y)
+			image->ReSize(testJacketSize);
+		benchmark.jackets.Add(image);
+	}
+	TestEnsure(!benchmark.jackets.empty());
+	TestEnsure(benchmark.Run());
+}
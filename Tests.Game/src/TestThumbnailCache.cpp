@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include <Shared/Files.hpp>
+#include <Graphics/ThumbnailCache.hpp>
+using namespace Graphics;
+
+static String testJacketPath = Path::Normalize("songs");
+static String testCachePath = Path::Normalize("test_jackets.cache");
+static const Vector2i testJacketSize = Vector2i(256, 256);
+
+// Loads every jacket like song select does while scrolling, first with an empty cache and then with the cache reopened
+Test("ThumbnailCache.Scroll")
+{
+	Vector<FileInfo> files = Files::ScanFilesRecursive(testJacketPath, "jpg");
+	Vector<FileInfo> pngFiles = Files::ScanFilesRecursive(testJacketPath, "png");
+	files.insert(files.end(), pngFiles.begin(), pngFiles.end());
+	TestEnsure(!files.empty());
+
+	Path::Delete(testCachePath);
+
+	Vector<Image> coldImages;
+	ThumbnailCache cache;
+	TestEnsure(cache.Open(testCachePath));
+	Timer t;
+	for(const FileInfo& file : files)
+		coldImages.Add(cache.Load(file.fullPath, testJacketSize));
+	double coldTime = t.SecondsAsDouble();
+	cache.Close();
+
+	TestEnsure(cache.Open(testCachePath));
+	t.Restart();
+	uint32 numJackets = 0;
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		Image image = cache.Load(files[i].fullPath, testJacketSize);
+		TestEnsure((bool)image == (bool)coldImages[i]);
+		if(!image)
+			continue;
+		TestEnsure(image->GetSize().x == coldImages[i]->GetSize().x && image->GetSize().y == coldImages[i]->GetSize().y);
+		TestEnsure(memcmp(image->GetBits(), coldImages[i]->GetBits(), image->GetSize().x * image->GetSize().y * sizeof(Colori)) == 0);
+		numJackets++;
+	}
+	double warmTime = t.SecondsAsDouble();
+	TestEnsure(cache.GetNumEntries() == numJackets);
+	cache.Close();
+	Path::Delete(testCachePath);
+
+	Logf("%d jackets at %dx%d", Logger::Severity::Info, numJackets, testJacketSize.x, testJacketSize.y);
+	Logf("Cold cache: %.1f jackets/s", Logger::Severity::Info, files.size() / coldTime);
+	Logf("Warm cache: %.1f jackets/s", Logger::Severity::Info, files.size() / warmTime);
+}
+
+static Image CreateTestThumbnail(Vector2i size, uint8 value)
+{
+	Image image = ImageRes::Create(size);
+	memset(image->GetBits(), value, size.x * size.y * sizeof(Colori));
+	return image;
+}
+
+// Storing the same thumbnails over and over compacts the pack instead of growing it or dropping the other thumbnails
+Test("ThumbnailCache.Compact")
+{
+	const Vector2i size = Vector2i(64, 64);
+	const size_t thumbnailSize = size.x * size.y * sizeof(Colori);
+	const size_t maxPackSize = thumbnailSize * 10;
+
+	Path::Delete(testCachePath);
+	ThumbnailCache cache;
+	cache.SetMaxPackSize(maxPackSize);
+	TestEnsure(cache.Open(testCachePath));
+
+	cache.Store("fixed", 1, size, CreateTestThumbnail(size, 0x11));
+	for(uint8 i = 0; i < 40; i++)
+	{
+		cache.Store("changing", i, size, CreateTestThumbnail(size, i));
+		TestEnsure(cache.GetPackSize() <= maxPackSize);
+
+		Image fixed = cache.Find("fixed", 1, size);
+		TestEnsure(fixed && fixed->GetBits()[0].x == 0x11);
+		Image changing = cache.Find("changing", i, size);
+		TestEnsure(changing && changing->GetBits()[size.x * size.y - 1].x == i);
+	}
+	TestEnsure(cache.GetNumEntries() == 2);
+	cache.Close();
+
+	// The compacted pack is read back like any other
+	cache.SetMaxPackSize(maxPackSize);
+	TestEnsure(cache.Open(testCachePath));
+	TestEnsure(cache.GetNumEntries() == 2);
+	TestEnsure(cache.Find("changing", 39, size));
+	TestEnsure(!cache.Find("changing", 38, size));
+	cache.Close();
+	Path::Delete(testCachePath);
+}
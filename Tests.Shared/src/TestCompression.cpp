@@ -0,0 +1,60 @@
+#include <Shared/Shared.hpp>
+#include <Shared/VarInt.hpp>
+#include <Shared/Compression.hpp>
+#include <Tests/Tests.hpp>
+
+Test("VarInt.RoundTrip")
+{
+	const int64 values[] = { 0, 1, -1, 63, -64, 64, 127, 128, -300, 16383, 16384, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN };
+	Buffer buffer;
+	for(int64 v : values)
+		VarInt::WriteSigned(buffer, v);
+	VarInt::Write(buffer, UINT64_MAX);
+
+	const uint8* data = buffer.data();
+	const uint8* end = data + buffer.size();
+	for(int64 v : values)
+	{
+		int64 read;
+		TestEnsure(VarInt::ReadSigned(data, end, read));
+		TestEnsure(read == v);
+	}
+	uint64 read;
+	TestEnsure(VarInt::Read(data, end, read));
+	TestEnsure(read == UINT64_MAX);
+	TestEnsure(data == end);
+
+	// Small values take a single byte
+	Buffer small;
+	VarInt::WriteSigned(small, -64);
+	VarInt::Write(small, 127);
+	TestEnsure(small.size() == 2);
+
+	// Values cut off at the end of the data fail
+	Buffer truncated;
+	VarInt::Write(truncated, 1 << 20);
+	truncated.pop_back();
+	data = truncated.data();
+	TestEnsure(!VarInt::Read(data, truncated.data() + truncated.size(), read));
+}
+
+Test("Compression.Deflate")
+{
+	Buffer input;
+	for(uint32 i = 0; i < 10000; i++)
+		input.push_back((uint8)(i % 7 + (i / 1000)));
+
+	Buffer compressed;
+	TestEnsure(Compression::Deflate(input, compressed));
+	TestEnsure(compressed.size() < input.size());
+
+	Buffer output;
+	TestEnsure(Compression::Inflate(compressed, output, input.size()));
+	TestEnsure(output.size() == input.size());
+	TestEnsure(memcmp(output.data(), input.data(), input.size()) == 0);
+
+	// Wrong size or corrupt data
+	TestEnsure(!Compression::Inflate(compressed, output, input.size() - 1));
+	compressed.resize(compressed.size() / 2);
+	TestEnsure(!Compression::Inflate(compressed, output, input.size()));
+}
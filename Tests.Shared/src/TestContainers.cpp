@@ -0,0 +1,113 @@
+#include <Shared/Shared.hpp>
+#include <Shared/RingBuffer.hpp>
+#include <Shared/ObjectArena.hpp>
+#include <Shared/BitSet.hpp>
+#include <Tests/Tests.hpp>
+
+Test("RingBuffer.Queue")
+{
+	RingBuffer<int32> queue(4);
+	TestEnsure(queue.empty());
+	TestEnsure(queue.capacity() == 4);
+
+	// Wrap around a few times without growing
+	int32 next = 0;
+	for(int32 i = 0; i < 20; i++)
+	{
+		queue.AddBack(i);
+		if(queue.size() == 3)
+			TestEnsure(queue.PopFront() == next++);
+	}
+	TestEnsure(queue.capacity() == 4);
+	TestEnsure(queue.size() == 2);
+	TestEnsure(queue.front() == 18);
+	TestEnsure(queue.back() == 19);
+
+	// Grow while wrapped
+	for(int32 i = 20; i < 40; i++)
+		queue.AddBack(i);
+	TestEnsure(queue.capacity() == 32);
+	TestEnsure(queue.size() == 22);
+	for(size_t i = 0; i < queue.size(); i++)
+		TestEnsure(queue[i] == (int32)i + 18);
+
+	queue.clear();
+	TestEnsure(queue.empty());
+	TestEnsure(queue.capacity() == 32);
+}
+
+Test("ObjectArena.Reuse")
+{
+	static int32 alive = 0;
+	struct Counted
+	{
+		Counted(int32 v) : value(v) { alive++; }
+		~Counted() { alive--; }
+		int32 value;
+	};
+
+	ObjectArena<Counted, 8> arena;
+	Vector<Counted*> objects;
+	for(int32 i = 0; i < 20; i++)
+		objects.Add(arena.New(i));
+	TestEnsure(alive == 20);
+	TestEnsure(arena.GetCount() == 20);
+	for(int32 i = 0; i < 20; i++)
+		TestEnsure(objects[i]->value == i);
+
+	// Blocks are reused after clearing
+	arena.Clear();
+	TestEnsure(alive == 0);
+	Counted* first = arena.New(100);
+	TestEnsure(first == objects[0]);
+	TestEnsure(first->value == 100);
+	arena.Clear();
+}
+
+Test("ObjectArena.Contains")
+{
+	ObjectArena<int32, 4> arena;
+	Vector<int32*> objects;
+	for(int32 i = 0; i < 50; i++)
+		objects.Add(arena.New(i));
+	int32* heap = new int32(0);
+	int32 stack = 0;
+	for(int32* object : objects)
+		TestEnsure(arena.Contains(object));
+	TestEnsure(!arena.Contains(heap));
+	TestEnsure(!arena.Contains(&stack));
+	TestEnsure(!arena.Contains(nullptr));
+	delete heap;
+}
+
+Test("BitSet.Operations")
+{
+	BitSet a(130);
+	TestEnsure(a.Count() == 0);
+	a.Set(0);
+	a.Set(63);
+	a.Set(64);
+	a.Set(129);
+	TestEnsure(a.IsSet(63) && a.IsSet(64) && !a.IsSet(65));
+	TestEnsure(a.Count() == 4);
+
+	BitSet b(130, true);
+	TestEnsure(b.Count() == 130);
+	b.Reset(64);
+	b &= a;
+	Vector<size_t> set;
+	b.ForEach([&](size_t i) { set.push_back(i); });
+	TestEnsure(set == Vector<size_t>({ 0, 63, 129 }));
+
+	TestEnsure(b.Any(60, 64));
+	TestEnsure(!b.Any(1, 63));
+	TestEnsure(!b.Any(64, 129));
+	TestEnsure(b.Any(64, 130));
+
+	// Growing with set bits keeps the old ones
+	b.Resize(200, true);
+	TestEnsure(b.Count() == 3 + 70);
+	TestEnsure(!b.IsSet(1) && b.IsSet(130) && b.IsSet(199));
+	b.ResetAll();
+	TestEnsure(!b.Any(0, b.size()));
+}
@@ -0,0 +1,68 @@
+#include <Shared/Shared.hpp>
+#include <Shared/FFT.hpp>
+#include <Tests/Tests.hpp>
+
+Test("FFT.Transform")
+{
+	const size_t n = 64;
+	Vector<std::complex<double>> data(n);
+	for(size_t i = 0; i < n; i++)
+		data[i] = std::complex<double>(Random::FloatRange(-1.0f, 1.0f), Random::FloatRange(-1.0f, 1.0f));
+	Vector<std::complex<double>> input = data;
+
+	// Compare to a direct DFT
+	FFT::Transform(data);
+	for(size_t k = 0; k < n; k++)
+	{
+		std::complex<double> expected;
+		for(size_t t = 0; t < n; t++)
+			expected += input[t] * std::polar(1.0, -2.0 * 3.14159265358979323846 * (double)(k * t) / n);
+		TestEnsure(std::abs(data[k] - expected) < 1e-9);
+	}
+
+	// Inverse transform scaled by n returns the input
+	FFT::Transform(data, true);
+	for(size_t i = 0; i < n; i++)
+		TestEnsure(std::abs(data[i] / (double)n - input[i]) < 1e-12);
+}
+
+Test("FFT.CrossCorrelate")
+{
+	Vector<float> a(37);
+	Vector<float> b(100);
+	for(float& v : a)
+		v = Random::FloatRange(-1.0f, 1.0f);
+	for(float& v : b)
+		v = Random::FloatRange(-1.0f, 1.0f);
+
+	Vector<float> correlation;
+	FFT::CrossCorrelate(a, b, correlation);
+	TestEnsure(correlation.size() == a.size() + b.size() - 1);
+	for(int32 lag = -(int32)(a.size() - 1); lag < (int32)b.size(); lag++)
+	{
+		double expected = 0.0;
+		for(int32 t = 0; t < (int32)a.size(); t++)
+		{
+			if(t + lag >= 0 && t + lag < (int32)b.size())
+				expected += a[t] * b[t + lag];
+		}
+		TestEnsure(fabs(correlation[lag + a.size() - 1] - expected) < 1e-4);
+	}
+
+	// A pulse train delayed by 25 samples peaks at lag 25
+	Vector<float> pulses(200, 0.0f);
+	Vector<float> delayed(400, 0.0f);
+	for(size_t i = 0; i < pulses.size(); i += 40)
+	{
+		pulses[i] = 1.0f;
+		delayed[i + 25] = 1.0f;
+	}
+	FFT::CrossCorrelate(pulses, delayed, correlation);
+	size_t peak = 0;
+	for(size_t i = 0; i < correlation.size(); i++)
+	{
+		if(correlation[i] > correlation[peak])
+			peak = i;
+	}
+	TestEnsure((int32)peak - (int32)(pulses.size() - 1) == 25);
+}
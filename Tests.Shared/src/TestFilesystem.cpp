@@ -32,6 +32,10 @@ Test("File.PathString")
 
 	String rem = Path::RemoveBase(a, b);
 	TestEnsure(rem == filename);
+
+	TestEnsure(Path::ReplaceExtension(a, "json") == b + Path::sep + "FileName.json");
+	TestEnsure(Path::ReplaceExtension(a, "") == b + Path::sep + "FileName");
+	TestEnsure(Path::ReplaceExtension(b, "ext") == b + ".ext");
 }
 Test("File.Create")
 {
@@ -166,3 +170,87 @@ Test("File.ReadWrite")
 		TestEnsure(file.Read(data, 1) == 0);
 	}
 }
+Test("File.Mapped")
+{
+	String data = "Line A\r\nLine B\r\n\r\n--\r\nLast line";
+	String filename = TestFilename;
+	{
+		File file;
+		TestEnsure(file.OpenWrite(filename, false));
+		file.Write(data.data(), data.size());
+	}
+
+	MappedFile mapping;
+	TestEnsure(mapping.Open(filename, MappedFileAccess::Sequential));
+	TestEnsure(mapping.GetSize() == data.size());
+	TestEnsure(memcmp(mapping.GetData(), data.data(), data.size()) == 0);
+	mapping.Advise(MappedFileAccess::Random);
+	mapping.Prefetch(true);
+
+	// Reads the same lines as a file reader
+	File file;
+	TestEnsure(file.OpenRead(filename));
+	FileReader fileReader(file);
+	MappedReader mappedReader(mapping);
+	String fileLine, mappedLine;
+	uint32 numLines = 0;
+	while(TextStream::ReadLine(fileReader, fileLine))
+	{
+		TestEnsure(TextStream::ReadLine(mappedReader, mappedLine));
+		TestEnsure(fileLine == mappedLine);
+		numLines++;
+	}
+	TestEnsure(numLines == 5);
+	TestEnsure(!TextStream::ReadLine(mappedReader, mappedLine));
+
+	// Reads past the end are cut off
+	char buffer[8];
+	mappedReader.SeekReverse(4);
+	TestEnsure(mappedReader.Serialize(buffer, sizeof(buffer)) == 4);
+	TestEnsure(memcmp(buffer, "line", 4) == 0);
+	TestEnsure(mappedReader.Serialize(buffer, 1) == 0);
+	mappedReader.Seek(2);
+	mappedReader.Skip(3);
+	TestEnsure(mappedReader.Tell() == 5 && *mappedReader.GetData() == 'A');
+	TestEnsure(mappedReader.GetRemaining() == data.size() - 5);
+
+	// Empty files can be mapped too
+	String emptyFilename = filename + ".empty";
+	{
+		File empty;
+		TestEnsure(empty.OpenWrite(emptyFilename, false));
+	}
+	MappedFile emptyMapping;
+	TestEnsure(emptyMapping.Open(emptyFilename));
+	TestEnsure(emptyMapping.GetSize() == 0);
+	emptyMapping.Prefetch(true);
+	MappedReader emptyReader(emptyMapping);
+	TestEnsure(emptyReader.Serialize(buffer, 1) == 0);
+
+	TestEnsure(!MappedFile().Open(filename + ".missing"));
+}
+Test("File.ReadAll")
+{
+	String data = "Line A\nLine B\n";
+	String filename = TestFilename;
+	{
+		File file;
+		TestEnsure(file.OpenWrite(filename, false));
+		file.Write(data.data(), data.size());
+	}
+
+	Buffer buffer;
+	TestEnsure(File::ReadAll(filename, buffer));
+	TestEnsure(buffer.size() == data.size() && memcmp(buffer.data(), data.data(), data.size()) == 0);
+
+	// The copy stays valid when the file is rewritten while it is read
+	MappedReader reader(buffer);
+	{
+		File file;
+		TestEnsure(file.OpenWrite(filename, false));
+	}
+	String line;
+	TestEnsure(TextStream::ReadLine(reader, line) && line == "Line A");
+
+	TestEnsure(!File::ReadAll(filename + ".missing", buffer));
+}
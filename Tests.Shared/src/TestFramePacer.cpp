@@ -0,0 +1,282 @@
+#include <Shared/Shared.hpp>
+#include <Shared/FramePacer.hpp>
+#include <Tests/Tests.hpp>
+#include <algorithm>
+#include <ctime>
+#include <thread>
+
+typedef FramePacer::Clock Clock;
+
+static double Seconds(Clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+static Clock::duration Duration(double seconds)
+{
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+// Simulated time for the pacer, only moves when the frame works, the pacer sleeps or the clock is read
+class SimulatedClock
+{
+public:
+	Clock::time_point time;
+	// Added on every read so spinning ends
+	Clock::duration readStep = std::chrono::microseconds(1);
+	// How much later than requested sleeps wake up
+	Clock::duration oversleep = std::chrono::microseconds(300);
+
+	Clock::time_point Now()
+	{
+		time += readStep;
+		return time;
+	}
+	void Attach(FramePacer& pacer)
+	{
+		pacer.SetClock([this]() { return Now(); }, [this](Clock::time_point wakeTime)
+		{
+			time = std::max(time, wakeTime + oversleep);
+		});
+	}
+	void Work(double seconds)
+	{
+		time += Duration(seconds);
+	}
+};
+
+// Runs frames on simulated time, returns the presents of every frame
+static Vector<Clock::time_point> RunSimulatedFrames(FramePacer& pacer, SimulatedClock& clock, const Vector<double>& workTimes, double* latency = nullptr)
+{
+	Vector<Clock::time_point> presents;
+	double totalLatency = 0.0;
+	for(double workTime : workTimes)
+	{
+		pacer.BeginFrame();
+		const Clock::time_point inputTime = clock.Now();
+		clock.Work(workTime);
+		pacer.EndFrame();
+		presents.Add(clock.Now());
+		totalLatency += Seconds(presents.back() - inputTime);
+	}
+	if(latency)
+		*latency = totalLatency / workTimes.size();
+	return presents;
+}
+
+// Busy work, the way a frame keeps the CPU busy
+static void Work(double seconds)
+{
+	const Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	while(Clock::now() < end)
+	{
+	}
+}
+
+struct PacingResult
+{
+	// Difference between frame intervals and the target interval in ms
+	Vector<double> errors;
+	// Time from sampling input to presenting in ms
+	double latency = 0.0;
+	double cpuUsage = 0.0;
+};
+
+// Runs frames with the given amount of work, beginFrame and endFrame wait for the frame limit
+template<typename Begin, typename End>
+static PacingResult RunFrames(int32 fps, double workFraction, double duration, Begin&& beginFrame, End&& endFrame)
+{
+	const double period = 1.0 / fps;
+	const uint32 numFrames = (uint32)(duration * fps);
+
+	PacingResult result;
+	const std::clock_t cpuStart = std::clock();
+	const Clock::time_point start = Clock::now();
+	Clock::time_point lastPresent = start;
+	for(uint32 i = 0; i < numFrames; i++)
+	{
+		beginFrame();
+		const Clock::time_point inputTime = Clock::now();
+		Work(period * workFraction);
+		endFrame();
+
+		const Clock::time_point present = Clock::now();
+		if(i > 0)
+			result.errors.push_back(fabs(Seconds(present - lastPresent) - period) * 1000.0);
+		result.latency += Seconds(present - inputTime) * 1000.0 / numFrames;
+		lastPresent = present;
+	}
+	const double wallTime = Seconds(Clock::now() - start);
+	result.cpuUsage = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC / wallTime * 100.0;
+	std::sort(result.errors.begin(), result.errors.end());
+	return result;
+}
+
+static double Percentile(const Vector<double>& sorted, uint32 percentile)
+{
+	return sorted[(sorted.size() - 1) * percentile / 100];
+}
+
+static String Histogram(const Vector<double>& errors)
+{
+	static const double bounds[] = { 0.05, 0.1, 0.25, 0.5, 1.0, 2.0 };
+	uint32 counts[7] = { 0 };
+	for(double e : errors)
+	{
+		uint32 bucket = 0;
+		while(bucket < 6 && e >= bounds[bucket])
+			bucket++;
+		counts[bucket]++;
+	}
+	return Utility::Sprintf("<0.05ms:%d <0.1ms:%d <0.25ms:%d <0.5ms:%d <1ms:%d <2ms:%d >=2ms:%d",
+		counts[0], counts[1], counts[2], counts[3], counts[4], counts[5], counts[6]);
+}
+
+// Frame interval jitter and CPU usage of the frame pacer compared to the sleep multiplier and yield loop it replaced
+//	measured on the real clock, so the numbers are only logged
+Test("FramePacer.Jitter")
+{
+	const double workFraction = 0.3;
+	const double duration = 0.5;
+	for(int32 fps : { 120, 240, 500 })
+	{
+		FramePacer pacer;
+		pacer.SetTarget(fps);
+		PacingResult paced = RunFrames(fps, workFraction, duration, [&]() { pacer.BeginFrame(); }, [&]() { pacer.EndFrame(); });
+
+		// Previous limiter in Application, frame times are relative to the end of the previous frame
+		const uint32 targetRenderTime = 1000000 / fps;
+		float sleepMult = 1.0f;
+		double legacySpinTime = 0.0;
+		Timer frameTimer;
+		PacingResult legacy = RunFrames(fps, workFraction, duration, [&]() { frameTimer.Restart(); }, [&]()
+		{
+			uint32 frameTime = (uint32)frameTimer.Microseconds();
+			if(frameTime >= targetRenderTime)
+				return;
+			uint32 timeLeft = targetRenderTime - frameTime;
+			uint32 sleepMicroSecs = (uint32)(timeLeft * sleepMult * 0.75);
+			if(sleepMicroSecs > 1000)
+			{
+				uint32 sleepStart = (uint32)frameTimer.Microseconds();
+				std::this_thread::sleep_for(std::chrono::microseconds(sleepMicroSecs));
+				float actualSleep = (float)(frameTimer.Microseconds() - sleepStart);
+				sleepMult += ((float)timeLeft - actualSleep / 0.75f) / 500000.f;
+				sleepMult = Math::Clamp(sleepMult, 0.0f, 1.0f);
+			}
+			Timer spinTimer;
+			do
+			{
+				std::this_thread::yield();
+			} while(frameTimer.Microseconds() < targetRenderTime);
+			legacySpinTime += spinTimer.SecondsAsDouble();
+		});
+
+		const FramePacer::Stats& stats = pacer.GetStats();
+		Logf("%d FPS pacer: p50 %.3f ms, p99 %.3f ms, CPU %.0f%%, spinning %.1f%%, %d late, slack %.3f ms", Logger::Severity::Info, fps,
+			Percentile(paced.errors, 50), Percentile(paced.errors, 99), paced.cpuUsage, stats.spinTime / duration * 100.0,
+			(int32)stats.numLateFrames, stats.sleepSlack * 1000.0);
+		Logf("%d FPS pacer: %s", Logger::Severity::Info, fps, Histogram(paced.errors));
+		Logf("%d FPS previous limiter: p50 %.3f ms, p99 %.3f ms, CPU %.0f%%, spinning %.1f%%", Logger::Severity::Info, fps,
+			Percentile(legacy.errors, 50), Percentile(legacy.errors, 99), legacy.cpuUsage, legacySpinTime / duration * 100.0);
+		Logf("%d FPS previous limiter: %s", Logger::Severity::Info, fps, Histogram(legacy.errors));
+
+		TestEnsure(stats.numFrames == (uint64)(duration * fps));
+	}
+}
+
+// Input latency of just in time mode on the real clock, the numbers are only logged
+Test("FramePacer.JustInTime")
+{
+	const int32 fps = 240;
+	const double workFraction = 0.25;
+	const double duration = 0.5;
+
+	FramePacer normal;
+	normal.SetTarget(fps, FramePacer::Mode::Normal);
+	PacingResult normalResult = RunFrames(fps, workFraction, duration, [&]() { normal.BeginFrame(); }, [&]() { normal.EndFrame(); });
+
+	FramePacer jit;
+	jit.SetTarget(fps, FramePacer::Mode::JustInTime);
+	PacingResult jitResult = RunFrames(fps, workFraction, duration, [&]() { jit.BeginFrame(); }, [&]() { jit.EndFrame(); });
+
+	Logf("Input to present latency: normal %.3f ms, just in time %.3f ms (%d late frames)", Logger::Severity::Info,
+		normalResult.latency, jitResult.latency, (int32)jit.GetStats().numLateFrames);
+	Logf("Just in time interval error p50 %.3f ms, p99 %.3f ms", Logger::Severity::Info,
+		Percentile(jitResult.errors, 50), Percentile(jitResult.errors, 99));
+	TestEnsure(jit.GetStats().numFrames == (uint64)(duration * fps));
+}
+
+// Frames are presented on their deadlines, the pacer sleeps most of the wait and a late frame doesn't make the next ones catch up
+Test("FramePacer.Deadlines")
+{
+	const int32 fps = 240;
+	const double period = 1.0 / fps;
+	FramePacer pacer;
+	SimulatedClock clock;
+	clock.Attach(pacer);
+	pacer.SetTarget(fps);
+
+	Vector<double> workTimes(200, period * 0.3);
+	workTimes[100] = period * 1.5;
+	Vector<Clock::time_point> presents = RunSimulatedFrames(pacer, clock, workTimes);
+
+	const FramePacer::Stats& stats = pacer.GetStats();
+	TestEnsure(stats.numFrames == 200);
+	TestEnsure(stats.numLateFrames == 1);
+	for(uint32 i = 1; i < presents.size(); i++)
+	{
+		// The late frame is presented when it is done, the next one still keeps to the original deadlines
+		double expected = period;
+		if(i == 100)
+			expected = period * 1.5;
+		if(i == 101)
+			expected = period * 0.5;
+		TestEnsure(fabs(Seconds(presents[i] - presents[i - 1]) - expected) < 0.00002);
+	}
+
+	// The slack follows the oversleep down, so spinning only covers the difference
+	TestEnsure(fabs(stats.sleepSlack - Seconds(clock.oversleep)) < 0.00001);
+	TestEnsure(stats.spinTime < stats.sleepTime * 0.1);
+}
+
+// Just in time mode samples input right before the predicted work time without missing deadlines
+Test("FramePacer.JustInTimeLatency")
+{
+	const int32 fps = 240;
+	const double period = 1.0 / fps;
+	const Vector<double> workTimes(200, period * 0.25);
+
+	double latencies[2];
+	for(uint32 i = 0; i < 2; i++)
+	{
+		FramePacer pacer;
+		SimulatedClock clock;
+		clock.Attach(pacer);
+		pacer.SetTarget(fps, i == 0 ? FramePacer::Mode::Normal : FramePacer::Mode::JustInTime);
+		Vector<Clock::time_point> presents = RunSimulatedFrames(pacer, clock, workTimes, &latencies[i]);
+
+		// Only the first frame of just in time mode is late, there is no estimate of the work time yet
+		TestEnsure(pacer.GetStats().numLateFrames == i);
+		for(uint32 j = 2; j < presents.size(); j++)
+			TestEnsure(fabs(Seconds(presents[j] - presents[j - 1]) - period) < 0.00002);
+	}
+
+	// Normal mode waits for the deadline after the work, just in time mode only the margin
+	TestEnsure(fabs(latencies[0] - period) < 0.0001);
+	TestEnsure(latencies[1] < period * 0.25 + 0.001);
+}
+
+Test("FramePacer.Unlimited")
+{
+	FramePacer pacer;
+	pacer.SetTarget(0);
+	const Clock::time_point start = Clock::now();
+	for(uint32 i = 0; i < 1000; i++)
+	{
+		pacer.BeginFrame();
+		pacer.EndFrame();
+	}
+	TestEnsure(Seconds(Clock::now() - start) < 0.1);
+	TestEnsure(pacer.GetTimeLeft() == 0.0);
+	TestEnsure(pacer.GetStats().sleepTime == 0.0);
+}
@@ -0,0 +1,90 @@
+#include <Shared/Shared.hpp>
+#include <Shared/Files.hpp>
+#include <Tests/Tests.hpp>
+#include <thread>
+
+static size_t CountLines(const String& text, const String& marker)
+{
+	size_t count = 0;
+	for (size_t pos = text.find(marker); pos != String::npos; pos = text.find(marker, pos + 1))
+		count++;
+	return count;
+}
+
+static String ReadLogFile()
+{
+	File file;
+	String text;
+	if (file.OpenRead(Path::Absolute(Utility::Sprintf("log_%s.txt", Path::GetModuleName()))))
+	{
+		text.resize(file.GetSize());
+		file.Read(&text.front(), text.size());
+	}
+	return text;
+}
+
+Test("Log.Async")
+{
+	const uint32 numThreads = 4;
+	const uint32 numMessages = 2000;
+
+	// Worst time a single call took, logging must not wait for the writer
+	std::atomic<uint64> worstNs{ 0 };
+	Timer total;
+	Vector<std::thread> threads;
+	for (uint32 t = 0; t < numThreads; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			for (uint32 i = 0; i < numMessages; i++)
+			{
+				Timer call;
+				Logf("AsyncLogTest thread %d message %d", Logger::Severity::Debug, t, i);
+				uint64 ns = (uint64)(call.SecondsAsDouble() * 1e9);
+				uint64 prev = worstNs.load();
+				while (ns > prev && !worstNs.compare_exchange_weak(prev, ns)) {}
+			}
+		}));
+	}
+	for (auto& thread : threads)
+		thread.join();
+	const double queueTime = total.SecondsAsDouble();
+	Logger::Get().Flush();
+	const double flushTime = total.SecondsAsDouble();
+
+	Logf("Logged %d messages from %d threads in %.2f ms (written after %.2f ms), worst call %.3f ms", Logger::Severity::Info,
+		numThreads * numMessages, numThreads, queueTime * 1000.0, flushTime * 1000.0, worstNs.load() / 1e6);
+
+	// Everything is written and the messages of each thread are in order
+	String text = ReadLogFile();
+	TestEnsure(CountLines(text, "AsyncLogTest thread") == numThreads * numMessages);
+	for (uint32 t = 0; t < numThreads; t++)
+	{
+		size_t first = text.find(Utility::Sprintf("AsyncLogTest thread %d message 0\n", t));
+		size_t last = text.find(Utility::Sprintf("AsyncLogTest thread %d message %d\n", t, numMessages - 1));
+		TestEnsure(first != String::npos && last != String::npos && first < last);
+	}
+}
+
+Test("Log.RateLimited")
+{
+	for (uint32 i = 0; i < 100; i++)
+		LogfRateLimited(60000, "RateLimitedLogTest %d", Logger::Severity::Info, i);
+	Logger::Get().Flush();
+	TestEnsure(CountLines(ReadLogFile(), "RateLimitedLogTest") == 1);
+
+	Logger::RateLimit limit(0);
+	uint32 suppressed = 0;
+	TestEnsure(limit.Allow(suppressed));
+	TestEnsure(suppressed == 0);
+}
+
+Test("Log.ErrorWrittenRightAway")
+{
+	// Messages logged before an error are written with it, the process may not live until the next batch
+	Log("ErrorLogTest info", Logger::Severity::Info);
+	Log("ErrorLogTest error", Logger::Severity::Error);
+	String text = ReadLogFile();
+	TestEnsure(CountLines(text, "ErrorLogTest info") == 1);
+	TestEnsure(CountLines(text, "ErrorLogTest error") == 1);
+}
@@ -0,0 +1,337 @@
+#include <Shared/Shared.hpp>
+#include <Shared/LuaTableCache.hpp>
+#include <Shared/LuaGCScheduler.hpp>
+#include <Tests/Tests.hpp>
+
+enum BenchKey : uint32
+{
+	Key_progress, Key_hispeed, Key_bpm, Key_x, Key_y, Key_rotation, Key_pos, Key_alpha, Key_skew, Key_maxScore, Key_currentScore,
+};
+enum BenchTable : uint32
+{
+	Table_Gameplay, Table_CritLine, Table_NoteHeld, Table_Cursor0, Table_Cursor1, Table_Replay0,
+};
+
+// Number of score replays shown next to the gauge
+static const int benchReplays = 3;
+
+static void SetField(lua_State* L, const char* key, lua_Number value)
+{
+	lua_pushstring(L, key);
+	lua_pushnumber(L, value);
+	lua_settable(L, -3);
+}
+
+// Per frame update of the gameplay table the way it was done before the table cache, new tables every frame
+static void UpdateFrameTables(lua_State* L, uint32 frame)
+{
+	const float t = frame / 60.0f;
+	lua_getglobal(L, "gameplay");
+	lua_pushstring(L, "noteHeld");
+	lua_newtable(L);
+	for (int i = 0; i < 6; i++)
+	{
+		lua_pushnumber(L, i + 1);
+		lua_pushboolean(L, (frame >> i) & 1);
+		lua_settable(L, -3);
+	}
+	lua_settable(L, -3);
+
+	lua_newtable(L);
+	for (int i = 0; i < benchReplays; i++)
+	{
+		lua_pushnumber(L, i + 1);
+		lua_newtable(L);
+		SetField(L, "maxScore", 10000000);
+		SetField(L, "currentScore", frame * 100 + i);
+		lua_settable(L, -3);
+	}
+	lua_setfield(L, -2, "scoreReplays");
+
+	SetField(L, "progress", t / 180.0f);
+	SetField(L, "hispeed", 8.0);
+	SetField(L, "bpm", 180.0);
+
+	lua_getfield(L, -1, "critLine");
+	SetField(L, "x", 640 + sinf(t));
+	SetField(L, "y", 600 + cosf(t));
+	SetField(L, "rotation", sinf(t) * 0.1f);
+	lua_getfield(L, -1, "cursors");
+	for (int i = 0; i < 2; i++)
+	{
+		lua_geti(L, -1, i);
+		SetField(L, "pos", sinf(t + i));
+		SetField(L, "alpha", 1.0);
+		SetField(L, "skew", 0.0);
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 2);
+	lua_setglobal(L, "gameplay");
+}
+
+// Same update with cached tables and keys
+static void UpdateFrameCached(lua_State* L, LuaTableCache& c, uint32 frame)
+{
+	const float t = frame / 60.0f;
+	if (!c.Begin(L))
+	{
+		lua_getglobal(L, "gameplay");
+		c.SetTable(Table_Gameplay, -1);
+		lua_newtable(L);
+		c.SetTable(Table_NoteHeld, -1);
+		lua_setfield(L, -2, "noteHeld");
+		lua_newtable(L);
+		for (int i = 0; i < benchReplays; i++)
+		{
+			lua_newtable(L);
+			c.SetTable(Table_Replay0 + i, -1);
+			lua_seti(L, -2, i + 1);
+		}
+		lua_setfield(L, -2, "scoreReplays");
+		lua_getfield(L, -1, "critLine");
+		c.SetTable(Table_CritLine, -1);
+		lua_getfield(L, -1, "cursors");
+		for (int i = 0; i < 2; i++)
+		{
+			lua_geti(L, -1, i);
+			c.SetTable(Table_Cursor0 + i, -1);
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 3);
+	}
+
+	c.PushTable(Table_NoteHeld);
+	for (int i = 0; i < 6; i++)
+	{
+		lua_pushboolean(L, (frame >> i) & 1);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_pop(L, 1);
+
+	for (int i = 0; i < benchReplays; i++)
+	{
+		c.PushTable(Table_Replay0 + i);
+		c.SetNumber(Key_maxScore, 10000000);
+		c.SetNumber(Key_currentScore, frame * 100 + i);
+		lua_pop(L, 1);
+	}
+
+	c.PushTable(Table_Gameplay);
+	c.SetNumber(Key_progress, t / 180.0f);
+	c.SetNumber(Key_hispeed, 8.0);
+	c.SetNumber(Key_bpm, 180.0);
+	lua_pop(L, 1);
+
+	c.PushTable(Table_CritLine);
+	c.SetNumber(Key_x, 640 + sinf(t));
+	c.SetNumber(Key_y, 600 + cosf(t));
+	c.SetNumber(Key_rotation, sinf(t) * 0.1f);
+	lua_pop(L, 1);
+	for (int i = 0; i < 2; i++)
+	{
+		c.PushTable(Table_Cursor0 + i);
+		c.SetNumber(Key_pos, sinf(t + i));
+		c.SetNumber(Key_alpha, 1.0);
+		c.SetNumber(Key_skew, 0.0);
+		lua_pop(L, 1);
+	}
+	c.End();
+}
+
+static lua_State* CreateGameplayState()
+{
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+	luaL_dostring(L, "gameplay = { critLine = { cursors = { [0] = {}, [1] = {} } } }");
+	return L;
+}
+
+static LuaTableCache CreateBenchCache()
+{
+	return LuaTableCache({ "progress", "hispeed", "bpm", "x", "y", "rotation", "pos", "alpha", "skew", "maxScore", "currentScore" });
+}
+
+Test("Lua.TableCache")
+{
+	lua_State* L = CreateGameplayState();
+	LuaTableCache cache = CreateBenchCache();
+	UpdateFrameCached(L, cache, 0);
+	UpdateFrameCached(L, cache, 1);
+	TestEnsure(lua_gettop(L) == 0);
+
+	luaL_dostring(L, "return gameplay.scoreReplays[2].currentScore + gameplay.critLine.cursors[1].alpha");
+	TestEnsure(lua_tonumber(L, -1) == 100 + 1 + 1);
+	lua_pop(L, 1);
+
+	// The same tables are updated every frame
+	luaL_dostring(L, "held = gameplay.noteHeld");
+	UpdateFrameCached(L, cache, 3);
+	luaL_dostring(L, "return held == gameplay.noteHeld and held[1] and held[2] and not held[3]");
+	TestEnsure(lua_toboolean(L, -1));
+	lua_pop(L, 1);
+
+	// Separate states have separate caches
+	lua_State* L1 = CreateGameplayState();
+	TestEnsure(!cache.Begin(L1));
+	cache.End();
+	TestEnsure(cache.Begin(L));
+	cache.End();
+	lua_close(L1);
+	lua_close(L);
+}
+
+// Plays 3 minutes of frames with both update methods and compares the garbage created and the frame time variance
+Test("Lua.TableCache.Benchmark")
+{
+	const uint32 numFrames = 60 * 180;
+	auto run = [&](const char* name, bool cached)
+	{
+		lua_State* L = CreateGameplayState();
+		LuaTableCache cache = CreateBenchCache();
+		lua_gc(L, LUA_GCCOLLECT, 0);
+		const int startKb = lua_gc(L, LUA_GCCOUNT, 0);
+		int peakKb = startKb;
+		double sum = 0.0, sumSq = 0.0, worst = 0.0;
+
+		Timer total;
+		for (uint32 i = 0; i < numFrames; i++)
+		{
+			Timer frame;
+			if (cached)
+				UpdateFrameCached(L, cache, i);
+			else
+				UpdateFrameTables(L, i);
+			// Incremental gc step as the skins get it every frame
+			lua_gc(L, LUA_GCSTEP, 0);
+			const double ms = frame.SecondsAsDouble() * 1000.0;
+			sum += ms;
+			sumSq += ms * ms;
+			worst = Math::Max(worst, ms);
+			peakKb = Math::Max(peakKb, lua_gc(L, LUA_GCCOUNT, 0));
+		}
+		const double mean = sum / numFrames;
+		const double stddev = sqrt(Math::Max(0.0, sumSq / numFrames - mean * mean));
+		Logf("%s: total %.2f ms, frame mean %.4f ms, stddev %.4f ms, worst %.4f ms, memory %d KB -> %d KB (peak %d KB)", Logger::Severity::Info,
+			name, total.SecondsAsDouble() * 1000.0, mean, stddev, worst, startKb, lua_gc(L, LUA_GCCOUNT, 0), peakKb);
+		lua_close(L);
+		return peakKb - startKb;
+	};
+
+	const int growthTables = run("New tables per frame", false);
+	const int growthCached = run("Cached tables", true);
+	TestEnsure(growthCached <= growthTables);
+}
+
+Test("Lua.Allocator")
+{
+	LuaAllocator allocator;
+	lua_State* L = lua_newstate(&LuaAllocator::Alloc, &allocator);
+	luaL_openlibs(L);
+	// Mix of small and large strings and tables that grow through all size classes
+	TestEnsure(luaL_dostring(L, R"(
+		local t = {}
+		for i = 1, 20000 do
+			t[i] = { i, tostring(i), string.rep("x", i % 600) }
+		end
+		local sum = 0
+		for i = 1, #t do
+			sum = sum + t[i][1] + #t[i][3]
+		end
+		result = sum
+	)") == 0);
+	lua_getglobal(L, "result");
+	TestEnsure(lua_tointeger(L, -1) == 200010000 + 5950200);
+	lua_pop(L, 1);
+	TestEnsure(allocator.GetBytesInUse() == (size_t)lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0));
+
+	// The table is garbage now
+	const size_t usedBytes = allocator.GetBytesInUse();
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	TestEnsure(allocator.GetBytesInUse() < usedBytes / 4);
+	lua_close(L);
+	TestEnsure(allocator.GetBytesInUse() == 0);
+}
+
+// Skin-like workload that creates garbage every frame
+static const char* gcBenchScript = R"(
+	function render(frame)
+		local items = {}
+		for i = 1, 200 do
+			items[i] = { x = i * 2, y = frame, label = "item " .. i .. " " .. frame }
+		end
+		local text = ""
+		for i = 1, 20 do
+			text = text .. items[i].label
+		end
+		return #text
+	end
+)";
+
+// Plays frames of a 60 fps game where the render work of a few skin states is followed by idle time,
+// compares the worst render times of lua's own collector with the collection moved into the idle time
+Test("Lua.GCScheduler.Benchmark")
+{
+	const uint32 numFrames = 60 * 30;
+	const uint32 numStates = 4;
+	auto run = [&](const char* name, bool scheduled)
+	{
+		LuaGCScheduler scheduler;
+		Vector<lua_State*> states;
+		for (uint32 i = 0; i < numStates; i++)
+		{
+			lua_State* L = scheduled ? scheduler.NewState(Utility::Sprintf("state%d", i)) : luaL_newstate();
+			luaL_openlibs(L);
+			luaL_dostring(L, gcBenchScript);
+			states.push_back(L);
+		}
+
+		Vector<double> frameTimes;
+		Timer total;
+		for (uint32 frame = 0; frame < numFrames; frame++)
+		{
+			Timer render;
+			for (lua_State* L : states)
+			{
+				lua_getglobal(L, "render");
+				lua_pushinteger(L, frame);
+				lua_call(L, 1, 1);
+				lua_pop(L, 1);
+			}
+			const double renderTime = render.SecondsAsDouble();
+			frameTimes.push_back(renderTime * 1000.0);
+
+			if (scheduled)
+			{
+				// Half of the remaining frame time, like the main loop
+				scheduler.Step(Math::Max(1.0 / 60.0 - renderTime, 0.0) * 0.5);
+				scheduler.EndFrame();
+			}
+		}
+		const double totalTime = total.SecondsAsDouble();
+
+		size_t memory = 0;
+		for (lua_State* L : states)
+			memory += lua_gc(L, LUA_GCCOUNT, 0);
+		if (scheduled)
+		{
+			for (lua_State* L : states)
+				scheduler.Close(L);
+		}
+		else
+		{
+			for (lua_State* L : states)
+				lua_close(L);
+		}
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		const double median = frameTimes[frameTimes.size() / 2];
+		const double p99 = frameTimes[frameTimes.size() * 99 / 100];
+		const double worst = frameTimes.back();
+		Logf("%s: total %.1f ms, render median %.3f ms, 99th %.3f ms, worst %.3f ms, memory %d KB", Logger::Severity::Info,
+			name, totalTime * 1000.0, median, p99, worst, (int)memory);
+		return p99;
+	};
+
+	run("Lua collector", false);
+	run("Scheduled collector", true);
+}
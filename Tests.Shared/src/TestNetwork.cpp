@@ -0,0 +1,615 @@
+#include <Shared/Shared.hpp>
+#include <Shared/TCPConnection.hpp>
+#include <Shared/Profiling.hpp>
+#include <Shared/MultiplayerProtocol.hpp>
+#include <Shared/VarInt.hpp>
+#include <Tests/Tests.hpp>
+#include <algorithm>
+#include <ctime>
+#include <thread>
+#include "json.hpp"
+
+static void CloseListener(SOCKET s)
+{
+#ifdef _WIN32
+	closesocket(s);
+#else
+	close(s);
+#endif
+}
+
+// Listens on a free port of the loopback interface
+static SOCKET ListenLoopback(String& port, int backlog = 1)
+{
+	SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (invalid_socket(listener))
+		return INVALID_SOCKET;
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	socklen_t addrLen = sizeof(addr);
+	if (bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, backlog) != 0 ||
+		getsockname(listener, (sockaddr*)&addr, &addrLen) != 0)
+	{
+		CloseListener(listener);
+		return INVALID_SOCKET;
+	}
+	port = Utility::Sprintf("%d", (int)ntohs(addr.sin_port));
+	return listener;
+}
+
+// Connects client and server over the loopback interface
+static bool ConnectLoopback(TCPConnection& client, TCPConnection& server)
+{
+	String port;
+	SOCKET listener = ListenLoopback(port);
+	if (invalid_socket(listener))
+		return false;
+
+	// The connection is completed by the backlog before accept is called
+	bool connected = client.Connect("127.0.0.1", port);
+	SOCKET accepted = connected ? accept(listener, nullptr, nullptr) : INVALID_SOCKET;
+	CloseListener(listener);
+	return connected && !invalid_socket(accepted) && server.Open(accepted);
+}
+
+// Waits until count packets were received
+static bool ReceiveAll(TCPConnection& connection, Vector<TCPPacket>& packets, size_t count)
+{
+	Timer timeout;
+	while (packets.size() < count)
+	{
+		connection.Receive(packets);
+		if (connection.IsClosed() || timeout.Milliseconds() > 5000)
+			return false;
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+Test("Network.Loopback")
+{
+	TCPConnection client, server;
+	TestEnsure(ConnectLoopback(client, server));
+
+	// Enough data to wrap around and grow the read buffer
+	const size_t numLines = 2000;
+	for (size_t i = 0; i < numLines; i++)
+	{
+		String line = Utility::Sprintf("{\"topic\":\"test\",\"index\":%d}", i);
+		if (i % 100 == 0)
+			line += String(10000, ' ');
+		client.Send(TCPPacketMode::JSON_LINE, line.c_str(), line.size());
+	}
+
+	Vector<TCPPacket> packets;
+	TestEnsure(ReceiveAll(server, packets, numLines));
+	TestEnsure(packets.size() == numLines);
+	for (size_t i = 0; i < numLines; i++)
+	{
+		TestEnsure(packets[i].mode == TCPPacketMode::JSON_LINE);
+		TestEnsure(packets[i].data.compare(0, 24, Utility::Sprintf("{\"topic\":\"test\",\"index\":%d}", i), 0, 24) == 0);
+		TestEnsure(packets[i].data.size() == Utility::Sprintf("{\"topic\":\"test\",\"index\":%d}", i).size() + (i % 100 == 0 ? 10000 : 0));
+	}
+
+	// Empty packets are valid
+	server.Send(TCPPacketMode::JSON_LINE, "", 0);
+	packets.clear();
+	TestEnsure(ReceiveAll(client, packets, 1));
+	TestEnsure(packets[0].data.empty());
+
+	// Packets with an unknown mode close the stream
+	server.Send(TCPPacketMode::UNKNOWN, "?", 1);
+	Timer timeout;
+	while (!client.IsClosed() && timeout.Milliseconds() < 5000)
+		std::this_thread::yield();
+	TestEnsure(client.IsClosed());
+	client.Close();
+	TestEnsure(!client.IsOpen());
+
+	// The server notices the connection was closed
+	timeout.Restart();
+	while (!server.IsClosed() && timeout.Milliseconds() < 5000)
+		std::this_thread::yield();
+	TestEnsure(server.IsClosed());
+}
+
+// Per packet latency from the server sending a score update until the receiving thread takes it from the queue
+static void MeasureScoreLatency(const char* name, uint32 numPlayers, uint32 numUpdates, uint32 intervalUs)
+{
+	TCPConnection client, server;
+	TestEnsure(ConnectLoopback(client, server));
+
+	std::thread sender([&]()
+	{
+		Timer interval;
+		for (uint32 i = 0; i < numUpdates; i++)
+		{
+			while (interval.SecondsAsDouble() * 1e6 < (double)i * intervalUs)
+				std::this_thread::yield();
+			for (uint32 p = 0; p < numPlayers; p++)
+			{
+				String line = Utility::Sprintf("{\"topic\":\"game.scoreboard\",\"uid\":\"player%d\",\"score\":%d,\"sent\":%llu}",
+					p, i * 100, (unsigned long long)Profiling::Now());
+				server.Send(TCPPacketMode::JSON_LINE, line.c_str(), line.size());
+			}
+		}
+	});
+
+	const size_t numPackets = (size_t)numPlayers * numUpdates;
+	Vector<double> latencies;
+	latencies.reserve(numPackets);
+	Vector<TCPPacket> packets;
+	Timer timeout;
+	while (latencies.size() < numPackets && !client.IsClosed() && timeout.Milliseconds() < 30000)
+	{
+		client.Receive(packets);
+		const uint64 now = Profiling::Now();
+		for (const TCPPacket& packet : packets)
+		{
+			size_t sentPos = packet.data.find("\"sent\":");
+			if (sentPos == String::npos)
+				continue;
+			const uint64 sent = strtoull(packet.data.c_str() + sentPos + 7, nullptr, 10);
+			latencies.push_back((now - sent) / 1000.0);
+		}
+		packets.clear();
+		std::this_thread::yield();
+	}
+	sender.join();
+	TestEnsure(latencies.size() == numPackets);
+
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&](double p) { return latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))]; };
+	Logf("%s: %d packets in %.1f ms, latency p50 %.1f us, p99 %.1f us, max %.1f us", Logger::Severity::Info,
+		name, numPackets, timeout.SecondsAsDouble() * 1000.0, percentile(0.5), percentile(0.99), latencies.back());
+}
+
+Test("Network.Latency.Benchmark")
+{
+	// 8 players updating their score every millisecond
+	MeasureScoreLatency("Paced score updates", 8, 2000, 1000);
+	// Everything at once, mostly measures queueing
+	MeasureScoreLatency("Flooded score updates", 8, 20000, 0);
+}
+
+Test("Network.Binary")
+{
+	TCPConnection client, server;
+	TestEnsure(ConnectLoopback(client, server));
+
+	// Binary and text packets can be mixed, binary data can contain line breaks
+	const String large(100000, '\n');
+	client.Send(TCPPacketMode::BINARY, "\n\0\n", 3);
+	client.Send(TCPPacketMode::JSON_LINE, "{}", 2);
+	client.Send(TCPPacketMode::BINARY, large.data(), large.size());
+	client.Send(TCPPacketMode::BINARY, "", 0);
+
+	Vector<TCPPacket> packets;
+	TestEnsure(ReceiveAll(server, packets, 4));
+	TestEnsure(packets[0].mode == TCPPacketMode::BINARY && packets[0].data == String("\n\0\n", 3));
+	TestEnsure(packets[1].mode == TCPPacketMode::JSON_LINE && packets[1].data == "{}");
+	TestEnsure(packets[2].mode == TCPPacketMode::BINARY && packets[2].data == large);
+	TestEnsure(packets[3].mode == TCPPacketMode::BINARY && packets[3].data.empty());
+}
+
+Test("MultiplayerProtocol.Encoding")
+{
+	using namespace MultiplayerProtocol;
+	Buffer buffer;
+
+	ScoreUpdate update;
+	update.time = 123400;
+	update.score = 9876543;
+	Encode(update, buffer);
+	String data((const char*)buffer.data(), buffer.size());
+	TestEnsure(GetTopic(data) == BinaryTopic::ScoreUpdate);
+	ScoreUpdate decodedUpdate;
+	TestEnsure(Decode(data, decodedUpdate));
+	TestEnsure(decodedUpdate.time == update.time && decodedUpdate.score == update.score);
+	// Truncated packets and other topics are rejected
+	Scoreboard wrongTopic;
+	TestEnsure(!Decode(data, wrongTopic));
+	TestEnsure(!Decode(data.substr(0, data.size() - 1), decodedUpdate));
+
+	Scoreboard scoreboard;
+	for (uint32 i = 0; i < 8; i++)
+		scoreboard.users.push_back({ Utility::Sprintf("user-%d", i), Utility::Sprintf("Player %d", i), i * 1000000 });
+	Encode(scoreboard, buffer);
+	data.assign((const char*)buffer.data(), buffer.size());
+	TestEnsure(GetTopic(data) == BinaryTopic::Scoreboard);
+	Scoreboard decoded;
+	TestEnsure(Decode(data, decoded));
+	TestEnsure(decoded.users.size() == 8);
+	for (uint32 i = 0; i < 8; i++)
+	{
+		TestEnsure(decoded.users[i].id == scoreboard.users[i].id);
+		TestEnsure(decoded.users[i].name == scoreboard.users[i].name);
+		TestEnsure(decoded.users[i].score == scoreboard.users[i].score);
+	}
+	for (size_t i = 1; i < data.size(); i++)
+		TestEnsure(!Decode(data.substr(0, i), decoded));
+	TestEnsure(GetTopic("") == BinaryTopic::Invalid);
+	TestEnsure(GetTopic("\x7f") == BinaryTopic::Invalid);
+}
+
+// Wire size of a packet including its framing
+static size_t FramedSize(TCPPacketMode mode, size_t length)
+{
+	uint8 header[VarInt::MaxBytes];
+	return 1 + length + (mode == TCPPacketMode::BINARY ? VarInt::Encode(header, length) : 1);
+}
+
+/*
+	Stand-in for the multiplayer server hosting a single room
+	authenticates players, agrees on the binary protocol if both sides want it
+	and sends the sorted scoreboard to everyone once all players sent their score
+*/
+class LocalMultiplayerServer
+{
+public:
+	LocalMultiplayerServer(bool allowBinary) : m_allowBinary(allowBinary)
+	{
+	}
+
+	bool Listen(String& port, int numPlayers)
+	{
+		m_listener = ListenLoopback(port, numPlayers);
+		return !invalid_socket(m_listener);
+	}
+	void Accept()
+	{
+		SOCKET s = accept(m_listener, nullptr, nullptr);
+		m_players.push_back(new Player());
+		m_players.back()->connection.Open(s);
+	}
+	~LocalMultiplayerServer()
+	{
+		CloseListener(m_listener);
+		for (Player* player : m_players)
+			delete player;
+	}
+
+	// Handles everything that was received, returns true when all players sent their score
+	bool Update()
+	{
+		bool allScores = true;
+		for (size_t i = 0; i < m_players.size(); i++)
+		{
+			Player& player = *m_players[i];
+			player.connection.Receive(m_packets);
+			for (const TCPPacket& packet : m_packets)
+			{
+				bytesReceived += FramedSize(packet.mode, packet.data.size());
+				if (packet.mode == TCPPacketMode::BINARY)
+				{
+					MultiplayerProtocol::ScoreUpdate update;
+					if (MultiplayerProtocol::Decode(packet.data, update))
+						m_SetScore(i, update.score);
+					continue;
+				}
+
+				nlohmann::json json = nlohmann::json::parse(packet.data);
+				String topic = json.value("topic", "");
+				if (topic == "user.auth")
+				{
+					player.binary = m_allowBinary && json.value("binary", 0u) == MultiplayerProtocol::BinaryVersion;
+					player.name = json.value("name", "");
+					player.id = Utility::Sprintf("user-%d", i);
+
+					nlohmann::json info;
+					info["topic"] = "server.info";
+					info["userid"] = player.id;
+					info["version"] = "v0.19";
+					info["refresh_rate"] = 1000;
+					if (player.binary)
+						info["binary"] = MultiplayerProtocol::BinaryVersion;
+					m_SendJSON(player, info);
+				}
+				else if (topic == "room.score.update")
+				{
+					m_SetScore(i, json.value("score", 0u));
+				}
+			}
+			m_packets.clear();
+			allScores = allScores && player.hasScore;
+		}
+		if (!allScores)
+			return false;
+
+		m_SendScoreboard();
+		for (Player* player : m_players)
+			player->hasScore = false;
+		return true;
+	}
+
+	size_t bytesSent = 0;
+	size_t bytesReceived = 0;
+
+private:
+	struct Player
+	{
+		TCPConnection connection;
+		String id;
+		String name;
+		uint32 score = 0;
+		bool hasScore = false;
+		bool binary = false;
+	};
+
+	void m_SetScore(size_t player, uint32 score)
+	{
+		m_players[player]->score = score;
+		m_players[player]->hasScore = true;
+	}
+
+	void m_SendJSON(Player& player, const nlohmann::json& json)
+	{
+		String line = json.dump();
+		bytesSent += FramedSize(TCPPacketMode::JSON_LINE, line.size());
+		player.connection.Send(TCPPacketMode::JSON_LINE, line.data(), line.size());
+	}
+
+	void m_SendScoreboard()
+	{
+		m_scoreboard.users.resize(m_players.size());
+		for (size_t i = 0; i < m_players.size(); i++)
+			m_scoreboard.users[i] = { m_players[i]->id, m_players[i]->name, m_players[i]->score };
+		std::sort(m_scoreboard.users.begin(), m_scoreboard.users.end(),
+			[](const MultiplayerProtocol::ScoreboardUser& a, const MultiplayerProtocol::ScoreboardUser& b) { return a.score > b.score; });
+
+		// Only encode each format once for the whole room
+		bool binaryEncoded = false;
+		String line;
+		for (Player* player : m_players)
+		{
+			if (player->binary)
+			{
+				if (!binaryEncoded)
+					MultiplayerProtocol::Encode(m_scoreboard, m_binary);
+				binaryEncoded = true;
+				bytesSent += FramedSize(TCPPacketMode::BINARY, m_binary.size());
+				player->connection.Send(TCPPacketMode::BINARY, (const char*)m_binary.data(), m_binary.size());
+				continue;
+			}
+
+			if (line.empty())
+			{
+				nlohmann::json json;
+				json["topic"] = "game.scoreboard";
+				json["users"] = nlohmann::json::array();
+				for (const MultiplayerProtocol::ScoreboardUser& user : m_scoreboard.users)
+					json["users"].push_back({ { "id", user.id }, { "name", user.name }, { "score", user.score } });
+				line = json.dump();
+			}
+			bytesSent += FramedSize(TCPPacketMode::JSON_LINE, line.size());
+			player->connection.Send(TCPPacketMode::JSON_LINE, line.data(), line.size());
+		}
+	}
+
+	bool m_allowBinary;
+	SOCKET m_listener = INVALID_SOCKET;
+	Vector<Player*> m_players;
+	Vector<TCPPacket> m_packets;
+	MultiplayerProtocol::Scoreboard m_scoreboard;
+	Buffer m_binary;
+};
+
+// Client side of a player, does what MultiplayerScreen does with score updates and scoreboards
+struct LocalMultiplayerClient
+{
+	TCPConnection connection;
+	bool authenticated = false;
+	bool binary = false;
+	MultiplayerProtocol::Scoreboard scoreboard;
+	Vector<TCPPacket> packets;
+	Buffer binaryPacket;
+
+	void Authenticate(const String& name, bool wantBinary)
+	{
+		nlohmann::json packet;
+		packet["topic"] = "user.auth";
+		packet["name"] = name;
+		packet["version"] = "v0.19";
+		if (wantBinary)
+			packet["binary"] = MultiplayerProtocol::BinaryVersion;
+		String line = packet.dump();
+		connection.Send(TCPPacketMode::JSON_LINE, line.data(), line.size());
+	}
+
+	void SendScore(uint32 time, uint32 score)
+	{
+		if (binary)
+		{
+			MultiplayerProtocol::ScoreUpdate update;
+			update.time = time;
+			update.score = score;
+			MultiplayerProtocol::Encode(update, binaryPacket);
+			connection.Send(TCPPacketMode::BINARY, (const char*)binaryPacket.data(), binaryPacket.size());
+			return;
+		}
+		nlohmann::json packet;
+		packet["topic"] = "room.score.update";
+		packet["time"] = time;
+		packet["score"] = score;
+		String line = packet.dump();
+		connection.Send(TCPPacketMode::JSON_LINE, line.data(), line.size());
+	}
+
+	// Returns the number of scoreboards received
+	size_t Update()
+	{
+		size_t numScoreboards = 0;
+		connection.Receive(packets);
+		for (const TCPPacket& packet : packets)
+		{
+			if (packet.mode == TCPPacketMode::BINARY)
+			{
+				if (MultiplayerProtocol::Decode(packet.data, scoreboard))
+					numScoreboards++;
+				continue;
+			}
+
+			nlohmann::json json = nlohmann::json::parse(packet.data);
+			String topic = json.value("topic", "");
+			if (topic == "server.info")
+			{
+				authenticated = true;
+				binary = json.value("binary", 0u) == MultiplayerProtocol::BinaryVersion;
+			}
+			else if (topic == "game.scoreboard")
+			{
+				const nlohmann::json& users = json["users"];
+				scoreboard.users.resize(users.size());
+				for (size_t i = 0; i < users.size(); i++)
+				{
+					scoreboard.users[i].id = users[i].value("id", "");
+					scoreboard.users[i].name = users[i].value("name", "");
+					scoreboard.users[i].score = users[i].value("score", 0u);
+				}
+				numScoreboards++;
+			}
+		}
+		packets.clear();
+		return numScoreboards;
+	}
+};
+
+struct RoomResult
+{
+	size_t bytesPerUpdate;
+	double cpuUsPerUpdate;
+	bool binary;
+};
+
+// Plays a number of score updates in a room with a stand-in server
+static RoomResult SimulateRoom(bool serverBinary, bool clientBinary, uint32 numPlayers, uint32 numRounds)
+{
+	RoomResult result = {};
+	LocalMultiplayerServer server(serverBinary);
+	String port;
+	TestEnsure(server.Listen(port, numPlayers));
+
+	Vector<LocalMultiplayerClient*> clients;
+	for (uint32 i = 0; i < numPlayers; i++)
+	{
+		clients.push_back(new LocalMultiplayerClient());
+		TestEnsure(clients.back()->connection.Connect("127.0.0.1", port));
+		server.Accept();
+		clients.back()->Authenticate(Utility::Sprintf("Player %d", i), clientBinary);
+	}
+
+	// Wait for the server.info replies
+	Timer timeout;
+	bool allAuthenticated = false;
+	while (!allAuthenticated && timeout.Milliseconds() < 5000)
+	{
+		server.Update();
+		allAuthenticated = true;
+		for (LocalMultiplayerClient* client : clients)
+		{
+			client->Update();
+			allAuthenticated = allAuthenticated && client->authenticated;
+		}
+		std::this_thread::yield();
+	}
+	TestEnsure(allAuthenticated);
+	result.binary = clients[0]->binary;
+	for (LocalMultiplayerClient* client : clients)
+		TestEnsure(client->binary == (serverBinary && clientBinary));
+
+	const size_t startSent = server.bytesSent;
+	const size_t startReceived = server.bytesReceived;
+	const std::clock_t cpuStart = std::clock();
+	for (uint32 round = 0; round < numRounds; round++)
+	{
+		for (uint32 i = 0; i < numPlayers; i++)
+			clients[i]->SendScore(round * 1000, (round * 997 + i * 7919) % 10000000);
+
+		timeout.Restart();
+		while (!server.Update())
+		{
+			TestEnsure(timeout.Milliseconds() < 5000);
+			std::this_thread::yield();
+		}
+		for (LocalMultiplayerClient* client : clients)
+		{
+			timeout.Restart();
+			while (client->Update() == 0)
+			{
+				TestEnsure(timeout.Milliseconds() < 5000);
+				std::this_thread::yield();
+			}
+			TestEnsure(client->scoreboard.users.size() == numPlayers);
+		}
+	}
+	const std::clock_t cpuEnd = std::clock();
+
+	// Scoreboard is sorted by score
+	const auto& users = clients[0]->scoreboard.users;
+	for (size_t i = 1; i < users.size(); i++)
+		TestEnsure(users[i - 1].score >= users[i].score);
+
+	const size_t numUpdates = (size_t)numRounds * numPlayers;
+	result.bytesPerUpdate = (server.bytesSent - startSent + server.bytesReceived - startReceived) / numUpdates;
+	result.cpuUsPerUpdate = (double)(cpuEnd - cpuStart) / CLOCKS_PER_SEC * 1e6 / numUpdates;
+	for (LocalMultiplayerClient* client : clients)
+		delete client;
+	return result;
+}
+
+Test("MultiplayerProtocol.Negotiation")
+{
+	// Either side not supporting binary falls back to JSON
+	TestEnsure(!SimulateRoom(false, true, 2, 10).binary);
+	TestEnsure(!SimulateRoom(true, false, 2, 10).binary);
+	TestEnsure(SimulateRoom(true, true, 2, 10).binary);
+}
+
+Test("MultiplayerProtocol.Benchmark")
+{
+	// Includes the score update and the share of the scoreboards sent back to every player
+	const uint32 numPlayers = 8;
+	const uint32 numRounds = 1000;
+	RoomResult json = SimulateRoom(false, false, numPlayers, numRounds);
+	RoomResult binary = SimulateRoom(true, true, numPlayers, numRounds);
+	Logf("%d player room, JSON: %d bytes and %.1f us CPU per update", Logger::Severity::Info, numPlayers, json.bytesPerUpdate, json.cpuUsPerUpdate);
+	Logf("%d player room, binary: %d bytes and %.1f us CPU per update", Logger::Severity::Info, numPlayers, binary.bytesPerUpdate, binary.cpuUsPerUpdate);
+
+	// Encoding and decoding alone
+	const uint32 numCodecRuns = 100000;
+	MultiplayerProtocol::Scoreboard scoreboard;
+	for (uint32 i = 0; i < numPlayers; i++)
+		scoreboard.users.push_back({ Utility::Sprintf("user-%d", i), Utility::Sprintf("Player %d", i), i * 1234567 });
+
+	Timer jsonTimer;
+	MultiplayerProtocol::Scoreboard decoded;
+	for (uint32 run = 0; run < numCodecRuns; run++)
+	{
+		nlohmann::json json;
+		json["topic"] = "game.scoreboard";
+		json["users"] = nlohmann::json::array();
+		for (const MultiplayerProtocol::ScoreboardUser& user : scoreboard.users)
+			json["users"].push_back({ { "id", user.id }, { "name", user.name }, { "score", user.score } });
+		nlohmann::json parsed = nlohmann::json::parse(json.dump());
+		const nlohmann::json& users = parsed["users"];
+		decoded.users.resize(users.size());
+		for (size_t i = 0; i < users.size(); i++)
+			decoded.users[i].score = users[i].value("score", 0u);
+	}
+	const double jsonNs = jsonTimer.SecondsAsDouble() * 1e9 / numCodecRuns;
+
+	Timer binaryTimer;
+	Buffer buffer;
+	String data;
+	for (uint32 run = 0; run < numCodecRuns; run++)
+	{
+		MultiplayerProtocol::Encode(scoreboard, buffer);
+		data.assign((const char*)buffer.data(), buffer.size());
+		TestEnsure(MultiplayerProtocol::Decode(data, decoded));
+	}
+	const double binaryNs = binaryTimer.SecondsAsDouble() * 1e9 / numCodecRuns;
+	Logf("Scoreboard encode + decode: JSON %.0f ns, binary %.0f ns", Logger::Severity::Info, jsonNs, binaryNs);
+}
@@ -0,0 +1,89 @@
+#include <Shared/Shared.hpp>
+#include <Shared/Profiling.hpp>
+#include <Shared/Files.hpp>
+#include <Tests/Tests.hpp>
+#include <thread>
+
+static size_t CountOccurrences(const String& str, const char* pattern)
+{
+	size_t count = 0;
+	for (size_t pos = str.find(pattern); pos != String::npos; pos = str.find(pattern, pos + 1))
+		count++;
+	return count;
+}
+
+Test("Profiling.ChromeTrace")
+{
+	// Nothing is recorded without a capture
+	TestEnsure(!Profiling::IsCapturing());
+	{
+		Profiling::Span span("Not recorded");
+	}
+
+	Profiling::StartCapture();
+	std::thread worker([]()
+	{
+		Profiling::SetThreadName("Worker \"1\"");
+		for (int i = 0; i < 10; i++)
+		{
+			Profiling::Span span("Work");
+			Profiling::Counter("Counter", i);
+		}
+	});
+	for (int i = 0; i < 3; i++)
+	{
+		Profiling::FrameMark();
+		Profiling::Span frame("Frame work");
+		Profiling::Span nested(Profiling::InternName(Utility::Sprintf("Nested %d", i)));
+	}
+	worker.join();
+
+	const String path = Path::Absolute(TestBasePath + Path::sep + "profiling_test.json");
+	const bool exported = Profiling::ExportChromeTrace(path);
+	TestEnsure(!Profiling::IsCapturing());
+
+	File file;
+	const bool opened = exported && file.OpenRead(path);
+	String json;
+	if (opened)
+	{
+		json.resize(file.GetSize());
+		file.Read(&json.front(), json.size());
+		file.Close();
+	}
+	Path::Delete(path);
+	TestEnsure(exported);
+	TestEnsure(opened);
+
+	TestEnsure(json.find("Not recorded") == String::npos);
+	TestEnsure(CountOccurrences(json, "\"ph\":\"B\"") == 16);
+	TestEnsure(CountOccurrences(json, "\"ph\":\"E\"") == 16);
+	TestEnsure(CountOccurrences(json, "\"ph\":\"C\"") == 10);
+	TestEnsure(CountOccurrences(json, "\"ph\":\"i\"") == 3);
+	TestEnsure(json.find("\"Nested 2\"") != String::npos);
+	// Names are escaped
+	TestEnsure(json.find("Worker \\\"1\\\"") != String::npos);
+}
+
+Test("Profiling.Overhead")
+{
+	const uint32 numSpans = 1000000;
+
+	Timer idle;
+	for (uint32 i = 0; i < numSpans; i++)
+	{
+		Profiling::Span span("Idle");
+	}
+	const double idleNs = idle.SecondsAsDouble() * 1e9 / numSpans;
+
+	Profiling::StartCapture();
+	Timer capturing;
+	for (uint32 i = 0; i < numSpans; i++)
+	{
+		Profiling::Span span("Capturing");
+	}
+	const double capturingNs = capturing.SecondsAsDouble() * 1e9 / numSpans;
+	Profiling::StopCapture();
+
+	Logf("Span overhead: %.1f ns without capture, %.1f ns while capturing", Logger::Severity::Info, idleNs, capturingNs);
+}
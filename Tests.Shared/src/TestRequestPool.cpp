@@ -0,0 +1,337 @@
+#include <Shared/Shared.hpp>
+#include <Shared/RequestPool.hpp>
+#include <Shared/TCPConnection.hpp>
+#include <Tests/Tests.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Blocks the workers of a pool until released
+class WorkerGate
+{
+public:
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_waiting++;
+		m_cv.wait(lock, [this]() { return m_open; });
+	}
+	void WaitForWorkers(uint32 count)
+	{
+		while (true)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				if (m_waiting >= count)
+					return;
+			}
+			std::this_thread::yield();
+		}
+	}
+	void Open()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_open = true;
+		}
+		m_cv.notify_all();
+	}
+private:
+	std::mutex m_lock;
+	std::condition_variable m_cv;
+	uint32 m_waiting = 0;
+	bool m_open = false;
+};
+
+static bool WaitFor(std::function<bool()> condition)
+{
+	Timer timeout;
+	while (!condition())
+	{
+		if (timeout.Milliseconds() > 5000)
+			return false;
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+Test("RequestPool.Priority")
+{
+	RequestPool pool(1);
+	WorkerGate gate;
+	pool.Queue("a", RequestPriority::Normal, nullptr, [&](uint32) { gate.Wait(); });
+	gate.WaitForWorkers(1);
+
+	std::mutex orderLock;
+	Vector<int> order;
+	auto record = [&](int i) { return [&, i](uint32) { std::lock_guard<std::mutex> lock(orderLock); order.push_back(i); }; };
+	pool.Queue("a", RequestPriority::Low, nullptr, record(0));
+	pool.Queue("a", RequestPriority::Normal, nullptr, record(1));
+	pool.Queue("a", RequestPriority::High, nullptr, record(2));
+	pool.Queue("a", RequestPriority::Normal, nullptr, record(3));
+	TestEnsure(pool.GetNumQueued() == 4);
+	gate.Open();
+
+	TestEnsure(WaitFor([&]() { std::lock_guard<std::mutex> lock(orderLock); return order.size() == 4; }));
+	TestEnsure(order == Vector<int>({ 2, 1, 3, 0 }));
+}
+
+Test("RequestPool.Cancel")
+{
+	RequestPool pool(1);
+	WorkerGate gate;
+	int owner = 0, otherOwner = 0;
+	std::atomic<bool> cancelledWhileRunning{ false };
+	pool.Queue("a", RequestPriority::Normal, &owner, [&](uint32 worker)
+	{
+		gate.Wait();
+		cancelledWhileRunning = pool.IsCancelled(worker);
+	});
+	gate.WaitForWorkers(1);
+
+	std::atomic<int> numRun{ 0 };
+	RequestId cancelled = pool.Queue("a", RequestPriority::Normal, nullptr, [&](uint32) { numRun++; });
+	pool.Queue("a", RequestPriority::Normal, &owner, [&](uint32) { numRun += 100; });
+	pool.Queue("a", RequestPriority::Normal, &otherOwner, [&](uint32) { numRun++; });
+	TestEnsure(pool.Cancel(cancelled));
+	TestEnsure(!pool.Cancel(cancelled));
+	pool.CancelOwner(&owner);
+	TestEnsure(pool.GetNumQueued() == 1);
+	gate.Open();
+
+	TestEnsure(WaitFor([&]() { return numRun == 1; }));
+	TestEnsure(cancelledWhileRunning);
+	TestEnsure(WaitFor([&]() { return pool.GetNumQueued() == 0; }));
+	TestEnsure(numRun == 1);
+}
+
+Test("RequestPool.HostAffinity")
+{
+	RequestPool pool(1);
+	WorkerGate gate;
+	pool.Queue("a", RequestPriority::Normal, nullptr, [&](uint32) { gate.Wait(); });
+	gate.WaitForWorkers(1);
+
+	std::mutex orderLock;
+	Vector<String> order;
+	auto record = [&](const String& host) { return [&, host](uint32) { std::lock_guard<std::mutex> lock(orderLock); order.push_back(host); }; };
+	// The worker already has a connection to a, so the newer request to a goes first
+	pool.Queue("b", RequestPriority::Normal, nullptr, record("b"));
+	pool.Queue("a", RequestPriority::Normal, nullptr, record("a"));
+	// But never before a request of higher priority
+	pool.Queue("c", RequestPriority::High, nullptr, record("c"));
+	gate.Open();
+
+	TestEnsure(WaitFor([&]() { std::lock_guard<std::mutex> lock(orderLock); return order.size() == 3; }));
+	TestEnsure(order == Vector<String>({ "c", "a", "b" }));
+}
+
+// Minimal HTTP/1.1 server with keep-alive, answers every request with a small body
+class LocalHttpServer
+{
+public:
+	bool Start()
+	{
+		m_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t addrLen = sizeof(addr);
+		if (invalid_socket(m_listener) || bind(m_listener, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+			listen(m_listener, 64) != 0 || getsockname(m_listener, (sockaddr*)&addr, &addrLen) != 0)
+			return false;
+		port = ntohs(addr.sin_port);
+		m_acceptThread = std::thread(&LocalHttpServer::m_Accept, this);
+		return true;
+	}
+	~LocalHttpServer()
+	{
+		m_stop = true;
+		// Wake up accept
+		SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = htons(port);
+		connect(s, (sockaddr*)&addr, sizeof(addr));
+		CloseSocket(s);
+		m_acceptThread.join();
+		CloseSocket(m_listener);
+		for (std::thread& t : m_connectionThreads)
+			t.join();
+	}
+
+	static void CloseSocket(SOCKET s)
+	{
+#ifdef _WIN32
+		closesocket(s);
+#else
+		close(s);
+#endif
+	}
+
+	uint16 port = 0;
+	std::atomic<uint32> numConnections{ 0 };
+
+private:
+	void m_Accept()
+	{
+		while (true)
+		{
+			SOCKET s = accept(m_listener, nullptr, nullptr);
+			if (m_stop)
+			{
+				CloseSocket(s);
+				break;
+			}
+			numConnections++;
+			m_connectionThreads.emplace_back(&LocalHttpServer::m_Serve, this, s);
+		}
+	}
+	void m_Serve(SOCKET s)
+	{
+		String received;
+		char buffer[4096];
+		while (true)
+		{
+			size_t end = received.find("\r\n\r\n");
+			if (end == String::npos)
+			{
+				int n = recv(s, buffer, sizeof(buffer), 0);
+				if (n <= 0)
+					break;
+				received.append(buffer, n);
+				continue;
+			}
+			const bool close = received.find("Connection: close") < end;
+			received.erase(0, end + 4);
+
+			const char* response = close ?
+				"HTTP/1.1 200 OK\r\nContent-Length: 13\r\nConnection: close\r\n\r\n{\"ok\": true }" :
+				"HTTP/1.1 200 OK\r\nContent-Length: 13\r\n\r\n{\"ok\": true }";
+			send(s, response, (int)strlen(response), 0);
+			if (close)
+				break;
+		}
+		CloseSocket(s);
+	}
+
+	SOCKET m_listener = INVALID_SOCKET;
+	std::thread m_acceptThread;
+	Vector<std::thread> m_connectionThreads;
+	std::atomic<bool> m_stop{ false };
+};
+
+// Blocking HTTP GET, connects if socket is invalid and leaves it open when keepAlive is set
+static bool HttpGet(SOCKET& s, uint16 port, const String& path, bool keepAlive)
+{
+	if (invalid_socket(s))
+	{
+		s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = htons(port);
+		if (connect(s, (sockaddr*)&addr, sizeof(addr)) != 0)
+			return false;
+	}
+
+	String request = Utility::Sprintf("GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n%s\r\n", path, keepAlive ? "" : "Connection: close\r\n");
+	send(s, request.data(), (int)request.size(), 0);
+
+	String response;
+	char buffer[4096];
+	size_t end = String::npos;
+	size_t contentLength = 0;
+	while (end == String::npos || response.size() < end + 4 + contentLength)
+	{
+		int n = recv(s, buffer, sizeof(buffer), 0);
+		if (n <= 0)
+			return false;
+		response.append(buffer, n);
+		if (end == String::npos && (end = response.find("\r\n\r\n")) != String::npos)
+		{
+			size_t lengthPos = response.find("Content-Length: ");
+			contentLength = lengthPos < end ? atoi(response.c_str() + lengthPos + 16) : 0;
+		}
+	}
+
+	if (!keepAlive)
+	{
+		LocalHttpServer::CloseSocket(s);
+		s = INVALID_SOCKET;
+	}
+	return response.compare(0, 12, "HTTP/1.1 200") == 0;
+}
+
+struct HttpPoolResult
+{
+	double meanMs;
+	double p99Ms;
+	uint32 numConnections;
+};
+
+// Sends requests through a pool, latency is measured from queueing until the completion was handed to the owner's queue
+static HttpPoolResult RunHttpRequests(uint32 numWorkers, uint32 numRequests, bool keepAlive)
+{
+	// Makes sure sockets are initialized on Windows
+	TCPConnection socketInit;
+	LocalHttpServer server;
+	TestEnsure(server.Start());
+
+	Vector<SOCKET> connections(numWorkers, INVALID_SOCKET);
+	std::mutex completedLock;
+	Vector<double> latencies;
+	std::atomic<uint32> numFailed{ 0 };
+	{
+		RequestPool pool(numWorkers, "Http test worker");
+		for (uint32 i = 0; i < numRequests; i++)
+		{
+			Timer queued;
+			const RequestPriority priority = i % 10 == 0 ? RequestPriority::High : RequestPriority::Normal;
+			pool.Queue("127.0.0.1", priority, nullptr, [&, queued](uint32 worker)
+			{
+				if (!HttpGet(connections[worker], server.port, Utility::Sprintf("/charts/%d", i), keepAlive))
+					numFailed++;
+				std::lock_guard<std::mutex> lock(completedLock);
+				latencies.push_back(queued.SecondsAsDouble() * 1000.0);
+			});
+			// Skins send requests in small bursts
+			if (i % 8 == 7)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		TestEnsure(WaitFor([&]() { std::lock_guard<std::mutex> lock(completedLock); return latencies.size() == numRequests; }));
+	}
+	for (SOCKET s : connections)
+	{
+		if (!invalid_socket(s))
+			LocalHttpServer::CloseSocket(s);
+	}
+	TestEnsure(numFailed == 0);
+
+	std::sort(latencies.begin(), latencies.end());
+	HttpPoolResult result;
+	double sum = 0.0;
+	for (double l : latencies)
+		sum += l;
+	result.meanMs = sum / latencies.size();
+	result.p99Ms = latencies[(size_t)(latencies.size() * 0.99)];
+	result.numConnections = server.numConnections;
+	return result;
+}
+
+Test("RequestPool.Http.Benchmark")
+{
+	const uint32 numRequests = 2000;
+	HttpPoolResult reuse = RunHttpRequests(4, numRequests, true);
+	HttpPoolResult noReuse = RunHttpRequests(4, numRequests, false);
+	// Every worker keeps a single connection to the host
+	TestEnsure(reuse.numConnections <= 4);
+	TestEnsure(noReuse.numConnections == numRequests);
+
+	Logf("%d requests with keep-alive: mean %.3f ms, p99 %.3f ms, %d connections opened", Logger::Severity::Info,
+		numRequests, reuse.meanMs, reuse.p99Ms, reuse.numConnections);
+	Logf("%d requests without keep-alive: mean %.3f ms, p99 %.3f ms, %d connections opened", Logger::Severity::Info,
+		numRequests, noReuse.meanMs, noReuse.p99Ms, noReuse.numConnections);
+}
@@ -1,6 +1,7 @@
 #include <Shared/Shared.hpp>
 #include <Shared/StringEncodingDetector.hpp>
 #include <Shared/StringEncodingConverter.hpp>
+#include <Shared/StringEncodingHeuristic.hpp>
 #include <Tests/Tests.hpp>
 
 #pragma region Test cases
@@ -213,4 +214,153 @@ Test("StringEncodingConverter.CP949")
 			TestEnsure(StringEncodingConverter::ToUTF8(StringEncoding::CP949, testCase.cp949) == testCase.utf8);
 		}
 	}
-}
\ No newline at end of file
+}
+
+Test("StringEncodingConverter.PlainASCII")
+{
+	TestEnsure(StringEncodingConverter::ToUTF8(StringEncoding::CP932, "t=180") == "t=180");
+	TestEnsure(StringEncodingConverter::ToUTF8(StringEncoding::CP949, "\tparallel prism\r\n") == "\tparallel prism\r\n");
+}
+
+Test("StringEncoding.PlainASCIILength")
+{
+	String str(100, 'a');
+	TestEnsure(GetPlainASCIILength(str.c_str(), str.size()) == str.size());
+
+	for (char ch : { '\0', '\x1F', '\x7F', '\x80', '\xFF' })
+	{
+		for (size_t i = 0; i < str.size(); ++i)
+		{
+			String other = str;
+			other[i] = ch;
+			TestEnsure(GetPlainASCIILength(other.c_str(), other.size()) == i);
+		}
+	}
+}
+
+#pragma region Chart headers
+
+// Same tiers as the detector, fed byte by byte without the UTF-8 fast path
+class ReferenceEncodingHeuristic : public TieredStringEncodingHeuristic
+<
+	StringEncodingHeuristicCollection<UTF8Heuristic>,
+	StringEncodingHeuristicCollection<CP932Heuristic, CP954Heuristic>
+>
+{
+public:
+	StringEncoding Detect(const String& str)
+	{
+		for (char ch : str) Consume(ch);
+		Finalize();
+
+		const StringEncodingHeuristic& best = GetBestHeuristic();
+		return best.IsValid() ? best.GetEncoding() : StringEncoding::Unknown;
+	}
+};
+
+static String MakeChartHeader(const char* title, const char* artist)
+{
+	return Utility::Sprintf("title=%s\r\nartist=%s\r\neffect=%s\r\njacket=jacket.png\r\nillustrator=%s\r\ndifficulty=extended\r\nlevel=16\r\n"
+		"t=180\r\nm=song.ogg;song_f.ogg\r\nmvol=75\r\no=0\r\nbg=desert\r\nlayer=arrow\r\npo=45000\r\nplength=15000\r\n"
+		"pfiltergain=50\r\nfilter=peak\r\nchokkakuautovol=0\r\nchokkakuvol=50\r\nver=167\r\n--\r\n",
+		title, artist, artist, title);
+}
+
+// Headers of ASCII, UTF-8 and CP932 charts, with some that aren't valid in any encoding
+static Vector<String> MakeChartHeaders()
+{
+	Vector<String> headers;
+	headers.push_back(MakeChartHeader("The quick brown fox", "jumps over the lazy dog"));
+	headers.push_back(MakeChartHeader("Truncated", "\xe3\x81"));
+	headers.push_back(MakeChartHeader("Control", "\x01"));
+
+	for (auto& testCase : TEST_CASES)
+	{
+		headers.push_back(MakeChartHeader(testCase.utf8, "ASCII artist"));
+		headers.push_back(MakeChartHeader("ASCII title", testCase.utf8));
+		if (testCase.cp932)
+		{
+			headers.push_back(MakeChartHeader(testCase.cp932, "ASCII artist"));
+			headers.push_back(MakeChartHeader("ASCII title", testCase.cp932));
+		}
+		if (testCase.cp949)
+		{
+			headers.push_back(MakeChartHeader(testCase.cp949, testCase.cp949));
+		}
+	}
+
+	return headers;
+}
+
+#pragma endregion
+
+Test("StringEncodingDetector.FastPath")
+{
+	for (const String& header : MakeChartHeaders())
+	{
+		const StringEncoding expected = ReferenceEncodingHeuristic().Detect(header);
+		TestEnsure(StringEncodingDetector::Detect(header) == expected);
+		TestEnsure(StringEncodingDetector::Detect(header + "\xe3\x81") == ReferenceEncodingHeuristic().Detect(header + "\xe3\x81"));
+
+		// Multi-byte characters split between calls
+		for (size_t chunkSize : { 1, 5, 33 })
+		{
+			StringEncodingDetector detector;
+			for (size_t i = 0; i < header.size(); i += chunkSize)
+				detector.Feed(header.c_str() + i, Math::Min(chunkSize, header.size() - i));
+			TestEnsure(detector.GetEncoding() == expected);
+		}
+	}
+}
+
+// Throughput of detecting the encoding of chart headers, compared to running every heuristic on every byte
+Test("StringEncodingDetector.Benchmark")
+{
+	// UTF-8 headers take the fast path, legacy ones are replayed into the heuristics
+	Vector<String> utf8Headers, legacyHeaders;
+	for (const String& header : MakeChartHeaders())
+	{
+		if (ReferenceEncodingHeuristic().Detect(header) == StringEncoding::UTF8) utf8Headers.push_back(header);
+		else legacyHeaders.push_back(header);
+	}
+
+	const uint32 iterations = 200;
+	for (const Vector<String>* headers : { &utf8Headers, &legacyHeaders })
+	{
+		size_t totalSize = 0;
+		for (const String& header : *headers)
+			totalSize += header.size();
+
+		int32 numMismatches = 0;
+		Timer timer;
+		for (uint32 i = 0; i < iterations; ++i)
+		{
+			for (const String& header : *headers)
+				numMismatches += StringEncodingDetector::Detect(header) != StringEncoding::UTF8;
+		}
+		const double detectorTime = timer.SecondsAsDouble();
+
+		timer.Restart();
+		for (uint32 i = 0; i < iterations; ++i)
+		{
+			for (const String& header : *headers)
+				numMismatches -= ReferenceEncodingHeuristic().Detect(header) != StringEncoding::UTF8;
+		}
+		const double referenceTime = timer.SecondsAsDouble();
+
+		const double megabytes = (double)totalSize * iterations / (1 << 20);
+		Logf("Detecting %d %s chart headers: %.1f MB/s, %.1f MB/s with per byte heuristics", Logger::Severity::Info,
+			headers->size(), headers == &utf8Headers ? "UTF-8" : "legacy", megabytes / detectorTime, megabytes / referenceTime);
+
+		TestEnsure(numMismatches == 0);
+		if (headers == &utf8Headers)
+			TestEnsure(detectorTime < referenceTime);
+	}
+
+	String ascii(1 << 20, 'a');
+	Timer timer;
+	size_t asciiLength = 0;
+	for (uint32 i = 0; i < iterations; ++i)
+		asciiLength += GetPlainASCIILength(ascii.c_str(), ascii.size() - i);
+	Logf("Plain ASCII scan: %.2f GB/s", Logger::Severity::Info, asciiLength / timer.SecondsAsDouble() / (1 << 30));
+}
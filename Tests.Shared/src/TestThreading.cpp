@@ -0,0 +1,185 @@
+#include <Shared/Shared.hpp>
+#include <Shared/TripleBuffer.hpp>
+#include <Shared/FixedRateThread.hpp>
+#include <Tests/Tests.hpp>
+#include <atomic>
+#include <thread>
+
+Test("TripleBuffer.Latest")
+{
+	TripleBuffer<int32> buffer;
+	TestEnsure(!buffer.Update());
+
+	// Only the last value is seen
+	for(int32 i = 1; i <= 3; i++)
+	{
+		buffer.GetWriteBuffer() = i;
+		buffer.Publish();
+	}
+	TestEnsure(buffer.Update());
+	TestEnsure(buffer.GetReadBuffer() == 3);
+	TestEnsure(!buffer.Update());
+	TestEnsure(buffer.GetReadBuffer() == 3);
+
+	// The writer never gets the buffer that is being read
+	for(int32 i = 4; i <= 10; i++)
+	{
+		TestEnsure(&buffer.GetWriteBuffer() != &buffer.GetReadBuffer());
+		buffer.GetWriteBuffer() = i;
+		buffer.Publish();
+		TestEnsure(buffer.GetReadBuffer() == 3);
+	}
+	TestEnsure(buffer.Update());
+	TestEnsure(buffer.GetReadBuffer() == 10);
+}
+
+Test("TripleBuffer.Threads")
+{
+	struct Value
+	{
+		int64 a = 0;
+		int64 b = 0;
+	};
+	TripleBuffer<Value> buffer;
+	const int64 numValues = 200000;
+
+	std::thread writer([&]()
+	{
+		for(int64 i = 1; i <= numValues; i++)
+		{
+			Value& value = buffer.GetWriteBuffer();
+			value.a = i;
+			value.b = -i;
+			buffer.Publish();
+		}
+	});
+
+	// Every value that is read must be complete and newer than the previous one
+	int64 last = 0;
+	while(last < numValues)
+	{
+		if(!buffer.Update())
+			continue;
+		const Value& value = buffer.GetReadBuffer();
+		TestEnsure(value.a == -value.b);
+		TestEnsure(value.a > last);
+		last = value.a;
+	}
+	writer.join();
+}
+
+// Clock for running a FixedRateThread on simulated time
+//	sleeping jumps to the wake up time, steps can move the time further to stall the thread
+//	once finished the time stops, so no more steps are run until the thread is stopped
+struct SimulatedClock
+{
+	std::atomic<int64> now{ 0 };
+	std::atomic<bool> finished{ false };
+
+	void Attach(FixedRateThread& thread)
+	{
+		thread.SetClock([this]()
+		{
+			return FixedRateThread::Clock::time_point(std::chrono::duration_cast<FixedRateThread::Clock::duration>(std::chrono::nanoseconds(now.load())));
+		},
+		[this](FixedRateThread::Clock::time_point time)
+		{
+			if(finished)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				return;
+			}
+			const int64 target = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+			if(target > now)
+				now = target;
+		});
+	}
+	void Stall(int64 ms)
+	{
+		now += ms * 1000000;
+	}
+	int64 GetMs() const
+	{
+		return now / 1000000;
+	}
+	void WaitUntilFinished()
+	{
+		while(!finished)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+};
+
+struct StepRecord
+{
+	uint64 step;
+	double time;
+	// Simulated time the step was run at
+	int64 runAt;
+};
+
+Test("FixedRateThread.Rate")
+{
+	FixedRateThread thread("Test");
+	SimulatedClock clock;
+	clock.Attach(thread);
+
+	Vector<StepRecord> steps;
+	thread.Start(1000, [&](uint64 step, double time)
+	{
+		steps.push_back({ step, time, clock.GetMs() });
+		if(step == 200)
+			clock.finished = true;
+	});
+	clock.WaitUntilFinished();
+	thread.Stop();
+
+	// Every step is run once at the time it was scheduled at
+	TestEnsure(steps.size() == 201);
+	TestEnsure(thread.GetNumSteps() == 201);
+	TestEnsure(thread.GetNumDroppedSteps() == 0);
+	for(size_t i = 0; i < steps.size(); i++)
+	{
+		TestEnsure(steps[i].step == i);
+		TestEnsure(steps[i].time == i / 1000.0);
+		TestEnsure(steps[i].runAt == (int64)i);
+	}
+}
+
+// The step thread itself stalls, a short stall is caught up with back to back steps
+//	a stall longer than MaxCatchUp steps drops the missed steps
+Test("FixedRateThread.Stall")
+{
+	FixedRateThread thread("Test");
+	SimulatedClock clock;
+	clock.Attach(thread);
+
+	Vector<StepRecord> steps;
+	thread.Start(1000, [&](uint64 step, double time)
+	{
+		steps.push_back({ step, time, clock.GetMs() });
+		if(step == 100)
+			clock.Stall(30);
+		if(step == 300)
+			clock.Stall(250);
+		if(step == 600)
+			clock.finished = true;
+	});
+	clock.WaitUntilFinished();
+	thread.Stop();
+
+	// Steps 0 - 300 and 550 - 600
+	const uint64 numDropped = 550 - 301;
+	TestEnsure(thread.GetNumDroppedSteps() == numDropped);
+	TestEnsure(steps.size() == 601 - numDropped);
+	TestEnsure(thread.GetNumSteps() == steps.size());
+	for(size_t i = 0; i < steps.size(); i++)
+	{
+		const StepRecord& r = steps[i];
+		TestEnsure(r.step == (i <= 300 ? i : i + numDropped));
+		// Step times don't move with the stalls
+		TestEnsure(r.time == r.step / 1000.0);
+		// Steps missed by the short stall are run right after it
+		const int64 runAt = (r.step > 100 && r.step <= 130) ? 130 : (int64)r.step;
+		TestEnsure(r.runAt == runAt);
+	}
+}